@@ -8,7 +8,7 @@
     error("Current version of Qt ($${QT_VERSION}) is too old, this project requires Qt 5.14 or newer")
 }
 
-QT = core gui printsupport qml serialbus serialport widgets help network opengl
+QT = core gui printsupport qml serialbus serialport widgets help network opengl concurrent
 
 CONFIG(release, debug|release):DEFINES += QT_NO_DEBUG_OUTPUT
 
@@ -25,6 +25,7 @@ ICON = icons/SavvyIcon.icns
 
 SOURCES += main.cpp\
     canbridgewindow.cpp \
+    can_trigger_structs.cpp \
     connections/canlogserver.cpp \
     connections/canserver.cpp \
     connections/lawicel_serial.cpp \
@@ -55,6 +56,7 @@ SOURCES += main.cpp\
     candatagrid.cpp \
     framesenderwindow.cpp \
     framefileio.cpp \
+    loadfilterdialog.cpp \
     mainsettingsdialog.cpp \
     firmwareuploaderwindow.cpp \
     scriptingwindow.cpp \
@@ -74,6 +76,10 @@ SOURCES += main.cpp\
     dbc/dbcmessageeditor.cpp \
     dbc/dbc_classes.cpp \
     dbc/dbchandler.cpp \
+    dbc/dbcparser.cpp \
+    dbc/dbccache.cpp \
+    dbc/dbcsnapshot.cpp \
+    dbc/signalvaluestore.cpp \
     dbc/dbcloadsavewindow.cpp \
     dbc/dbcmaineditor.cpp \
     dbc/dbcnodeeditor.cpp \
@@ -81,10 +87,13 @@ SOURCES += main.cpp\
     dbc/dbcnoderebaseeditor.cpp \
     re/discretestatewindow.cpp \
     re/filecomparatorwindow.cpp \
+    re/flowtransitionindex.cpp \
     re/flowviewwindow.cpp \
     re/frameinfowindow.cpp \
+    re/framestatistics.cpp \
     re/fuzzingwindow.cpp \
     re/isotp_interpreterwindow.cpp \
+    re/poolprogress.cpp \
     re/rangestatewindow.cpp \
     re/udsscanwindow.cpp \
     connections/canbus.cpp \
@@ -149,6 +158,8 @@ HEADERS  += mainwindow.h \
     framesenderwindow.h \
     can_trigger_structs.h \
     framefileio.h \
+    frameloadfilter.h \
+    loadfilterdialog.h \
     config.h \
     mainsettingsdialog.h \
     firmwareuploaderwindow.h \
@@ -156,6 +167,11 @@ HEADERS  += mainwindow.h \
     scriptcontainer.h \
     canfilter.h \
     utils/lfqueue.h \
+    utils/textformatter.h \
+    utils/signalextractor.h \
+    utils/signalencoder.h \
+    utils/minmaxpyramid.h \
+    utils/flatidmap.h \
     motorcontrollerconfigwindow.h \
     connections/canconnection.h \
     connections/serialbusconnection.h \
@@ -168,6 +184,10 @@ HEADERS  += mainwindow.h \
     re/sniffer/snifferwindow.h \
     dbc/dbc_classes.h \
     dbc/dbchandler.h \
+    dbc/dbcparser.h \
+    dbc/dbccache.h \
+    dbc/dbcsnapshot.h \
+    dbc/signalvaluestore.h \
     dbc/dbcloadsavewindow.h \
     dbc/dbcmaineditor.h \
     dbc/dbcsignaleditor.h \
@@ -175,10 +195,13 @@ HEADERS  += mainwindow.h \
     dbc/dbcnodeeditor.h \
     re/discretestatewindow.h \
     re/filecomparatorwindow.h \
+    re/flowtransitionindex.h \
     re/flowviewwindow.h \
     re/frameinfowindow.h \
+    re/framestatistics.h \
     re/fuzzingwindow.h \
     re/isotp_interpreterwindow.h \
+    re/poolprogress.h \
     re/rangestatewindow.h \
     re/udsscanwindow.h \
     connections/canbus.h \
@@ -223,6 +246,7 @@ FORMS    += ui/candatagrid.ui \
     ui/framesenderwindow.ui \
     ui/fuzzingwindow.ui \
     ui/graphingwindow.ui \
+    ui/loadfilterdialog.ui \
     ui/isotp_interpreterwindow.ui \
     ui/mainsettingsdialog.ui \
     ui/mainwindow.ui \
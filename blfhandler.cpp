@@ -1,14 +1,100 @@
 #include "blfhandler.h"
+#include <QDateTime>
 #include <QDebug>
 #include <QFile>
+#include <QQueue>
 #include <QString>
+#include <QThread>
+#include <QtConcurrent/QtConcurrentMap>
+#include <QtConcurrent/QtConcurrentRun>
 #include <QtEndian>
 
 #define BLF_REMOTE_FLAG 0x80
+#define BLF_TX_FLAG 0x01
+#define BLF_FD64_REMOTE_FLAG 0x10
+#define BLF_FD64_EDL_FLAG 0x1000
+#define BLF_FD64_BRS_FLAG 0x2000
+#define BLF_FD_EDL_FLAG 0x01
+#define BLF_FD_BRS_FLAG 0x02
+
+#define BLF_FILE_SIG 0x47474F4C //LOGG
+#define BLF_OBJ_SIG 0x4A424F4C //LOBJ
+
+//object header flags that tell the unit of the timestamp
+#define BLF_TIME_TEN_MICS 1
+#define BLF_TIME_ONE_NANS 2
+
+//how much frame data is packed into a single container when saving
+#define BLF_CONTAINER_SIZE 0x20000
 
 BLFHandler::BLFHandler()
 {
+    loadFilter = nullptr;
+}
+
+void BLFHandler::setLoadFilter(const FrameLoadFilter *filter)
+{
+    if (filter && filter->isActive()) loadFilter = filter;
+    else loadFilter = nullptr;
+}
+
+//a container's uncompressed contents, or a loose object. ok is false if a container couldn't be unpacked
+struct BLFBlock
+{
+    QByteArray data;
+    bool ok;
+};
+
+//runs on the thread pool. Returns the uncompressed contents of a container
+static BLFBlock inflateContainer(const char *data, int len, quint32 uncompressedSize, quint16 compressionMethod)
+{
+    if (compressionMethod == BLF_CONT_NO_COMPRESSION) return {QByteArray(data, len), true};
+    if (compressionMethod == BLF_CONT_ZLIB_COMPRESSION)
+    {
+        //qUncompress wants the expected size in front of the zlib stream
+        QByteArray packed(len + 4, Qt::Uninitialized);
+        qToBigEndian<quint32>(uncompressedSize, packed.data());
+        memcpy(packed.data() + 4, data, len);
+        QByteArray unpacked = qUncompress(packed);
+        //qUncompress gives back nothing at all when the stream is corrupt
+        return {unpacked, uncompressedSize == 0 || !unpacked.isEmpty()};
+    }
+    qDebug() << "Dunno what this is... " << compressionMethod;
+    return {QByteArray(), false};
+}
+
+//objects found outside of any container are just passed through in order
+static BLFBlock copyObject(const char *data, int len)
+{
+    return {QByteArray(data, len), true};
+}
+
+static void appendBLFFrame(QVector<CANFrame>* frames, const FrameLoadFilter *filter, uint32_t channel, uint32_t id, bool received,
+                           bool remote, bool fd, bool brs, const uint8_t *data, int len, uint64_t timeStamp)
+{
+    //skip frames the load filter doesn't want before anything gets allocated for them
+    if (filter && !filter->accepts(id & 0x1FFFFFFFull, channel, timeStamp)) return;
 
+    CANFrame frame;
+    frame.bus = channel;
+    frame.setExtendedFrameFormat((id & 0x80000000ull)?true:false);
+    frame.setFrameId(id & 0x1FFFFFFFull);
+    frame.isReceived = received;
+    if (fd)
+    {
+        frame.setFlexibleDataRateFormat(true);
+        frame.setBitrateSwitch(brs);
+    }
+
+    if (remote) {
+        frame.setFrameType(QCanBusFrame::RemoteRequestFrame);
+        frame.setPayload(QByteArray(len, 0));
+    } else {
+        frame.setFrameType(QCanBusFrame::DataFrame);
+        frame.setPayload(QByteArray(reinterpret_cast<const char *>(data), len));
+    }
+    frame.setTimeStamp(QCanBusFrame::TimeStamp(0, timeStamp));
+    frames->append(frame);
 }
 
 /*
@@ -19,16 +105,71 @@ https://bitbucket.org/tobylorenz/vector_blf/
 All the code actually below is freshly written but heavily based upon things seen in those
 two source repos.
 */
-bool BLFHandler::loadBLF(QString filename, QVector<CANFrame>* frames)
+bool BLFHandler::decodeObject(const char *obj, uint32_t objSize, QVector<CANFrame>* frames)
 {
     BLF_OBJ_HEADER objHeader;
-    QByteArray fileData;
-    QByteArray uncompressedData;
-    QByteArray junk;
-    BLF_OBJECT obj;
-    uint32_t pos;
     BLF_CAN_OBJ canObject;
     BLF_CAN_OBJ2 canObject2;
+    BLF_CANFD_OBJ canFDObject;
+    BLF_CANFD_OBJ64 canFDObject64;
+
+    memcpy(&objHeader.base, obj, sizeof(BLF_OBJ_HEADER_BASE));
+    if (objHeader.base.objType > 0xFFFF) return false;
+
+    //v1 and v2 object headers both keep the flags and the timestamp in the same spot. V2 is just longer
+    uint32_t headerSize = objHeader.base.headerSize;
+    if (headerSize < sizeof(BLF_OBJ_HEADER_BASE) + sizeof(BLF_OBJ_HEADER_V1) || headerSize > objSize) return true;
+    memcpy(&objHeader.v1Obj, obj + sizeof(BLF_OBJ_HEADER_BASE), sizeof(BLF_OBJ_HEADER_V1));
+
+    //uncompsize field is also used for the timestamp. Logs are stamped either in 10us or ns units
+    uint64_t timeStamp;
+    if (objHeader.v1Obj.flags == BLF_TIME_TEN_MICS) timeStamp = objHeader.v1Obj.uncompSize * 10;
+    else timeStamp = objHeader.v1Obj.uncompSize / 1000;
+
+    const char *data = obj + headerSize;
+    uint32_t dataLen = objSize - headerSize;
+
+    switch (objHeader.base.objType)
+    {
+    case BLF_CAN_MSG:
+        if (dataLen < sizeof(BLF_CAN_OBJ)) break;
+        memcpy(&canObject, data, sizeof(BLF_CAN_OBJ));
+        appendBLFFrame(frames, loadFilter, canObject.channel, canObject.id, !(canObject.flags & BLF_TX_FLAG), canObject.flags & BLF_REMOTE_FLAG,
+                       false, false, canObject.data, qMin((int)canObject.dlc, 8), timeStamp);
+        break;
+    case BLF_CAN_MSG2:
+        if (dataLen < sizeof(BLF_CAN_OBJ)) break;
+        memset(&canObject2, 0, sizeof(BLF_CAN_OBJ2));
+        memcpy(&canObject2, data, qMin(dataLen, (uint32_t)sizeof(BLF_CAN_OBJ2)));
+        appendBLFFrame(frames, loadFilter, canObject2.channel, canObject2.id, !(canObject2.flags & BLF_TX_FLAG), canObject2.flags & BLF_REMOTE_FLAG,
+                       false, false, canObject2.data, qMin((int)canObject2.dlc, 8), timeStamp);
+        break;
+    case BLF_CAN_FD_MSG:
+        memset(&canFDObject, 0, sizeof(BLF_CANFD_OBJ));
+        memcpy(&canFDObject, data, qMin(dataLen, (uint32_t)sizeof(BLF_CANFD_OBJ)));
+        appendBLFFrame(frames, loadFilter, canFDObject.channel, canFDObject.id, !(canFDObject.flags & BLF_TX_FLAG), canFDObject.flags & BLF_REMOTE_FLAG,
+                       canFDObject.fdFlags & BLF_FD_EDL_FLAG, canFDObject.fdFlags & BLF_FD_BRS_FLAG, canFDObject.data,
+                       qMin((int)canFDObject.validDataBytes, 64), timeStamp);
+        break;
+    case BLF_CAN_FD_MSG64:
+        memset(&canFDObject64, 0, sizeof(BLF_CANFD_OBJ64));
+        memcpy(&canFDObject64, data, qMin(dataLen, (uint32_t)sizeof(BLF_CANFD_OBJ64)));
+        appendBLFFrame(frames, loadFilter, canFDObject64.channel, canFDObject64.id, canFDObject64.dir == 0, canFDObject64.flags & BLF_FD64_REMOTE_FLAG,
+                       canFDObject64.flags & BLF_FD64_EDL_FLAG, canFDObject64.flags & BLF_FD64_BRS_FLAG, canFDObject64.data,
+                       qMin((int)canFDObject64.validDataBytes, 64), timeStamp);
+        break;
+    default:
+        //qDebug() << "Not a can frame! ObjType: " << objHeader.base.objType;
+        break;
+    }
+    return true;
+}
+
+bool BLFHandler::loadBLF(QString filename, QVector<CANFrame>* frames)
+{
+    BLF_OBJ_HEADER_BASE objBase;
+    BLF_OBJ_HEADER_CONTAINER containerHeader;
+    QByteArray readData;
 
     QFile *inFile = new QFile(filename);
 
@@ -37,140 +178,315 @@ bool BLFHandler::loadBLF(QString filename, QVector<CANFrame>* frames)
         delete inFile;
         return false;
     }
-    inFile->read((char *)&header, sizeof(header));
-    if (qFromLittleEndian(header.sig) == 0x47474F4C)
+
+    //map the whole file so containers can be handed to the worker threads without copying them first
+    qint64 fileSize = inFile->size();
+    const char *fileData = reinterpret_cast<const char *>(inFile->map(0, fileSize));
+    if (!fileData)
+    {
+        readData = inFile->readAll();
+        fileData = readData.constData();
+    }
+
+    if (fileSize < (qint64)sizeof(header))
+    {
+        inFile->close();
+        delete inFile;
+        return false;
+    }
+    memcpy(&header, fileData, sizeof(header));
+    if (qFromLittleEndian(header.sig) == BLF_FILE_SIG)
     {
         qDebug() << "Proper BLF file header token";
     }
-    else return false;
+    else
+    {
+        inFile->close();
+        delete inFile;
+        return false;
+    }
+
+    //countObjs also counts things that aren't frames so only use it as long as it's believable
+    if (header.countObjs < header.uncompressedFileSize / 16) frames->reserve(frames->count() + header.countObjs);
 
-    while (!inFile->atEnd())
+    const int maxInFlight = qMax(2, QThread::idealThreadCount() * 2);
+    QQueue<QFuture<BLFBlock>> inFlight;
+    QByteArray pending; //uncompressed data not yet turned into frames. Objects can straddle containers
+    int pendingPos = 0;
+    bool result = true;
+
+    //waits for the oldest inflated block and decodes every complete object in it
+    auto decodeNextBlock = [&]()
     {
-        qDebug() << "Position within file: " << inFile->pos();
-        inFile->read((char *)&objHeader.base, sizeof(BLF_OBJ_HEADER_BASE));
-        if (qFromLittleEndian(objHeader.base.sig) == 0x4A424F4C)
+        BLFBlock inflated = inFlight.dequeue().result();
+        if (!result) return;
+        if (!inflated.ok)
+        {
+            //without its contents every object after this one would be out of step
+            qDebug() << "Could not uncompress a container, aborting";
+            result = false;
+            return;
+        }
+        const QByteArray &block = inflated.data;
+        if (pendingPos >= pending.size())
         {
-            int readSize = objHeader.base.objSize - sizeof(BLF_OBJ_HEADER_BASE);
-            qDebug() << "Proper object header token. Read Size: " << readSize;
-            fileData = inFile->read(readSize);
-            junk = inFile->read(readSize % 4); //file is padded so sizes must always end up on even multiple of 4
-            //qDebug() << "Fudge bytes in readSize: " << (readSize % 4);
+            //padding of the last object can end up at the start of the next container
+            int skip = pendingPos - pending.size();
+            pending = block;
+            pendingPos = skip;
+        }
+        else
+        {
+            pending = pending.mid(pendingPos) + block;
+            pendingPos = 0;
+        }
 
-            switch (objHeader.base.objType)
+        while (pendingPos + (int)sizeof(BLF_OBJ_HEADER_BASE) <= pending.size())
+        {
+            const char *obj = pending.constData() + pendingPos;
+            memcpy(&objBase, obj, sizeof(BLF_OBJ_HEADER_BASE));
+            if (qFromLittleEndian(objBase.sig) != BLF_OBJ_SIG || objBase.objSize < sizeof(BLF_OBJ_HEADER_BASE))
             {
-                case BLF_CONTAINER:
-                qDebug() << "Object is a container.";
-                memcpy(&objHeader.containerObj, fileData.constData(), sizeof(BLF_OBJ_HEADER_CONTAINER));
-                fileData.remove(0, sizeof(BLF_OBJ_HEADER_CONTAINER));
-                if (objHeader.containerObj.compressionMethod == BLF_CONT_NO_COMPRESSION)
-                {
-                    qDebug() << "Container is not compressed";
-                    uncompressedData = fileData;
-                }
-                else if (objHeader.containerObj.compressionMethod == BLF_CONT_ZLIB_COMPRESSION)
-                {
-                    qDebug() << "Compressed container. Unpacking it.";
-                    fileData.prepend(objHeader.containerObj.uncompressedSize & 0xFF);
-                    fileData.prepend((objHeader.containerObj.uncompressedSize >> 8) & 0xFF);
-                    fileData.prepend((objHeader.containerObj.uncompressedSize >> 16) & 0xFF);
-                    fileData.prepend((objHeader.containerObj.uncompressedSize >> 24) & 0xFF);
-                    uncompressedData += qUncompress(fileData);
-                }
-                else
-                {
-                    qDebug() << "Dunno what this is... " << objHeader.containerObj.compressionMethod;
-                }
-                qDebug() << "Uncompressed size: " << uncompressedData.count();
-                qDebug() << "Currently loaded frames at this point: " << frames->count();
-                pos = 0;
-                //bool foundHeader = false;
-                //first skip forward to find a header signature - usually not necessary
-                while ( (int)(pos + sizeof(BLF_OBJ_HEADER)) < uncompressedData.count())
-                {
-                    int32_t *headerSig = (int32_t *)(uncompressedData.constData() + pos);
-                    if (*headerSig == 0x4A424F4C) break;
-                    pos += 4;
-                }
-                //then process all the objects
-                while ( (int)(pos + sizeof(BLF_OBJ_HEADER)) < uncompressedData.count())
-                {
-                    memcpy(&obj.header.base, (uncompressedData.constData() + pos), sizeof(BLF_OBJ_HEADER_BASE));
-                    memcpy(&obj.header.v1Obj, (uncompressedData.constData() + pos) + sizeof(BLF_OBJ_HEADER_BASE), sizeof(BLF_OBJ_HEADER_V1));
-                    //if (obj.header.base.objType != 1)
-                        //qDebug() << "Pos: " << pos << " Type: " << obj.header.base.objType << "Obj Size: " << obj.header.base.objSize;
-                    if (qFromLittleEndian(objHeader.base.sig) == 0x4A424F4C)
-                    {
-                        fileData = uncompressedData.mid(pos + sizeof(BLF_OBJ_HEADER_BASE) + sizeof(BLF_OBJ_HEADER_V1), obj.header.base.objSize - sizeof(BLF_OBJ_HEADER_BASE) - sizeof(BLF_OBJ_HEADER_V1));
-                        if (obj.header.base.objType == BLF_CAN_MSG)
-                        {
-                            memcpy(&canObject, fileData.constData(), sizeof(BLF_CAN_OBJ));
-                            CANFrame frame;
-                            frame.bus = canObject.channel;
-                            frame.setExtendedFrameFormat((canObject.id & 0x80000000ull)?true:false);
-                            frame.setFrameId(canObject.id & 0x1FFFFFFFull);
-                            frame.isReceived = true;
-                            QByteArray bytes(canObject.dlc, 0);
-
-                            if (canObject.flags & BLF_REMOTE_FLAG) {
-                                frame.setFrameType(QCanBusFrame::RemoteRequestFrame);
-                            } else {
-                                frame.setFrameType(QCanBusFrame::DataFrame);
-                                for (int i = 0; i < canObject.dlc; i++) bytes[i] = canObject.data[i];
-                            }
-                            frame.setPayload(bytes);
-                            //Should we divide by a thousand or a million? Unsure here. It appears some logs are stamped in microseconds and some in milliseconds?
-                            frame.setTimeStamp(QCanBusFrame::TimeStamp(0, obj.header.v1Obj.uncompSize / 1000.0)); //uncompsize field also used for timestamp oddly enough
-                            frames->append(frame);
-                        }
-                        else if (obj.header.base.objType == BLF_CAN_MSG2)
-                        {
-                            memcpy(&canObject2, fileData.constData(), sizeof(BLF_CAN_OBJ2));
-                            CANFrame frame;
-                            frame.bus = canObject2.channel;
-                            frame.setExtendedFrameFormat((canObject2.id & 0x80000000ull)?true:false);
-                            frame.setFrameId(canObject2.id & 0x1FFFFFFFull);
-                            frame.isReceived = true;
-                            QByteArray bytes(canObject2.dlc, 0);
-
-                            if (canObject2.flags & BLF_REMOTE_FLAG) {
-                                frame.setFrameType(QCanBusFrame::RemoteRequestFrame);
-                            } else {
-                                frame.setFrameType(QCanBusFrame::DataFrame);
-                                for (int i = 0; i < canObject2.dlc; i++) bytes[i] = canObject2.data[i];
-                            }
-                            frame.setPayload(bytes);
-                            //Should we divide by a thousand or a million? Unsure here. It appears some logs are stamped in microseconds and some in milliseconds?
-                            frame.setTimeStamp(QCanBusFrame::TimeStamp(0, obj.header.v1Obj.uncompSize / 1000.0)); //uncompsize field also used for timestamp oddly enough
-                            frames->append(frame);
-                        }
-                        else
-                        {
-                            qDebug() << "Not a can frame! ObjType: " << obj.header.base.objType;
-                            if (obj.header.base.objType > 0xFFFF)
-                                return false;
-                        }
-                        pos += obj.header.base.objSize + (obj.header.base.objSize % 4);
-                    }
-                    else
-                    {
-                        qDebug() << "Unexpected object header signature, aborting";
-                        return false;
-                    }
-                }
-                uncompressedData.remove(0, pos);
-                qDebug() << "After removing used data uncompressedData is now this big: " << uncompressedData.count();
-
-                break;
+                //not on an object. Skip forward to find the next header signature
+                pendingPos += 4;
+                continue;
             }
+            if (pendingPos + (qint64)objBase.objSize > pending.size()) break; //rest of it is in the next container
+            if (!decodeObject(obj, objBase.objSize, frames))
+            {
+                qDebug() << "Unexpected object type, aborting";
+                result = false;
+                return;
+            }
+            pendingPos += objBase.objSize + (objBase.objSize % 4);
         }
-        else return false;
+    };
+
+    qint64 pos = qMax((qint64)sizeof(header), (qint64)header.headerSize);
+    while (result && pos + (qint64)sizeof(BLF_OBJ_HEADER_BASE) <= fileSize)
+    {
+        memcpy(&objBase, fileData + pos, sizeof(BLF_OBJ_HEADER_BASE));
+        if (qFromLittleEndian(objBase.sig) != BLF_OBJ_SIG)
+        {
+            qDebug() << "Unexpected object header signature at " << pos << ", aborting";
+            result = false;
+            break;
+        }
+        qint64 objSize = objBase.objSize;
+        if (objSize < (qint64)sizeof(BLF_OBJ_HEADER_BASE) || pos + objSize > fileSize)
+        {
+            qDebug() << "Truncated object at " << pos;
+            break;
+        }
+
+        if (objBase.objType == BLF_CONTAINER)
+        {
+            memcpy(&containerHeader, fileData + pos + sizeof(BLF_OBJ_HEADER_BASE), sizeof(BLF_OBJ_HEADER_CONTAINER));
+            int headerLen = sizeof(BLF_OBJ_HEADER_BASE) + sizeof(BLF_OBJ_HEADER_CONTAINER);
+            inFlight.enqueue(QtConcurrent::run(inflateContainer, fileData + pos + headerLen, (int)(objSize - headerLen),
+                                               (quint32)containerHeader.uncompressedSize, (quint16)containerHeader.compressionMethod));
+        }
+        else
+        {
+            inFlight.enqueue(QtConcurrent::run(copyObject, fileData + pos, (int)qMin(objSize + (objSize % 4), fileSize - pos)));
+        }
+        pos += objSize + (objSize % 4);
+
+        while (inFlight.count() >= maxInFlight) decodeNextBlock();
     }
-    return true;
+    while (!inFlight.isEmpty()) decodeNextBlock(); //also makes sure no worker still reads the mapping
+
+    qDebug() << "Currently loaded frames at this point: " << frames->count();
+
+    inFile->close();
+    delete inFile;
+    return result;
+}
+
+//DLC code for a payload length. CAN-FD only allows some lengths above 8
+static uint8_t blfLengthToDLC(int len)
+{
+    if (len <= 8) return len;
+    if (len <= 12) return 9;
+    if (len <= 16) return 10;
+    if (len <= 20) return 11;
+    if (len <= 24) return 12;
+    if (len <= 32) return 13;
+    if (len <= 48) return 14;
+    return 15;
+}
+
+//SYSTEMTIME layout used by the BLF file header
+static void blfSystemTime(uint8_t *out, const QDateTime &time)
+{
+    uint16_t fields[8];
+    fields[0] = time.date().year();
+    fields[1] = time.date().month();
+    fields[2] = time.date().dayOfWeek() % 7; //sunday is 0
+    fields[3] = time.date().day();
+    fields[4] = time.time().hour();
+    fields[5] = time.time().minute();
+    fields[6] = time.time().second();
+    fields[7] = time.time().msec();
+    memcpy(out, fields, sizeof(fields));
 }
 
-bool BLFHandler::saveBLF(QString filename, QVector<CANFrame> *frames)
+static void appendBLFObject(QByteArray &out, uint32_t objType, uint64_t timeStamp, const void *obj, uint32_t objLen)
 {
-    Q_UNUSED(filename)
-    Q_UNUSED(frames)
-    return false;
+    BLF_OBJ_HEADER_BASE base;
+    BLF_OBJ_HEADER_V1 v1;
+
+    base.sig = BLF_OBJ_SIG;
+    base.headerSize = sizeof(BLF_OBJ_HEADER_BASE) + sizeof(BLF_OBJ_HEADER_V1);
+    base.headerVersion = 1;
+    base.objSize = base.headerSize + objLen;
+    base.objType = objType;
+    v1.flags = BLF_TIME_ONE_NANS;
+    v1.clientIdx = 0;
+    v1.objVer = 0;
+    v1.uncompSize = timeStamp;
+
+    out.append(reinterpret_cast<const char *>(&base), sizeof(base));
+    out.append(reinterpret_cast<const char *>(&v1), sizeof(v1));
+    out.append(reinterpret_cast<const char *>(obj), objLen);
+    if (base.objSize % 4) out.append(base.objSize % 4, 0);
+}
+
+struct BLFContainer
+{
+    QByteArray raw;
+    QByteArray packed;
+};
+
+//runs on the thread pool
+static void compressContainer(BLFContainer &container)
+{
+    container.packed = qCompress(container.raw, 6); //first four bytes are the qCompress size header and are skipped later
+}
+
+bool BLFHandler::saveBLF(QString filename, const QVector<CANFrame>* frames)
+{
+    BLF_OBJ_HEADER_BASE base;
+    BLF_OBJ_HEADER_CONTAINER containerHeader;
+    BLF_CAN_OBJ canObject;
+    BLF_CANFD_OBJ64 canFDObject64;
+
+    QFile *outFile = new QFile(filename);
+    if (!outFile->open(QIODevice::WriteOnly))
+    {
+        delete outFile;
+        return false;
+    }
+
+    //BLF stamps are relative to the start time in the header
+    int64_t offsetTime = frames->isEmpty() ? 0 : frames->at(0).timeStamp().microSeconds();
+    int64_t lastTime = offsetTime;
+    for (int c = 0; c < frames->count(); c++)
+    {
+        int64_t stamp = frames->at(c).timeStamp().microSeconds();
+        if (stamp < offsetTime) offsetTime = stamp;
+        if (stamp > lastTime) lastTime = stamp;
+    }
+    QDateTime startTime = QDateTime::currentDateTime();
+    QDateTime stopTime = startTime;
+    if (offsetTime > 10000000000) //chances are the input file had times as system time so use it
+    {
+        startTime.setMSecsSinceEpoch(offsetTime / 1000);
+        stopTime.setMSecsSinceEpoch(lastTime / 1000);
+    }
+    else stopTime = startTime.addMSecs((lastTime - offsetTime) / 1000);
+
+    memset(&header, 0, sizeof(header));
+    header.sig = BLF_FILE_SIG;
+    header.headerSize = sizeof(header);
+    header.binLogVerMajor = 2;
+    header.binLogVerMinor = 6;
+    header.binLogVerBuild = 8;
+    header.binLogVerPatch = 1;
+    header.uncompressedFileSize = sizeof(header);
+    header.countObjs = frames->count();
+    blfSystemTime(header.startTime, startTime);
+    blfSystemTime(header.stopTime, stopTime);
+    outFile->write(reinterpret_cast<const char *>(&header), sizeof(header)); //rewritten at the end once sizes are known
+
+    const int batchSize = qMax(1, QThread::idealThreadCount()) * 2;
+    QVector<BLFContainer> batch;
+    BLFContainer current;
+    current.raw.reserve(BLF_CONTAINER_SIZE + sizeof(BLF_OBJ_HEADER) + sizeof(BLF_CANFD_OBJ64));
+    bool result = true;
+
+    auto writeBatch = [&]()
+    {
+        QtConcurrent::blockingMap(batch, compressContainer);
+        for (int i = 0; i < batch.count(); i++)
+        {
+            int packedLen = batch[i].packed.size() - 4;
+            base.sig = BLF_OBJ_SIG;
+            base.headerSize = sizeof(BLF_OBJ_HEADER_BASE);
+            base.headerVersion = 1;
+            base.objSize = sizeof(BLF_OBJ_HEADER_BASE) + sizeof(BLF_OBJ_HEADER_CONTAINER) + packedLen;
+            base.objType = BLF_CONTAINER;
+            memset(&containerHeader, 0, sizeof(containerHeader));
+            containerHeader.compressionMethod = BLF_CONT_ZLIB_COMPRESSION;
+            containerHeader.uncompressedSize = batch[i].raw.size();
+
+            outFile->write(reinterpret_cast<const char *>(&base), sizeof(base));
+            outFile->write(reinterpret_cast<const char *>(&containerHeader), sizeof(containerHeader));
+            if (outFile->write(batch[i].packed.constData() + 4, packedLen) != packedLen) result = false;
+            if (base.objSize % 4) outFile->write(QByteArray(base.objSize % 4, 0));
+            header.uncompressedFileSize += sizeof(BLF_OBJ_HEADER_BASE) + sizeof(BLF_OBJ_HEADER_CONTAINER) + batch[i].raw.size();
+        }
+        batch.clear();
+    };
+
+    for (int c = 0; c < frames->count() && result; c++)
+    {
+        const CANFrame &frame = frames->at(c);
+        const QByteArray payload = frame.payload();
+        int dataLen = qMin(payload.count(), 64);
+        uint32_t id = frame.frameId() | (frame.hasExtendedFrameFormat() ? 0x80000000ul : 0);
+        uint64_t timeStamp = (frame.timeStamp().microSeconds() - offsetTime) * 1000ull;
+        bool remote = (frame.frameType() == QCanBusFrame::RemoteRequestFrame);
+
+        if (frame.hasFlexibleDataRateFormat() || dataLen > 8)
+        {
+            memset(&canFDObject64, 0, sizeof(canFDObject64));
+            canFDObject64.channel = frame.bus;
+            canFDObject64.dlc = blfLengthToDLC(dataLen);
+            canFDObject64.validDataBytes = dataLen;
+            canFDObject64.id = id;
+            canFDObject64.flags = BLF_FD64_EDL_FLAG | (frame.hasBitrateSwitch() ? BLF_FD64_BRS_FLAG : 0);
+            canFDObject64.dir = frame.isReceived ? 0 : 1;
+            memcpy(canFDObject64.data, payload.constData(), dataLen);
+            appendBLFObject(current.raw, BLF_CAN_FD_MSG64, timeStamp, &canFDObject64, sizeof(canFDObject64));
+        }
+        else
+        {
+            memset(&canObject, 0, sizeof(canObject));
+            canObject.channel = frame.bus;
+            canObject.flags = (frame.isReceived ? 0 : BLF_TX_FLAG) | (remote ? BLF_REMOTE_FLAG : 0);
+            canObject.dlc = dataLen;
+            canObject.id = id;
+            if (!remote) memcpy(canObject.data, payload.constData(), dataLen);
+            appendBLFObject(current.raw, BLF_CAN_MSG, timeStamp, &canObject, sizeof(canObject));
+        }
+
+        if (current.raw.size() >= BLF_CONTAINER_SIZE)
+        {
+            batch.append(current);
+            current.raw = QByteArray();
+            current.raw.reserve(BLF_CONTAINER_SIZE + sizeof(BLF_OBJ_HEADER) + sizeof(BLF_CANFD_OBJ64));
+            if (batch.count() >= batchSize) writeBatch();
+        }
+    }
+    if (!current.raw.isEmpty()) batch.append(current);
+    if (!batch.isEmpty()) writeBatch();
+
+    header.fileSize = outFile->pos();
+    outFile->seek(0);
+    outFile->write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    outFile->close();
+    delete outFile;
+    return result;
 }
@@ -5,6 +5,7 @@
 #include <QByteArray>
 #include <QList>
 #include "can_structs.h"
+#include "frameloadfilter.h"
 
 enum
 {
@@ -146,6 +147,26 @@ struct BLF_CANFD_OBJ
     uint8_t data[64];
 };
 
+struct BLF_CANFD_OBJ64
+{
+    uint8_t channel;
+    uint8_t dlc;
+    uint8_t validDataBytes;
+    uint8_t txCount;
+    uint32_t id;
+    uint32_t frameLength;
+    uint32_t flags; //0x10 = RTR, 0x1000 = EDL (FD frame), 0x2000 = BRS, 0x4000 = ESI
+    uint32_t btrCfgArb;
+    uint32_t btrCfgData;
+    uint32_t timeOffsetBrsNs;
+    uint32_t timeOffsetCrcDelNs;
+    uint16_t bitCount;
+    uint8_t dir; //0 = Rx, 1 = Tx
+    uint8_t extDataOffset;
+    uint32_t crc;
+    uint8_t data[64];
+};
+
 struct BLF_ERROR_EXT
 {
     uint16_t channel;
@@ -175,14 +196,25 @@ struct BLF_GLOBAL_MARKER
     uint8_t ignore2[12];
 };
 
+/*
+ * Loading streams through the file: LOG_CONTAINER objects are handed to the global thread pool to be
+ * inflated (a few ahead of where the decoder is) while the calling thread turns the inflated objects
+ * into frames in file order. Saving packs frames into zlib compressed containers which are also
+ * compressed in parallel.
+ */
 class BLFHandler
 {
 public:
     BLFHandler();
     bool loadBLF(QString filename, QVector<CANFrame>* frames);
-    bool saveBLF(QString filename, QVector<CANFrame>* frames);
+    bool saveBLF(QString filename, const QVector<CANFrame>* frames);
+    void setLoadFilter(const FrameLoadFilter *filter);
 
 private:
+    bool decodeObject(const char *obj, uint32_t objSize, QVector<CANFrame>* frames);
+
+    const FrameLoadFilter *loadFilter;
+
     BLF_FILE_HEADER header;
     QList<BLF_OBJECT> objects;
 };
@@ -0,0 +1,47 @@
+#include "can_trigger_structs.h"
+#include "dbc/dbchandler.h"
+
+/*
+ * Bring the signal handles up to date if the DBC files changed since they were resolved. Safe from any thread,
+ * off the GUI thread the handles move over once the GUI thread has published a snapshot of the changed files.
+ */
+void FrameSendData::updateSignalHandles()
+{
+    if (dbcSnapshot && dbcSnapshot->getGeneration() == DBCHandler::getLookupGeneration()) return;
+    QSharedPointer<const DBCSnapshot> current = DBCHandler::getReference()->getSnapshot();
+    if (current && current != dbcSnapshot) resolveSignalHandles(current);
+}
+
+/*
+ * Look up the signals named in the triggers and modifiers once so sending doesn't search by name every time.
+ * Modifier targets are signals of the record's own ID, trigger signals belong to the trigger ID.
+ */
+void FrameSendData::resolveSignalHandles(const QSharedPointer<const DBCSnapshot> &snapshot)
+{
+    dbcSnapshot = snapshot;
+    const DBCSnapshot::Message *ownMsg = snapshot ? snapshot->findMessage(frameId()) : nullptr;
+    for (int i = 0; i < modifiers.count(); i++)
+    {
+        Modifier &mod = modifiers[i];
+        mod.sigHandle = nullptr;
+        if (mod.destByte == -1 && ownMsg) mod.sigHandle = ownMsg->findSignal(mod.signalName);
+    }
+    for (int i = 0; i < triggers.count(); i++)
+    {
+        Trigger &trigger = triggers[i];
+        trigger.sigHandle = nullptr;
+        if (!snapshot || !(trigger.triggerMask & TriggerMask::TRG_SIGNAL)) continue;
+        const DBCSnapshot::Message *msg = snapshot->findMessage(static_cast<uint32_t>(trigger.ID));
+        if (msg) trigger.sigHandle = msg->findSignal(trigger.sigName);
+    }
+}
+
+//packs the values collected by the modifiers into the payload, all of them or none
+bool FrameSendData::packSignalValues(const QList<QPair<const DBCSnapshot::Signal *, double>> &values, QString *errorString)
+{
+    if (values.isEmpty()) return true;
+    QByteArray newArr(payload());
+    if (!values.first().first->message->packSignals(values, newArr, errorString)) return false;
+    setPayload(newArr);
+    return true;
+}
@@ -2,8 +2,11 @@
 #define CAN_TRIGGER_STRUCTS_H
 
 #include "can_structs.h"
+#include "dbc/dbcsnapshot.h"
 
 #include <QList>
+#include <QPair>
+#include <QSharedPointer>
 #include <QUuid>
 
 enum TriggerMask
@@ -31,6 +34,7 @@ public:
     int64_t sigValueInt; //value to trigger on (integer)
     double sigValueDbl; //value to trigger on (floating point)
     uint32_t triggerMask;
+    const DBCSnapshot::Signal *sigHandle = nullptr; //sigName looked up once, see FrameSendData::dbcSnapshot
 };
 
 //referece for a source location for a single modifier.
@@ -78,6 +82,7 @@ class Modifier
 public:
     int destByte; //if -1 then target one of this ID's signals instead
     QString signalName;
+    const DBCSnapshot::Signal *sigHandle = nullptr; //signalName looked up once, see FrameSendData::dbcSnapshot
     QList<ModifierOp> operations;
 };
 
@@ -90,6 +95,13 @@ public:
     int count;
     QList<Trigger> triggers;
     QList<Modifier> modifiers;
+    //DBC snapshot the signal handles in triggers and modifiers point into, held so they stay valid on any thread.
+    //Null means not resolved yet. Resolved again once a snapshot of changed DBC files is published
+    QSharedPointer<const DBCSnapshot> dbcSnapshot;
+
+    void updateSignalHandles();
+    void resolveSignalHandles(const QSharedPointer<const DBCSnapshot> &snapshot);
+    bool packSignalValues(const QList<QPair<const DBCSnapshot::Signal *, double>> &values, QString *errorString = nullptr);
 };
 
 #endif // CAN_TRIGGER_STRUCTS_H
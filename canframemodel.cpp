@@ -6,9 +6,16 @@
 #include <QDateTime>
 #include <QSettings>
 #include "utility.h"
+#include "dbc/signalvaluestore.h"
+
+#include <QtConcurrent/QtConcurrentRun>
+
+static const int renderedRowsMaxChars = 8 * 1024 * 1024; //cost of a cached row is its length
+static const int prefetchRows = 256;
 
 CANFrameModel::~CANFrameModel()
 {
+    prefetchWatcher->waitForFinished();
     frames.clear();
     filteredFrames.clear();
     filters.clear();
@@ -83,11 +90,20 @@ CANFrameModel::CANFrameModel(QObject *parent)
     timeFormat =  "MMM-dd HH:mm:ss.zzz";
     sortDirAsc = false;
     bytesPerLine = 8;
+
+    renderedRows.setMaxCost(renderedRowsMaxChars);
+    renderedGeneration = DBCHandler::getLookupGeneration();
+    renderEpoch = 0;
+    prefetchStart = prefetchEnd = 0;
+    prefetchPending = false;
+    prefetchWatcher = new QFutureWatcher<RenderBatch>(this);
+    connect(prefetchWatcher, &QFutureWatcher<RenderBatch>::finished, this, &CANFrameModel::prefetchFinished);
 }
 
 void CANFrameModel::setBytesPerLine(int bpl)
 {
     bytesPerLine = bpl;
+    clearRenderedRows();
 }
 
 void CANFrameModel::setHexMode(bool mode)
@@ -97,6 +113,7 @@ void CANFrameModel::setHexMode(bool mode)
         this->beginResetModel();
         useHexMode = mode;
         Utility::decimalMode = !useHexMode;
+        clearRenderedRows();
         this->endResetModel();
     }
 }
@@ -120,6 +137,7 @@ void CANFrameModel::setInterpretMode(bool mode)
     {
         this->beginResetModel();
         interpretFrames = mode;
+        clearRenderedRows();
         this->endResetModel();
     }
 }
@@ -176,6 +194,8 @@ void CANFrameModel::normalizeTiming()
         }
         frames[i].setTimeStamp(QCanBusFrame::TimeStamp(0, thisStamp));
     }
+    SignalValueStore::invalidateFrames();
+    clearRenderedRows();
 
     this->beginResetModel();
     for (int i = 0; i < filteredFrames.count(); i++)
@@ -333,6 +353,7 @@ void CANFrameModel::sortByColumn(int column)
     sortDirAsc = !sortDirAsc;
     if (sortDirAsc) qSortCANFrameAsc(&filteredFrames, Column(column), 0, filteredFrames.count()-1);
     else qSortCANFrameDesc(&filteredFrames, Column(column), 0, filteredFrames.count()-1);
+    SignalValueStore::invalidateFrames();
 
     mutex.lock();
     beginResetModel();
@@ -384,6 +405,7 @@ void CANFrameModel::recalcOverwrite()
     filteredFrames.clear();
     filteredFrames.append(overWriteFrames.values().toVector());
     filteredFrames.reserve(preallocSize);
+    SignalValueStore::invalidateFrames();
 
     /*for (int i = 0; i < frames.count(); i++)
     {
@@ -412,7 +434,6 @@ QVariant CANFrameModel::data(const QModelIndex &index, int role) const
 
     thisFrame = filteredFrames.at(index.row());
 
-    const unsigned char *data = reinterpret_cast<const unsigned char *>(thisFrame.payload().constData());
     int dataLen = thisFrame.payload().count();
 
     if (role == Qt::BackgroundRole)
@@ -516,73 +537,229 @@ QVariant CANFrameModel::data(const QModelIndex &index, int role) const
             }
             return tempString;
         case Column::Data:
-            if (dataLen < 0) dataLen = 0;
-            //if (useHexMode) tempString.append("0x ");
-            if (thisFrame.frameType() == QCanBusFrame::RemoteRequestFrame) {
-                return tempString;
-            }
-            for (int i = 0; i < dataLen; i++)
-            {
-                if (useHexMode) tempString.append( QString::number(data[i], 16).toUpper().rightJustified(2, '0'));
-                else tempString.append(QString::number(data[i], 10));
-                if (!((i+1) % bytesPerLine) && (i != (dataLen - 1))) tempString.append("\n");
-                else tempString.append(" ");
-            }
-            if (thisFrame.frameType() == thisFrame.ErrorFrame)
-            {
-                if (thisFrame.error() & thisFrame.TransmissionTimeoutError) tempString.append("\nTX Timeout");
-                if (thisFrame.error() & thisFrame.LostArbitrationError) tempString.append("\nLost Arbitration");
-                if (thisFrame.error() & thisFrame.ControllerError) tempString.append("\nController Error");
-                if (thisFrame.error() & thisFrame.ProtocolViolationError) tempString.append("\nProtocol Violation");
-                if (thisFrame.error() & thisFrame.TransceiverError) tempString.append("\nTransceiver Error");
-                if (thisFrame.error() & thisFrame.MissingAcknowledgmentError) tempString.append("\nMissing ACK");
-                if (thisFrame.error() & thisFrame.BusOffError) tempString.append("\nBus OFF");
-                if (thisFrame.error() & thisFrame.BusError) tempString.append("\nBus ERR");
-                if (thisFrame.error() & thisFrame.ControllerRestartError) tempString.append("\nController restart err");
-                if (thisFrame.error() & thisFrame.UnknownError) tempString.append("\nUnknown error type");
-            }
-            //TODO: technically the actual returned bytes for an error frame encode some more info. Not interpreting it yet.
+            if (interpretFrames && !overwriteDups) return cachedDataColumn(index.row(), thisFrame);
+            return renderDataColumn(thisFrame);
+        default:
+            return tempString;
+        }
+    }
 
-            //now, if we're supposed to interpret the data and the DBC handler is loaded then use it
-            if ( (dbcHandler != nullptr) && interpretFrames && (thisFrame.frameType() == thisFrame.DataFrame) )
-            {
-                DBC_MESSAGE *msg = dbcHandler->findMessage(thisFrame);
-                if (msg != nullptr)
+    return QVariant();
+}
+
+/*
+ * Bytes of the data column, plus the error flags of error frames. Only looks at its arguments so the prefetch
+ * batches can use it on the thread pool.
+ */
+QString CANFrameModel::renderFrameBytes(const CANFrame &thisFrame, bool useHexMode, int bytesPerLine)
+{
+    QString tempString;
+    const QByteArray payload = thisFrame.payload();
+    const unsigned char *data = reinterpret_cast<const unsigned char *>(payload.constData());
+    int dataLen = payload.count();
+
+    if (dataLen < 0) dataLen = 0;
+    //if (useHexMode) tempString.append("0x ");
+    if (thisFrame.frameType() == QCanBusFrame::RemoteRequestFrame) {
+        return tempString;
+    }
+    for (int i = 0; i < dataLen; i++)
+    {
+        if (useHexMode) tempString.append( QString::number(data[i], 16).toUpper().rightJustified(2, '0'));
+        else tempString.append(QString::number(data[i], 10));
+        if (!((i+1) % bytesPerLine) && (i != (dataLen - 1))) tempString.append("\n");
+        else tempString.append(" ");
+    }
+    if (thisFrame.frameType() == thisFrame.ErrorFrame)
+    {
+        if (thisFrame.error() & thisFrame.TransmissionTimeoutError) tempString.append("\nTX Timeout");
+        if (thisFrame.error() & thisFrame.LostArbitrationError) tempString.append("\nLost Arbitration");
+        if (thisFrame.error() & thisFrame.ControllerError) tempString.append("\nController Error");
+        if (thisFrame.error() & thisFrame.ProtocolViolationError) tempString.append("\nProtocol Violation");
+        if (thisFrame.error() & thisFrame.TransceiverError) tempString.append("\nTransceiver Error");
+        if (thisFrame.error() & thisFrame.MissingAcknowledgmentError) tempString.append("\nMissing ACK");
+        if (thisFrame.error() & thisFrame.BusOffError) tempString.append("\nBus OFF");
+        if (thisFrame.error() & thisFrame.BusError) tempString.append("\nBus ERR");
+        if (thisFrame.error() & thisFrame.ControllerRestartError) tempString.append("\nController restart err");
+        if (thisFrame.error() & thisFrame.UnknownError) tempString.append("\nUnknown error type");
+    }
+    //TODO: technically the actual returned bytes for an error frame encode some more info. Not interpreting it yet.
+    return tempString;
+}
+
+/*
+ * Text of the data column for one frame. Bytes first, then when interpreting the frame every signal of its message.
+ * The interpreted form is by far the most expensive thing the model produces, see cachedDataColumn
+ */
+QString CANFrameModel::renderDataColumn(const CANFrame &thisFrame) const
+{
+    QString tempString = renderFrameBytes(thisFrame, useHexMode, bytesPerLine);
+    if (thisFrame.frameType() == QCanBusFrame::RemoteRequestFrame) return tempString;
+
+    //now, if we're supposed to interpret the data and the DBC handler is loaded then use it
+    if ( (dbcHandler != nullptr) && interpretFrames && (thisFrame.frameType() == thisFrame.DataFrame) )
+    {
+        DBC_MESSAGE *msg = dbcHandler->findMessage(thisFrame);
+        if (msg != nullptr)
+        {
+            tempString.append("   <" + msg->name + ">\n");
+            if (msg->comment.length() > 1) tempString.append(msg->comment + "\n");
+            for (int j = 0; j < msg->sigHandler->getCount(); j++)
+            {                        
+                QString sigString;
+                DBC_SIGNAL* sig = msg->sigHandler->findSignalByIdx(j);
+
+                if ( (sig->multiplexParent == nullptr) && sig->processAsText(thisFrame, sigString))
                 {
-                    tempString.append("   <" + msg->name + ">\n");
-                    if (msg->comment.length() > 1) tempString.append(msg->comment + "\n");
-                    for (int j = 0; j < msg->sigHandler->getCount(); j++)
-                    {                        
-                        QString sigString;
-                        DBC_SIGNAL* sig = msg->sigHandler->findSignalByIdx(j);
-
-                        if ( (sig->multiplexParent == nullptr) && sig->processAsText(thisFrame, sigString))
-                        {
-                            tempString.append(sigString);
-                            tempString.append("\n");
-                            if (sig->isMultiplexor)
-                            {
-                                qDebug() << "Multiplexor. Diving into the tree";
-                                tempString.append(sig->processSignalTree(thisFrame));
-                            }
-                        }
-                        else if (sig->isMultiplexed && overwriteDups) //wasn't in this exact frame but is in the message. Use cached value
-                        {
-                            bool isInteger = false;
-                            if (sig->valType == UNSIGNED_INT || sig->valType == SIGNED_INT) isInteger = true;
-                            tempString.append(sig->makePrettyOutput(sig->cachedValue.toDouble(), sig->cachedValue.toLongLong(), true, isInteger));
-                            tempString.append("\n");
-                        }
+                    tempString.append(sigString);
+                    tempString.append("\n");
+                    if (sig->isMultiplexor)
+                    {
+                        tempString.append(sig->processSignalTree(thisFrame));
                     }
                 }
+                else if (sig->isMultiplexed && overwriteDups) //wasn't in this exact frame but is in the message. Use cached value
+                {
+                    bool isInteger = false;
+                    if (sig->valType == UNSIGNED_INT || sig->valType == SIGNED_INT) isInteger = true;
+                    tempString.append(sig->makePrettyOutput(sig->cachedValue.toDouble(), sig->cachedValue.toLongLong(), true, isInteger));
+                    tempString.append("\n");
+                }
             }
-            return tempString;
-        default:
-            return tempString;
         }
     }
+    return tempString;
+}
 
-    return QVariant();
+//the interpreted part of renderDataColumn made from a DBC snapshot, for everything but overwrite mode
+QString CANFrameModel::renderSnapshotSignals(const DBCSnapshot &snapshot, const CANFrame &thisFrame)
+{
+    QString tempString;
+    if (thisFrame.frameType() != QCanBusFrame::DataFrame) return tempString;
+    const DBCSnapshot::Message *msg = snapshot.findMessage(thisFrame);
+    if (!msg) return tempString;
+
+    tempString.append("   <" + msg->name + ">\n");
+    if (msg->comment.length() > 1) tempString.append(msg->comment + "\n");
+    for (const DBCSnapshot::Signal &sig : msg->sigs)
+    {
+        QString sigString;
+        if ((sig.multiplexParent == nullptr) && sig.decodeAsText(thisFrame, sigString))
+        {
+            tempString.append(sigString);
+            tempString.append("\n");
+            if (sig.isMultiplexor) tempString.append(sig.decodeSignalTree(thisFrame));
+        }
+    }
+    return tempString;
+}
+
+//runs on the thread pool, nothing in the batch is shared with the model
+CANFrameModel::RenderBatch CANFrameModel::renderBatch(RenderBatch batch)
+{
+    batch.texts.reserve(batch.frames.count());
+    for (const CANFrame &frame : qAsConst(batch.frames))
+    {
+        QString text = renderFrameBytes(frame, batch.useHexMode, batch.bytesPerLine);
+        if (frame.frameType() != QCanBusFrame::RemoteRequestFrame) text.append(renderSnapshotSignals(*batch.snapshot, frame));
+        batch.texts.append(text);
+    }
+    return batch;
+}
+
+/*
+ * Interpreted rows are rendered once and kept in an LRU cache keyed by row. An entry remembers which frame it was
+ * made from so rows that moved (front trimmed, resorted, refiltered) simply miss. The whole cache goes when the
+ * DBC files change or a setting that affects the text does. Overwrite mode isn't cached, its rows are
+ * rewritten in place and show the last value of multiplexed signals from other frames.
+ *
+ * Cached rows are rendered from the DBC snapshot. Every miss also hands the rows below it to the thread pool so
+ * they're already rendered when the view scrolls onto them.
+ */
+QString CANFrameModel::cachedDataColumn(int row, const CANFrame &thisFrame) const
+{
+    if (renderedGeneration != DBCHandler::getLookupGeneration())
+    {
+        renderedRows.clear();
+        renderedGeneration = DBCHandler::getLookupGeneration();
+        renderEpoch++;
+    }
+
+    RenderedRow *cached = renderedRows.object(row);
+    if (cached && cached->timeStamp == thisFrame.timeStamp().microSeconds() && cached->frameId == thisFrame.frameId()
+        && cached->bus == thisFrame.bus) return cached->text;
+
+    RenderedRow *fresh = new RenderedRow;
+    fresh->timeStamp = thisFrame.timeStamp().microSeconds();
+    fresh->frameId = thisFrame.frameId();
+    fresh->bus = thisFrame.bus;
+    fresh->text = renderFrameBytes(thisFrame, useHexMode, bytesPerLine);
+    QSharedPointer<const DBCSnapshot> snapshot = dbcHandler->getSnapshot();
+    if (snapshot && thisFrame.frameType() != QCanBusFrame::RemoteRequestFrame)
+        fresh->text.append(renderSnapshotSignals(*snapshot, thisFrame));
+    QString text = fresh->text;
+    renderedRows.insert(row, fresh, text.length() + 1);
+
+    if (row < prefetchStart || row + prefetchRows / 2 >= prefetchEnd)
+    {
+        prefetchStart = row + 1;
+        prefetchEnd = row + 1 + prefetchRows;
+        startPrefetch();
+    }
+    return text;
+}
+
+//hands the prefetch window to the thread pool, or remembers it for when the batch that is running comes back
+void CANFrameModel::startPrefetch() const
+{
+    if (prefetchWatcher->isRunning())
+    {
+        prefetchPending = true;
+        return;
+    }
+    prefetchPending = false;
+
+    RenderBatch batch;
+    batch.snapshot = dbcHandler->getSnapshot();
+    batch.firstRow = prefetchStart;
+    batch.useHexMode = useHexMode;
+    batch.bytesPerLine = bytesPerLine;
+    batch.epoch = renderEpoch;
+    int stop = qMin(prefetchEnd, filteredFrames.count());
+    if (!batch.snapshot || batch.firstRow >= stop) return;
+    batch.frames = filteredFrames.mid(batch.firstRow, stop - batch.firstRow);
+    prefetchWatcher->setFuture(QtConcurrent::run(&CANFrameModel::renderBatch, batch));
+}
+
+//files the rows of a finished batch into the cache, unless the cache was thrown away since it started
+void CANFrameModel::prefetchFinished()
+{
+    RenderBatch batch = prefetchWatcher->result();
+    if (batch.epoch == renderEpoch && interpretFrames && !overwriteDups
+        && batch.snapshot->getGeneration() == renderedGeneration)
+    {
+        for (int i = 0; i < batch.texts.count(); i++)
+        {
+            int row = batch.firstRow + i;
+            if (renderedRows.contains(row)) continue;
+            const CANFrame &frame = batch.frames.at(i);
+            RenderedRow *fresh = new RenderedRow;
+            fresh->timeStamp = frame.timeStamp().microSeconds();
+            fresh->frameId = frame.frameId();
+            fresh->bus = frame.bus;
+            fresh->text = batch.texts.at(i);
+            renderedRows.insert(row, fresh, fresh->text.length() + 1);
+        }
+    }
+    if (prefetchPending) startPrefetch();
+}
+
+void CANFrameModel::clearRenderedRows()
+{
+    renderedRows.clear();
+    renderEpoch++;
+    prefetchStart = prefetchEnd = 0;
+    prefetchPending = false;
 }
 
 QVariant CANFrameModel::headerData(int section, Qt::Orientation orientation,
@@ -752,6 +929,8 @@ void CANFrameModel::addFrame(const CANFrame& frame, bool autoRefresh = false)
                     if (autoRefresh) endResetModel();
                 }
             }
+            //a frame already in the list changed, series decoded from it are stale
+            SignalValueStore::invalidateFrames();
         }
     }
 
@@ -766,6 +945,7 @@ void CANFrameModel::addFrames(const CANConnection*, const QVector<CANFrame>& pFr
         mutex.lock();
         qDebug() << "Frames count: " << frames.length() << " of " << frames.capacity() << " capacity, removing first " << (int)(frames.capacity() * 0.05) << " frames";
         frames.remove(0, (int)(frames.capacity() * 0.05));
+        SignalValueStore::invalidateFrames();
         qDebug() << "Frames removed, new count: " << frames.length();
         mutex.unlock();
     }
@@ -775,6 +955,7 @@ void CANFrameModel::addFrames(const CANConnection*, const QVector<CANFrame>& pFr
         mutex.lock();
         qDebug() << "filteredFrames count: " << filteredFrames.length() << " of " << filteredFrames.capacity() << " capacity, removing first " << (int)(filteredFrames.capacity() * 0.05) << " frames";
         filteredFrames.remove(0, (int)(filteredFrames.capacity() * 0.05));
+        SignalValueStore::invalidateFrames();
         qDebug() << "filteredFrames removed, new count: " << filteredFrames.length();
         mutex.unlock();
     }
@@ -815,6 +996,7 @@ void CANFrameModel::sendRefresh()
         filteredFrames.clear();
         filteredFrames.append(tempContainer);
         filteredFrames.reserve(preallocSize);
+        SignalValueStore::invalidateFrames();
         lastUpdateNumFrames = 0;
         endResetModel();
         mutex.unlock();
@@ -855,6 +1037,8 @@ void CANFrameModel::clearFrames()
     this->beginResetModel();
     frames.clear();
     filteredFrames.clear();
+    SignalValueStore::invalidateFrames();
+    clearRenderedRows();
     if(filtersPersistDuringClear == false)
     {
         filters.clear();
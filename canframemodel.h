@@ -6,8 +6,12 @@
 #include <QVector>
 #include <QDebug>
 #include <QMutex>
+#include <QCache>
+#include <QFutureWatcher>
+#include <QSharedPointer>
 #include "can_structs.h"
 #include "dbc/dbchandler.h"
+#include "dbc/dbcsnapshot.h"
 #include "connections/canconnection.h"
 #include "utility.h"
 
@@ -75,7 +79,37 @@ public slots:
 signals:
     void updatedFiltersList();
 
+private slots:
+    void prefetchFinished();
+
 private:
+    struct RenderedRow
+    {
+        int64_t timeStamp; //which frame the text was made from
+        uint32_t frameId;
+        int bus;
+        QString text;
+    };
+
+    //rows rendered ahead of the view on the thread pool, from copies of their frames
+    struct RenderBatch
+    {
+        QSharedPointer<const DBCSnapshot> snapshot;
+        QVector<CANFrame> frames;
+        QVector<QString> texts;
+        int firstRow;
+        bool useHexMode;
+        int bytesPerLine;
+        quint32 epoch;
+    };
+
+    static QString renderFrameBytes(const CANFrame &thisFrame, bool useHexMode, int bytesPerLine);
+    static QString renderSnapshotSignals(const DBCSnapshot &snapshot, const CANFrame &thisFrame);
+    static RenderBatch renderBatch(RenderBatch batch);
+    QString renderDataColumn(const CANFrame &thisFrame) const;
+    QString cachedDataColumn(int row, const CANFrame &thisFrame) const;
+    void startPrefetch() const;
+    void clearRenderedRows();
     void qSortCANFrameAsc(QVector<CANFrame>* frames, Column column, int lowerBound, int upperBound);
     void qSortCANFrameDesc(QVector<CANFrame>* frames, Column column, int lowerBound, int upperBound);
     uint64_t getCANFrameVal(QVector<CANFrame> *frames, int row, Column col);
@@ -101,6 +135,15 @@ private:
     uint32_t preallocSize;
     bool sortDirAsc;
     int bytesPerLine;
+
+    //interpreted data column text by row, see cachedDataColumn
+    mutable QCache<int, RenderedRow> renderedRows;
+    mutable quint32 renderedGeneration;
+    mutable quint32 renderEpoch; //bumped whenever the cache is thrown away so batches still running get dropped
+    mutable int prefetchStart;
+    mutable int prefetchEnd;
+    mutable bool prefetchPending; //the window moved while a batch was running
+    QFutureWatcher<RenderBatch> *prefetchWatcher;
 };
 
 
@@ -2,6 +2,7 @@
 #include "dbchandler.h"
 #include "utility.h"
 #include <QtMath>
+#include <algorithm>
 
 DBC_MESSAGE::DBC_MESSAGE()
 {
@@ -34,7 +35,7 @@ bool DBC_SIGNAL::isSignalInMessage(const CANFrame &frame)
             {
                 int val;
                 if (!multiplexParent->processAsInt(frame, val)) return false;
-                return isValueMatchingMultiplex(val);
+                return multiplexParent->getActiveChildren(val).contains(this);
             }
             else return false;
         }
@@ -157,6 +158,67 @@ bool DBC_SIGNAL::multiplexesIdenticalToSignal(DBC_SIGNAL *other) const
     return othersMuxes.isEmpty();
 }
 
+/*
+ * Turn the ranges of all multiplexedChildren into a dispatch table for this multiplexor. Every range start and
+ * every range end + 1 is a point where the set of active children can change, so the values are cut up at those
+ * points and each piece gets the list of children active in it. Adjacent pieces with the same children are merged.
+ * Extended multiplexing with overlapping ranges works out the same way, a value simply lands in a piece
+ * that lists several children.
+ */
+void DBC_SIGNAL::compileMultiplexPlan()
+{
+    multiplexPlan.clear();
+    multiplexPlanGeneration = DBCHandler::getLookupGeneration();
+    multiplexPlanChildren = multiplexedChildren.count();
+
+    QVector<qint64> bounds;
+    for (DBC_SIGNAL *child : qAsConst(multiplexedChildren))
+    {
+        for (const auto &limitPair : qAsConst(child->multiplexLowAndHighValues))
+        {
+            bounds.append(limitPair.first);
+            bounds.append(static_cast<qint64>(limitPair.second) + 1);
+        }
+    }
+    std::sort(bounds.begin(), bounds.end());
+    bounds.erase(std::unique(bounds.begin(), bounds.end()), bounds.end());
+
+    for (int i = 0; i + 1 < bounds.count(); i++)
+    {
+        DBC_MULTIPLEX_SEGMENT seg;
+        seg.low = static_cast<int>(bounds[i]);
+        seg.high = static_cast<int>(bounds[i + 1] - 1);
+        for (DBC_SIGNAL *child : qAsConst(multiplexedChildren))
+        {
+            if (child->isValueMatchingMultiplex(seg.low)) seg.children.append(child);
+        }
+        if (seg.children.isEmpty()) continue;
+
+        if (!multiplexPlan.isEmpty() && (multiplexPlan.last().high + 1 == seg.low)
+            && (multiplexPlan.last().children == seg.children))
+        {
+            multiplexPlan.last().high = seg.high;
+        }
+        else multiplexPlan.append(seg);
+    }
+}
+
+//The children of this multiplexor that are present when it has the value val. One binary search in the dispatch table
+const QVector<DBC_SIGNAL *> &DBC_SIGNAL::getActiveChildren(int val)
+{
+    static const QVector<DBC_SIGNAL *> noChildren;
+
+    if ((multiplexPlanChildren != multiplexedChildren.count())
+        || (multiplexPlanGeneration != DBCHandler::getLookupGeneration())) compileMultiplexPlan();
+
+    auto it = std::upper_bound(multiplexPlan.constBegin(), multiplexPlan.constEnd(), val,
+                               [](int v, const DBC_MULTIPLEX_SEGMENT &seg) { return v < seg.low; });
+    if (it == multiplexPlan.constBegin()) return noChildren;
+    --it;
+    if (val > it->high) return noChildren;
+    return it->children;
+}
+
 //Take all the children of this signal and see if they exist in the message. Can be called recursively to descend the dependency tree
 QString DBC_SIGNAL::processSignalTree(const CANFrame &frame)
 {
@@ -167,28 +229,23 @@ QString DBC_SIGNAL::processSignalTree(const CANFrame &frame)
         qDebug() << "Could not process multiplexor as an integer.";
         return build;
     }
-    qDebug() << val;
 
-    foreach (DBC_SIGNAL *sig, multiplexedChildren)
+    //only the children switched on by this value get decoded, everything else is skipped without a look
+    const QVector<DBC_SIGNAL *> &active = getActiveChildren(val);
+    for (DBC_SIGNAL *sig : active)
     {
-        if (sig->isValueMatchingMultiplex(val))
+        QString sigString;
+        if (sig->processAsText(frame, sigString))
         {
-            qDebug() << "Found match for multiplex value range - " << sig->name;
-            QString sigString;
-            if (sig->processAsText(frame, sigString))
+            if (!build.isEmpty() && !sigString.isEmpty())
+                build.append("\n");
+            build.append(sigString);
+            if (sig->isMultiplexor)
             {
-                qDebug() << "Returned value: " << sigString;
-                if (!build.isEmpty() && !sigString.isEmpty())
+                auto subTreeString = sig->processSignalTree(frame);
+                if (!build.isEmpty() && !subTreeString.isEmpty())
                     build.append("\n");
-                build.append(sigString);
-                if (sig->isMultiplexor)
-                {
-                    qDebug() << "Spelunkin!";
-                    auto subTreeString = sig->processSignalTree(frame);
-                    if (!build.isEmpty() && !subTreeString.isEmpty())
-                        build.append("\n");
-                    build.append(subTreeString);
-                }
+                build.append(subTreeString);
             }
         }
     }
@@ -247,7 +304,7 @@ bool DBC_SIGNAL::processAsText(const CANFrame &frame, QString &outString, bool o
     if (valType == SIGNED_INT) isSigned = true;
     if (valType == SIGNED_INT || valType == UNSIGNED_INT)
     {
-        result = Utility::processIntegerSignal(frame.payload(), startBit, signalSize, intelByteOrder, isSigned);
+        result = extractRawValue(frame, signalSize, intelByteOrder, isSigned);
         endResult = ((double)result * factor) + bias;
         result = (int64_t)endResult;
         // if factor is an integer, we don't need the possibly human-unreadable float representation
@@ -260,7 +317,7 @@ bool DBC_SIGNAL::processAsText(const CANFrame &frame, QString &outString, bool o
         //that the bytes that make up the integer are instead treated as having made up
         //a 32 bit single precision float. That's evil incarnate but it is very fast and small
         //in terms of new code.
-        result = Utility::processIntegerSignal(frame.payload(), startBit, 32, intelByteOrder, false);
+        result = extractRawValue(frame, 32, intelByteOrder, false);
         endResult = (*((float *)(&result)) * factor) + bias; //look away! This is awful. I don't even know for sure if it works. Should test that.
     }
     else //double precision float
@@ -272,7 +329,7 @@ bool DBC_SIGNAL::processAsText(const CANFrame &frame, QString &outString, bool o
         }
         //like the above, this is rotten and evil and wrong in so many ways. Force
         //calculation of a 64 bit integer and then cast it into a double.
-        result = Utility::processIntegerSignal(frame.payload(), startBit, 64, intelByteOrder, false);
+        result = extractRawValue(frame, 64, intelByteOrder, false);
         endResult = (*((double *)(&result)) * factor) + bias;
     }
 
@@ -281,6 +338,13 @@ bool DBC_SIGNAL::processAsText(const CANFrame &frame, QString &outString, bool o
     return true;
 }
 
+int64_t DBC_SIGNAL::extractRawValue(const CANFrame &frame, int sigSize, bool littleEndian, bool isSigned)
+{
+    if (!extractor.isCompiledFor(startBit, sigSize, littleEndian, isSigned))
+        extractor.compile(startBit, sigSize, littleEndian, isSigned);
+    return extractor.extract(frame.payload());
+}
+
 bool DBC_SIGNAL::getValueString(int64_t intVal, QString &outString)
 {
     if (valList.count() > 0) //if this is a value list type then look it up and display the proper string
@@ -351,7 +415,7 @@ bool DBC_SIGNAL::processAsInt(const CANFrame &frame, int32_t &outValue)
         return false;
     }*/
 
-    result = static_cast<int32_t>(Utility::processIntegerSignal(frame.payload(), startBit, signalSize, intelByteOrder, isSigned));
+    result = static_cast<int32_t>(extractRawValue(frame, signalSize, intelByteOrder, isSigned));
 
     double endResult = (result * factor) + bias;
     result = static_cast<int32_t>(endResult);
@@ -385,7 +449,7 @@ bool DBC_SIGNAL::processAsDouble(const CANFrame &frame, double &outValue)
             result = 0;
             return false;
         }
-        result = Utility::processIntegerSignal(frame.payload(), startBit, signalSize, intelByteOrder, isSigned);
+        result = extractRawValue(frame, signalSize, intelByteOrder, isSigned);
         endResult = ((double)result * factor) + bias;
         result = (int64_t)endResult;
     }
@@ -402,7 +466,7 @@ bool DBC_SIGNAL::processAsDouble(const CANFrame &frame, double &outValue)
         //that the bytes that make up the integer are instead treated as having made up
         //a 32 bit single precision float. That's evil incarnate but it is very fast and small
         //in terms of new code.
-        result = Utility::processIntegerSignal(frame.payload(), startBit, 32, false, false);
+        result = extractRawValue(frame, 32, false, false);
         endResult = (*((float *)(&result)) * factor) + bias;
     }
     else //double precision float
@@ -414,7 +478,7 @@ bool DBC_SIGNAL::processAsDouble(const CANFrame &frame, double &outValue)
         }
         //like the above, this is rotten and evil and wrong in so many ways. Force
         //calculation of a 64 bit integer and then cast it into a double.
-        result = Utility::processIntegerSignal(frame.payload(), startBit, 64, false, false);
+        result = extractRawValue(frame, 64, false, false);
         endResult = (*((double *)(&result)) * factor) + bias;
     }
     cachedValue = endResult;
@@ -422,6 +486,83 @@ bool DBC_SIGNAL::processAsDouble(const CANFrame &frame, double &outValue)
     return true;
 }
 
+/*
+ * Batch form of processAsDouble for frames[0], frames[stride], ... (count of them). out[i] gets the value and valid[i]
+ * (if given) whether processAsDouble would have succeeded for that frame, out[i] is 0 when it wouldn't have.
+ * Decoding is done a block at a time by the compiled extractor and the factor / bias applied to the whole block
+ * afterward. cachedValue is not touched. Returns the number of frames that could be decoded.
+*/
+int DBC_SIGNAL::processBatchAsDouble(const CANFrame *frames, int count, double *out, bool *valid, int stride)
+{
+    if (valType == STRING || count <= 0) return 0;
+
+    //same layouts and length checks as processAsDouble
+    int sigSize = signalSize;
+    bool littleEndian = intelByteOrder;
+    bool isSigned = (valType == SIGNED_INT);
+    int neededBits = startBit + signalSize;
+    if (valType == SP_FLOAT)
+    {
+        sigSize = 32;
+        littleEndian = false;
+        isSigned = false;
+        neededBits = startBit + 32;
+    }
+    else if (valType == DP_FLOAT)
+    {
+        sigSize = 64;
+        littleEndian = false;
+        isSigned = false;
+        neededBits = 64;
+    }
+    if (!extractor.isCompiledFor(startBit, sigSize, littleEndian, isSigned))
+        extractor.compile(startBit, sigSize, littleEndian, isSigned);
+
+    const int blockSize = 1024;
+    int64_t raw[blockSize];
+    bool ok[blockSize];
+    int numValid = 0;
+
+    for (int base = 0; base < count; base += blockSize)
+    {
+        int n = qMin(blockSize, count - base);
+        extractor.extractBatch(frames + static_cast<qsizetype>(base) * stride, n, stride, raw, ok, (neededBits + 7) / 8);
+
+        double *dest = out + base;
+        if (valType == SIGNED_INT || valType == UNSIGNED_INT)
+        {
+            SignalExtractor::applyScale(raw, n, factor, bias, dest);
+        }
+        else if (valType == SP_FLOAT)
+        {
+            for (int i = 0; i < n; i++)
+            {
+                uint32_t bits = static_cast<uint32_t>(raw[i]);
+                float val;
+                memcpy(&val, &bits, sizeof(val));
+                dest[i] = (val * factor) + bias;
+            }
+        }
+        else
+        {
+            for (int i = 0; i < n; i++)
+            {
+                double val;
+                memcpy(&val, &raw[i], sizeof(val));
+                dest[i] = (val * factor) + bias;
+            }
+        }
+
+        for (int i = 0; i < n; i++)
+        {
+            if (ok[i]) numValid++;
+            else dest[i] = 0.0;
+        }
+        if (valid) memcpy(valid + base, ok, n * sizeof(bool));
+    }
+    return numValid;
+}
+
 DBC_ATTRIBUTE_VALUE *DBC_SIGNAL::findAttrValByName(QString name)
 {
     if (attributes.length() == 0) return nullptr;
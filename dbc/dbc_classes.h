@@ -5,7 +5,9 @@
 #include <QString>
 #include <QStringList>
 #include <QVariant>
+#include <QVector>
 #include "can_structs.h"
+#include "utils/signalextractor.h"
 
 /*classes to encapsulate data from a DBC file. Really, the stuff of interest
   are the nodes, messages, signals, attributes, and comments.
@@ -86,6 +88,14 @@ public:
 class DBC_MESSAGE; //forward reference so that DBC_SIGNAL can compile before we get to real definition of DBC_MESSAGE
 class DBC_SIGNAL;
 
+//one run of multiplexor values that all switch on the same children. Part of a multiplexor's dispatch table
+struct DBC_MULTIPLEX_SEGMENT
+{
+    int low;
+    int high;
+    QVector<DBC_SIGNAL *> children; //same order as multiplexedChildren
+};
+
 class DBC_SIGNAL
 {
 public: //TODO: Clean up this class so that not everything is public. There is one private member which is a start...
@@ -128,6 +138,7 @@ public: //TODO: Clean up this class so that not everything is public. There is o
     bool processAsText(const CANFrame &frame, QString &outString, bool outputName = true, bool outputUnit = true);
     bool processAsInt(const CANFrame &frame, int32_t &outValue);
     bool processAsDouble(const CANFrame &frame, double &outValue);
+    int processBatchAsDouble(const CANFrame *frames, int count, double *out, bool *valid = nullptr, int stride = 1);
     bool getValueString(int64_t intVal, QString &outString);
     QString makePrettyOutput(double floatVal, int64_t intVal, bool outputName = true, bool isInteger = false, bool outputUnit = true);
     QString processSignalTree(const CANFrame &frame);
@@ -135,6 +146,7 @@ public: //TODO: Clean up this class so that not everything is public. There is o
     DBC_ATTRIBUTE_VALUE *findAttrValByIdx(int idx);
     bool isSignalInMessage(const CANFrame &frame);
     bool isValueMatchingMultiplex(int val) const;
+    const QVector<DBC_SIGNAL *> &getActiveChildren(int val);
     int getSimpleMultiplexValue();
 
 
@@ -144,6 +156,20 @@ public: //TODO: Clean up this class so that not everything is public. There is o
     }
 private:
     QList<QPair<int, int>> multiplexLowAndHighValues;
+
+    //compiled form of startBit / signalSize / byte order. Recompiled on use whenever those have been edited
+    SignalExtractor extractor;
+    int64_t extractRawValue(const CANFrame &frame, int sigSize, bool littleEndian, bool isSigned);
+
+    //multiplexedChildren and their ranges compiled into sorted, non overlapping value segments.
+    //Rebuilt whenever the DBC lookup generation moves or children were added / removed
+    QVector<DBC_MULTIPLEX_SEGMENT> multiplexPlan;
+    quint32 multiplexPlanGeneration = 0;
+    int multiplexPlanChildren = -1;
+    void compileMultiplexPlan();
+
+    friend class DBCCache; //stores multiplexLowAndHighValues
+    friend class DBCSnapshot; //copies them
 };
 
 class DBCSignalHandler; //forward declaration to keep from having to include dbchandler.h in this file and thus create a loop
@@ -0,0 +1,246 @@
+#include "dbccache.h"
+#include "dbchandler.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+static const quint32 cacheMagic = 0x53444243; //"SDBC"
+static const quint32 cacheVersion = 1;
+
+static void writeAttrValues(QDataStream &out, const QList<DBC_ATTRIBUTE_VALUE> &vals)
+{
+    out << static_cast<qint32>(vals.count());
+    for (const DBC_ATTRIBUTE_VALUE &val : vals) out << val.attrName << val.value;
+}
+
+static void readAttrValues(QDataStream &in, QList<DBC_ATTRIBUTE_VALUE> &vals)
+{
+    qint32 count;
+    in >> count;
+    vals.clear();
+    for (int i = 0; i < count && in.status() == QDataStream::Ok; i++)
+    {
+        DBC_ATTRIBUTE_VALUE val;
+        in >> val.attrName >> val.value;
+        vals.append(val);
+    }
+}
+
+QString DBCCache::cacheFileName(const QString &canonicalPath)
+{
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/dbc";
+    QByteArray hash = QCryptographicHash::hash(canonicalPath.toUtf8(), QCryptographicHash::Sha1).toHex();
+    return dir + "/" + QString::fromLatin1(hash) + ".dbcc";
+}
+
+bool DBCCache::load(const QString &sourcePath, DBCFile *file, int &numMsgFaults, int &numSigFaults)
+{
+    QFileInfo source(sourcePath);
+    if (!source.exists()) return false;
+
+    QFile cacheFile(cacheFileName(source.canonicalFilePath()));
+    if (!cacheFile.open(QIODevice::ReadOnly)) return false;
+    uchar *mapped = cacheFile.map(0, cacheFile.size());
+    QByteArray data;
+    if (mapped) data = QByteArray::fromRawData(reinterpret_cast<const char *>(mapped), static_cast<int>(cacheFile.size()));
+    else data = cacheFile.readAll();
+
+    QDataStream in(data);
+    in.setVersion(QDataStream::Qt_5_12);
+
+    quint32 magic, version;
+    QString path;
+    qint64 size, modified;
+    qint32 msgFaults, sigFaults;
+    in >> magic >> version >> path >> size >> modified >> msgFaults >> sigFaults;
+    if (in.status() != QDataStream::Ok || magic != cacheMagic || version != cacheVersion) return false;
+    if (path != source.canonicalFilePath() || size != source.size()
+        || modified != source.lastModified().toMSecsSinceEpoch()) return false;
+
+    file->dbc_nodes.clear();
+    file->dbc_attributes.clear();
+    file->messageHandler->removeAllMessages();
+    file->messageHandler->setMatchingCriteria(EXACT);
+    file->messageHandler->setFilterLabeling(false);
+
+    qint32 nodeCount;
+    in >> nodeCount;
+    for (int i = 0; i < nodeCount && in.status() == QDataStream::Ok; i++)
+    {
+        DBC_NODE node;
+        in >> node.name >> node.comment >> node.sourceFileName;
+        readAttrValues(in, node.attributes);
+        file->dbc_nodes.append(node);
+    }
+
+    qint32 attrCount;
+    in >> attrCount;
+    for (int i = 0; i < attrCount && in.status() == QDataStream::Ok; i++)
+    {
+        DBC_ATTRIBUTE attr;
+        qint32 valType, attrType;
+        in >> attr.name >> valType >> attrType >> attr.upper >> attr.lower >> attr.enumVals >> attr.defaultValue;
+        attr.valType = static_cast<DBC_ATTRIBUTE_VAL_TYPE>(valType);
+        attr.attrType = static_cast<DBC_ATTRIBUTE_TYPE>(attrType);
+        file->dbc_attributes.append(attr);
+    }
+
+    DBCMessageHandler *handler = file->messageHandler;
+    qint32 msgCount;
+    in >> msgCount;
+    for (int m = 0; m < msgCount && in.status() == QDataStream::Ok; m++)
+    {
+        DBC_MESSAGE newMsg;
+        quint32 len;
+        qint32 senderIdx, multiplexorIdx, sigCount;
+        in >> newMsg.ID >> newMsg.extendedID >> newMsg.name >> newMsg.comment >> len >> senderIdx;
+        readAttrValues(in, newMsg.attributes);
+        in >> multiplexorIdx >> sigCount;
+        newMsg.len = len;
+        newMsg.sender = file->findNodeByIdx(senderIdx);
+        handler->addMessage(newMsg);
+        DBC_MESSAGE *msg = handler->findMsgByIdx(handler->getCount() - 1);
+
+        for (int s = 0; s < sigCount && in.status() == QDataStream::Ok; s++)
+        {
+            DBC_SIGNAL sig;
+            qint32 startBit, signalSize, valType, receiverIdx;
+            in >> sig.name >> startBit >> signalSize >> sig.intelByteOrder >> valType;
+            in >> sig.factor >> sig.bias >> sig.min >> sig.max >> receiverIdx >> sig.unitName >> sig.comment;
+            in >> sig.isMultiplexor >> sig.isMultiplexed >> sig.hasExtendedMultiplexing >> sig.multiplexLowAndHighValues;
+            readAttrValues(in, sig.attributes);
+            qint32 valCount;
+            in >> valCount;
+            for (int v = 0; v < valCount && in.status() == QDataStream::Ok; v++)
+            {
+                DBC_VAL_ENUM_ENTRY val;
+                qint32 value;
+                in >> value >> val.descript;
+                val.value = value;
+                sig.valList.append(val);
+            }
+            sig.startBit = startBit;
+            sig.signalSize = signalSize;
+            sig.valType = static_cast<DBC_SIG_VAL_TYPE>(valType);
+            sig.receiver = file->findNodeByIdx(receiverIdx);
+            sig.parentMessage = msg;
+            msg->sigHandler->addSignal(sig);
+        }
+
+        //now that all signals of the message have their final address the multiplex links can be resolved
+        msg->multiplexorSignal = msg->sigHandler->findSignalByIdx(multiplexorIdx);
+        for (int s = 0; s < sigCount && in.status() == QDataStream::Ok; s++)
+        {
+            DBC_SIGNAL *sig = msg->sigHandler->findSignalByIdx(s);
+            qint32 parentIdx;
+            QVector<qint32> children;
+            in >> parentIdx >> children;
+            if (!sig) continue;
+            sig->multiplexParent = msg->sigHandler->findSignalByIdx(parentIdx);
+            for (qint32 child : children)
+            {
+                DBC_SIGNAL *childSig = msg->sigHandler->findSignalByIdx(child);
+                if (childSig) sig->multiplexedChildren.append(childSig);
+            }
+        }
+    }
+
+    if (in.status() != QDataStream::Ok)
+    {
+        qDebug() << "DBC cache for " << sourcePath << " is damaged, parsing the file instead";
+        return false;
+    }
+
+    numMsgFaults = msgFaults;
+    numSigFaults = sigFaults;
+    qDebug() << "Loaded " << sourcePath << " from DBC cache " << cacheFile.fileName();
+    return true;
+}
+
+bool DBCCache::store(const QString &sourcePath, DBCFile *file, int numMsgFaults, int numSigFaults)
+{
+    QFileInfo source(sourcePath);
+    if (!source.exists()) return false;
+
+    QString fileName = cacheFileName(source.canonicalFilePath());
+    QDir().mkpath(QFileInfo(fileName).path());
+    QSaveFile cacheFile(fileName);
+    if (!cacheFile.open(QIODevice::WriteOnly))
+    {
+        qDebug() << "Could not write DBC cache file " << fileName;
+        return false;
+    }
+
+    QDataStream out(&cacheFile);
+    out.setVersion(QDataStream::Qt_5_12);
+    out << cacheMagic << cacheVersion << source.canonicalFilePath() << static_cast<qint64>(source.size())
+        << static_cast<qint64>(source.lastModified().toMSecsSinceEpoch())
+        << static_cast<qint32>(numMsgFaults) << static_cast<qint32>(numSigFaults);
+
+    QHash<const DBC_NODE *, qint32> nodeIdx;
+    out << static_cast<qint32>(file->dbc_nodes.count());
+    for (int i = 0; i < file->dbc_nodes.count(); i++)
+    {
+        const DBC_NODE &node = file->dbc_nodes.at(i);
+        nodeIdx.insert(&node, i);
+        out << node.name << node.comment << node.sourceFileName;
+        writeAttrValues(out, node.attributes);
+    }
+
+    out << static_cast<qint32>(file->dbc_attributes.count());
+    for (const DBC_ATTRIBUTE &attr : qAsConst(file->dbc_attributes))
+    {
+        out << attr.name << static_cast<qint32>(attr.valType) << static_cast<qint32>(attr.attrType) << attr.upper
+            << attr.lower << attr.enumVals << attr.defaultValue;
+    }
+
+    DBCMessageHandler *handler = file->messageHandler;
+    out << static_cast<qint32>(handler->getCount());
+    for (int m = 0; m < handler->getCount(); m++)
+    {
+        DBC_MESSAGE *msg = handler->findMsgByIdx(m);
+        DBCSignalHandler *sigs = msg->sigHandler;
+        QHash<const DBC_SIGNAL *, qint32> sigIdx;
+        for (int s = 0; s < sigs->getCount(); s++) sigIdx.insert(sigs->findSignalByIdx(s), s);
+
+        out << msg->ID << msg->extendedID << msg->name << msg->comment << static_cast<quint32>(msg->len)
+            << nodeIdx.value(msg->sender, -1);
+        writeAttrValues(out, msg->attributes);
+        out << sigIdx.value(msg->multiplexorSignal, -1) << static_cast<qint32>(sigs->getCount());
+
+        for (int s = 0; s < sigs->getCount(); s++)
+        {
+            const DBC_SIGNAL *sig = sigs->findSignalByIdx(s);
+            out << sig->name << static_cast<qint32>(sig->startBit) << static_cast<qint32>(sig->signalSize)
+                << sig->intelByteOrder << static_cast<qint32>(sig->valType);
+            out << sig->factor << sig->bias << sig->min << sig->max << nodeIdx.value(sig->receiver, -1)
+                << sig->unitName << sig->comment;
+            out << sig->isMultiplexor << sig->isMultiplexed << sig->hasExtendedMultiplexing << sig->multiplexLowAndHighValues;
+            writeAttrValues(out, sig->attributes);
+            out << static_cast<qint32>(sig->valList.count());
+            for (const DBC_VAL_ENUM_ENTRY &val : sig->valList) out << static_cast<qint32>(val.value) << val.descript;
+        }
+
+        for (int s = 0; s < sigs->getCount(); s++)
+        {
+            const DBC_SIGNAL *sig = sigs->findSignalByIdx(s);
+            QVector<qint32> children;
+            for (const DBC_SIGNAL *child : sig->multiplexedChildren) children.append(sigIdx.value(child, -1));
+            out << sigIdx.value(sig->multiplexParent, -1) << children;
+        }
+    }
+
+    if (out.status() != QDataStream::Ok || !cacheFile.commit())
+    {
+        qDebug() << "Could not write DBC cache file " << fileName;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,27 @@
+#ifndef DBCCACHE_H
+#define DBCCACHE_H
+
+#include <QString>
+
+class DBCFile;
+
+/*
+ * Binary cache of parsed DBC files. After a DBC has gone through the text parser the resulting nodes, attributes,
+ * messages, signals, value tables and multiplexing links are written to a cache file keyed by the canonical path,
+ * size and modification time of the source. The next load of an unchanged file maps the cache file and reads it
+ * back instead of parsing the text again. Pointers between the objects are stored as indexes.
+ *
+ * Cache files live in the application's cache directory. Anything that doesn't match (other version, changed
+ * source, damaged cache) is a miss and the caller falls back to parsing the text.
+ */
+class DBCCache
+{
+public:
+    static bool load(const QString &sourcePath, DBCFile *file, int &numMsgFaults, int &numSigFaults);
+    static bool store(const QString &sourcePath, DBCFile *file, int numMsgFaults, int numSigFaults);
+
+private:
+    static QString cacheFileName(const QString &canonicalPath);
+};
+
+#endif // DBCCACHE_H
@@ -1,7 +1,6 @@
 #include "dbchandler.h"
 
 #include <QFile>
-#include <QRegularExpression>
 #include <QDebug>
 #include <QMessageBox>
 #include <QFileDialog>
@@ -11,10 +10,20 @@
 #include <QJsonDocument>
 #include <QJsonArray>
 #include <QJsonObject>
+#include <QProgressDialog>
+#include <QEventLoop>
+#include <QFutureWatcher>
+#include <QTimer>
+#include <QThread>
+#include <QtConcurrent/QtConcurrentRun>
+#include "dbccache.h"
+#include "dbcparser.h"
+#include "dbcsnapshot.h"
 #include "utility.h"
 #include "connections/canconmanager.h"
 
 DBCHandler* DBCHandler::instance = nullptr;
+QAtomicInteger<quint32> DBCHandler::lookupGeneration(0);
 
 DBC_SIGNAL* DBCSignalHandler::findSignalByIdx(int idx)
 {
@@ -97,49 +106,81 @@ void DBCSignalHandler::sort()
     std::sort(sigs.begin(), sigs.end());
 }
 
+/*
+ * An exact ID match always wins. Otherwise, in J1939 or GMLAN mode, the last message in the list that matches
+ * the PGN or arbitration ID is returned. The tables are built so that they give the same answer a scan of the
+ * whole message list would.
+ */
 DBC_MESSAGE* DBCMessageHandler::findMsgByID(uint32_t id)
 {
     if (messages.count() == 0) return nullptr;
-    DBC_MESSAGE *bestMatch = nullptr;
+    if (!indexValid) buildIndex();
 
-    for (int i = 0; i < messages.count(); i++)
+    auto exact = exactIndex.constFind(id);
+    if (exact != exactIndex.constEnd()) return &messages[exact.value()];
+
+    if (matchingCriteria == J1939)
     {
-        if ( messages[i].ID == id )
+        // include data page and extended data page in the pgn
+        uint32_t pgn = (id & 0x3FFFF00) >> 8;
+        if ( (pgn & 0xFF00) <= 0xEF00 )
         {
-            return &messages[i];
+            // PDU1 format
+            auto it = j1939PDU1Index.constFind(id & 0x3FF0000);
+            if (it != j1939PDU1Index.constEnd()) return &messages[it.value()];
         }
-
-        if (matchingCriteria == J1939)
+        else
         {
-            // include data page and extended data page in the pgn
-            uint32_t pgn = (id & 0x3FFFF00) >> 8;
-            if ( (pgn & 0xFF00) <= 0xEF00 )
-            {
-                // PDU1 format
-                pgn &= 0x3FF00;
-                if ((messages[i].ID & 0x3FF0000) == (pgn << 8))
-                {
-                    bestMatch = &messages[i];
-                }
-            }
-            else
-            {
-                // PDU2 format
-                if ((messages[i].ID & 0x3FFFF00) == (pgn << 8))
-                {
-                    bestMatch = &messages[i];
-                }
-            }
+            // PDU2 format
+            auto it = j1939PDU2Index.constFind(id & 0x3FFFF00);
+            if (it != j1939PDU2Index.constEnd()) return &messages[it.value()];
         }
-        else if (matchingCriteria == GMLAN)
+    }
+    else if (matchingCriteria == GMLAN)
+    {
+        // Match the bits 14-26 (Arbitration Id) of GMLAN 29bit header
+        uint32_t arbId = id & 0x3FFE000;
+        if (arbId != 0)
         {
-            // Match the bits 14-26 (Arbitration Id) of GMLAN 29bit header
-            uint32_t arbId = id &0x3FFE000;
-            if ( (arbId != 0) && (messages[i].ID & 0x3FFE000) == arbId )
-                bestMatch = &messages[i];
+            auto it = gmlanIndex.constFind(arbId);
+            if (it != gmlanIndex.constEnd()) return &messages[it.value()];
         }
     }
-    return bestMatch;
+    return nullptr;
+}
+
+void DBCMessageHandler::buildIndex()
+{
+    exactIndex.clear();
+    j1939PDU1Index.clear();
+    j1939PDU2Index.clear();
+    gmlanIndex.clear();
+    exactIndex.reserve(messages.count());
+    for (int i = 0; i < messages.count(); i++) indexMessage(i);
+    indexValid = true;
+}
+
+void DBCMessageHandler::indexMessage(int idx)
+{
+    uint32_t id = messages[idx].ID;
+    if (!exactIndex.contains(id)) exactIndex.insert(id, idx);
+
+    //later messages replace earlier ones here, same as the old linear search did
+    if (matchingCriteria == J1939)
+    {
+        j1939PDU1Index.insert(id & 0x3FF0000, idx);
+        j1939PDU2Index.insert(id & 0x3FFFF00, idx);
+    }
+    else if (matchingCriteria == GMLAN)
+    {
+        gmlanIndex.insert(id & 0x3FFE000, idx);
+    }
+}
+
+void DBCMessageHandler::invalidateIndex()
+{
+    indexValid = false;
+    DBCHandler::invalidateLookupCache();
 }
 
 DBC_MESSAGE* DBCMessageHandler::findMsgByIdx(int idx)
@@ -198,6 +239,8 @@ QList<DBC_MESSAGE*> DBCMessageHandler::findMsgsByNode(DBC_NODE* node)
 bool DBCMessageHandler::addMessage(DBC_MESSAGE &msg)
 {
     messages.append(msg);
+    if (indexValid) indexMessage(messages.count() - 1);
+    DBCHandler::invalidateLookupCache();
     return true;
 }
 
@@ -213,6 +256,7 @@ bool DBCMessageHandler::removeMessage(DBC_MESSAGE *msg)
             break;
         }
     }
+    invalidateIndex();
     return true;
 }
 
@@ -222,6 +266,7 @@ bool DBCMessageHandler::removeMessageByIndex(int idx)
     if (idx < 0) return false;
     if (idx >= messages.count()) return false;
     messages.removeAt(idx);
+    invalidateIndex();
     return true;
 }
 
@@ -237,6 +282,7 @@ bool DBCMessageHandler::removeMessage(uint32_t ID)
             foundSome = true;
         }
     }
+    if (foundSome) invalidateIndex();
     return foundSome;
 }
 
@@ -252,12 +298,14 @@ bool DBCMessageHandler::removeMessage(QString name)
             foundSome = true;
         }
     }
+    if (foundSome) invalidateIndex();
     return foundSome;
 }
 
 void DBCMessageHandler::removeAllMessages()
 {
     messages.clear();
+    invalidateIndex();
 }
 
 int DBCMessageHandler::getCount()
@@ -272,6 +320,7 @@ void DBCMessageHandler::sort()
     {
         messages[i].sigHandler->sort();
     }
+    invalidateIndex();
 }
 
 bool DBCMessageHandler::filterLabeling()
@@ -292,6 +341,7 @@ MatchingCriteria_t DBCMessageHandler::getMatchingCriteria()
 void DBCMessageHandler::setMatchingCriteria(MatchingCriteria_t _matchingCriteria)
 {
     matchingCriteria = _matchingCriteria;
+    invalidateIndex();
 }
 
 DBCFile::DBCFile()
@@ -414,6 +464,7 @@ void DBCFile::setAssocBus(int bus)
     //int numBuses = CANConManager::getInstance()->getNumBuses();
     //if (bus >= numBuses) return;
     assocBuses = bus;
+    DBCHandler::invalidateLookupCache();
 }
 
 DBC_ATTRIBUTE *DBCFile::findAttributeByName(QString name, DBC_ATTRIBUTE_TYPE type)
@@ -446,9 +497,11 @@ void DBCFile::findAttributesByType(DBC_ATTRIBUTE_TYPE typ, QList<DBC_ATTRIBUTE>
     }
 }
 
+//anything that marks the file dirty may have changed message IDs so the lookup tables have to go too
 void DBCFile::setDirtyFlag()
 {
     isDirty = true;
+    messageHandler->invalidateIndex();
 }
 
 //BE CAREFUL HERE. Do not clear the dirty flag unless you're absolutely sure nothing has changed.
@@ -466,668 +519,78 @@ bool DBCFile::getDirtyFlag()
     return isDirty;
 }
 
-DBC_MESSAGE* DBCFile::parseMessageLine(QString line)
-{
-    QRegularExpression regex;
-    QRegularExpressionMatch match;
-
-    DBC_MESSAGE *msgPtr;
-
-    qDebug() << "Found a BO line";
-    regex.setPattern("^BO\\_ (\\w+) ([-\\w]+) *: (\\w+) ([-\\w]+)");
-    match = regex.match(line);
-    //captured 1 = the ID in decimal
-    //captured 2 = The message name
-    //captured 3 = the message length
-    //captured 4 = the NODE responsible for this message
-    if (match.hasMatch())
-    {
-        DBC_MESSAGE msg;
-        uint32_t ID = match.captured(1).toULong(); //the ID is always stored in decimal format
-        msg.ID = ID & 0x1FFFFFFFul;
-        msg.extendedID = (ID & 0x80000000ul) ? true : false;
-        msg.name = match.captured(2);
-        msg.len = match.captured(3).toUInt();
-        msg.sender = findNodeByName(match.captured(4));
-        if (!msg.sender) msg.sender = findNodeByIdx(0);
-        messageHandler->addMessage(msg);
-        msgPtr = messageHandler->findMsgByID(msg.ID);
-    }
-    else msgPtr = nullptr;
-    return msgPtr;
-}
-
-DBC_SIGNAL* DBCFile::parseSignalLine(QString line, DBC_MESSAGE *msg)
-{
-    QRegularExpression regex;
-    QRegularExpressionMatch match;
-
-    int offset = 0;
-    bool isMessageMultiplexor = false;
-    //bool isMultiplexed = false;
-    DBC_SIGNAL sig;
-
-    qDebug() << "Found a SG line";
-    regex.setPattern("^SG\\_ *([-\\w]+) +M *: *(\\d+)\\|(\\d+)@(\\d+)([\\+|\\-]) \\(([0-9.+\\-eE]+),([0-9.+\\-eE]+)\\) \\[([0-9.+\\-eE]+)\\|([0-9.+\\-eE]+)\\] \\\"(.*)\\\" (.*)");
-
-    match = regex.match(line);
-    if (match.hasMatch())
-    {
-        qDebug() << "Multiplexor signal";
-        isMessageMultiplexor = true;
-        sig.isMultiplexor = true;
-    }
-    else
-    {
-        regex.setPattern("^SG\\_ *([-\\w]+) +m(\\d+) *: *(\\d+)\\|(\\d+)@(\\d+)([\\+|\\-]) \\(([0-9.+\\-eE]+),([0-9.+\\-eE]+)\\) \\[([0-9.+\\-eE]+)\\|([0-9.+\\-eE]+)\\] \\\"(.*)\\\" (.*)");
-        match = regex.match(line);
-        if (match.hasMatch())
-        {
-            qDebug() << "Multiplexed signal";
-            sig.addMultiplexRange(match.captured(2).toInt(), match.captured(2).toInt());
-            offset = 1;
-        }
-        else
-        {
-            regex.setPattern("^SG\\_ *([-\\w]+) +m(\\d+)M *: *(\\d+)\\|(\\d+)@(\\d+)([\\+|\\-]) \\(([0-9.+\\-eE]+),([0-9.+\\-eE]+)\\) \\[([0-9.+\\-eE]+)\\|([0-9.+\\-eE]+)\\] \\\"(.*)\\\" (.*)");
-            match = regex.match(line);
-            if (match.hasMatch())
-            {
-                qDebug() << "Extended Multiplexor Signal";
-                sig.isMultiplexor = true; //we don't set the local isMessageMultiplexor variable because this isn't the top level multiplexor
-                sig.addMultiplexRange(match.captured(2).toInt(), match.captured(2).toInt());
-                offset = 1;
-            }
-            else
-            {
-                qDebug() << "standard signal";
-                regex.setPattern("^SG\\_ *([-\\w]+) *: *(\\d+)\\|(\\d+)@(\\d+)([\\+|\\-]) \\(([0-9.+\\-eE]+),([0-9.+\\-eE]+)\\) \\[([0-9.+\\-eE]+)\\|([0-9.+\\-eE]+)\\] \\\"(.*)\\\" (.*)");
-                match = regex.match(line);
-                sig.isMultiplexed = false;
-                sig.isMultiplexor = false;
-            }
-        }
-    }
-
-    //captured 1 is the signal name
-    //captured 2 would be multiplex value if this is a multiplex signal. Then offset the rest of these by 1
-    //captured 2 is the starting bit
-    //captured 3 is the length in bits
-    //captured 4 is the byte order / value type
-    //captured 5 specifies signed/unsigned for ints
-    //captured 6 is the scaling factor
-    //captured 7 is the offset
-    //captured 8 is the minimum value
-    //captured 9 is the maximum value
-    //captured 10 is the unit
-    //captured 11 is the receiving node
-
-    if (match.hasMatch())
-    {
-        sig.name = match.captured(1);
-        sig.startBit = match.captured(2 + offset).toInt();
-        sig.signalSize = match.captured(3 + offset).toInt();
-        int val = match.captured(4 + offset).toInt();
-        if (val < 2)
-        {
-            if (match.captured(5 + offset) == "+") sig.valType = UNSIGNED_INT;
-            else sig.valType = SIGNED_INT;
-        }
-        switch (val)
-        {
-        case 0: //big endian mode
-            sig.intelByteOrder = false;
-            break;
-        case 1: //little endian mode
-            sig.intelByteOrder = true;
-            break;
-        case 2:
-            sig.valType = SP_FLOAT;
-            break;
-        case 3:
-            sig.valType = DP_FLOAT;
-            break;
-        case 4:
-            sig.valType = STRING;
-            break;
-        case 5: //single point float in little endian
-            sig.valType = SP_FLOAT;
-            sig.intelByteOrder = true;
-            break;
-        case 6: //double point float in little endian
-            sig.valType = DP_FLOAT;
-            sig.intelByteOrder = true;
-            break;
-        }
-        sig.factor = match.captured(6 + offset).toDouble();
-        sig.bias = match.captured(7 + offset).toDouble();
-        sig.min = match.captured(8 + offset).toDouble();
-        sig.max = match.captured(9 + offset).toDouble();
-        sig.unitName = match.captured(10 + offset);
-        if (match.captured(11 + offset).contains(','))
-        {
-            QString tmp = match.captured(11 + offset).split(',')[0];
-            sig.receiver = findNodeByName(tmp);            
-        }
-        else sig.receiver = findNodeByName(match.captured(11 + offset));
-
-        if (!sig.receiver) sig.receiver = findNodeByIdx(0); //apply default if there was no match
-
-        sig.parentMessage = msg;
-        if (msg)
-        {
-            msg->sigHandler->addSignal(sig);
-            if (isMessageMultiplexor) msg->multiplexorSignal = msg->sigHandler->findSignalByName(sig.name);
-            return msg->sigHandler->findSignalByName(sig.name);
-        }
-        else return nullptr;
-    }
-
-    return nullptr;
-}
-
-//SG_MUL_VAL_ 2024 S1_PID_0D_VehicleSpeed S1 13-13;
-bool DBCFile::parseSignalMultiplexValueLine(QString line)
-{
-    QRegularExpression regex;
-    QRegularExpressionMatch match;
-
-    qDebug() << "Found a multiplex definition line";
-    regex.setPattern("^SG\\_MUL\\_VAL\\_ (\\d+) ([-\\w]+) ([-\\w]+) ((?:\\d+\\-\\d+[\\s]*[\\,]?[\\s]*)*)");
-    match = regex.match(line);
-    //captured 1 is message ID
-    //Captured 2 is signal name
-    //Captured 3 is parent multiplexor
-    //captured 4 is the lower bound
-    //captured 5 is the upper bound
-    if (match.hasMatch())
-    {
-        DBC_MESSAGE *msg = messageHandler->findMsgByID(match.captured(1).toULong() & 0x1FFFFFFFUL);
-        if (msg != nullptr)
-        {
-            DBC_SIGNAL *thisSignal = msg->sigHandler->findSignalByName(match.captured(2));
-            if (thisSignal != nullptr)
-            {
-                DBC_SIGNAL *parentSignal = msg->sigHandler->findSignalByName(match.captured(3));
-                if (parentSignal != nullptr)
-                {
-                    const QStringList ranges = match.captured(4).split(QChar(','), Qt::SkipEmptyParts);
-                    for (const QString &range : ranges) {
-                        //now need to add "thisSignal" to the children multiplexed signals of "parentSignal"
-                        const QStringList rangeSides = range.trimmed().split(QChar('-'));
-                        if (rangeSides.count() != 2) {
-                            qDebug() << QString("Malformed range definition: '%2' found in the multiplexed signal: %1")
-                                            .arg(match.captured(1).arg(range.trimmed()));
-                            return false;
-                        }
-                        int rangeMin = rangeSides.at(0).toInt();
-                        int rangeMax = rangeSides.at(1).toInt();
-                        thisSignal->multiplexParent = parentSignal;
-                        thisSignal->addMultiplexRange(rangeMin, rangeMax);
-                    }
-                    parentSignal->multiplexedChildren.append(thisSignal);
-                    return true;
-                }
-            }
-        }
-    }
-    return false;
-}
-
-bool DBCFile::parseSignalValueTypeLine(QString line)
-{
-    QRegularExpression regex;
-    QRegularExpressionMatch match;
-    qDebug() << "Found a signal valtype line";
-    regex.setPattern("^SIG\\_VALTYPE\\_ *(\\d+) *([-\\w]+) *: *(\\d+);");
-    match = regex.match(line);
-
-    // captured 1 is the message id
-    // captured 2 is the signal name
-    // captured 3 is the valtype
-    if (!match.hasMatch()) { return false; }
-    uint32_t id = match.captured(1).toULong() & 0x1FFFFFFFUL;
-
-    DBC_MESSAGE *msg = messageHandler->findMsgByID(match.captured(1).toULong() & 0x1FFFFFFFUL);
-    if (msg == nullptr) { return false; }
-
-    DBC_SIGNAL *thisSignal = msg->sigHandler->findSignalByName(match.captured(2));
-    if (thisSignal == nullptr) { return false; }
-    int valType = match.captured(3).toInt();
-
-    switch (valType) {
-        case 1: {
-            thisSignal->valType = SP_FLOAT;
-            break;
-        }
-        case 2: {
-            thisSignal->valType = DP_FLOAT;
-            break;
-        }
-        default: {
-            return false;
-        }
-    }
-    return true;
-}
-
-
-bool DBCFile::parseValueLine(QString line)
-{
-    QRegularExpression regex;
-    QRegularExpressionMatch match;
-
-    qDebug() << "Found a value definition line";
-    regex.setPattern("^VAL\\_ (\\w+) ([-\\w]+) (.*);");
-    match = regex.match(line);
-    //captured 1 is the ID to match against
-    //captured 2 is the signal name to match against
-    //captured 3 is a series of values in the form (number "text") that is, all sep'd by spaces
-    if (match.hasMatch())
-    {
-        //qDebug() << "Data was: " << match.captured(3);
-        DBC_MESSAGE *msg = messageHandler->findMsgByID(match.captured(1).toULong() & 0x1FFFFFFFul);
-        if (msg != nullptr)
-        {
-            DBC_SIGNAL *sig = msg->sigHandler->findSignalByName(match.captured(2));
-            if (sig != nullptr)
-            {
-                QString tokenString = match.captured(3);
-                DBC_VAL_ENUM_ENTRY val;
-                while (tokenString.length() > 2)
-                {
-                    regex.setPattern("(\\d+) \\\"(.*?)\\\"(.*)");
-                    match = regex.match(tokenString);
-                    if (match.hasMatch())
-                    {
-                        val.value = match.captured(1).toULong() & 0x1FFFFFFFul;
-                        val.descript = match.captured(2);
-                        //qDebug() << "sig val " << val.value << " desc " <<val.descript;
-                        sig->valList.append(val);
-                        int rightSize = tokenString.length() - match.captured(1).length() - match.captured(2).length() - 4;
-                        if (rightSize > 0) tokenString = tokenString.right(rightSize);
-                        else tokenString = "";
-                        //qDebug() << "New token string: " << tokenString;
-                    }
-                    else tokenString = "";
-                }
-                return true;
-            }
-        }
-    }
-    return false;
-}
-
-bool DBCFile::parseAttributeLine(QString line)
-{
-    QRegularExpression regex;
-    QRegularExpressionMatch match;
-
-    regex.setPattern("^BA\\_ \\\"*([-\\w]+)\\\"* BO\\_ (\\d+) \\\"*([#\\w]+)\\\"*");
-    match = regex.match(line);
-    //captured 1 is the attribute name
-    //captured 2 is the message ID number (frame ID)
-    //captured 3 is the attribute value
-    if (match.hasMatch())
-    {
-        qDebug() << "Found an attribute setting line for a message";
-        DBC_ATTRIBUTE *foundAttr = findAttributeByName(match.captured(1));
-        if (foundAttr)
-        {
-            qDebug() << "That message attribute does exist";
-            DBC_MESSAGE *foundMsg = messageHandler->findMsgByID(match.captured(2).toULong() & 0x1FFFFFFFul);
-            if (foundMsg)
-            {
-                qDebug() << "It references a valid, registered message";
-                DBC_ATTRIBUTE_VALUE *foundAttrVal = foundMsg->findAttrValByName(match.captured(1));
-                if (foundAttrVal) {
-                    foundAttrVal->value = processAttributeVal(match.captured(3), foundAttr->valType);
-                }
-                else
-                {
-                    DBC_ATTRIBUTE_VALUE val;
-                    val.attrName = match.captured(1);
-                    val.value = processAttributeVal(match.captured(3), foundAttr->valType);
-                    foundMsg->attributes.append(val);
-                }
-            }
-        }
-    }
-
-    regex.setPattern("^BA\\_ \\\"*([-\\w]+)\\\"* SG\\_ (\\d+) \\\"*([-\\w]+)\\\"* \\\"*([#\\w]+)\\\"*");
-    match = regex.match(line);
-    //captured 1 is the attribute name
-    //captured 2 is the message ID number (frame ID)
-    //captured 3 is the signal name to bind to
-    //captured 4 is the attribute value
-    if (match.hasMatch())
-    {
-        qDebug() << "Found an attribute setting line for a signal";
-        DBC_ATTRIBUTE *foundAttr = findAttributeByName(match.captured(1));
-        if (foundAttr)
-        {
-            qDebug() << "That signal attribute does exist";
-            DBC_MESSAGE *foundMsg = messageHandler->findMsgByID(match.captured(2).toULong() & 0x1FFFFFFFUL);
-            if (foundMsg)
-            {
-                qDebug() << "It references a valid, registered message";
-                DBC_SIGNAL *foundSig = foundMsg->sigHandler->findSignalByName(match.captured(3));
-                if (foundSig)
-                {
-                    DBC_ATTRIBUTE_VALUE *foundAttrVal = foundSig->findAttrValByName(match.captured(1));
-                    if (foundAttrVal) foundAttrVal->value = processAttributeVal(match.captured(3), foundAttr->valType);
-                    else
-                    {
-                        DBC_ATTRIBUTE_VALUE val;
-                        val.attrName = match.captured(1);
-                        val.value = processAttributeVal(match.captured(3), foundAttr->valType);
-                        foundSig->attributes.append(val);
-                    }
-                }
-            }
-        }
-    }
-
-    regex.setPattern("^BA\\_ \\\"*([-\\w]+)\\\"* BU\\_ \\\"*([-\\w]+)\\\"* \\\"*([#\\w]+)\\\"*");
-    match = regex.match(line);
-    //captured 1 is the attribute name
-    //captured 2 is the name of the node
-    //captured 3 is the attribute value
-    if (match.hasMatch())
-    {
-        qDebug() << "Found an attribute setting line for a node";
-        DBC_ATTRIBUTE *foundAttr = findAttributeByName(match.captured(1));
-        if (foundAttr)
-        {
-            qDebug() << "That node attribute does exist";
-            DBC_NODE *foundNode = findNodeByName(match.captured(2));
-            if (foundNode)
-            {
-                qDebug() << "References a valid node name";
-                DBC_ATTRIBUTE_VALUE *foundAttrVal = foundNode->findAttrValByName(match.captured(1));
-                if (foundAttrVal) foundAttrVal->value = processAttributeVal(match.captured(3), foundAttr->valType);
-                else
-                {
-                    DBC_ATTRIBUTE_VALUE val;
-                    val.attrName = match.captured(1);
-                    val.value = processAttributeVal(match.captured(3), foundAttr->valType);
-                    foundNode->attributes.append(val);
-                }
-            }
-            return true;
-        }
-    }
-
-    return false;
-}
-
-bool DBCFile::parseDefaultAttrLine(QString line)
-{
-    QRegularExpression regex;
-    QRegularExpressionMatch match;
-
-    regex.setPattern("^BA\\_DEF\\_DEF\\_ \\\"*([-\\w]+)\\\"* \\\"*([#\\w]*)\\\"*");
-    match = regex.match(line);
-    //captured 1 is the name of the attribute
-    //captured 2 is the default value for that attribute
-    if (match.hasMatch())
-    {
-        qDebug() << "Found an attribute default value line, searching for an attribute named " << match.captured(1) << "with data " << match.captured(2);
-        DBC_ATTRIBUTE *found = findAttributeByName(match.captured(1));
-        if (found)
-        {
-            switch (found->valType)
-            {
-            case ATTR_STRING:
-                found->defaultValue = match.captured(2);
-                break;
-            case ATTR_FLOAT:
-                found->defaultValue = match.captured(2).toFloat();
-                break;
-            case ATTR_INT:
-                found->defaultValue = match.captured(2).toInt();
-                break;
-            case ATTR_ENUM:
-                QString temp = match.captured(2);
-                found->defaultValue = 0;
-                for (int x = 0; x < found->enumVals.count(); x++)
-                {
-                    if (!found->enumVals[x].compare(temp, Qt::CaseInsensitive))
-                    {
-                        found->defaultValue = x;
-                        break;
-                    }
-                }
-            }
-            qDebug() << "Matched an attribute. Setting default value to " << found->defaultValue;
-            return true;
-        }
-    }
-    return false;
-}
-
 bool DBCFile::loadFile(QString fileName)
 {
-    QFile *inFile = new QFile(fileName);
-    QString line, rawLine;
-    QRegularExpression regex;
-    QRegularExpressionMatch match;
-    DBC_MESSAGE *currentMessage = nullptr;
     DBC_ATTRIBUTE attr;
-    int numSigFaults = 0, numMsgFaults = 0;
-    int linesSinceYield = 0;
     QString fileBaseName = QFileInfo(fileName).baseName();
-
-    bool inMultilineBU = false;
+    int numSigFaults = 0, numMsgFaults = 0;
 
     qDebug() << "DBC File: " << fileName;
 
-    if (!inFile->open(QIODevice::ReadOnly | QIODevice::Text))
+    //an unchanged file that was parsed before comes straight out of the cache
+    if (!DBCCache::load(fileName, this, numMsgFaults, numSigFaults))
     {
-        delete inFile;
-        qDebug() << "Could not load the file!";
-        return false;
-    }
-
-    qDebug() << "Starting DBC load";
-    dbc_nodes.clear();
-    messageHandler->removeAllMessages();
-    messageHandler->setMatchingCriteria(EXACT);
-    messageHandler->setFilterLabeling(false);
-
-    DBC_NODE falseNode;
-    falseNode.name = "Vector__XXX";
-    falseNode.comment = "Default node if none specified";
-    dbc_nodes.append(falseNode);
-
-    while (!inFile->atEnd()) {
-        rawLine = QString(inFile->readLine());
-        line = rawLine.simplified();
-
-        linesSinceYield++;
-        if (linesSinceYield > 100)
+        QFile inFile(fileName);
+        if (!inFile.open(QIODevice::ReadOnly | QIODevice::Text))
         {
-            qApp->processEvents();
+            qDebug() << "Could not load the file!";
+            return false;
         }
+        QByteArray text = inFile.readAll();
+        inFile.close();
+
+        qDebug() << "Starting DBC load";
+        dbc_nodes.clear();
+        dbc_attributes.clear();
+        messageHandler->removeAllMessages();
+        messageHandler->setMatchingCriteria(EXACT);
+        messageHandler->setFilterLabeling(false);
+
+        DBC_NODE falseNode;
+        falseNode.name = "Vector__XXX";
+        falseNode.comment = "Default node if none specified";
+        dbc_nodes.append(falseNode);
 
-        if (inMultilineBU)
+        DBCParser parser(this, fileBaseName);
+        bool parsed;
+        if (QThread::currentThread() == qApp->thread())
         {
-            if (rawLine.startsWith("\t") || rawLine.startsWith("   "))
-            {
-                DBC_NODE node;
-                node.sourceFileName = fileBaseName;
-                node.name = line;
-                dbc_nodes.append(node);
-            }
-            else inMultilineBU = false;
+            //parse on the thread pool so the GUI stays responsive, the user can see how far along it is and bail out.
+            //The dialog is application modal so nothing can load or remove DBC files while this one is parsed
+            QProgressDialog progress(qApp->activeWindow());
+            progress.setWindowModality(Qt::ApplicationModal);
+            progress.setLabelText("Loading " + QFileInfo(fileName).fileName() + "...");
+            progress.setRange(0, 100);
+            progress.setMinimumDuration(500);
+            progress.setAutoClose(false);
+            progress.setAutoReset(false);
+
+            QFutureWatcher<bool> watcher;
+            QEventLoop waitLoop;
+            QTimer progressTimer;
+            progressTimer.setInterval(50);
+            QObject::connect(&watcher, &QFutureWatcher<bool>::finished, &waitLoop, &QEventLoop::quit);
+            QObject::connect(&progress, &QProgressDialog::canceled, [&parser]() { parser.cancel(); });
+            QObject::connect(&progressTimer, &QTimer::timeout, [&progress, &parser]() { progress.setValue(parser.progress()); });
+
+            watcher.setFuture(QtConcurrent::run([&parser, &text]() { return parser.parse(text); }));
+            progressTimer.start();
+            if (!watcher.isFinished()) waitLoop.exec();
+            progressTimer.stop();
+            watcher.waitForFinished();
+            progress.reset();
+            parsed = watcher.result();
         }
+        else parsed = parser.parse(text);
 
-        if (!inMultilineBU)
+        if (!parsed)
         {
-            if (line.startsWith("BO_ ")) //defines a message
-            {
-                currentMessage = parseMessageLine(line);
-                if (currentMessage == nullptr) numMsgFaults++;
-            }
-            if (line.startsWith("SG_ ")) //defines a signal
-            {
-                if (!parseSignalLine(line, currentMessage)) numSigFaults++;
-            }
-
-            if (line.startsWith("SG_MUL_VAL_ ")) //defines a signal multiplexing value definition
-            {
-                if (!parseSignalMultiplexValueLine(line)) numSigFaults++;
-            }
-
-            if (line.startsWith("SIG_VALTYPE_ ")) //defines a signal value type
-            {
-                if (!parseSignalValueTypeLine(line)) numSigFaults++;
-            }
-
-            if (line.startsWith("BU_:")) //line specifies the nodes on this canbus
-            {
-                qDebug() << "Found a BU line";
-                regex.setPattern("^BU\\_\\:(.*)");
-                match = regex.match(line);
-                //captured 1 = a list of node names separated by spaces. No idea how many yet
-                if (match.hasMatch())
-                {
-                    QStringList nodeStrings = match.captured(1).split(' ');
-                    qDebug() << "Found " << nodeStrings.count() << " node names";
-                    for (int i = 0; i < nodeStrings.count(); i++)
-                    {
-                        //qDebug() << nodeStrings[i];
-                        if (nodeStrings[i].length() > 1)
-                        {
-                            DBC_NODE node;
-                            node.sourceFileName = fileBaseName;
-                            node.name = nodeStrings[i];
-                            dbc_nodes.append(node);
-                        }
-                    }
-                    inMultilineBU = true; //we might be... Need to check next line.
-                }
-            }
-            if (line.startsWith("CM_ SG_ "))
-            {
-                qDebug() << "Found an SG comment line";
-                regex.setPattern("^CM\\_ SG\\_ *(\\w+) *([-\\w]+) *\\\"(.*)\\\";");
-                match = regex.match(line);
-                //captured 1 is the ID to match against to get to the message
-                //captured 2 is the signal name from that message
-                //captured 3 is the comment itself
-                if (match.hasMatch())
-                {
-                    //qDebug() << "Comment was: " << match.captured(3);
-                    DBC_MESSAGE *msg = messageHandler->findMsgByID(match.captured(1).toULong() & 0x1FFFFFFFul);
-                    if (msg != nullptr)
-                    {
-                        DBC_SIGNAL *sig = msg->sigHandler->findSignalByName(match.captured(2));
-                        if (sig != nullptr)
-                        {
-                            sig->comment = match.captured(3);
-                        }
-                    }
-                }
-            }
-            if (line.startsWith("CM_ BO_ "))
-            {
-                qDebug() << "Found a BO comment line";
-                regex.setPattern("^CM\\_ BO\\_ *(\\w+) *\\\"(.*)\\\";");
-                match = regex.match(line);
-                //captured 1 is the ID to match against to get to the message
-                //captured 2 is the comment itself
-                if (match.hasMatch())
-                {
-                    //qDebug() << "Comment was: " << match.captured(2);
-                    DBC_MESSAGE *msg = messageHandler->findMsgByID(match.captured(1).toULong() & 0x1FFFFFFFul);
-                    if (msg != nullptr)
-                    {
-                        msg->comment = match.captured(2);
-                    }
-                }
-            }
-            if (line.startsWith("CM_ BU_ "))
-            {
-                qDebug() << "Found a BU comment line";
-                regex.setPattern("^CM\\_ BU\\_ *([-\\w]+) *\\\"(.*)\\\";");
-                match = regex.match(line);
-                //captured 1 is the Node name
-                //captured 2 is the comment itself
-                if (match.hasMatch())
-                {
-                    //qDebug() << "Comment was: " << match.captured(2);
-                    DBC_NODE *node = findNodeByName(match.captured(1));
-                    if (node != nullptr)
-                    {
-                        node->comment = match.captured(2);
-                    }
-                }
-            }
-            //VAL_ (1090) (VCUPresentParkLightOC) (1 "Error present" 0 "Error not present") ;
-            if (line.startsWith("VAL_ "))
-            {
-                parseValueLine(line);
-            }
-
-            if (line.startsWith("BA_DEF_ SG_ "))
-            {
-                qDebug() << "Found a SG attribute line";
-
-                if (parseAttribute(line.right(line.length() - 12), attr))
-                {
-                    //qDebug() << "Success";
-                    attr.attrType = ATTR_TYPE_SIG;
-                    dbc_attributes.append(attr);
-                }
-            }
-            else if (line.startsWith("BA_DEF_ BO_ ")) //definition of a message attribute
-            {
-                qDebug() << "Found a BO attribute line";
-
-                if (parseAttribute(line.right(line.length() - 12), attr))
-                {
-                    qDebug() << "Success";
-                    attr.attrType = ATTR_TYPE_MESSAGE;
-                    dbc_attributes.append(attr);
-                }
-            }
-            else if (line.startsWith("BA_DEF_ BU_ ")) //definition of a node attribute
-            {
-                qDebug() << "Found a BU attribute line";
-
-                if (parseAttribute(line.right(line.length() - 12), attr))
-                {
-                    //qDebug() << "Success";
-                    attr.attrType = ATTR_TYPE_NODE;
-                    dbc_attributes.append(attr);
-                }
-            }
-
-            else if (line.startsWith("BA_DEF_ ")) //definition of a root attribute
-            {
-                qDebug() << "Found a BU attribute line";
-
-                if (parseAttribute(line.right(line.length() - 9), attr))
-                {
-                    //qDebug() << "Success";
-                    attr.attrType = ATTR_TYPE_GENERAL;
-                    dbc_attributes.append(attr);
-                }
-            }
-
-
-            if (line.startsWith("BA_DEF_DEF_ ")) //definition of default value for an attribute
-            {
-                parseDefaultAttrLine(line);
-            }
-
-            //BA_ "GenMsgCycleTime" BO_ 101 100;
-            if (line.startsWith("BA_ ")) //set value of attribute
-            {
-                parseAttributeLine(line);
-            }
+            qDebug() << "DBC load canceled";
+            return false;
         }
+        numSigFaults = parser.signalFaults();
+        numMsgFaults = parser.messageFaults();
+        DBCCache::store(fileName, this, numMsgFaults, numSigFaults);
     }
 
     //upon loading the file add our custom foreground and background color attributes if they don't exist already
@@ -1216,8 +679,6 @@ bool DBCFile::loadFile(QString fileName)
         msgBox.setText(msg);
         msgBox.exec();
     }
-    inFile->close();
-    delete inFile;
     QStringList fileList = fileName.split('/');
     this->fileName = fileList[fileList.length() - 1]; //whoops... same name as parameter in this function.
     filePath = fileName.left(fileName.length() - this->fileName.length());
@@ -1245,102 +706,6 @@ QVariant DBCFile::processAttributeVal(QString input, DBC_ATTRIBUTE_VAL_TYPE typ)
     return out;
 }
 
-bool DBCFile::parseAttribute(QString inpString, DBC_ATTRIBUTE &attr)
-{
-    bool goodAttr = false;
-    QRegularExpression regex;
-    QRegularExpressionMatch match;
-
-    regex.setPattern("\\\"*(\\w+)\\\"* \\\"*(\\w+)\\\"* (\\d+) (\\d+)");
-    match = regex.match(inpString);
-    //captured 1 is the name of the attribute to set up
-    //captured 2 is the type of signal attribute to create.
-    //captured 3 is the lower bound value for this attribute
-    //captured 4 is the upper bound value for this attribute
-    if (match.hasMatch())
-    {
-        qDebug() << "Parsing an attribute with low/high values";
-        attr.name = match.captured(1);
-        QString typ = match.captured(2);
-        attr.attrType = ATTR_TYPE_SIG;
-        attr.lower = 0;
-        attr.upper = 0;
-        attr.valType = ATTR_STRING;
-        if (!typ.compare("INT", Qt::CaseInsensitive))
-        {
-            qDebug() << "INT attribute named " << attr.name;
-            attr.valType = ATTR_INT;
-            attr.lower = match.captured(3).toInt();
-            attr.upper = match.captured(4).toInt();
-            goodAttr = true;
-        }
-        if (!typ.compare("FLOAT", Qt::CaseInsensitive))
-        {
-            qDebug() << "FLOAT attribute named " << attr.name;
-            attr.valType = ATTR_FLOAT;
-            attr.lower = match.captured(3).toDouble();
-            attr.upper = match.captured(4).toDouble();
-            goodAttr = true;
-        }
-        if (!typ.compare("STRING", Qt::CaseInsensitive))
-        {
-            qDebug() << "STRING attribute named " << attr.name;
-            attr.valType = ATTR_STRING;
-            goodAttr = true;
-        }
-    }
-    else
-    {
-        regex.setPattern("\\\"*(\\w+)\\\"* \\\"*(\\w+)\\\"* (.*)");
-        match = regex.match(inpString);
-        //Same as above but no upper/lower bound values.
-        if (match.hasMatch())
-        {
-            qDebug() << "Parsing an attribute without boundaries";
-            attr.name = match.captured(1);
-            QString typ = match.captured(2);
-            attr.lower = 0;
-            attr.upper = 0;
-            attr.attrType = ATTR_TYPE_SIG;
-
-            if (!typ.compare("INT", Qt::CaseInsensitive))
-            {
-                qDebug() << "INT attribute named " << attr.name;
-                attr.valType = ATTR_INT;
-                goodAttr = true;
-            }
-
-            if (!typ.compare("FLOAT", Qt::CaseInsensitive))
-            {
-                qDebug() << "FLOAT attribute named " << attr.name;
-                attr.valType = ATTR_FLOAT;
-                goodAttr = true;
-            }
-
-            if (!typ.compare("STRING", Qt::CaseInsensitive))
-            {
-                qDebug() << "STRING attribute named " << attr.name;
-                attr.valType = ATTR_STRING;
-                goodAttr = true;
-            }
-
-            if (!typ.compare("ENUM", Qt::CaseInsensitive))
-            {
-                qDebug() << "ENUM attribute named " << attr.name;
-                QStringList enumLst = match.captured(3).split(',');
-                foreach (QString enumStr, enumLst)
-                {
-                    attr.enumVals.append(Utility::unQuote(enumStr));
-                    qDebug() << "Enum value: " << enumStr;
-                }
-                attr.valType = ATTR_ENUM;
-                goodAttr = true;
-            }
-        }
-    }
-    return goodAttr;
-}
-
 bool DBCFile::saveFile(QString fileName)
 {
     int nodeNumber = 1;
@@ -1782,6 +1147,7 @@ int DBCHandler::createBlankFile()
     newFile.setAssocBus(-1);
 
     loadedFiles.append(newFile);
+    invalidateLookupCache();
     return loadedFiles.count();
 }
 
@@ -1791,6 +1157,7 @@ DBCFile* DBCHandler::loadDBCFile(QString filename)
     if (newFile.loadFile(filename))
     {
         loadedFiles.append(newFile);
+        invalidateLookupCache();
     }
     else
     {
@@ -2174,11 +1541,13 @@ void DBCHandler::removeDBCFile(int idx)
     if (idx < 0) return;
     if (idx >= loadedFiles.count()) return;
     loadedFiles.removeAt(idx);
+    invalidateLookupCache();
 }
 
 void DBCHandler::removeAllFiles()
 {
     loadedFiles.clear();
+    invalidateLookupCache();
 }
 
 void DBCHandler::swapFiles(int pos1, int pos2)
@@ -2190,6 +1559,7 @@ void DBCHandler::swapFiles(int pos1, int pos2)
     if (pos2 >= loadedFiles.count()) return;
 
     loadedFiles.swapItemsAt(pos1, pos2);
+    invalidateLookupCache();
 }
 
 /*
@@ -2200,15 +1570,73 @@ void DBCHandler::swapFiles(int pos1, int pos2)
 */
 DBC_MESSAGE* DBCHandler::findMessage(const CANFrame &frame)
 {
+    if (cacheGeneration != lookupGeneration)
+    {
+        busLookupCache.clear();
+        cacheGeneration = lookupGeneration;
+    }
+
+    quint64 key = (static_cast<quint64>(static_cast<quint32>(frame.bus)) << 32) | frame.frameId();
+    auto cached = busLookupCache.constFind(key);
+    if (cached != busLookupCache.constEnd()) return cached.value();
+
+    DBC_MESSAGE* found = nullptr;
     for(int i = 0; i < loadedFiles.count(); i++)
     {
         if (loadedFiles[i].getAssocBus() == -1 || frame.bus == loadedFiles[i].getAssocBus())
         {
             DBC_MESSAGE* msg = loadedFiles[i].messageHandler->findMsgByID(frame.frameId());
-            if (msg != nullptr) return msg;
+            if (msg != nullptr)
+            {
+                found = msg;
+                break;
+            }
         }
     }
-    return nullptr;
+    busLookupCache.insert(key, found);
+    return found;
+}
+
+void DBCHandler::invalidateLookupCache()
+{
+    lookupGeneration++;
+}
+
+//anything compiled from the DBC structures can remember this and rebuild itself once it moves
+quint32 DBCHandler::getLookupGeneration()
+{
+    return lookupGeneration;
+}
+
+/*
+ * The current snapshot of all loaded files. Called on the GUI thread this first republishes the snapshot if any file
+ * changed since it was built. Other threads can't look at the files, they get the last published snapshot and if
+ * that is out of date a republish is queued on the GUI thread so a later call picks up the changes.
+ */
+QSharedPointer<const DBCSnapshot> DBCHandler::getSnapshot()
+{
+    if (QThread::currentThread() == thread())
+    {
+        //only this thread ever replaces the snapshot so it can be read without the lock here
+        if (snapshot.isNull() || snapshot->getGeneration() != lookupGeneration) publishSnapshot();
+        return snapshot;
+    }
+    QMutexLocker locker(&snapshotLock);
+    if ((snapshot.isNull() || snapshot->getGeneration() != lookupGeneration) && !publishQueued)
+    {
+        publishQueued = true;
+        QMetaObject::invokeMethod(this, [this]() { getSnapshot(); }, Qt::QueuedConnection);
+    }
+    return snapshot;
+}
+
+//builds a new snapshot from the files as they are now and swaps it in. GUI thread only
+void DBCHandler::publishSnapshot()
+{
+    QSharedPointer<const DBCSnapshot> fresh = DBCSnapshot::build(this, lookupGeneration);
+    QMutexLocker locker(&snapshotLock);
+    snapshot = fresh;
+    publishQueued = false;
 }
 
 DBC_MESSAGE* DBCHandler::findMessage(uint32_t id)
@@ -2328,6 +1756,7 @@ DBCFile* DBCHandler::getFileByName(QString name)
 
 DBCHandler::DBCHandler()
 {
+    cacheGeneration = lookupGeneration - 1; //force the cache to start out empty
     // Load previously saved DBC file settings
     QSettings settings;
     qDebug() <<"Settings file: " << settings.fileName();
@@ -2371,6 +1800,7 @@ DBCHandler::DBCHandler()
                 << ", Matching Criteria:" << (int)matchingCriteria << "Filter labeling: " << (filterLabeling?"enabled":"disabled") << ")";
         }
     }
+    publishSnapshot();
 }
 
 DBCHandler* DBCHandler::getReference()
@@ -2,9 +2,15 @@
 #define DBCHANDLER_H
 
 #include <QObject>
+#include <QAtomicInteger>
+#include <QHash>
+#include <QMutex>
+#include <QSharedPointer>
 #include "dbc_classes.h"
 #include "can_structs.h"
 
+class DBCSnapshot;
+
     typedef enum
     {
         EXACT,
@@ -56,11 +62,23 @@ public:
     void setFilterLabeling( bool labelFiltering );
     bool filterLabeling();
     void sort();
+    void invalidateIndex();
 
 private:
+    void buildIndex();
+    void indexMessage(int idx);
+
     QList<DBC_MESSAGE> messages;
     MatchingCriteria_t matchingCriteria;
     bool filterLabelingEnabled;
+
+    //lookup tables for findMsgByID. They hold indexes into messages and are rebuilt on the next lookup after
+    //anything changes. Appending a message just adds it to the existing tables so loading a file stays linear.
+    bool indexValid = false;
+    QHash<uint32_t, int> exactIndex; //first message with a given ID
+    QHash<uint32_t, int> j1939PDU1Index; //J1939 PDU1 messages keyed by data page + PDU format (ID & 0x3FF0000)
+    QHash<uint32_t, int> j1939PDU2Index; //J1939 PDU2 messages keyed by the whole PGN (ID & 0x3FFFF00)
+    QHash<uint32_t, int> gmlanIndex; //GMLAN messages keyed by arbitration ID (ID & 0x3FFE000)
 };
 
 //technically there should be a node handler too but I'm sort of treating nodes as second class
@@ -100,15 +118,9 @@ private:
     int assocBuses; //-1 = all buses, 0 = first bus, 1 = second bus, etc.
     bool isDirty; //has the file been modified?
 
-    bool parseAttribute(QString inpString, DBC_ATTRIBUTE &attr);
     QVariant processAttributeVal(QString input, DBC_ATTRIBUTE_VAL_TYPE typ);
-    DBC_SIGNAL* parseSignalLine(QString line, DBC_MESSAGE *msg);
-    bool parseSignalMultiplexValueLine(QString line);
-    DBC_MESSAGE* parseMessageLine(QString line);
-    bool parseValueLine(QString line);
-    bool parseSignalValueTypeLine(QString line);
-    bool parseAttributeLine(QString line);
-    bool parseDefaultAttrLine(QString line);
+
+    friend class DBCParser;
 };
 
 class DBCHandler: public QObject
@@ -134,10 +146,25 @@ public:
     DBCFile* loadJSONFile(QString);
     DBCFile* loadSecretCSVFile(QString);
     static DBCHandler *getReference();
+    static void invalidateLookupCache();
+    static quint32 getLookupGeneration();
+    QSharedPointer<const DBCSnapshot> getSnapshot();
+    void publishSnapshot();
 
 private:
     QList<DBCFile> loadedFiles;
 
+    //bus / ID -> message resolved by findMessage(const CANFrame&), misses included.
+    //Thrown away whenever lookupGeneration moves, which happens on any change to the loaded files.
+    QHash<quint64, DBC_MESSAGE*> busLookupCache;
+    quint32 cacheGeneration;
+    static QAtomicInteger<quint32> lookupGeneration; //bumped from the DBC parser thread as well
+
+    //read only copy of the loaded files for worker threads. Only the GUI thread replaces it, under snapshotLock
+    QSharedPointer<const DBCSnapshot> snapshot;
+    QMutex snapshotLock;
+    bool publishQueued = false; //another thread found the snapshot out of date and asked for a new one, under snapshotLock
+
     DBCHandler();
     static DBCHandler *instance;
 };
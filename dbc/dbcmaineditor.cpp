@@ -135,6 +135,7 @@ void DBCMainEditor::closeEvent(QCloseEvent *event)
     Q_UNUSED(event)
     writeSettings();
     sigEditor->close();
+    dbcHandler->publishSnapshot(); //hand the edits to anything decoding off the GUI thread
 }
 
 void DBCMainEditor::readSettings()
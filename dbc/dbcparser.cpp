@@ -0,0 +1,689 @@
+#include "dbcparser.h"
+#include "dbchandler.h"
+
+#include <QDebug>
+#include <QThread>
+#include <string.h>
+
+static inline bool isSpaceChar(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+static inline bool isKeywordChar(char c)
+{
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+//same set the old regular expressions used for names ([-\w]). Bytes above 0x7F are parts of UTF-8 characters
+static inline bool isNameChar(char c)
+{
+    return isKeywordChar(c) || c == '-' || (static_cast<unsigned char>(c) >= 0x80);
+}
+
+static inline bool isNumberChar(char c)
+{
+    return (c >= '0' && c <= '9') || c == '.' || c == '+' || c == '-' || c == 'e' || c == 'E';
+}
+
+DBCParser::DBCParser(DBCFile *file, const QString &sourceFileName)
+{
+    dbcFile = file;
+    fileBaseName = sourceFileName;
+    targetThread = file->thread();
+    begin = pos = end = nullptr;
+    numMsgFaults = 0;
+    numSigFaults = 0;
+
+    for (int i = 0; i < dbcFile->dbc_nodes.count(); i++)
+    {
+        QString key = dbcFile->dbc_nodes[i].name.toCaseFolded();
+        if (!nodeIndex.contains(key)) nodeIndex.insert(key, i);
+    }
+    for (int i = 0; i < dbcFile->dbc_attributes.count(); i++)
+    {
+        QString key = dbcFile->dbc_attributes[i].name.toCaseFolded();
+        if (!attributeIndex.contains(key)) attributeIndex.insert(key, i);
+    }
+}
+
+void DBCParser::cancel()
+{
+    canceled.storeRelaxed(1);
+}
+
+int DBCParser::progress() const
+{
+    return progressPercent.loadRelaxed();
+}
+
+int DBCParser::messageFaults() const
+{
+    return numMsgFaults;
+}
+
+int DBCParser::signalFaults() const
+{
+    return numSigFaults;
+}
+
+bool DBCParser::parse(const QByteArray &text)
+{
+    DBC_MESSAGE *currentMessage = nullptr;
+    bool inMultilineBU = false;
+    int lineCounter = 0;
+
+    begin = text.constData();
+    pos = begin;
+    end = begin + text.size();
+    if (text.startsWith("\xEF\xBB\xBF")) pos += 3; //UTF-8 byte order mark
+
+    while (pos < end)
+    {
+        if (++lineCounter > 1000)
+        {
+            if (canceled.loadRelaxed()) return false;
+            progressPercent.storeRelaxed(static_cast<int>((static_cast<qint64>(pos - begin) * 100) / (end - begin)));
+            lineCounter = 0;
+        }
+
+        //indented lines right after BU_: are more node names
+        if (inMultilineBU)
+        {
+            if (*pos == '\t' || (end - pos >= 3 && !memcmp(pos, "   ", 3)))
+            {
+                const char *lineStart = pos;
+                while (pos < end && *pos != '\n') pos++;
+                QString name = QString::fromUtf8(lineStart, static_cast<int>(pos - lineStart)).simplified();
+                if (!name.isEmpty()) addNode(name);
+                skipLine();
+                continue;
+            }
+            inMultilineBU = false;
+        }
+
+        if (takeKeyword("BO_")) //defines a message
+        {
+            currentMessage = parseMessage();
+            if (currentMessage == nullptr) numMsgFaults++;
+        }
+        else if (takeKeyword("SG_")) //defines a signal
+        {
+            if (!parseSignal(currentMessage)) numSigFaults++;
+        }
+        else if (takeKeyword("SG_MUL_VAL_")) //defines a signal multiplexing value definition
+        {
+            if (!parseSignalMultiplexValues()) numSigFaults++;
+        }
+        else if (takeKeyword("SIG_VALTYPE_")) //defines a signal value type
+        {
+            if (!parseSignalValueType()) numSigFaults++;
+        }
+        else if (takeKeyword("BU_")) //line specifies the nodes on this canbus
+        {
+            inMultilineBU = parseNodes(); //we might be... Need to check next line.
+        }
+        else if (takeKeyword("CM_")) parseComment();
+        else if (takeKeyword("VAL_")) parseValues();
+        else if (takeKeyword("BA_DEF_"))
+        {
+            if (takeKeyword("SG_")) parseAttributeDefinition(ATTR_TYPE_SIG);
+            else if (takeKeyword("BO_")) parseAttributeDefinition(ATTR_TYPE_MESSAGE);
+            else if (takeKeyword("BU_")) parseAttributeDefinition(ATTR_TYPE_NODE);
+            else if (!takeKeyword("EV_")) parseAttributeDefinition(ATTR_TYPE_GENERAL);
+        }
+        else if (takeKeyword("BA_DEF_DEF_")) parseAttributeDefault(); //definition of default value for an attribute
+        else if (takeKeyword("BA_")) parseAttributeValue(); //set value of attribute
+
+        skipLine();
+    }
+
+    //signal handlers created on a worker thread belong to the thread that owns the file
+    if (targetThread != QThread::currentThread())
+    {
+        for (int i = 0; i < dbcFile->messageHandler->getCount(); i++)
+        {
+            dbcFile->messageHandler->findMsgByIdx(i)->sigHandler->moveToThread(targetThread);
+        }
+    }
+
+    qDebug() << "DBC parse done. " << dbcFile->messageHandler->getCount() << " messages, " << dbcFile->dbc_nodes.count()
+             << " nodes, " << dbcFile->dbc_attributes.count() << " attributes";
+    progressPercent.storeRelaxed(100);
+    return true;
+}
+
+//BO_ 1090 VCU_Status: 8 VCU
+DBC_MESSAGE *DBCParser::parseMessage()
+{
+    quint64 id, len;
+    QString name, sender;
+
+    if (!readUInt(id) || !readName(name) || !expect(':') || !readUInt(len)) return nullptr;
+    readName(sender);
+
+    DBC_MESSAGE msg;
+    msg.ID = static_cast<uint32_t>(id) & 0x1FFFFFFFul; //the ID is always stored in decimal format
+    msg.extendedID = (id & 0x80000000ul) ? true : false;
+    msg.name = name;
+    msg.len = static_cast<unsigned int>(len);
+    msg.sender = findNode(sender);
+    if (!msg.sender) msg.sender = dbcFile->findNodeByIdx(0);
+
+    DBCMessageHandler *handler = dbcFile->messageHandler;
+    handler->addMessage(msg);
+    return handler->findMsgByIdx(handler->getCount() - 1);
+}
+
+//SG_ name [M | mX | mXM] : startBit|size@order+/- (factor,offset) [min|max] "unit" receiver[,receiver...]
+bool DBCParser::parseSignal(DBC_MESSAGE *msg)
+{
+    DBC_SIGNAL sig;
+    bool isMessageMultiplexor = false;
+    quint64 startBit, size, order;
+    double factor, bias, min, max;
+    QString name, unit, receiver;
+
+    if (!readName(name)) return false;
+
+    skipSpaces();
+    if (pos < end && (*pos == 'M' || *pos == 'm'))
+    {
+        if (*pos == 'M')
+        {
+            isMessageMultiplexor = true;
+            sig.isMultiplexor = true;
+            pos++;
+        }
+        else
+        {
+            quint64 muxValue;
+            pos++;
+            if (!readUInt(muxValue)) return false;
+            sig.addMultiplexRange(static_cast<int>(muxValue), static_cast<int>(muxValue));
+            if (pos < end && *pos == 'M')
+            {
+                //extended multiplexor. Not the top level multiplexor so the message doesn't point at it
+                sig.isMultiplexor = true;
+                pos++;
+            }
+        }
+    }
+
+    if (!expect(':') || !readUInt(startBit) || !expect('|') || !readUInt(size) || !expect('@')) return false;
+    if (pos >= end || *pos < '0' || *pos > '9') return false;
+    order = static_cast<quint64>(*pos++ - '0');
+    if (pos >= end || (*pos != '+' && *pos != '-')) return false;
+    bool isUnsigned = (*pos++ == '+');
+    if (!expect('(') || !readNumber(factor) || !expect(',') || !readNumber(bias) || !expect(')')) return false;
+    if (!expect('[') || !readNumber(min) || !expect('|') || !readNumber(max) || !expect(']')) return false;
+    if (!readQuoted(unit)) return false;
+    readName(receiver); //only the first receiver is kept
+
+    sig.name = name;
+    sig.startBit = static_cast<int>(startBit);
+    sig.signalSize = static_cast<int>(size);
+    if (order < 2)
+    {
+        if (isUnsigned) sig.valType = UNSIGNED_INT;
+        else sig.valType = SIGNED_INT;
+    }
+    switch (order)
+    {
+    case 0: //big endian mode
+        sig.intelByteOrder = false;
+        break;
+    case 1: //little endian mode
+        sig.intelByteOrder = true;
+        break;
+    case 2:
+        sig.valType = SP_FLOAT;
+        break;
+    case 3:
+        sig.valType = DP_FLOAT;
+        break;
+    case 4:
+        sig.valType = STRING;
+        break;
+    case 5: //single point float in little endian
+        sig.valType = SP_FLOAT;
+        sig.intelByteOrder = true;
+        break;
+    case 6: //double point float in little endian
+        sig.valType = DP_FLOAT;
+        sig.intelByteOrder = true;
+        break;
+    }
+    sig.factor = factor;
+    sig.bias = bias;
+    sig.min = min;
+    sig.max = max;
+    sig.unitName = unit;
+    sig.receiver = findNode(receiver);
+    if (!sig.receiver) sig.receiver = dbcFile->findNodeByIdx(0); //apply default if there was no match
+
+    sig.parentMessage = msg;
+    if (!msg) return false;
+
+    msg->sigHandler->addSignal(sig);
+    DBC_SIGNAL *added = msg->sigHandler->findSignalByIdx(msg->sigHandler->getCount() - 1);
+    QHash<QString, DBC_SIGNAL *> &sigs = signalIndex[msg];
+    QString key = name.toCaseFolded();
+    if (!sigs.contains(key)) sigs.insert(key, added);
+    if (isMessageMultiplexor) msg->multiplexorSignal = sigs.value(key);
+    return true;
+}
+
+//SG_MUL_VAL_ 2024 S1_PID_0D_VehicleSpeed S1 13-13, 20-25;
+bool DBCParser::parseSignalMultiplexValues()
+{
+    quint64 id;
+    QString sigName, parentName;
+
+    if (!readUInt(id) || !readName(sigName) || !readName(parentName)) return false;
+
+    DBC_MESSAGE *msg = findMessage(id);
+    if (msg == nullptr) return false;
+    DBC_SIGNAL *thisSignal = findSignal(msg, sigName);
+    if (thisSignal == nullptr) return false;
+    DBC_SIGNAL *parentSignal = findSignal(msg, parentName);
+    if (parentSignal == nullptr) return false;
+
+    while (!atLineEnd() && !peek(';'))
+    {
+        //now need to add "thisSignal" to the children multiplexed signals of "parentSignal"
+        quint64 rangeMin, rangeMax;
+        if (!readUInt(rangeMin) || !expect('-') || !readUInt(rangeMax))
+        {
+            qDebug() << "Malformed range definition found in the multiplexed signal: " << sigName;
+            return false;
+        }
+        thisSignal->multiplexParent = parentSignal;
+        thisSignal->addMultiplexRange(static_cast<int>(rangeMin), static_cast<int>(rangeMax));
+        expect(',');
+    }
+    parentSignal->multiplexedChildren.append(thisSignal);
+    return true;
+}
+
+//SIG_VALTYPE_ 1090 VCUTorque : 1;
+bool DBCParser::parseSignalValueType()
+{
+    quint64 id, valType;
+    QString sigName;
+
+    if (!readUInt(id) || !readName(sigName) || !expect(':') || !readUInt(valType)) return false;
+
+    DBC_MESSAGE *msg = findMessage(id);
+    if (msg == nullptr) return false;
+    DBC_SIGNAL *thisSignal = findSignal(msg, sigName);
+    if (thisSignal == nullptr) return false;
+
+    switch (valType)
+    {
+    case 1:
+        thisSignal->valType = SP_FLOAT;
+        break;
+    case 2:
+        thisSignal->valType = DP_FLOAT;
+        break;
+    default:
+        return false;
+    }
+    return true;
+}
+
+//BU_: VCU BMS Charger
+bool DBCParser::parseNodes()
+{
+    if (!expect(':')) return false;
+
+    QString name;
+    while (readName(name)) addNode(name);
+    return true;
+}
+
+//CM_ SG_ 1090 VCUTorque "comment";  CM_ BO_ 1090 "comment";  CM_ BU_ VCU "comment";
+void DBCParser::parseComment()
+{
+    quint64 id;
+    QString name, comment;
+
+    if (takeKeyword("SG_"))
+    {
+        if (!readUInt(id) || !readName(name) || !readQuoted(comment)) return;
+        DBC_MESSAGE *msg = findMessage(id);
+        if (msg == nullptr) return;
+        DBC_SIGNAL *sig = findSignal(msg, name);
+        if (sig != nullptr) sig->comment = comment;
+    }
+    else if (takeKeyword("BO_"))
+    {
+        if (!readUInt(id) || !readQuoted(comment)) return;
+        DBC_MESSAGE *msg = findMessage(id);
+        if (msg != nullptr) msg->comment = comment;
+    }
+    else if (takeKeyword("BU_"))
+    {
+        if (!readName(name) || !readQuoted(comment)) return;
+        DBC_NODE *node = findNode(name);
+        if (node != nullptr) node->comment = comment;
+    }
+}
+
+//VAL_ 1090 VCUPresentParkLightOC 1 "Error present" 0 "Error not present" ;
+void DBCParser::parseValues()
+{
+    quint64 id;
+    QString sigName;
+
+    if (!readUInt(id) || !readName(sigName)) return; //value tables of environment variables don't start with an ID
+
+    DBC_MESSAGE *msg = findMessage(id);
+    if (msg == nullptr) return;
+    DBC_SIGNAL *sig = findSignal(msg, sigName);
+    if (sig == nullptr) return;
+
+    DBC_VAL_ENUM_ENTRY val;
+    qint64 value;
+    while (readInt(value) && readQuoted(val.descript))
+    {
+        val.value = static_cast<int>(value);
+        sig->valList.append(val);
+    }
+}
+
+//BA_DEF_ BO_ "GenMsgCycleTime" INT 0 65535;  BA_DEF_ "BusType" STRING;  BA_DEF_ SG_ "x" ENUM "No","Yes";
+void DBCParser::parseAttributeDefinition(DBC_ATTRIBUTE_TYPE type)
+{
+    DBC_ATTRIBUTE attr;
+    QString typ;
+
+    if (!readName(attr.name) || !readName(typ)) return;
+    attr.attrType = type;
+    attr.lower = 0;
+    attr.upper = 0;
+
+    bool isInt = !typ.compare("INT", Qt::CaseInsensitive);
+    if (isInt || !typ.compare("FLOAT", Qt::CaseInsensitive))
+    {
+        attr.valType = isInt ? ATTR_INT : ATTR_FLOAT;
+        double lower, upper;
+        if (readNumber(lower) && readNumber(upper))
+        {
+            attr.lower = lower;
+            attr.upper = upper;
+        }
+    }
+    else if (!typ.compare("STRING", Qt::CaseInsensitive))
+    {
+        attr.valType = ATTR_STRING;
+    }
+    else if (!typ.compare("ENUM", Qt::CaseInsensitive))
+    {
+        attr.valType = ATTR_ENUM;
+        QString enumStr;
+        while (readName(enumStr))
+        {
+            attr.enumVals.append(enumStr);
+            if (!expect(',')) break;
+        }
+    }
+    else return; //HEX and anything else isn't supported
+
+    QString key = attr.name.toCaseFolded();
+    if (!attributeIndex.contains(key)) attributeIndex.insert(key, dbcFile->dbc_attributes.count());
+    dbcFile->dbc_attributes.append(attr);
+}
+
+//BA_DEF_DEF_ "GenMsgCycleTime" 100;
+void DBCParser::parseAttributeDefault()
+{
+    QString name, value;
+
+    if (!readName(name) || !readValue(value)) return;
+
+    DBC_ATTRIBUTE *found = findAttribute(name);
+    if (!found) return;
+
+    switch (found->valType)
+    {
+    case ATTR_STRING:
+        found->defaultValue = value;
+        break;
+    case ATTR_FLOAT:
+        found->defaultValue = value.toFloat();
+        break;
+    case ATTR_INT:
+        found->defaultValue = value.toInt();
+        break;
+    case ATTR_ENUM:
+        found->defaultValue = 0;
+        for (int x = 0; x < found->enumVals.count(); x++)
+        {
+            if (!found->enumVals[x].compare(value, Qt::CaseInsensitive))
+            {
+                found->defaultValue = x;
+                break;
+            }
+        }
+        break;
+    }
+}
+
+//BA_ "GenMsgCycleTime" BO_ 101 100;  BA_ "x" SG_ 101 SigName 1;  BA_ "x" BU_ NodeName 1;
+void DBCParser::parseAttributeValue()
+{
+    QString attrName, name, value;
+    quint64 id;
+    QList<DBC_ATTRIBUTE_VALUE> *attrList = nullptr;
+
+    if (!readName(attrName)) return;
+    DBC_ATTRIBUTE *foundAttr = findAttribute(attrName);
+    if (!foundAttr) return;
+
+    if (takeKeyword("BO_"))
+    {
+        if (!readUInt(id) || !readValue(value)) return;
+        DBC_MESSAGE *foundMsg = findMessage(id);
+        if (foundMsg) attrList = &foundMsg->attributes;
+    }
+    else if (takeKeyword("SG_"))
+    {
+        if (!readUInt(id) || !readName(name) || !readValue(value)) return;
+        DBC_MESSAGE *foundMsg = findMessage(id);
+        DBC_SIGNAL *foundSig = foundMsg ? findSignal(foundMsg, name) : nullptr;
+        if (foundSig) attrList = &foundSig->attributes;
+    }
+    else if (takeKeyword("BU_"))
+    {
+        if (!readName(name) || !readValue(value)) return;
+        DBC_NODE *foundNode = findNode(name);
+        if (foundNode) attrList = &foundNode->attributes;
+    }
+    if (!attrList) return;
+
+    QVariant attrVal = dbcFile->processAttributeVal(value, foundAttr->valType);
+    for (DBC_ATTRIBUTE_VALUE &existing : *attrList)
+    {
+        if (!existing.attrName.compare(attrName, Qt::CaseInsensitive))
+        {
+            existing.value = attrVal;
+            return;
+        }
+    }
+    DBC_ATTRIBUTE_VALUE val;
+    val.attrName = attrName;
+    val.value = attrVal;
+    attrList->append(val);
+}
+
+void DBCParser::addNode(const QString &name)
+{
+    DBC_NODE node;
+    node.sourceFileName = fileBaseName;
+    node.name = name;
+    QString key = name.toCaseFolded();
+    if (!nodeIndex.contains(key)) nodeIndex.insert(key, dbcFile->dbc_nodes.count());
+    dbcFile->dbc_nodes.append(node);
+}
+
+DBC_NODE *DBCParser::findNode(const QString &name)
+{
+    auto it = nodeIndex.constFind(name.toCaseFolded());
+    if (it == nodeIndex.constEnd()) return nullptr;
+    return &dbcFile->dbc_nodes[it.value()];
+}
+
+DBC_ATTRIBUTE *DBCParser::findAttribute(const QString &name)
+{
+    auto it = attributeIndex.constFind(name.toCaseFolded());
+    if (it == attributeIndex.constEnd()) return nullptr;
+    return &dbcFile->dbc_attributes[it.value()];
+}
+
+DBC_MESSAGE *DBCParser::findMessage(quint64 id)
+{
+    return dbcFile->messageHandler->findMsgByID(static_cast<uint32_t>(id) & 0x1FFFFFFFul);
+}
+
+DBC_SIGNAL *DBCParser::findSignal(DBC_MESSAGE *msg, const QString &name)
+{
+    auto sigs = signalIndex.constFind(msg);
+    if (sigs == signalIndex.constEnd()) return nullptr;
+    return sigs.value().value(name.toCaseFolded(), nullptr);
+}
+
+void DBCParser::skipSpaces()
+{
+    while (pos < end && isSpaceChar(*pos)) pos++;
+}
+
+void DBCParser::skipLine()
+{
+    while (pos < end && *pos != '\n') pos++;
+    if (pos < end) pos++;
+}
+
+bool DBCParser::atLineEnd()
+{
+    skipSpaces();
+    return pos >= end || *pos == '\n';
+}
+
+//matches a whole keyword followed by a space or colon. Keywords alone on a line (the NS_ list) don't match
+bool DBCParser::takeKeyword(const char *keyword)
+{
+    skipSpaces();
+    int len = static_cast<int>(strlen(keyword));
+    if (end - pos <= len || memcmp(pos, keyword, len)) return false;
+    char next = pos[len];
+    if (!isSpaceChar(next) && next != ':') return false;
+    const char *start = pos;
+    pos += len;
+    if (atLineEnd())
+    {
+        pos = start;
+        return false;
+    }
+    return true;
+}
+
+bool DBCParser::expect(char c)
+{
+    skipSpaces();
+    if (pos >= end || *pos != c) return false;
+    pos++;
+    return true;
+}
+
+bool DBCParser::peek(char c)
+{
+    skipSpaces();
+    return pos < end && *pos == c;
+}
+
+//a bare name or a quoted one. Attribute names are usually quoted, most other names never are
+bool DBCParser::readName(QString &out)
+{
+    skipSpaces();
+    if (pos < end && *pos == '"') return readQuoted(out);
+    const char *start = pos;
+    while (pos < end && isNameChar(*pos)) pos++;
+    if (pos == start) return false;
+    out = QString::fromUtf8(start, static_cast<int>(pos - start));
+    return true;
+}
+
+bool DBCParser::readUInt(quint64 &out)
+{
+    skipSpaces();
+    const char *start = pos;
+    quint64 value = 0;
+    while (pos < end && *pos >= '0' && *pos <= '9') value = (value * 10) + static_cast<quint64>(*pos++ - '0');
+    if (pos == start) return false;
+    out = value;
+    return true;
+}
+
+bool DBCParser::readInt(qint64 &out)
+{
+    skipSpaces();
+    const char *start = pos;
+    bool negative = false;
+    if (pos < end && (*pos == '-' || *pos == '+')) negative = (*pos++ == '-');
+    quint64 value;
+    if (!readUInt(value))
+    {
+        pos = start;
+        return false;
+    }
+    out = negative ? -static_cast<qint64>(value) : static_cast<qint64>(value);
+    return true;
+}
+
+//decimal or exponent notation. Converted the same way QString::toDouble does, independent of locale
+bool DBCParser::readNumber(double &out)
+{
+    skipSpaces();
+    const char *start = pos;
+    while (pos < end && isNumberChar(*pos)) pos++;
+    if (pos == start) return false;
+    bool ok;
+    out = QByteArray::fromRawData(start, static_cast<int>(pos - start)).toDouble(&ok);
+    if (!ok) pos = start;
+    return ok;
+}
+
+//the text between double quotes, which may run over several lines. Escaped quotes are kept as written
+bool DBCParser::readQuoted(QString &out)
+{
+    skipSpaces();
+    if (pos >= end || *pos != '"') return false;
+    const char *start = ++pos;
+    while (pos < end && *pos != '"')
+    {
+        if (*pos == '\\' && (pos + 1) < end) pos++;
+        pos++;
+    }
+    if (pos >= end)
+    {
+        pos = start - 1;
+        return false;
+    }
+    out = QString::fromUtf8(start, static_cast<int>(pos - start));
+    pos++;
+    return true;
+}
+
+//an attribute value: a quoted string or everything up to the next space or semicolon
+bool DBCParser::readValue(QString &out)
+{
+    skipSpaces();
+    if (pos < end && *pos == '"') return readQuoted(out);
+    const char *start = pos;
+    while (pos < end && !isSpaceChar(*pos) && *pos != ';' && *pos != '\n') pos++;
+    if (pos == start) return false;
+    out = QString::fromUtf8(start, static_cast<int>(pos - start));
+    return true;
+}
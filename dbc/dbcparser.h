@@ -0,0 +1,88 @@
+#ifndef DBCPARSER_H
+#define DBCPARSER_H
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include "dbc_classes.h"
+
+class DBCFile;
+class QThread;
+
+/*
+ * Hand written DBC parser used by DBCFile::loadFile. It walks the raw file contents with a cursor and reads
+ * each statement token by token instead of simplifying every line and running it through regular expressions.
+ * Messages, signals, nodes and attributes are indexed while they are created so comments, value tables and
+ * attribute values resolve their targets by hash lookup.
+ *
+ * parse() does not touch the GUI so it can be run on a worker thread. progress() and cancel() may be called
+ * from any thread while it runs.
+ *
+ * Quoted strings (comments mostly) may span several lines. Everything else is one statement per line, like
+ * the line based parser this replaces.
+ */
+class DBCParser
+{
+public:
+    DBCParser(DBCFile *file, const QString &sourceFileName);
+
+    bool parse(const QByteArray &text);
+    void cancel();
+    int progress() const; //percent of the file parsed so far
+    int messageFaults() const;
+    int signalFaults() const;
+
+private:
+    DBC_MESSAGE *parseMessage();
+    bool parseSignal(DBC_MESSAGE *msg);
+    bool parseSignalMultiplexValues();
+    bool parseSignalValueType();
+    bool parseNodes();
+    void parseComment();
+    void parseValues();
+    void parseAttributeDefinition(DBC_ATTRIBUTE_TYPE type);
+    void parseAttributeDefault();
+    void parseAttributeValue();
+
+    void addNode(const QString &name);
+    DBC_NODE *findNode(const QString &name);
+    DBC_ATTRIBUTE *findAttribute(const QString &name);
+    DBC_MESSAGE *findMessage(quint64 id);
+    DBC_SIGNAL *findSignal(DBC_MESSAGE *msg, const QString &name);
+
+    //cursor primitives. All of them skip leading spaces and tabs but never leave the current line except
+    //readQuoted, which follows a string to its closing quote.
+    void skipSpaces();
+    void skipLine();
+    bool atLineEnd();
+    bool takeKeyword(const char *keyword);
+    bool expect(char c);
+    bool peek(char c);
+    bool readName(QString &out);
+    bool readUInt(quint64 &out);
+    bool readInt(qint64 &out);
+    bool readNumber(double &out);
+    bool readQuoted(QString &out);
+    bool readValue(QString &out);
+
+    DBCFile *dbcFile;
+    QString fileBaseName;
+    QThread *targetThread;
+
+    const char *begin;
+    const char *pos;
+    const char *end;
+
+    int numMsgFaults;
+    int numSigFaults;
+    QAtomicInt progressPercent;
+    QAtomicInt canceled;
+
+    //case folded name -> first entry with that name, same result as the linear findXXXByName lookups
+    QHash<QString, int> nodeIndex;
+    QHash<QString, int> attributeIndex;
+    QHash<const DBC_MESSAGE *, QHash<QString, DBC_SIGNAL *>> signalIndex;
+};
+
+#endif // DBCPARSER_H
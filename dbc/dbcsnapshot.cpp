@@ -0,0 +1,535 @@
+#include "dbcsnapshot.h"
+
+#include <QtMath>
+#include <cmath>
+#include <string.h>
+
+/*
+ * Physical value to the raw bits encodeFromDouble puts into a payload. Integer signals are rounded and clamped to what
+ * signalSize bits can hold, floats become their bit pattern.
+ */
+static uint64_t physicalToRaw(double value, DBC_SIG_VAL_TYPE valType, int signalSize, double factor, double bias)
+{
+    double scaled = (factor != 0.0) ? ((value - bias) / factor) : 0.0;
+    uint64_t raw;
+    if (valType == SP_FLOAT)
+    {
+        float val = static_cast<float>(scaled);
+        uint32_t bits;
+        memcpy(&bits, &val, sizeof(bits));
+        raw = bits;
+    }
+    else if (valType == DP_FLOAT)
+    {
+        memcpy(&raw, &scaled, sizeof(raw));
+    }
+    else
+    {
+        //largest double below 2^n so the casts below can't overflow even for 64 bit signals
+        int valueBits = (valType == SIGNED_INT) ? signalSize - 1 : signalSize;
+        double high = qMin(std::ldexp(1.0, valueBits) - 1.0, std::nextafter(std::ldexp(1.0, valueBits), 0.0));
+        double low = (valType == SIGNED_INT) ? -std::ldexp(1.0, valueBits) : 0.0;
+        double rounded = qBound(low, std::round(scaled), high);
+        if (valType == SIGNED_INT) raw = static_cast<uint64_t>(static_cast<int64_t>(rounded));
+        else raw = static_cast<uint64_t>(rounded);
+    }
+    return raw;
+}
+
+QSharedPointer<const DBCSnapshot> DBCSnapshot::build(DBCHandler *handler, quint32 generation)
+{
+    QSharedPointer<DBCSnapshot> snap(new DBCSnapshot);
+    snap->generation = generation;
+
+    for (int f = 0; f < handler->getFileCount(); f++)
+    {
+        DBCFile *file = handler->getFileByIdx(f);
+        DBCMessageHandler *msgHandler = file->messageHandler;
+        FileTables tables;
+        tables.assocBus = file->getAssocBus();
+        tables.matchingCriteria = msgHandler->getMatchingCriteria();
+
+        for (int m = 0; m < msgHandler->getCount(); m++)
+        {
+            DBC_MESSAGE *msg = msgHandler->findMsgByIdx(m);
+            int idx = snap->messages.count();
+            uint32_t id = msg->ID;
+
+            //built the same way DBCMessageHandler::indexMessage does
+            if (!tables.exactIndex.contains(id)) tables.exactIndex.insert(id, idx);
+            if (tables.matchingCriteria == J1939)
+            {
+                tables.j1939PDU1Index.insert(id & 0x3FF0000, idx);
+                tables.j1939PDU2Index.insert(id & 0x3FFFF00, idx);
+            }
+            else if (tables.matchingCriteria == GMLAN)
+            {
+                tables.gmlanIndex.insert(id & 0x3FFE000, idx);
+            }
+
+            Message out;
+            out.ID = msg->ID;
+            out.extendedID = msg->extendedID;
+            out.name = msg->name;
+            out.comment = msg->comment;
+            out.len = msg->len;
+            out.fileIdx = f;
+            out.source = msg;
+            out.multiplexorSignal = nullptr;
+            out.sigs.reserve(msg->sigHandler->getCount());
+            for (int s = 0; s < msg->sigHandler->getCount(); s++)
+            {
+                DBC_SIGNAL *sig = msg->sigHandler->findSignalByIdx(s);
+                Signal outSig;
+                outSig.name = sig->name;
+                outSig.unitName = sig->unitName;
+                outSig.valType = sig->valType;
+                outSig.intelByteOrder = sig->intelByteOrder;
+                outSig.startBit = sig->startBit;
+                outSig.signalSize = sig->signalSize;
+                outSig.factor = sig->factor;
+                outSig.bias = sig->bias;
+                outSig.min = sig->min;
+                outSig.max = sig->max;
+                outSig.isMultiplexor = sig->isMultiplexor;
+                outSig.isMultiplexed = sig->isMultiplexed;
+                outSig.multiplexRanges = sig->multiplexLowAndHighValues.toVector();
+                outSig.multiplexParent = nullptr;
+                outSig.message = nullptr;
+                outSig.source = sig;
+                for (const DBC_VAL_ENUM_ENTRY &val : qAsConst(sig->valList))
+                {
+                    if (!outSig.values.contains(val.value)) outSig.values.insert(val.value, val.descript);
+                }
+
+                //same layouts and length checks as DBC_SIGNAL::processAsDouble / processAsText
+                switch (sig->valType)
+                {
+                case SP_FLOAT:
+                    outSig.extractor.compile(sig->startBit, 32, false, false);
+                    outSig.textExtractor.compile(sig->startBit, 32, sig->intelByteOrder, false);
+                    outSig.encoder.compile(sig->startBit, 32, false);
+                    outSig.neededBytes = (sig->startBit + 32 + 7) / 8;
+                    break;
+                case DP_FLOAT:
+                    outSig.extractor.compile(sig->startBit, 64, false, false);
+                    outSig.textExtractor.compile(sig->startBit, 64, sig->intelByteOrder, false);
+                    outSig.encoder.compile(sig->startBit, 64, false);
+                    outSig.neededBytes = 8;
+                    break;
+                default:
+                    outSig.extractor.compile(sig->startBit, sig->signalSize, sig->intelByteOrder, sig->valType == SIGNED_INT);
+                    outSig.textExtractor = outSig.extractor;
+                    if (sig->valType != STRING) outSig.encoder.compile(sig->startBit, sig->signalSize, sig->intelByteOrder);
+                    outSig.neededBytes = (sig->startBit + sig->signalSize + 7) / 8;
+                    break;
+                }
+                out.sigs.append(outSig);
+            }
+            snap->messages.append(out);
+        }
+        snap->files.append(tables);
+    }
+
+    //the vectors are final now so the links between messages and signals can be turned into pointers
+    int msgIdx = 0;
+    for (int f = 0; f < handler->getFileCount(); f++)
+    {
+        DBCMessageHandler *msgHandler = handler->getFileByIdx(f)->messageHandler;
+        for (int m = 0; m < msgHandler->getCount(); m++, msgIdx++)
+        {
+            DBC_MESSAGE *msg = msgHandler->findMsgByIdx(m);
+            Message &out = snap->messages[msgIdx];
+            QHash<const DBC_SIGNAL *, const Signal *> sigMap;
+            for (int s = 0; s < out.sigs.count(); s++) sigMap.insert(out.sigs[s].source, &out.sigs[s]);
+
+            out.multiplexorSignal = sigMap.value(msg->multiplexorSignal, nullptr);
+            for (int s = 0; s < out.sigs.count(); s++)
+            {
+                out.sigs[s].message = &out;
+                DBC_SIGNAL *sig = msg->sigHandler->findSignalByIdx(s);
+                out.sigs[s].multiplexParent = sigMap.value(sig->multiplexParent, nullptr);
+                for (DBC_SIGNAL *child : qAsConst(sig->multiplexedChildren))
+                {
+                    const Signal *outChild = sigMap.value(child, nullptr);
+                    if (outChild) out.sigs[s].multiplexChildren.append(outChild);
+                }
+            }
+        }
+    }
+
+    return snap;
+}
+
+const DBCSnapshot::Message *DBCSnapshot::findInFile(int fileIdx, uint32_t id) const
+{
+    const FileTables &tables = files[fileIdx];
+
+    auto exact = tables.exactIndex.constFind(id);
+    if (exact != tables.exactIndex.constEnd()) return &messages[exact.value()];
+
+    if (tables.matchingCriteria == J1939)
+    {
+        // include data page and extended data page in the pgn
+        uint32_t pgn = (id & 0x3FFFF00) >> 8;
+        if ( (pgn & 0xFF00) <= 0xEF00 )
+        {
+            // PDU1 format
+            auto it = tables.j1939PDU1Index.constFind(id & 0x3FF0000);
+            if (it != tables.j1939PDU1Index.constEnd()) return &messages[it.value()];
+        }
+        else
+        {
+            // PDU2 format
+            auto it = tables.j1939PDU2Index.constFind(id & 0x3FFFF00);
+            if (it != tables.j1939PDU2Index.constEnd()) return &messages[it.value()];
+        }
+    }
+    else if (tables.matchingCriteria == GMLAN)
+    {
+        // Match the bits 14-26 (Arbitration Id) of GMLAN 29bit header
+        uint32_t arbId = id & 0x3FFE000;
+        if (arbId != 0)
+        {
+            auto it = tables.gmlanIndex.constFind(arbId);
+            if (it != tables.gmlanIndex.constEnd()) return &messages[it.value()];
+        }
+    }
+    return nullptr;
+}
+
+const DBCSnapshot::Message *DBCSnapshot::findMessage(uint32_t id, int bus) const
+{
+    for (int f = 0; f < files.count(); f++)
+    {
+        if (files[f].assocBus != -1 && files[f].assocBus != bus) continue;
+        const Message *msg = findInFile(f, id);
+        if (msg) return msg;
+    }
+    return nullptr;
+}
+
+//any file regardless of bus, same as DBCHandler::findMessage(uint32_t)
+const DBCSnapshot::Message *DBCSnapshot::findMessage(uint32_t id) const
+{
+    for (int f = 0; f < files.count(); f++)
+    {
+        const Message *msg = findInFile(f, id);
+        if (msg) return msg;
+    }
+    return nullptr;
+}
+
+const DBCSnapshot::Message *DBCSnapshot::findMessage(const CANFrame &frame) const
+{
+    return findMessage(frame.frameId(), frame.bus);
+}
+
+const DBCSnapshot::Message *DBCSnapshot::findMessage(const QString &name) const
+{
+    for (const Message &msg : messages)
+    {
+        if (msg.name.compare(name, Qt::CaseInsensitive) == 0) return &msg;
+    }
+    return nullptr;
+}
+
+//the copy of a live DBC signal, null if that signal was added after this snapshot was taken
+const DBCSnapshot::Signal *DBCSnapshot::findSignal(const DBC_SIGNAL *source) const
+{
+    if (!source) return nullptr;
+    for (const Message &msg : messages)
+    {
+        if (msg.source != source->parentMessage) continue;
+        for (const Signal &sig : msg.sigs)
+        {
+            if (sig.source == source) return &sig;
+        }
+    }
+    return nullptr;
+}
+
+int DBCSnapshot::getMessageCount() const
+{
+    return messages.count();
+}
+
+const DBCSnapshot::Message *DBCSnapshot::getMessageByIdx(int idx) const
+{
+    if (idx < 0 || idx >= messages.count()) return nullptr;
+    return &messages[idx];
+}
+
+quint32 DBCSnapshot::getGeneration() const
+{
+    return generation;
+}
+
+const DBCSnapshot::Signal *DBCSnapshot::Message::findSignal(const QString &name) const
+{
+    for (const Signal &sig : sigs)
+    {
+        if (sig.name.compare(name, Qt::CaseInsensitive) == 0) return &sig;
+    }
+    return nullptr;
+}
+
+bool DBCSnapshot::Signal::isValueMatchingMultiplex(int val) const
+{
+    for (const QPair<int, int> &limitPair : multiplexRanges)
+    {
+        if ((limitPair.first <= val) && (val <= limitPair.second)) return true;
+    }
+    return false;
+}
+
+bool DBCSnapshot::Signal::isInFrame(const CANFrame &frame) const
+{
+    if (isMultiplexor && !isMultiplexed) return true; //the root multiplexor is always in the message.
+    if (!isMultiplexed) return true;
+    if (!message->multiplexorSignal || !multiplexParent) return false;
+    if (!multiplexParent->isInFrame(frame)) return false;
+    int32_t val;
+    if (!multiplexParent->decodeAsInt(frame, val)) return false;
+    return isValueMatchingMultiplex(val);
+}
+
+bool DBCSnapshot::Signal::decodeAsDouble(const CANFrame &frame, double &outValue) const
+{
+    if (valType == STRING) return false;
+    const QByteArray payload = frame.payload();
+    if (payload.length() < neededBytes) return false;
+
+    int64_t result = extractor.extract(payload);
+    if (valType == SP_FLOAT)
+    {
+        uint32_t bits = static_cast<uint32_t>(result);
+        float val;
+        memcpy(&val, &bits, sizeof(val));
+        outValue = (val * factor) + bias;
+    }
+    else if (valType == DP_FLOAT)
+    {
+        double val;
+        memcpy(&val, &result, sizeof(val));
+        outValue = (val * factor) + bias;
+    }
+    else outValue = (static_cast<double>(result) * factor) + bias;
+    return true;
+}
+
+bool DBCSnapshot::Signal::decodeAsInt(const CANFrame &frame, int32_t &outValue) const
+{
+    if (valType == STRING || valType == SP_FLOAT || valType == DP_FLOAT) return false;
+
+    int32_t result = static_cast<int32_t>(extractor.extract(frame.payload()));
+    outValue = static_cast<int32_t>((result * factor) + bias);
+    return true;
+}
+
+bool DBCSnapshot::Signal::decodeAsText(const CANFrame &frame, QString &outString, bool outputName, bool outputUnit) const
+{
+    if (valType == STRING)
+    {
+        const QByteArray payload = frame.payload();
+        QString buildString;
+        int startByte = startBit / 8;
+        int bytes = signalSize / 8;
+        for (int x = 0; x < bytes; x++) buildString.append(payload.data()[startByte + x]);
+        outString = buildString;
+        return true;
+    }
+
+    int64_t raw;
+    if (!decodeTextRaw(frame, raw)) return false;
+    outString = formatText(raw, outputName, outputUnit);
+    return true;
+}
+
+/*
+ * The unscaled value decodeAsText would format for this frame. Frames giving the same raw value always give the
+ * same text, so callers collecting distinct values can keep these and only format the ones they end up showing.
+ * Not for STRING signals.
+ */
+bool DBCSnapshot::Signal::decodeTextRaw(const CANFrame &frame, int64_t &outRaw) const
+{
+    if (valType == STRING) return false;
+    const QByteArray payload = frame.payload();
+    if (valType == DP_FLOAT && payload.length() < 8) return false;
+    outRaw = textExtractor.extract(payload);
+    return true;
+}
+
+QString DBCSnapshot::Signal::formatText(int64_t raw, bool outputName, bool outputUnit) const
+{
+    int64_t result = raw;
+    bool isInteger = false;
+    double endResult;
+
+    if (valType == SIGNED_INT || valType == UNSIGNED_INT)
+    {
+        endResult = ((double)raw * factor) + bias;
+        result = (int64_t)endResult;
+        // if factor is an integer, we don't need the possibly human-unreadable float representation
+        isInteger = (factor == qFloor(factor));
+    }
+    else if (valType == SP_FLOAT)
+    {
+        uint32_t bits = static_cast<uint32_t>(raw);
+        float val;
+        memcpy(&val, &bits, sizeof(val));
+        endResult = (val * factor) + bias;
+    }
+    else //double precision float
+    {
+        double val;
+        memcpy(&val, &raw, sizeof(val));
+        endResult = (val * factor) + bias;
+    }
+
+    //same output as DBC_SIGNAL::makePrettyOutput
+    QString outString;
+    if (outputName) outString = name + ": ";
+    if (!values.isEmpty())
+    {
+        auto found = values.constFind(result);
+        if (found != values.constEnd()) outString += found.value();
+        else outString += QString::number(result);
+    }
+    else outString += (isInteger ? QString::number(result) : QString::number(endResult));
+    if (outputUnit) outString += " " + unitName;
+    return outString;
+}
+
+//same results as DBC_SIGNAL::processBatchAsDouble
+int DBCSnapshot::Signal::decodeBatchAsDouble(const CANFrame *frames, int count, double *out, bool *valid, int stride) const
+{
+    if (valType == STRING || count <= 0) return 0;
+
+    const int blockSize = 1024;
+    int64_t raw[blockSize];
+    bool ok[blockSize];
+    int numValid = 0;
+
+    for (int base = 0; base < count; base += blockSize)
+    {
+        int n = qMin(blockSize, count - base);
+        extractor.extractBatch(frames + static_cast<qsizetype>(base) * stride, n, stride, raw, ok, neededBytes);
+
+        double *dest = out + base;
+        if (valType == SIGNED_INT || valType == UNSIGNED_INT)
+        {
+            SignalExtractor::applyScale(raw, n, factor, bias, dest);
+        }
+        else if (valType == SP_FLOAT)
+        {
+            for (int i = 0; i < n; i++)
+            {
+                uint32_t bits = static_cast<uint32_t>(raw[i]);
+                float val;
+                memcpy(&val, &bits, sizeof(val));
+                dest[i] = (val * factor) + bias;
+            }
+        }
+        else
+        {
+            for (int i = 0; i < n; i++)
+            {
+                double val;
+                memcpy(&val, &raw[i], sizeof(val));
+                dest[i] = (val * factor) + bias;
+            }
+        }
+
+        for (int i = 0; i < n; i++)
+        {
+            if (ok[i]) numValid++;
+            else dest[i] = 0.0;
+        }
+        if (valid) memcpy(valid + base, ok, n * sizeof(bool));
+    }
+    return numValid;
+}
+
+/*
+ * The reverse of decodeAsDouble, using the same layouts so decoding the result gives the value back.
+ * The payload has to be long enough already, it is never resized here.
+ */
+bool DBCSnapshot::Signal::encodeFromDouble(double value, QByteArray &payload) const
+{
+    if (valType == STRING || qIsNaN(value)) return false;
+    if (!encoder.isValid() || !encoder.fits(payload.size()) || (payload.size() < neededBytes)) return false;
+    return encoder.insert(payload, physicalToRaw(value, valType, signalSize, factor, bias));
+}
+
+/*
+ * Put a whole set of signal values into a payload for this message in one go. The payload is grown to the message
+ * length first. Nothing is written unless every value passes the checks: the signal belongs to this message, the
+ * value is inside the signal's min / max (when the DBC gives a range), it can be encoded, and multiplexed signals
+ * are switched on by the multiplexor value that ends up in the payload.
+ */
+bool DBCSnapshot::Message::packSignals(const QList<QPair<const Signal *, double>> &values, QByteArray &payload, QString *errorString) const
+{
+    QByteArray packed(payload);
+    if (packed.size() < static_cast<int>(len)) packed.append(QByteArray(static_cast<int>(len) - packed.size(), 0));
+
+    for (const auto &entry : values)
+    {
+        const Signal *sig = entry.first;
+        if (!sig || sig->message != this)
+        {
+            if (errorString) *errorString = QObject::tr("Signal %1 is not part of message %2").arg(sig ? sig->name : QString(), name);
+            return false;
+        }
+        if ((sig->min < sig->max) && ((entry.second < sig->min) || (entry.second > sig->max)))
+        {
+            if (errorString) *errorString = QObject::tr("Value %1 is outside the range of signal %2").arg(entry.second).arg(sig->name);
+            return false;
+        }
+        if (!sig->encodeFromDouble(entry.second, packed))
+        {
+            if (errorString) *errorString = QObject::tr("Signal %1 could not be encoded into a %2 byte payload").arg(sig->name).arg(packed.size());
+            return false;
+        }
+    }
+
+    CANFrame check;
+    check.setPayload(packed);
+    for (const auto &entry : values)
+    {
+        if (entry.first->isMultiplexed && !entry.first->isInFrame(check))
+        {
+            if (errorString) *errorString = QObject::tr("Signal %1 is not selected by the multiplexor value").arg(entry.first->name);
+            return false;
+        }
+    }
+
+    payload = packed;
+    return true;
+}
+
+//same text as DBC_SIGNAL::processSignalTree: every child switched on by this multiplexor's value, depth first
+QString DBCSnapshot::Signal::decodeSignalTree(const CANFrame &frame) const
+{
+    QString build;
+    int32_t val;
+    if (!decodeAsInt(frame, val)) return build;
+
+    for (const Signal *sig : multiplexChildren)
+    {
+        if (!sig->isValueMatchingMultiplex(val)) continue;
+        QString sigString;
+        if (sig->decodeAsText(frame, sigString))
+        {
+            if (!build.isEmpty() && !sigString.isEmpty()) build.append("\n");
+            build.append(sigString);
+            if (sig->isMultiplexor)
+            {
+                QString subTreeString = sig->decodeSignalTree(frame);
+                if (!build.isEmpty() && !subTreeString.isEmpty()) build.append("\n");
+                build.append(subTreeString);
+            }
+        }
+    }
+    return build;
+}
@@ -0,0 +1,116 @@
+#ifndef DBCSNAPSHOT_H
+#define DBCSNAPSHOT_H
+
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+#include "dbc_classes.h"
+#include "dbchandler.h"
+#include "utils/signalencoder.h"
+#include "utils/signalextractor.h"
+
+/*
+ * Read only copy of every loaded DBC file, made for decoding on worker threads.
+ *
+ * The regular DBC classes are edited in place by the DBC editor, DBC_SIGNAL writes cachedValue on every decode
+ * and DBCHandler lives on the GUI thread, so none of them can be used from another thread. A snapshot copies
+ * what decoding needs into plain structures: message lookup tables per file and signals with their extractors
+ * already compiled. Once built it never changes, so any number of threads can decode with it at the same time.
+ *
+ * DBCHandler::getSnapshot() hands out the current snapshot as a shared pointer. Changes to the DBC files are
+ * published as a new snapshot and holders of the old one keep a consistent view until they let go of it.
+ */
+class DBCSnapshot
+{
+public:
+    struct Message;
+
+    struct Signal
+    {
+        QString name;
+        QString unitName;
+        DBC_SIG_VAL_TYPE valType;
+        bool intelByteOrder;
+        int startBit;
+        int signalSize;
+        double factor;
+        double bias;
+        double min;
+        double max;
+        bool isMultiplexor;
+        bool isMultiplexed;
+        QVector<QPair<int, int>> multiplexRanges;
+        const Signal *multiplexParent;
+        QVector<const Signal *> multiplexChildren; //same order as DBC_SIGNAL::multiplexedChildren
+        const Message *message;
+        QHash<qint64, QString> values; //value table, first description for a value wins like the linear search
+        const DBC_SIGNAL *source; //the signal this was copied from. Only compare it, never dereference off the GUI thread
+
+        bool decodeAsDouble(const CANFrame &frame, double &outValue) const;
+        bool decodeAsInt(const CANFrame &frame, int32_t &outValue) const;
+        bool decodeAsText(const CANFrame &frame, QString &outString, bool outputName = true, bool outputUnit = true) const;
+        bool decodeTextRaw(const CANFrame &frame, int64_t &outRaw) const;
+        QString formatText(int64_t raw, bool outputName = true, bool outputUnit = true) const;
+        QString decodeSignalTree(const CANFrame &frame) const;
+        int decodeBatchAsDouble(const CANFrame *frames, int count, double *out, bool *valid = nullptr, int stride = 1) const;
+        bool isInFrame(const CANFrame &frame) const;
+        bool isValueMatchingMultiplex(int val) const;
+        bool encodeFromDouble(double value, QByteArray &payload) const;
+
+        SignalExtractor extractor; //the layout processAsDouble / processAsInt use
+        SignalExtractor textExtractor; //floats decoded as text honor the byte order, processAsText does it that way
+        int neededBytes; //payload length processAsDouble wants
+        SignalEncoder encoder; //the extractor's layout for writing, STRING signals get an invalid one
+    };
+
+    struct Message
+    {
+        uint32_t ID;
+        bool extendedID;
+        QString name;
+        QString comment;
+        unsigned int len;
+        QVector<Signal> sigs;
+        const Signal *multiplexorSignal;
+        int fileIdx;
+        const DBC_MESSAGE *source; //same rules as Signal::source
+
+        const Signal *findSignal(const QString &name) const;
+        bool packSignals(const QList<QPair<const Signal *, double>> &values, QByteArray &payload, QString *errorString = nullptr) const;
+    };
+
+    static QSharedPointer<const DBCSnapshot> build(DBCHandler *handler, quint32 generation);
+
+    //same matching rules as DBCHandler::findMessage / DBCMessageHandler::findMsgByID
+    const Message *findMessage(const CANFrame &frame) const;
+    const Message *findMessage(uint32_t id, int bus) const;
+    const Message *findMessage(uint32_t id) const;
+    const Message *findMessage(const QString &name) const;
+    const Signal *findSignal(const DBC_SIGNAL *source) const;
+    int getMessageCount() const;
+    const Message *getMessageByIdx(int idx) const;
+    quint32 getGeneration() const;
+
+private:
+    DBCSnapshot() = default;
+    const Message *findInFile(int fileIdx, uint32_t id) const;
+
+    struct FileTables
+    {
+        int assocBus;
+        MatchingCriteria_t matchingCriteria;
+        QHash<uint32_t, int> exactIndex;
+        QHash<uint32_t, int> j1939PDU1Index;
+        QHash<uint32_t, int> j1939PDU2Index;
+        QHash<uint32_t, int> gmlanIndex;
+    };
+
+    QVector<Message> messages;
+    QVector<FileTables> files;
+    quint32 generation;
+};
+
+#endif // DBCSNAPSHOT_H
@@ -0,0 +1,210 @@
+#include "signalvaluestore.h"
+#include <algorithm>
+
+SignalValueStore* SignalValueStore::instance = nullptr;
+QAtomicInteger<quint32> SignalValueStore::frameEpoch(0);
+
+static const qint64 defaultMemoryBudget = 256ll * 1024 * 1024;
+
+qint64 SignalSeries::memoryUsed() const
+{
+    return timestamps.capacity() * static_cast<qint64>(sizeof(qint64))
+         + values.capacity() * static_cast<qint64>(sizeof(double))
+         + raw.capacity() * static_cast<qint64>(sizeof(int64_t))
+         + valid.capacity() * static_cast<qint64>(sizeof(bool))
+         + frameIndex.capacity() * static_cast<qint64>(sizeof(int));
+}
+
+//row decoded from frames->at(frameIdx), -1 if that frame isn't in the series
+int SignalSeries::rowOfFrame(int frameIdx) const
+{
+    auto it = std::lower_bound(frameIndex.constBegin(), frameIndex.constEnd(), frameIdx);
+    if (it == frameIndex.constEnd() || *it != frameIdx) return -1;
+    return static_cast<int>(it - frameIndex.constBegin());
+}
+
+/*
+ * Same text processAsText gives for the frame of this row. Integer signals are formatted straight from the raw
+ * column, text of those is decoded with the very same layout. Floats and strings are read from the frame again,
+ * frames is the list the series was built from.
+ */
+bool SignalSeries::textAt(int row, const QVector<CANFrame> &frames, const DBCSnapshot::Signal *sig, QString &outString,
+                          bool outputName, bool outputUnit) const
+{
+    if (row < 0 || row >= count() || !sig) return false;
+    if (sig->valType == SIGNED_INT || sig->valType == UNSIGNED_INT)
+    {
+        outString = sig->formatText(raw.at(row), outputName, outputUnit);
+        return true;
+    }
+    return sig->decodeAsText(frames.at(frameIndex.at(row)), outString, outputName, outputUnit);
+}
+
+uint qHash(const SignalValueStore::Key &key, uint seed)
+{
+    seed = qHash(key.frames, seed);
+    seed = qHash(key.sig, seed);
+    seed = qHash(key.frameId, seed);
+    return qHash(key.bus, seed);
+}
+
+SignalValueStore::SignalValueStore()
+{
+    currentGeneration = 0;
+    useCounter = 0;
+    memoryBudget = defaultMemoryBudget;
+    memoryUsed = 0;
+}
+
+SignalValueStore* SignalValueStore::getReference()
+{
+    if (!instance) instance = new SignalValueStore();
+    return instance;
+}
+
+//called whenever frames already in a list change or go away. Appending frames doesn't need this.
+void SignalValueStore::invalidateFrames()
+{
+    frameEpoch.fetchAndAddOrdered(1);
+}
+
+//changes whenever invalidateFrames is called. Other caches built over frame lists can watch it too
+quint32 SignalValueStore::getFrameEpoch()
+{
+    return frameEpoch.loadAcquire();
+}
+
+QSharedPointer<const SignalSeries> SignalValueStore::getSeries(const QVector<CANFrame> *frames,
+                                                               const QSharedPointer<const DBCSnapshot> &snapshot,
+                                                               const DBCSnapshot::Signal *sig, uint32_t frameId, int bus)
+{
+    if (!frames || !snapshot || !sig) return QSharedPointer<const SignalSeries>();
+
+    //series of an older snapshot can never be asked for again once the DBC changed, drop them all at once
+    if (snapshot->getGeneration() != currentGeneration)
+    {
+        for (auto it = entries.begin(); it != entries.end(); )
+        {
+            if (it.value().snapshot->getGeneration() != snapshot->getGeneration())
+            {
+                memoryUsed -= it.value().memoryUsed;
+                it = entries.erase(it);
+            }
+            else ++it;
+        }
+        currentGeneration = snapshot->getGeneration();
+    }
+
+    Key key{frames, sig, frameId, bus};
+    auto it = entries.find(key);
+    if (it == entries.end())
+    {
+        Entry entry;
+        entry.snapshot = snapshot;
+        entry.series.reset(new SignalSeries);
+        entry.rawExtractor.compile(sig->startBit, sig->signalSize, sig->intelByteOrder, sig->valType == SIGNED_INT);
+        entry.scannedFrames = 0;
+        entry.frameEpoch = frameEpoch.loadAcquire();
+        entry.memoryUsed = 0;
+        it = entries.insert(key, entry);
+    }
+
+    Entry &entry = it.value();
+    //frames were replaced under us. Start a fresh series, whoever still holds the old one keeps a consistent copy
+    if (entry.frameEpoch != frameEpoch.loadAcquire() || entry.scannedFrames > frames->count())
+    {
+        entry.series.reset(new SignalSeries);
+        entry.scannedFrames = 0;
+        entry.frameEpoch = frameEpoch.loadAcquire();
+    }
+
+    entry.lastUse = ++useCounter;
+    if (entry.scannedFrames < frames->count())
+    {
+        scanNewFrames(key, entry);
+        evict(key);
+    }
+    return entry.series;
+}
+
+/*
+ * Same as getSeries but only for series that are already here. Returns null instead of scanning the whole frame
+ * list, for callers that have a cheaper way to decode many signals at once. Frames appended since still get added.
+ */
+QSharedPointer<const SignalSeries> SignalValueStore::getCachedSeries(const QVector<CANFrame> *frames,
+                                                                     const QSharedPointer<const DBCSnapshot> &snapshot,
+                                                                     const DBCSnapshot::Signal *sig, uint32_t frameId, int bus)
+{
+    if (!frames || !snapshot || !sig) return QSharedPointer<const SignalSeries>();
+    auto it = entries.constFind(Key{frames, sig, frameId, bus});
+    if (it == entries.constEnd()) return QSharedPointer<const SignalSeries>();
+    if (it.value().frameEpoch != frameEpoch.loadAcquire() || it.value().scannedFrames > frames->count())
+        return QSharedPointer<const SignalSeries>();
+    return getSeries(frames, snapshot, sig, frameId, bus);
+}
+
+void SignalValueStore::scanNewFrames(const Key &key, Entry &entry)
+{
+    const QVector<CANFrame> &frames = *key.frames;
+    SignalSeries *series = entry.series.data();
+    const DBCSnapshot::Signal *sig = key.sig;
+
+    for (int i = entry.scannedFrames; i < frames.count(); i++)
+    {
+        const CANFrame &frame = frames.at(i);
+        if (frame.frameId() != key.frameId || frame.frameType() != QCanBusFrame::DataFrame) continue;
+        if (key.bus != -1 && frame.bus != key.bus) continue;
+        if (!sig->isInFrame(frame)) continue;
+
+        double value = 0.0;
+        bool ok = sig->decodeAsDouble(frame, value);
+        series->timestamps.append(frame.timeStamp().microSeconds());
+        series->values.append(value);
+        series->raw.append(entry.rawExtractor.extract(frame.payload()));
+        series->valid.append(ok);
+        series->frameIndex.append(i);
+    }
+    entry.scannedFrames = frames.count();
+
+    qint64 newSize = series->memoryUsed();
+    memoryUsed += newSize - entry.memoryUsed;
+    entry.memoryUsed = newSize;
+}
+
+void SignalValueStore::evict(const Key &keep)
+{
+    while (memoryUsed > memoryBudget && entries.count() > 1)
+    {
+        auto oldest = entries.end();
+        for (auto it = entries.begin(); it != entries.end(); ++it)
+        {
+            if (it.key() == keep) continue;
+            if (oldest == entries.end() || it.value().lastUse < oldest.value().lastUse) oldest = it;
+        }
+        if (oldest == entries.end()) break;
+        memoryUsed -= oldest.value().memoryUsed;
+        entries.erase(oldest);
+    }
+}
+
+void SignalValueStore::setMemoryBudget(qint64 bytes)
+{
+    memoryBudget = bytes;
+    evict(Key{nullptr, nullptr, 0, 0});
+}
+
+qint64 SignalValueStore::getMemoryBudget() const
+{
+    return memoryBudget;
+}
+
+qint64 SignalValueStore::getMemoryUsed() const
+{
+    return memoryUsed;
+}
+
+void SignalValueStore::clear()
+{
+    entries.clear();
+    memoryUsed = 0;
+}
@@ -0,0 +1,105 @@
+#ifndef SIGNALVALUESTORE_H
+#define SIGNALVALUESTORE_H
+
+#include <QAtomicInteger>
+#include <QHash>
+#include <QSharedPointer>
+#include <QVector>
+#include "can_structs.h"
+#include "dbcsnapshot.h"
+
+/*
+ * Decoded values of one signal over a list of frames, as columns. Row i is the i-th frame of the list that has
+ * the message ID, is on the bus and carries the signal (multiplexing included).
+ * value is what processAsDouble gives, valid is false where that decode failed (frame too short, string signal).
+ * raw is the integer pulled out with the signal's own layout, that's what value tables are looked up with.
+ * frameIndex is where in the frame list the row came from, rising from row to row.
+ */
+struct SignalSeries
+{
+    QVector<qint64> timestamps; //microseconds, straight from the frame
+    QVector<double> values;
+    QVector<int64_t> raw;
+    QVector<bool> valid;
+    QVector<int> frameIndex;
+
+    int count() const { return timestamps.count(); }
+    int rowOfFrame(int frameIdx) const;
+    bool textAt(int row, const QVector<CANFrame> &frames, const DBCSnapshot::Signal *sig, QString &outString,
+                bool outputName = true, bool outputUnit = true) const;
+    qint64 memoryUsed() const;
+};
+
+/*
+ * Shared cache of decoded signal time series. Graphing the same signal twice, re-opening a graph or a second
+ * window showing the signal all get the columns that were decoded the first time.
+ *
+ * Series are keyed by (frame list, DBC snapshot signal, message ID, bus). The snapshot signal ties a series to
+ * one DBC snapshot so edits to the DBC give new series, the entry keeps its snapshot alive for as long as it
+ * exists. Columns are filled lazily: the first request scans the frame list, later requests only decode the
+ * frames appended since. Anything that changes frames already in a list (clearing, trimming the front, timestamp
+ * normalization) must call invalidateFrames() and every series gets rebuilt on its next use.
+ *
+ * The total size of all columns is kept under a memory budget by dropping the least recently used series.
+ * Everything here runs on the GUI thread, same as the frame lists it reads.
+ */
+class SignalValueStore
+{
+public:
+    static SignalValueStore *getReference();
+    static void invalidateFrames();
+    static quint32 getFrameEpoch();
+
+    QSharedPointer<const SignalSeries> getSeries(const QVector<CANFrame> *frames,
+                                                 const QSharedPointer<const DBCSnapshot> &snapshot,
+                                                 const DBCSnapshot::Signal *sig, uint32_t frameId, int bus);
+    QSharedPointer<const SignalSeries> getCachedSeries(const QVector<CANFrame> *frames,
+                                                       const QSharedPointer<const DBCSnapshot> &snapshot,
+                                                       const DBCSnapshot::Signal *sig, uint32_t frameId, int bus);
+    void setMemoryBudget(qint64 bytes);
+    qint64 getMemoryBudget() const;
+    qint64 getMemoryUsed() const;
+    void clear();
+
+private:
+    SignalValueStore();
+
+    struct Key
+    {
+        const QVector<CANFrame> *frames;
+        const DBCSnapshot::Signal *sig;
+        uint32_t frameId;
+        int bus;
+
+        bool operator==(const Key &other) const
+        {
+            return frames == other.frames && sig == other.sig && frameId == other.frameId && bus == other.bus;
+        }
+    };
+    friend uint qHash(const Key &key, uint seed);
+
+    struct Entry
+    {
+        QSharedPointer<const DBCSnapshot> snapshot;
+        QSharedPointer<SignalSeries> series;
+        SignalExtractor rawExtractor;
+        int scannedFrames;
+        quint32 frameEpoch;
+        quint64 lastUse;
+        qint64 memoryUsed;
+    };
+
+    void scanNewFrames(const Key &key, Entry &entry);
+    void evict(const Key &keep);
+
+    static SignalValueStore *instance;
+    static QAtomicInteger<quint32> frameEpoch;
+
+    QHash<Key, Entry> entries;
+    quint32 currentGeneration;
+    quint64 useCounter;
+    qint64 memoryBudget;
+    qint64 memoryUsed;
+};
+
+#endif // SIGNALVALUESTORE_H
@@ -6,14 +6,28 @@
 #include <QRegularExpression>
 #include <QtEndian>
 #include <QSettings>
+#include <QThread>
+#include <QEventLoop>
+#include <QFutureWatcher>
+#include <QtConcurrent/QtConcurrentMap>
+#include <algorithm>
 #include <iostream>
 #include <memory>
+#include <queue>
 #include "pcaplite.h"
 
 #include "utility.h"
 #include "blfhandler.h"
+#include "utils/textformatter.h"
+
+//SocketCAN frame layout used by LINKTYPE_CAN_SOCKETCAN
+#define SOCKETCAN_CAN_MTU 16
+#define SOCKETCAN_CANFD_MTU 72
+#define SOCKETCAN_CANFD_BRS 0x01
+#define SOCKETCAN_CANFD_FDF 0x04
 
 QFile FrameFileIO::continuousFile;
+FrameLoadFilter FrameFileIO::loadFilter;
 
 struct TeslaAPCANRecord
 {
@@ -53,6 +67,8 @@ bool FrameFileIO::saveFrameFile(QString &fileName, const QVector<CANFrame>* fram
     filters.append(QString(tr("Cabana Log (*.csv *.CSV)")));
     filters.append(QString(tr("CANalyzer Ascii Log (*.asc *.ASC)")));
     filters.append(QString(tr("CARBUS Analyzer (*.trc *.TRC)")));
+    filters.append(QString(tr("CANalyzer Binary Log Files (*.blf *.BLF)")));
+    filters.append(QString(tr("Wireshark SocketCAN (*.pcapng *.PCAPNG)")));
 
     dialog.setDirectory(settings.value("FileIO/LoadSaveDirectory", dialog.directory().path()).toString());
     dialog.setFileMode(QFileDialog::AnyFile);
@@ -143,6 +159,16 @@ bool FrameFileIO::saveFrameFile(QString &fileName, const QVector<CANFrame>* fram
             if (!filename.contains('.')) filename += ".trc";
             result = saveCARBUSAnalzyer(filename, frameCache);
         }
+        if (dialog.selectedNameFilter() == filters[13])
+        {
+            if (!filename.contains('.')) filename += ".blf";
+            result = saveCanalyzerBLF(filename, frameCache);
+        }
+        if (dialog.selectedNameFilter() == filters[14])
+        {
+            if (!filename.contains('.')) filename += ".pcapng";
+            result = saveWiresharkSocketCANFile(filename, frameCache);
+        }
 
         progress.cancel();
 
@@ -191,7 +217,7 @@ bool FrameFileIO::loadFrameFile(QString &fileName, QVector<CANFrame>* frameCache
     filters.append(QString(tr("CLX000 (*.txt *.TXT)")));
     filters.append(QString(tr("CANServer Binary Log (*.log *.LOG)")));
     filters.append(QString(tr("Wireshark (*.pcap *.PCAP *.pcapng *.PCAPNG)")));
-    filters.append(QString(tr("Wireshark SocketCAN (*.pcap *.PCAP")));
+    filters.append(QString(tr("Wireshark SocketCAN (*.pcap *.PCAP *.pcapng *.PCAPNG)")));
 
     dialog.setDirectory(settings.value("FileIO/LoadSaveDirectory", dialog.directory().path()).toString());
     dialog.setFileMode(QFileDialog::ExistingFile);
@@ -213,6 +239,7 @@ bool FrameFileIO::loadFrameFile(QString &fileName, QVector<CANFrame>* frameCache
 
         qApp->processEvents();
 
+        int startCount = frameCache->count();
         if (selectedNameFilter == filters[0]) result = autoDetectLoadFile(filename, frameCache);
         if (selectedNameFilter == filters[1]) result = loadNativeCSVFile(filename, frameCache);
         if (selectedNameFilter == filters[2]) result = loadCRTDFile(filename, frameCache);
@@ -240,6 +267,8 @@ bool FrameFileIO::loadFrameFile(QString &fileName, QVector<CANFrame>* frameCache
         if (selectedNameFilter == filters[24]) result = loadWiresharkFile(filename, frameCache);
         if (selectedNameFilter == filters[25]) result = loadWiresharkSocketCANFile(filename, frameCache);
 
+        //catches the formats that don't check the filter themselves
+        applyLoadFilter(frameCache, startCount);
 
         progress.cancel();
 
@@ -264,11 +293,41 @@ bool FrameFileIO::loadFrameFile(QString &fileName, QVector<CANFrame>* frameCache
     return false;
 }
 
+bool FrameFileIO::loadFilteredFrameFile(QString &fileName, QVector<CANFrame>* frameCache, const FrameLoadFilter &filter)
+{
+    setLoadFilter(filter);
+    bool result = loadFrameFile(fileName, frameCache);
+    clearLoadFilter();
+    return result;
+}
+
+void FrameFileIO::setLoadFilter(const FrameLoadFilter &filter)
+{
+    loadFilter = filter;
+}
+
+void FrameFileIO::clearLoadFilter()
+{
+    loadFilter.clear();
+}
+
+const FrameLoadFilter &FrameFileIO::getLoadFilter()
+{
+    return loadFilter;
+}
+
+void FrameFileIO::applyLoadFilter(QVector<CANFrame>* frames, int firstNew)
+{
+    if (!loadFilter.isActive() || firstNew >= frames->count()) return;
+    auto newEnd = std::remove_if(frames->begin() + firstNew, frames->end(),
+                                 [](const CANFrame &frame) { return !loadFilter.accepts(frame); });
+    frames->erase(newEnd, frames->end());
+}
 
 //Try every format by first using the "is" functions which try to detect whether a given file is a good match to that
 //file format or not. Those functions are much less tolerant than the load functions and so should help to discriminate
 //whether a file could be loaded or not by a given loader. The loader return is still used in case the guess was wrong.
-bool FrameFileIO::autoDetectLoadFile(QString filename, QVector<CANFrame>* frames)
+bool FrameFileIO::autoDetectLoadFile(QString filename, QVector<CANFrame>* frames, bool showErrors)
 {
     qDebug() << "Attempting Canalyzer BLF";
     if (isCanalyzerBLF(filename))
@@ -518,13 +577,149 @@ bool FrameFileIO::autoDetectLoadFile(QString filename, QVector<CANFrame>* frames
         }
     }
 
-    QMessageBox msgBox;
-    msgBox.setText("Could not autodetect the file type.\rPlease try to manually select the file format.");
-    msgBox.exec();
+    if (showErrors)
+    {
+        QMessageBox msgBox;
+        msgBox.setText("Could not autodetect the file type.\rPlease try to manually select the file format.");
+        msgBox.exec();
+    }
     qDebug() << "Nothing worked... sorry...";
     return false;
 }
 
+struct MergeSource
+{
+    QString filename;
+    QVector<CANFrame> frames;
+    bool result;
+};
+
+//runs on the thread pool. No message boxes can be shown from here so the autodetect stays quiet
+static void loadMergeSource(MergeSource &source)
+{
+    source.result = FrameFileIO::autoDetectLoadFile(source.filename, &source.frames, false);
+    std::stable_sort(source.frames.begin(), source.frames.end()); //usually already in order, then this is cheap
+}
+
+struct MergeHead
+{
+    qint64 timeStamp;
+    int source;
+    int index;
+
+    //priority_queue is a max heap. Ties go to the earlier file so the merge is stable
+    bool operator<(const MergeHead &other) const
+    {
+        if (timeStamp != other.timeStamp) return timeStamp > other.timeStamp;
+        return source > other.source;
+    }
+};
+
+bool FrameFileIO::mergeLoadFiles(const QStringList &filenames, QVector<CANFrame>* frames)
+{
+    QVector<MergeSource> sources(filenames.count());
+    bool result = true;
+    for (int i = 0; i < filenames.count(); i++)
+    {
+        sources[i].filename = filenames[i];
+        sources[i].result = false;
+    }
+
+    //every file is parsed on its own pool thread. The local event loop only keeps the caller's progress dialog
+    //painting until they are all done, frames isn't touched before that
+    QFutureWatcher<void> loadWatcher;
+    QEventLoop waitLoop;
+    QObject::connect(&loadWatcher, &QFutureWatcher<void>::finished, &waitLoop, &QEventLoop::quit);
+    loadWatcher.setFuture(QtConcurrent::map(sources, loadMergeSource));
+    if (!loadWatcher.isFinished()) waitLoop.exec(QEventLoop::ExcludeUserInputEvents);
+    loadWatcher.waitForFinished();
+
+    //give each file its own range of buses so the origin of a frame stays visible after merging
+    int busOffset = 0;
+    int totalFrames = 0;
+    std::priority_queue<MergeHead> heads;
+    for (int i = 0; i < sources.count(); i++)
+    {
+        if (!sources[i].result)
+        {
+            qDebug() << "Could not load " << filenames[i] << " for merging";
+            result = false;
+        }
+        int maxBus = -1;
+        for (CANFrame &frame : sources[i].frames)
+        {
+            maxBus = qMax(maxBus, frame.bus);
+            frame.bus += busOffset;
+        }
+        busOffset += maxBus + 1;
+        totalFrames += sources[i].frames.count();
+        if (!sources[i].frames.isEmpty()) heads.push({sources[i].frames[0].timeStamp().microSeconds(), i, 0});
+    }
+
+    //k-way merge. Each step takes the oldest head frame and advances that file. It is only copying so it runs without
+    //handing control back to the event loop, nothing gets to look at frames while it is half built
+    frames->reserve(frames->count() + totalFrames);
+    while (!heads.empty())
+    {
+        MergeHead head = heads.top();
+        heads.pop();
+        const QVector<CANFrame> &source = sources[head.source].frames;
+        frames->append(source[head.index]);
+        if (++head.index < source.count())
+        {
+            head.timeStamp = source[head.index].timeStamp().microSeconds();
+            heads.push(head);
+        }
+        else sources[head.source].frames = QVector<CANFrame>(); //done with this file, give the memory back
+    }
+
+    return result;
+}
+
+bool FrameFileIO::loadMultipleFrameFiles(QString &fileName, QVector<CANFrame>* frameCache)
+{
+    QFileDialog dialog;
+    QSettings settings;
+
+    dialog.setDirectory(settings.value("FileIO/LoadSaveDirectory", dialog.directory().path()).toString());
+    dialog.setFileMode(QFileDialog::ExistingFiles);
+    dialog.setNameFilter(QString(tr("Log Files (*.*)")));
+    dialog.setViewMode(QFileDialog::Detail);
+
+    if (dialog.exec() == QDialog::Accepted)
+    {
+        QStringList filenames = dialog.selectedFiles();
+
+        QProgressDialog progress(qApp->activeWindow());
+        progress.setWindowModality(Qt::WindowModal);
+        progress.setLabelText("Loading and merging files...");
+        progress.setCancelButton(nullptr);
+        progress.setRange(0,0);
+        progress.setMinimumDuration(0);
+        progress.show();
+
+        qApp->processEvents();
+
+        bool result = mergeLoadFiles(filenames, frameCache);
+
+        progress.cancel();
+
+        QStringList names;
+        for (const QString &name : filenames) names.append(name.split('/').last());
+        fileName = names.join(", ");
+        settings.setValue("FileIO/LoadSaveDirectory", dialog.directory().path());
+
+        if (!result)
+        {
+            QMessageBox msgBox;
+            msgBox.setText("Some of the files could not be loaded.\r\nOnly the frames that could be loaded were merged.");
+            msgBox.exec();
+        }
+        return result;
+    }
+    return false;
+}
+
 
 bool FrameFileIO::isVehicleSpyFile(QString filename)
 {
@@ -735,6 +930,7 @@ bool FrameFileIO::loadCRTDFile(QString filename, QVector<CANFrame>* frames)
     QByteArray line;
     int lineCounter = 0;
     bool foundErrors = false;
+    const bool filterActive = loadFilter.isActive();
 
     if (!inFile->open(QIODevice::ReadOnly | QIODevice::Text))
     {
@@ -781,7 +977,9 @@ bool FrameFileIO::loadCRTDFile(QString filename, QVector<CANFrame>* frames)
                 }
                 if (firstChar == 'R' || firstChar == 'T')
                 {
-                    thisFrame.setFrameId(static_cast<uint32_t>(tokens[2].toInt(nullptr, 16)));
+                    uint32_t frameId = static_cast<uint32_t>(tokens[2].toInt(nullptr, 16));
+                    if (filterActive && !loadFilter.accepts(frameId, thisFrame.bus, thisFrame.timeStamp().microSeconds())) continue;
+                    thisFrame.setFrameId(frameId);
                     if (tokens[1] == "R29" || tokens[1] == "T29") thisFrame.setExtendedFrameFormat(true);
                         else thisFrame.setExtendedFrameFormat(false);
                     if (firstChar == 'T') thisFrame.isReceived = false;
@@ -930,8 +1128,6 @@ bool FrameFileIO::saveCARBUSAnalzyer(QString filename, const QVector<CANFrame>*
     }
     QTextStream outTextStream(outFile);
 
-    int lineCounter = 0;
-
     qint64 minTime = frames->at(0).timeStamp().microSeconds();
     qint64 maxTime = minTime;
     for (int c = 0; c < frames->count(); c++)
@@ -954,68 +1150,56 @@ bool FrameFileIO::saveCARBUSAnalzyer(QString filename, const QVector<CANFrame>*
     // saving in version format 3 with microseconds in packets time
     outTextStream << "@ TEXT @ 3 @ 64 @ 0 @ " << frames->count() <<  " @ " << totalTime
                   <<" @ " << someTime.toString("hh:mm:ss.zzz") <<" @\r";
+    outTextStream.flush();
 
-    const unsigned char *data;
-    for (int c = 0; c < frames->count(); c++)
+    bool result = TextFormatter::writeChunked(outFile, frames->count(), [frames](TextFormatter &out, int first, int last)
     {
-        lineCounter++;
-        if (lineCounter > 100)
+        for (int c = first; c < last; c++)
         {
-            qApp->processEvents();
-            lineCounter = 0;
-        }
-        auto frame = frames->at(c);
-
-        uint64_t timeStamp = frame.timeStamp().microSeconds();
-        QString canId = QString::number(frame.frameId(), 16).toUpper().rightJustified(3, '0').toUtf8();
-        QString canDlc = QString::number(frame.payload().length()).toUtf8();
-
-        QString ascii = "";
-        QString finalCanData;
+            const CANFrame *frame = &frames->at(c);
+            const QByteArray payload = frame->payload();
+            const unsigned char *data = reinterpret_cast<const unsigned char *>(payload.constData());
+            int dataLen = payload.length();
+
+            uint64_t timeStamp = frame->timeStamp().microSeconds();
+            out.appendDec(timeStamp / 1000000);
+            out.appendChar(',');
+            out.appendDec(timeStamp % 1000000);
+            out.appendChar('\t');
+            out.appendSignedDec(frame->bus); // bus channel
+            out.append("\t0004\t"); // it's CAN frame
+            out.appendHex(frame->frameId(), 3);
+            out.appendChar('\t');
+            out.appendDec(dataLen);
+            out.appendChar('\t');
+
+            //data bytes separated by spaces then padded out to the width of 8 bytes
+            int dataWidth = 0;
+            if (dataLen > 0)
+            {
+                out.appendHexBytes(data, dataLen - 1, " ", 1);
+                out.appendHexByte(data[dataLen - 1]);
+                dataWidth = (dataLen * 3) - 1;
+            }
+            out.appendChars(' ', 23 - dataWidth);
+            out.append("\t00000000\t");
 
-        data = reinterpret_cast<const unsigned char *>(frame.payload().constData());
-        for (int d = 0; d < frame.payload().length(); d++)
-        {
-            auto octet = data[d];
-            finalCanData.append(QString::number(octet, 16).toUpper().rightJustified(2, '0').toUtf8());
-            finalCanData.append(" ");
-
-            QString strCode = QString::number(octet, 16);
-            bool conv;
-            uint symbolCode = strCode.toInt(&conv, 16);
-
-            if ((symbolCode >= 32 && symbolCode < 126)) {
-                QChar localQChar = QChar(symbolCode);
-                if (localQChar.toLatin1() != 0) {
-                   ascii += QString::fromLocal8Bit(QByteArray::fromHex(strCode.toLatin1()));
-              }
-            } else {
-                ascii += " ";
+            int asciiLen = 0;
+            for (int d = 0; d < dataLen; d++)
+            {
+                if (data[d] >= 32 && data[d] < 126) out.appendChar(static_cast<char>(data[d]));
+                else out.appendChar(' ');
+                asciiLen++;
             }
+            out.appendChars(' ', 8 - asciiLen);
+            out.append("\t\r");
         }
-        finalCanData = finalCanData.trimmed().leftJustified(23, ' ');
-        ascii = ascii.leftJustified(8, ' ');
-        auto seconds = QString::number(timeStamp / 1000000);
-        auto uSeconds = QString::number(timeStamp % 1000000);
-        QString localArg = "";
-        localArg.append(seconds).append(",").append(uSeconds).append("\t")
-                .append(QString::number(frame.bus)).append("\t") // bus channel
-                .append("0004").append("\t") // it's CAN frame
-                .append(canId).append("\t")
-                .append(canDlc).append("\t")
-                .append(finalCanData).append("\t")
-                .append("00000000").append("\t")
-                .append(ascii).append("\t")
-                .append("\r");
-
-        qDebug() << localArg;
-        outTextStream << localArg;
-    }
+    });
 
     outFile->close();
     delete outFile;
 
-    return true;
+    return result;
 }
 
 bool FrameFileIO::isCANHackerFile(QString filename)
@@ -1271,11 +1455,6 @@ bool FrameFileIO::loadCANOpenFile(QString filename, QVector<CANFrame>* frames)
 bool FrameFileIO::saveCRTDFile(QString filename, const QVector<CANFrame>* frames)
 {
     QFile *outFile = new QFile(filename);
-    int lineCounter = 0;
-
-    const unsigned char *data;
-    int dataLen;
-    const CANFrame *frame;
 
     if (!outFile->open(QIODevice::WriteOnly | QIODevice::Text))
     {
@@ -1287,46 +1466,34 @@ bool FrameFileIO::saveCRTDFile(QString filename, const QVector<CANFrame>* frames
     outFile->write(QString::number(frames->at(0).timeStamp().microSeconds() / 1000000.0, 'f', 6).toUtf8() + tr(" CXX GVRET-PC Reverse Engineering Tool Output V").toUtf8() + QString::number(VERSION).toUtf8());
     outFile->write("\n");
 
-    for (int c = 0; c < frames->count(); c++)
+    bool result = TextFormatter::writeChunked(outFile, frames->count(), [frames](TextFormatter &out, int first, int last)
     {
-        lineCounter++;
-        if (lineCounter > 100)
+        for (int c = first; c < last; c++)
         {
-            qApp->processEvents();
-            lineCounter = 0;
-        }
+            const CANFrame *frame = &frames->at(c);
+            const QByteArray payload = frame->payload();
 
-        frame = &frames->at(c);
-        data = reinterpret_cast<const unsigned char *>(frame->payload().constData());
-        dataLen = frame->payload().count();
+            out.appendFixed(frame->timeStamp().microSeconds(), 6, 6);
+            out.appendChar(' ');
 
-        outFile->write(QString::number(frame->timeStamp().microSeconds() / 1000000.0, 'f', 6).toUtf8());
-        outFile->putChar(' ');
+            out.appendSignedDec(frame->bus + 1);
+            if (frame->isReceived) out.appendChar('R');
+            else out.appendChar('T');
 
-        outFile->write(QString::number(frame->bus + 1).toUtf8());
-        if (frame->isReceived) outFile->putChar('R');
-        else outFile->putChar('T');
+            if (frame->hasExtendedFrameFormat()) out.append("29 ");
+            else out.append("11 ");
+            out.appendHex(frame->frameId(), 8);
+            out.appendChar(' ');
 
-        if (frame->hasExtendedFrameFormat())
-        {
-            outFile->write("29 ");
+            out.appendHexBytes(reinterpret_cast<const unsigned char *>(payload.constData()), payload.count(), " ", 1);
+            out.appendChar('\n');
         }
-        else outFile->write("11 ");
-        outFile->write(QString::number(frame->frameId(), 16).toUpper().rightJustified(8, '0').toUtf8());
-        outFile->putChar(' ');
+    });
 
-        for (int temp = 0; temp < dataLen; temp++)
-        {
-            outFile->write(QString::number(data[temp], 16).toUpper().rightJustified(2, '0').toUtf8());
-            outFile->putChar(' ');
-        }
-
-        outFile->write("\n");
-    }
     outFile->close();
     delete outFile;
 
-    return true;
+    return result;
 }
 
 
@@ -1699,6 +1866,7 @@ bool FrameFileIO::loadCanalyzerASC(QString filename, QVector<CANFrame>* frames)
     int lineCounter = 0;
     bool foundErrors = false;
     bool inHeader = true;
+    const bool filterActive = loadFilter.isActive();
     int verMajor;
     int verMinor;
     int verRevision;
@@ -1767,6 +1935,7 @@ bool FrameFileIO::loadCanalyzerASC(QString filename, QVector<CANFrame>* frames)
                             thisFrame.setFrameId(tokens[4].toUInt(nullptr, 16));
                             thisFrame.setExtendedFrameFormat(thisFrame.frameId() > 0x7FF);  //some .asc files have extended IDs without 'x'
                         }
+                        if (filterActive && !loadFilter.accepts(thisFrame.frameId(), tokens[2].toInt(), thisFrame.timeStamp().microSeconds())) continue;
 
                         int payloadLen = tokens[8].toInt();
                         qDebug() << "PayloadLen: " << payloadLen << " Tokens: " << tokens;
@@ -1837,6 +2006,7 @@ bool FrameFileIO::loadCanalyzerASC(QString filename, QVector<CANFrame>* frames)
                             thisFrame.setFrameId(tokens[2].toUInt(nullptr, 16));
                             thisFrame.setExtendedFrameFormat(thisFrame.frameId() > 0x7FF);  //some .asc files have extended IDs without 'x'
                         }
+                        if (filterActive && !loadFilter.accepts(thisFrame.frameId(), tokens[1].toInt(), thisFrame.timeStamp().microSeconds())) continue;
                         QByteArray bytes(payloadLen, 0);
 
                         if (payloadLen > 8)
@@ -1882,13 +2052,8 @@ bool FrameFileIO::loadCanalyzerASC(QString filename, QVector<CANFrame>* frames)
 bool FrameFileIO::saveCanalyzerASC(QString filename, const QVector<CANFrame>* frames)
 {
     QFile *outFile = new QFile(filename);
-    int lineCounter = 0;
     int64_t offsetTime = frames->at(0).timeStamp().microSeconds();
 
-    const unsigned char *data;
-    int dataLen;
-    const CANFrame *frame;
-
     for (int c = 0; c < frames->count(); c++)
     {
         if (frames->at(c).timeStamp().microSeconds() < offsetTime) offsetTime = frames->at(c).timeStamp().microSeconds();
@@ -1912,62 +2077,56 @@ bool FrameFileIO::saveCanalyzerASC(QString filename, const QVector<CANFrame>* fr
     outFile->write("no internal event logging\n");
     outFile->write("// version 11.0.0\n");
 
-    for (int c = 0; c < frames->count(); c++)
+    bool result = TextFormatter::writeChunked(outFile, frames->count(), [frames, offsetTime](TextFormatter &out, int first, int last)
     {
-        lineCounter++;
-        if (lineCounter > 100)
-        {
-            qApp->processEvents();
-            lineCounter = 0;
-        }
-
-        frame = &frames->at(c);
-        data = reinterpret_cast<const unsigned char *>(frame->payload().constData());
-        dataLen = frame->payload().count();
-
-        uint64_t timeStamp = (frame->timeStamp().microSeconds() - offsetTime) / 1000000ull;
-        int tsLen = QString::number(timeStamp).length();
-        int precision = 6;
-        //vector seems to keep 10 bytes at the start of the line for the timestamp. It should never exceed this
-        //and there should never be a precision over 6 digits after the decimal
-        if (tsLen > 3) precision = 9 - tsLen;
-        outFile->write(QString::number((frame->timeStamp().microSeconds() - offsetTime) / 1000000.0, 'f', precision).rightJustified(10, ' ').toUtf8());
-        outFile->putChar(' ');
-        outFile->write(QString::number(frame->bus + 1).toUtf8());
-        outFile->write("  ");
-        if (frames->at(c).hasExtendedFrameFormat())
+        for (int c = first; c < last; c++)
         {
-            outFile->write(QString::number(frame->frameId(), 16).toUpper().rightJustified(8, '0').toUtf8());
-            outFile->write("x");
-        }
-        else
-        {
-            outFile->write(QString::number(frame->frameId(), 16).toUpper().rightJustified(3, '0').toUtf8());
-            outFile->write("      ");
-        }
-        outFile->write("   ");
+            const CANFrame *frame = &frames->at(c);
+            const QByteArray payload = frame->payload();
+            int dataLen = payload.count();
+
+            int64_t relTime = frame->timeStamp().microSeconds() - offsetTime;
+            uint64_t timeStamp = relTime / 1000000ull;
+            int tsLen = 1;
+            for (uint64_t t = timeStamp / 10; t; t /= 10) tsLen++;
+            int precision = 6;
+            //vector seems to keep 10 bytes at the start of the line for the timestamp. It should never exceed this
+            //and there should never be a precision over 6 digits after the decimal
+            if (tsLen > 3) precision = 9 - tsLen;
+            out.appendFixed(relTime, 6, precision, 10);
+            out.appendChar(' ');
+            out.appendSignedDec(frame->bus + 1);
+            out.append("  ");
+            if (frame->hasExtendedFrameFormat())
+            {
+                out.appendHex(frame->frameId(), 8);
+                out.appendChar('x');
+            }
+            else
+            {
+                out.appendHex(frame->frameId(), 3);
+                out.append("      ");
+            }
+            out.append("   ");
 
-        if (frames->at(c).isReceived) outFile->write("Rx ");
-        else outFile->write("Tx ");
+            if (frame->isReceived) out.append("Rx ");
+            else out.append("Tx ");
 
-        if (frames->at(c).frameType() == QCanBusFrame::RemoteRequestFrame) outFile->write("r ");
-        else outFile->write("d ");
+            if (frame->frameType() == QCanBusFrame::RemoteRequestFrame) out.append("r ");
+            else out.append("d ");
 
-        outFile->write(QString::number(dataLen).toUtf8());
-        outFile->write("  ");
+            out.appendDec(dataLen);
+            out.append("  ");
 
-        for (int temp = 0; temp < dataLen; temp++)
-        {
-            outFile->write(QString::number(data[temp], 16).toUpper().rightJustified(2, '0').toUtf8());
-            outFile->write("  ");
+            out.appendHexBytes(reinterpret_cast<const unsigned char *>(payload.constData()), dataLen, "  ", 2);
+            out.appendChar('\n');
         }
+    });
 
-        outFile->write("\n");
-    }
     outFile->close();
     delete outFile;
 
-    return true;
+    return result;
 }
 
 bool FrameFileIO::isCanalyzerBLF(QString filename)
@@ -2000,9 +2159,16 @@ bool FrameFileIO::isCanalyzerBLF(QString filename)
 bool FrameFileIO::loadCanalyzerBLF(QString filename, QVector<CANFrame> *frames)
 {
     BLFHandler blf;
+    blf.setLoadFilter(&loadFilter);
     return blf.loadBLF(filename, frames);
 }
 
+bool FrameFileIO::saveCanalyzerBLF(QString filename, const QVector<CANFrame> *frames)
+{
+    BLFHandler blf;
+    return blf.saveBLF(filename, frames);
+}
+
 bool FrameFileIO::isNativeCSVFile(QString filename)
 {
     QFile *inFile = new QFile(filename);
@@ -2068,6 +2234,7 @@ bool FrameFileIO::loadNativeCSVFile(QString filename, QVector<CANFrame>* frames)
     int lineCounter = 0;
     bool foundErrors = false;
     thisFrame.setFrameType(QCanBusFrame::DataFrame);
+    const bool filterActive = loadFilter.isActive();
 
     if (!inFile->open(QIODevice::ReadOnly | QIODevice::Text))
     {
@@ -2104,7 +2271,14 @@ bool FrameFileIO::loadNativeCSVFile(QString filename, QVector<CANFrame>* frames)
                     thisFrame.setTimeStamp(QCanBusFrame::TimeStamp(0, timeStamp));
                 }
 
-                thisFrame.setFrameId(tokens[1].toUInt(nullptr, 16));
+                uint32_t frameId = tokens[1].toUInt(nullptr, 16);
+                if (filterActive)
+                {
+                    int bus = (fileVersion == 1) ? tokens[3].toInt() : tokens[4].toInt();
+                    if (!loadFilter.accepts(frameId, bus, thisFrame.timeStamp().microSeconds())) continue;
+                }
+
+                thisFrame.setFrameId(frameId);
                 if (tokens[2].toUpper().contains("TRUE")) thisFrame.setExtendedFrameFormat(true);
                     else thisFrame.setExtendedFrameFormat(false);
 
@@ -2153,14 +2327,44 @@ bool FrameFileIO::loadNativeCSVFile(QString filename, QVector<CANFrame>* frames)
     return !foundErrors;
 }
 
+//one line of the native GVRET CSV format. Shared by the normal saver and continuous logging
+static void formatNativeCSVLine(TextFormatter &out, const CANFrame &frame)
+{
+    const QByteArray payload = frame.payload();
+    const unsigned char *data = reinterpret_cast<const unsigned char *>(payload.constData());
+    int dataLen = payload.count();
+
+    out.appendSignedDec(frame.timeStamp().microSeconds());
+    out.appendChar(',');
+
+    out.appendHex(frame.frameId(), 8);
+    out.appendChar(',');
+
+    if (frame.hasExtendedFrameFormat()) out.append("true,");
+    else out.append("false,");
+
+    if (frame.isReceived) out.append("Rx,");
+    else out.append("Tx,");
+
+    out.appendSignedDec(frame.bus);
+    out.appendChar(',');
+
+    out.appendDec(dataLen);
+    out.appendChar(',');
+
+    for (int temp = 0; temp < 8; temp++)
+    {
+        if (temp < dataLen) out.appendHexByte(data[temp]);
+        else out.append("00");
+        out.appendChar(',');
+    }
+
+    out.appendChar('\n');
+}
+
 bool FrameFileIO::saveNativeCSVFile(QString filename, const QVector<CANFrame>* frames)
 {
     QFile *outFile = new QFile(filename);
-    int lineCounter = 0;
-
-    const unsigned char *data;
-    int dataLen;
-    const CANFrame *frame;
 
     if (!outFile->open(QIODevice::WriteOnly | QIODevice::Text))
     {
@@ -2171,52 +2375,14 @@ bool FrameFileIO::saveNativeCSVFile(QString filename, const QVector<CANFrame>* f
     outFile->write("Time Stamp,ID,Extended,Dir,Bus,LEN,D1,D2,D3,D4,D5,D6,D7,D8");
     outFile->write("\n");
 
-    for (int c = 0; c < frames->count(); c++)
+    bool result = TextFormatter::writeChunked(outFile, frames->count(), [frames](TextFormatter &out, int first, int last)
     {
-        lineCounter++;
-        if (lineCounter > 100)
-        {
-            qApp->processEvents();
-            lineCounter = 0;
-        }
-
-        frame = &frames->at(c);
-        data = reinterpret_cast<const unsigned char *>(frame->payload().constData());
-        dataLen = frame->payload().count();
-
-        outFile->write(QString::number(frame->timeStamp().microSeconds()).toUtf8());
-        outFile->putChar(44);
+        for (int c = first; c < last; c++) formatNativeCSVLine(out, frames->at(c));
+    });
 
-        outFile->write(QString::number(frame->frameId(), 16).toUpper().rightJustified(8, '0').toUtf8());
-        outFile->putChar(44);
-
-        if (frame->hasExtendedFrameFormat()) outFile->write("true,");
-        else outFile->write("false,");
-
-        if (frame->isReceived) outFile->write("Rx,");
-        else outFile->write("Tx,");
-
-        outFile->write(QString::number(frame->bus).toUtf8());
-        outFile->putChar(44);
-
-        outFile->write(QString::number(dataLen).toUtf8());
-        outFile->putChar(44);
-
-        for (int temp = 0; temp < 8; temp++)
-        {
-            if (temp < dataLen)
-                outFile->write(QString::number(data[temp], 16).toUpper().rightJustified(2, '0').toUtf8());
-            else
-                outFile->write("00");
-            outFile->putChar(44);
-        }
-
-        outFile->write("\n");
-
-    }
     outFile->close();
     delete outFile;
-    return true;
+    return result;
 }
 
 bool FrameFileIO::openContinuousNative()
@@ -2263,49 +2429,13 @@ bool FrameFileIO::closeContinuousNative()
 
 bool FrameFileIO::writeContinuousNative(const QVector<CANFrame>* frames, int beginningFrame)
 {
-
-    const unsigned char *data;
-    int dataLen;
-    const CANFrame *frame;
-
     if (!continuousFile.isOpen()) return false;
     qDebug() << "Bgn: " << beginningFrame << "  Count: " << frames->count();
-    for (int c = beginningFrame; c < frames->count(); c++)
-    {
-        frame = &frames->at(c);
-        data = reinterpret_cast<const unsigned char *>(frame->payload().constData());
-        dataLen = frame->payload().count();
 
-        continuousFile.write(QString::number(frame->timeStamp().microSeconds()).toUtf8());
-        continuousFile.putChar(44);
+    TextFormatter out(qMax(0, frames->count() - beginningFrame) * 64);
+    for (int c = beginningFrame; c < frames->count(); c++) formatNativeCSVLine(out, frames->at(c));
 
-        continuousFile.write(QString::number(frame->frameId(), 16).toUpper().rightJustified(8, '0').toUtf8());
-        continuousFile.putChar(44);
-
-        if (frame->hasExtendedFrameFormat()) continuousFile.write("true,");
-        else continuousFile.write("false,");
-
-        if (frame->isReceived) continuousFile.write("Rx,");
-        else continuousFile.write("Tx,");
-
-        continuousFile.write(QString::number(frame->bus).toUtf8());
-        continuousFile.putChar(44);
-
-        continuousFile.write(QString::number(dataLen).toUtf8());
-        continuousFile.putChar(44);
-
-        for (int temp = 0; temp < 8; temp++)
-        {
-            if (temp < dataLen)
-                continuousFile.write(QString::number(data[temp], 16).toUpper().rightJustified(2, '0').toUtf8());
-            else
-                continuousFile.write("00");
-            continuousFile.putChar(44);
-        }
-
-        continuousFile.write("\n");
-    }
-    return true;
+    return out.flushTo(&continuousFile);
 }
 
 bool FrameFileIO::flushContinuousNative()
@@ -2427,11 +2557,6 @@ bool FrameFileIO::loadGenericCSVFile(QString filename, QVector<CANFrame>* frames
 bool FrameFileIO::saveGenericCSVFile(QString filename, const QVector<CANFrame>* frames)
 {
     QFile *outFile = new QFile(filename);
-    int lineCounter = 0;
-
-    const unsigned char *data;
-    int dataLen;
-    const CANFrame *frame;
 
     if (!outFile->open(QIODevice::WriteOnly | QIODevice::Text))
     {
@@ -2442,34 +2567,23 @@ bool FrameFileIO::saveGenericCSVFile(QString filename, const QVector<CANFrame>*
     outFile->write("ID,Data Bytes");
     outFile->write("\n");
 
-    for (int c = 0; c < frames->count(); c++)
+    bool result = TextFormatter::writeChunked(outFile, frames->count(), [frames](TextFormatter &out, int first, int last)
     {
-        lineCounter++;
-        if (lineCounter > 100)
+        for (int c = first; c < last; c++)
         {
-            qApp->processEvents();
-            lineCounter = 0;
-        }
-
-        frame = &frames->at(c);
-        data = reinterpret_cast<const unsigned char *>(frame->payload().constData());
-        dataLen = frame->payload().count();
+            const CANFrame *frame = &frames->at(c);
+            const QByteArray payload = frame->payload();
 
-        outFile->write(QString::number(frame->frameId(), 16).toUpper().rightJustified(8, '0').toUtf8());
-        outFile->putChar(44);
-
-        for (int temp = 0; temp < dataLen; temp++)
-        {
-            outFile->write(QString::number(data[temp], 16).toUpper().rightJustified(2, '0').toUtf8());
-            outFile->putChar(' ');
+            out.appendHex(frame->frameId(), 8);
+            out.appendChar(',');
+            out.appendHexBytes(reinterpret_cast<const unsigned char *>(payload.constData()), payload.count(), " ", 1);
+            out.appendChar('\n');
         }
+    });
 
-        outFile->write("\n");
-
-    }
     outFile->close();
     delete outFile;
-    return true;
+    return result;
 }
 
 bool FrameFileIO::isLogFile(QString filename)
@@ -2631,12 +2745,7 @@ bool FrameFileIO::loadLogFile(QString filename, QVector<CANFrame>* frames)
 bool FrameFileIO::saveLogFile(QString filename, const QVector<CANFrame>* frames)
 {
     QFile *outFile = new QFile(filename);
-    QDateTime timestamp, tempStamp;
-    int lineCounter = 0;
-
-    const unsigned char *data;
-    int dataLen;
-    const CANFrame *frame;
+    QDateTime timestamp;
 
     //timestamp = QDateTime::currentDateTime();
 
@@ -2662,51 +2771,50 @@ bool FrameFileIO::saveLogFile(QString filename, const QVector<CANFrame>* frames)
     outFile->write("***END OF DATABASE FILES***\n");
     outFile->write("***<Time><Tx/Rx><Channel><CAN ID><Type><DLC><DataBytes>***\n");
 
-    for (int c = 0; c < frames->count(); c++)
+    bool result = TextFormatter::writeChunked(outFile, frames->count(), [frames](TextFormatter &out, int first, int last)
     {
-        lineCounter++;
-        if (lineCounter > 100)
+        //converting to local time is the slow part so it is only done when the second changes
+        int64_t cachedSecond = -1;
+        QByteArray cachedClock;
+        for (int c = first; c < last; c++)
         {
-            qApp->processEvents();
-            lineCounter = 0;
-        }
-
-        frame = &frames->at(c);
-        data = reinterpret_cast<const unsigned char *>(frame->payload().constData());
-        dataLen = frame->payload().count();
-
-        tempStamp = QDateTime::fromMSecsSinceEpoch(frame->timeStamp().microSeconds() / 1000);
-        outFile->write(tempStamp.toString("hh:mm:ss:zzz").toUtf8());
-        if (frame->isReceived) outFile->write(" Rx ");
-        else outFile->write(" Tx ");
-        // busmaster channel start at 1
-        outFile->write(QString::number(frame->bus + 1).toUtf8() + " ");
-        outFile->write("0x");
-        if (frame->hasExtendedFrameFormat() && frame->frameId() > 0x7FF) {
-            outFile->write(QString::number(frame->frameId(), 16).toUpper().rightJustified(8, '0').toUtf8());
-        } else {
-            outFile->write(QString::number(frame->frameId(), 16).toUpper().rightJustified(3, '0').toUtf8());
-        }
-        if (frame->hasExtendedFrameFormat()) outFile->write(" x");
-            else outFile->write(" s");
-        if (frame->frameType() == QCanBusFrame::RemoteRequestFrame) outFile->write("r ");
-            else outFile->write(" ");
-        outFile->write(QString::number(dataLen).toUtf8() + " ");
+            const CANFrame *frame = &frames->at(c);
+            const QByteArray payload = frame->payload();
+            int dataLen = payload.count();
 
-        if (frame->frameType() != QCanBusFrame::RemoteRequestFrame) {
-            for (int temp = 0; temp < dataLen; temp++)
+            int64_t ms = frame->timeStamp().microSeconds() / 1000;
+            int64_t second = (ms >= 0) ? (ms / 1000) : ((ms - 999) / 1000);
+            if (second != cachedSecond)
             {
-                outFile->write(QString::number(data[temp], 16).toUpper().rightJustified(2, '0').toUtf8());
-                outFile->putChar(' ');
+                cachedSecond = second;
+                cachedClock = QDateTime::fromMSecsSinceEpoch(second * 1000).toString("hh:mm:ss:").toUtf8();
             }
-        }
-
-        outFile->write("\n");
+            out.append(cachedClock);
+            out.appendDec(ms - (second * 1000), 3, '0');
+            if (frame->isReceived) out.append(" Rx ");
+            else out.append(" Tx ");
+            // busmaster channel start at 1
+            out.appendSignedDec(frame->bus + 1);
+            out.append(" 0x");
+            if (frame->hasExtendedFrameFormat() && frame->frameId() > 0x7FF) out.appendHex(frame->frameId(), 8);
+            else out.appendHex(frame->frameId(), 3);
+            if (frame->hasExtendedFrameFormat()) out.append(" x");
+                else out.append(" s");
+            if (frame->frameType() == QCanBusFrame::RemoteRequestFrame) out.append("r ");
+                else out.appendChar(' ');
+            out.appendDec(dataLen);
+            out.appendChar(' ');
+
+            if (frame->frameType() != QCanBusFrame::RemoteRequestFrame)
+                out.appendHexBytes(reinterpret_cast<const unsigned char *>(payload.constData()), dataLen, " ", 1);
+
+            out.appendChar('\n');
+        }
+    });
 
-    }
     outFile->close();
     delete outFile;
-    return true;
+    return result;
 }
 
 bool FrameFileIO::isIXXATFile(QString filename)
@@ -2828,12 +2936,7 @@ bool FrameFileIO::loadIXXATFile(QString filename, QVector<CANFrame>* frames)
 bool FrameFileIO::saveIXXATFile(QString filename, const QVector<CANFrame>* frames)
 {
     QFile *outFile = new QFile(filename);
-    QDateTime timestamp, tempStamp;
-    int lineCounter = 0;
-
-    const unsigned char *data;
-    int dataLen;
-    const CANFrame *frame;
+    QDateTime timestamp;
 
     timestamp = QDateTime::currentDateTime();
 
@@ -2852,39 +2955,42 @@ bool FrameFileIO::saveIXXATFile(QString filename, const QVector<CANFrame>* frame
     outFile->write("Baudrate: 500 kbit/s\n"); //could be a lie... this code has no way to know the baud rate (at the moment)
     outFile->write("\"Time\",\"Identifier (hex)\",\"Format\",\"Flags\",\"Data (hex)\"\n");
 
-    for (int c = 0; c < frames->count(); c++)
+    bool result = TextFormatter::writeChunked(outFile, frames->count(), [frames](TextFormatter &out, int first, int last)
     {
-        lineCounter++;
-        if (lineCounter > 100)
+        //converting to local time is the slow part so it is only done when the second changes
+        int64_t cachedSecond = -1;
+        QByteArray cachedClock;
+        for (int c = first; c < last; c++)
         {
-            qApp->processEvents();
-            lineCounter = 0;
-        }
+            const CANFrame *frame = &frames->at(c);
+            const QByteArray payload = frame->payload();
 
-        frame = &frames->at(c);
-        data = reinterpret_cast<const unsigned char *>(frame->payload().constData());
-        dataLen = frame->payload().count();
-
-        tempStamp = QDateTime::fromMSecsSinceEpoch(frame->timeStamp().microSeconds() / 1000);
-        outFile->write("\"" + tempStamp.toString("h:m:s.").toUtf8() + tempStamp.toString("z").rightJustified(3, '0').toUtf8() + "\"");
+            int64_t ms = frame->timeStamp().microSeconds() / 1000;
+            int64_t second = (ms >= 0) ? (ms / 1000) : ((ms - 999) / 1000);
+            if (second != cachedSecond)
+            {
+                cachedSecond = second;
+                cachedClock = QDateTime::fromMSecsSinceEpoch(second * 1000).toString("h:m:s.").toUtf8();
+            }
+            out.appendChar('"');
+            out.append(cachedClock);
+            out.appendDec(ms - (second * 1000), 3, '0');
+            out.append("\",\"");
 
-        outFile->write(",\"" + QString::number(frame->frameId(), 16).toUpper().rightJustified(8, '0').toUtf8() + "\"");
-        if (frame->hasExtendedFrameFormat()) outFile->write(",\"Ext\"");
-            else outFile->write(",\"Std\"");
-        outFile->write(",\"\",\"");
+            out.appendHex(frame->frameId(), 8);
+            out.appendChar('"');
+            if (frame->hasExtendedFrameFormat()) out.append(",\"Ext\"");
+                else out.append(",\"Std\"");
+            out.append(",\"\",\"");
 
-        for (int temp = 0; temp < dataLen; temp++)
-        {
-            outFile->write(QString::number(data[temp], 16).toUpper().rightJustified(2, '0').toUtf8());
-            outFile->putChar(' ');
+            out.appendHexBytes(reinterpret_cast<const unsigned char *>(payload.constData()), payload.count(), " ", 1);
+            out.append("\"\n");
         }
+    });
 
-        outFile->write("\"\n");
-
-    }
     outFile->close();
     delete outFile;
-    return true;
+    return result;
 }
 
 bool FrameFileIO::isCANDOFile(QString filename)
@@ -3208,12 +3314,7 @@ tokens:
 bool FrameFileIO::saveMicrochipFile(QString filename, const QVector<CANFrame>* frames)
 {
     QFile *outFile = new QFile(filename);
-    QDateTime timestamp, tempStamp;
-    int lineCounter = 0;
-
-    const unsigned char *data;
-    int dataLen;
-    const CANFrame *frame;
+    QDateTime timestamp;
 
     timestamp = QDateTime::currentDateTime();
 
@@ -3232,37 +3333,36 @@ bool FrameFileIO::saveMicrochipFile(QString filename, const QVector<CANFrame>* f
     outFile->write("\n");
     outFile->write("//---------------------------------\n");
 
-    for (int c = 0; c < frames->count(); c++)
+    bool result = TextFormatter::writeChunked(outFile, frames->count(), [frames](TextFormatter &out, int first, int last)
     {
-        lineCounter++;
-        if (lineCounter > 100)
+        for (int c = first; c < last; c++)
         {
-            qApp->processEvents();
-            lineCounter = 0;
-        }
-
-        frame = &frames->at(c);
-        data = reinterpret_cast<const unsigned char *>(frame->payload().constData());
-        dataLen = frame->payload().count();
-
-        outFile->write(QString::number((frame->timeStamp().microSeconds() / 1000)).toUtf8());
-        if (frame->isReceived) outFile->write(";RX;");
-        else outFile->write(";TX;");
-        outFile->write("0x" + QString::number(frame->frameId(), 16).toUpper().rightJustified(8, '0').toUtf8() + ";");
-        outFile->write(QString::number(dataLen).toUtf8() + ";");
+            const CANFrame *frame = &frames->at(c);
+            const QByteArray payload = frame->payload();
+
+            out.appendSignedDec(frame->timeStamp().microSeconds() / 1000);
+            if (frame->isReceived) out.append(";RX;");
+            else out.append(";TX;");
+            out.append("0x");
+            out.appendHex(frame->frameId(), 8);
+            out.appendChar(';');
+            out.appendDec(payload.count());
+            out.appendChar(';');
+
+            for (int temp = 0; temp < payload.count(); temp++)
+            {
+                out.append("0x");
+                out.appendHexByte(static_cast<uint8_t>(payload[temp]));
+                out.appendChar(';');
+            }
 
-        for (int temp = 0; temp < dataLen; temp++)
-        {
-            outFile->write("0x" + QString::number(data[temp], 16).toUpper().rightJustified(2, '0').toUtf8());
-            outFile->putChar(';');
+            out.appendChar('\n');
         }
+    });
 
-        outFile->write("\n");
-
-    }
     outFile->close();
     delete outFile;
-    return true;
+    return result;
 }
 
 bool FrameFileIO::isTraceFile(QString filename)
@@ -3423,13 +3523,6 @@ bool FrameFileIO::saveTraceFile(QString filename, const QVector<CANFrame> * fram
 {
     QFile *outFile = new QFile(filename);
     QDateTime timestamp;
-    int lineCounter = 0;
-    int64_t tempTime;
-    int tempTimePiece;
-
-    const unsigned char *data;
-    int dataLen;
-    const CANFrame *frame;
 
     timestamp = QDateTime::currentDateTime();
 
@@ -3459,74 +3552,57 @@ bool FrameFileIO::saveTraceFile(QString filename, const QVector<CANFrame> * fram
     outFile->write(";   |     	     |      	    |   	|	 |\n");
     outFile->write(";---+-----	-----+------	----+---	+	-+ -- -- -- -- -- -- --\n");
 
-
-    for (int c = 0; c < frames->count(); c++)
+    bool result = TextFormatter::writeChunked(outFile, frames->count(), [frames](TextFormatter &out, int first, int last)
     {
-        lineCounter++;
-        if ((lineCounter % 100) == 0)
+        for (int c = first; c < last; c++)
         {
-            qApp->processEvents();
-            //lineCounter = 0;
-        }
-
-        frame = &frames->at(c);
-        data = reinterpret_cast<const unsigned char *>(frame->payload().constData());
-        dataLen = frame->payload().count();
+            const CANFrame *frame = &frames->at(c);
+            const QByteArray payload = frame->payload();
+            int dataLen = payload.count();
 
-         //1F D3 3F FF 08 FF E0 CB
-        outFile->write(QString::number(lineCounter).rightJustified(10, ' ').toUtf8());
-        outFile->write("\t");
+             //1F D3 3F FF 08 FF E0 CB
+            out.appendDec(c + 1, 10);
+            out.appendChar('\t');
 
-        tempTime = frame->timeStamp().microSeconds();
-        tempTimePiece = static_cast<int>(tempTime / 1000000l / 60 / 60);
-        tempTime -= tempTimePiece * 1000000l * 60 * 60;
-        outFile->write(QString::number(tempTimePiece).rightJustified(2, '0').toUtf8());
-        outFile->write(":");
+            int64_t tempTime = frame->timeStamp().microSeconds();
+            int tempTimePiece = static_cast<int>(tempTime / 1000000l / 60 / 60);
+            tempTime -= tempTimePiece * 1000000l * 60 * 60;
+            out.appendSignedDec(tempTimePiece, 2, '0');
+            out.appendChar(':');
 
-        tempTimePiece = static_cast<int>(tempTime / 1000000l / 60);
-        tempTime -= tempTimePiece * 1000000l * 60;
-        outFile->write(QString::number(tempTimePiece).rightJustified(2, '0').toUtf8());
-        outFile->write(":");
+            tempTimePiece = static_cast<int>(tempTime / 1000000l / 60);
+            tempTime -= tempTimePiece * 1000000l * 60;
+            out.appendSignedDec(tempTimePiece, 2, '0');
+            out.appendChar(':');
 
-        tempTimePiece = static_cast<int>(tempTime / 1000000l);
-        tempTime -= tempTimePiece * 1000000l;
-        outFile->write(QString::number(tempTimePiece).rightJustified(2, '0').toUtf8());
-        outFile->write(":");
+            tempTimePiece = static_cast<int>(tempTime / 1000000l);
+            tempTime -= tempTimePiece * 1000000l;
+            out.appendSignedDec(tempTimePiece, 2, '0');
+            out.appendChar(':');
 
-        tempTimePiece = static_cast<int>(tempTime / 100);
-        outFile->write(QString::number(tempTimePiece).rightJustified(4, '0').toUtf8());
-        outFile->write("\t");
+            tempTimePiece = static_cast<int>(tempTime / 100);
+            out.appendSignedDec(tempTimePiece, 4, '0');
+            out.appendChar('\t');
 
-        outFile->write(QString::number(frame->frameId(), 16).toUpper().rightJustified(8, '0').toUtf8() + "\t");
+            out.appendHex(frame->frameId(), 8);
+            out.appendChar('\t');
 
-        outFile->write(QString::number(dataLen).toUtf8() + "\t");
+            out.appendDec(dataLen);
+            out.appendChar('\t');
 
-        for (int temp = 0; temp < dataLen; temp++)
-        {
-            outFile->write(QString::number(data[temp], 16).toUpper().rightJustified(2, '0').toUtf8());
-            outFile->putChar(' ');
+            out.appendHexBytes(reinterpret_cast<const unsigned char *>(payload.constData()), dataLen, " ", 1);
+            out.appendChar('\n');
         }
+    });
 
-        outFile->write("\n");
-
-    }
     outFile->close();
     delete outFile;
-    return true;
+    return result;
 }
 
 bool FrameFileIO::saveCanDumpFile(QString filename, const QVector<CANFrame> * frames)
 {
     QFile *outFile = new QFile(filename);
-    QDateTime timestamp;
-    int lineCounter = 0;
-    double tempTime;
-
-    const unsigned char *data;
-    int dataLen;
-    const CANFrame *frame;
-
-    timestamp = QDateTime::currentDateTime();
 
     if (!outFile->open(QIODevice::WriteOnly | QIODevice::Text))
     {
@@ -3534,48 +3610,37 @@ bool FrameFileIO::saveCanDumpFile(QString filename, const QVector<CANFrame> * fr
         return false;
     }
 
-    for (int c = 0; c < frames->count(); c++)
+    bool result = TextFormatter::writeChunked(outFile, frames->count(), [frames](TextFormatter &out, int first, int last)
     {
-        lineCounter++;
-        if ((lineCounter % 100) == 0)
+        for (int c = first; c < last; c++)
         {
-            qApp->processEvents();
-        }
+            const CANFrame *frame = &frames->at(c);
+            const QByteArray payload = frame->payload();
+            int dataLen = payload.count();
 
-        frame = &frames->at(c);
-        data = reinterpret_cast<const unsigned char *>(frame->payload().constData());
-        dataLen = frame->payload().count();
-
-        outFile->write("(");
-
-        tempTime = frame->timeStamp().microSeconds() / 1000000.0;
-        outFile->write(QString::number(tempTime,'f', 6).rightJustified(17, '0').toUtf8());
-        outFile->write(") vcan0 ");
+            out.appendChar('(');
+            out.appendFixed(frame->timeStamp().microSeconds(), 6, 6, 17, '0');
+            out.append(") vcan0 ");
 
-        if (frame->hasExtendedFrameFormat()) {
-            outFile->write(QString::number(frame->frameId(), 16).rightJustified(8,'0').toUpper().toUtf8());
-        } else {
-            outFile->write(QString::number(frame->frameId(), 16).rightJustified(3,'0').toUpper().toUtf8());
-        }
+            if (frame->hasExtendedFrameFormat()) out.appendHex(frame->frameId(), 8);
+            else out.appendHex(frame->frameId(), 3);
 
-        outFile->write("#");
+            out.appendChar('#');
 
-        if (frame->frameType() == QCanBusFrame::RemoteRequestFrame) {
-            outFile->write("R");
-            outFile->write(QString::number(dataLen).toUtf8());
-        } else {
-            for (int temp = 0; temp < dataLen; temp++)
+            if (frame->frameType() == QCanBusFrame::RemoteRequestFrame)
             {
-                outFile->write(QString::number(data[temp], 16).rightJustified(2,'0').toUpper().toUtf8());
+                out.appendChar('R');
+                out.appendDec(dataLen);
             }
-        }
+            else out.appendHexBytes(reinterpret_cast<const unsigned char *>(payload.constData()), dataLen);
 
-        outFile->write("\n");
+            out.appendChar('\n');
+        }
+    });
 
-    }
     outFile->close();
     delete outFile;
-    return true;
+    return result;
 }
 
 bool FrameFileIO::isCanDumpFile(QString filename)
@@ -3720,6 +3785,7 @@ bool FrameFileIO::loadCanDumpFile(QString filename, QVector<CANFrame>* frames)
     QRegularExpression valExp("(\\S{2})");
     int lineCounter = 0;
     bool ret;
+    const bool filterActive = loadFilter.isActive();
 
     if (!inFile->open(QIODevice::ReadOnly | QIODevice::Text))
     {
@@ -3769,6 +3835,13 @@ bool FrameFileIO::loadCanDumpFile(QString filename, QVector<CANFrame>* frames)
             thisFrame.setTimeStamp(QCanBusFrame::TimeStamp(0, (uint64_t)(timeExpMatched.captured(1).toDouble(&ret) * (double)1000000.0)));
             if(!ret) continue;
 
+            //the ID is the third token in both formats, optionally followed by #data
+            if (filterActive)
+            {
+                uint32_t frameId = tokens[2].left(tokens[2].indexOf('#')).toUInt(nullptr, 16);
+                if (!loadFilter.accepts(frameId, busNum, thisFrame.timeStamp().microSeconds())) continue;
+            }
+
             if (line.contains('[')) //the expanded format (second one from the above list)
             {
                 //(1551774790.942758) can1 7A8 [8] F4 DC D1 83 0E 02 00 00
@@ -4196,11 +4269,6 @@ bool FrameFileIO::loadCabanaFile(QString filename, QVector<CANFrame>* frames)
 bool FrameFileIO::saveCabanaFile(QString filename, const QVector<CANFrame>* frames)
 {
     QFile *outFile = new QFile(filename);
-    int lineCounter = 0;
-
-    const unsigned char *data;
-    int dataLen;
-    const CANFrame *frame;
 
     if (!outFile->open(QIODevice::WriteOnly | QIODevice::Text))
     {
@@ -4211,46 +4279,37 @@ bool FrameFileIO::saveCabanaFile(QString filename, const QVector<CANFrame>* fram
     outFile->write("time,addr,bus,data");
     outFile->write("\n");
 
-    for (int c = 0; c < frames->count(); c++)
+    bool result = TextFormatter::writeChunked(outFile, frames->count(), [frames](TextFormatter &out, int first, int last)
     {
-        lineCounter++;
-        if (lineCounter > 100)
+        for (int c = first; c < last; c++)
         {
-            qApp->processEvents();
-            lineCounter = 0;
-        }
+            const CANFrame *frame = &frames->at(c);
+            const QByteArray payload = frame->payload();
+            const unsigned char *data = reinterpret_cast<const unsigned char *>(payload.constData());
+            int dataLen = payload.count();
 
-        frame = &frames->at(c);
-        data = reinterpret_cast<const unsigned char *>(frame->payload().constData());
-        dataLen = frame->payload().count();
-
-        double tempTimeStamp = frame->timeStamp().microSeconds();
-        tempTimeStamp /= 1000000;
+            out.appendFixed(frame->timeStamp().microSeconds(), 6, 6);
+            out.append(".0,");
 
-        outFile->write(QString::number(tempTimeStamp, 'f').toUtf8());
-        outFile->write(".0");
-        outFile->putChar(44);
+            out.appendDec(frame->frameId());
+            out.appendChar(',');
 
-        outFile->write(QString::number(frame->frameId(), 10).toUpper().toUtf8());
-        outFile->putChar(44);
+            out.appendSignedDec(frame->bus);
+            out.appendChar(',');
 
-        outFile->write(QString::number(frame->bus).toUtf8());
-        outFile->putChar(44);
+            for (int temp = 0; temp < 8; temp++)
+            {
+                if (temp < dataLen) out.appendHexByte(data[temp]);
+                else out.append("00");
+            }
 
-        for (int temp = 0; temp < 8; temp++)
-        {
-            if (temp < dataLen)
-                outFile->write(QString::number(data[temp], 16).toUpper().rightJustified(2, '0').toUtf8());
-            else
-                outFile->write("00");
+            out.appendChar('\n');
         }
+    });
 
-        outFile->write("\n");
-
-    }
     outFile->close();
     delete outFile;
-    return true;
+    return result;
 }
 
 bool FrameFileIO::isTeslaAPFile(QString filename)
@@ -5022,6 +5081,7 @@ bool FrameFileIO::loadWiresharkFile(QString filename, QVector<CANFrame>* frames)
     long long timeStamp;
     int lineCounter = 0;
     bool foundErrors = false;
+    const bool filterActive = loadFilter.isActive();
     pcap_pkthdr    packetHeader;
 	const char     *packetData = NULL;
 	char errbuf[PCAP_ERRBUF_SIZE];
@@ -5045,7 +5105,7 @@ bool FrameFileIO::loadWiresharkFile(QString filename, QVector<CANFrame>* frames)
             lineCounter = 0;
         }
         
-        timeStamp = packetHeader.ts.tv_sec * 1000000 + packetHeader.ts.tv_usec;
+        timeStamp = (long long)packetHeader.ts.tv_sec * 1000000 + packetHeader.ts.tv_usec;
         if (0 == startTimestamp) 
         {
             startTimestamp = timeStamp;
@@ -5055,6 +5115,12 @@ bool FrameFileIO::loadWiresharkFile(QString filename, QVector<CANFrame>* frames)
 
         thisFrame.setTimeStamp(QCanBusFrame::TimeStamp(0, timeStamp));
         thisFrame.isReceived = true; // TODO: check if tx detection is possible
+
+        if (packetHeader.caplen < 24)
+        {
+            packetData = (const char*)pcap_next(pcap_data_file, &packetHeader);
+            continue;
+        }
             
         thisFrame.setFrameType(QCanBusFrame::DataFrame);
         if ((0x80 & *(packetData+19)))  {
@@ -5064,15 +5130,14 @@ bool FrameFileIO::loadWiresharkFile(QString filename, QVector<CANFrame>* frames)
             thisFrame.setExtendedFrameFormat(false);
             thisFrame.setFrameId((0xff & *(packetData+17)) << 8 | (0xff & *(packetData+16)));
         }
-        thisFrame.bus = 0;
-        int numBytes = *(packetData+20);
-        QByteArray bytes(numBytes, 0);
-        if (thisFrame.payload().length() > 8) thisFrame.payload().resize(8);
-        for (int d = 0; d < numBytes; d++) 
-        { 
-            bytes[d] = *(packetData + 24 + d);
+        thisFrame.bus = packetHeader.interface_id;
+        if (filterActive && !loadFilter.accepts(thisFrame.frameId(), thisFrame.bus, timeStamp))
+        {
+            packetData = (const char*)pcap_next(pcap_data_file, &packetHeader);
+            continue;
         }
-        thisFrame.setPayload(bytes);
+        int numBytes = qMin((int)(quint8)*(packetData+20), (int)packetHeader.caplen - 24);
+        thisFrame.setPayload(QByteArray(packetData + 24, numBytes));
         frames->append(thisFrame);
 
         packetData = (const char*)pcap_next(pcap_data_file, &packetHeader);
@@ -5109,6 +5174,7 @@ bool FrameFileIO::loadWiresharkSocketCANFile(QString filename, QVector<CANFrame>
     long long timeStamp;
     int lineCounter = 0;
     bool foundErrors = false;
+    const bool filterActive = loadFilter.isActive();
     pcap_pkthdr packetHeader;
     const char *packetData = NULL;
     char errbuf[PCAP_ERRBUF_SIZE];
@@ -5127,10 +5193,15 @@ bool FrameFileIO::loadWiresharkSocketCANFile(QString filename, QVector<CANFrame>
             qApp->processEvents();
             lineCounter = 0;
         }
-        thisFrame.bus = 0;
+        if (packetHeader.caplen < 8) {
+            packetData = (const char*) pcap_next(pcap_data_file, &packetHeader);
+            continue;
+        }
+        // pcapng files can have one interface per bus
+        thisFrame.bus = packetHeader.interface_id;
 
         // Timestamp
-        timeStamp = packetHeader.ts.tv_sec * 1000000 + packetHeader.ts.tv_usec;
+        timeStamp = (long long)packetHeader.ts.tv_sec * 1000000 + packetHeader.ts.tv_usec;
         if (0 == startTimestamp) {
             startTimestamp = timeStamp;
         }
@@ -5146,6 +5217,10 @@ bool FrameFileIO::loadWiresharkSocketCANFile(QString filename, QVector<CANFrame>
             thisFrame.setExtendedFrameFormat(false);
             thisFrame.setFrameId(0x7ff & can_id);
         }
+        if (filterActive && !loadFilter.accepts(thisFrame.frameId(), thisFrame.bus, timeStamp)) {
+            packetData = (const char*) pcap_next(pcap_data_file, &packetHeader);
+            continue;
+        }
 
         // Frame type
         if (can_id & 0x20000000U) {
@@ -5160,16 +5235,17 @@ bool FrameFileIO::loadWiresharkSocketCANFile(QString filename, QVector<CANFrame>
         quint8 direction = (quint8) *(packetData + 6);
         thisFrame.isReceived = (direction != 1);
 
+        // CAN-FD frames are told apart by the size of the packet (CANFD_MTU) or the FDF flag
+        quint8 fdFlags = (quint8) *(packetData + 5);
+        bool isFD = (packetHeader.caplen >= SOCKETCAN_CANFD_MTU) || (fdFlags & SOCKETCAN_CANFD_FDF);
+        thisFrame.setFlexibleDataRateFormat(isFD);
+        thisFrame.setBitrateSwitch(isFD && (fdFlags & SOCKETCAN_CANFD_BRS));
+
         // Data
-        quint8 numBytes = (quint8) *(packetData + 4);
-        if (numBytes > 8) {
-            numBytes = 8;
-        }
-        QByteArray bytes(numBytes, 0);
-        for (int d = 0; d < numBytes; d++) {
-            bytes[d] = *(packetData + 8 + d);
-        }
-        thisFrame.setPayload(bytes);
+        int numBytes = (quint8) *(packetData + 4);
+        numBytes = qMin(numBytes, isFD ? 64 : 8);
+        numBytes = qMin(numBytes, (int)packetHeader.caplen - 8);
+        thisFrame.setPayload(QByteArray(packetData + 8, numBytes));
         frames->append(thisFrame);
 
         packetData = (const char*) pcap_next(pcap_data_file, &packetHeader);
@@ -5193,3 +5269,65 @@ bool FrameFileIO::isWiresharkSocketCANFile(QString filename)
     pcap_data_file = NULL;
     return true;
 }
+
+bool FrameFileIO::saveWiresharkSocketCANFile(QString filename, const QVector<CANFrame>* frames)
+{
+    pcap_dumper_t *pcap_data_file;
+    pcap_pkthdr packetHeader;
+    unsigned char packet[SOCKETCAN_CANFD_MTU];
+    int lineCounter = 0;
+    bool result = true;
+    char errbuf[PCAP_ERRBUF_SIZE];
+
+    QByteArray ba = filename.toLocal8Bit();
+
+    pcap_data_file = pcap_ng_dump_open(ba.data(), errbuf, PCAP_LINKTYPE_SOCKETCAN);
+    if (!pcap_data_file) {
+        return false;
+    }
+
+    for (int c = 0; c < frames->count(); c++) {
+        lineCounter++;
+        if (lineCounter > 10000) {
+            qApp->processEvents();
+            lineCounter = 0;
+        }
+        const CANFrame &frame = frames->at(c);
+        const QByteArray payload = frame.payload();
+        bool isFD = frame.hasFlexibleDataRateFormat() || payload.length() > 8;
+        int numBytes = qMin(payload.length(), isFD ? 64 : 8);
+        int packetLen = isFD ? SOCKETCAN_CANFD_MTU : SOCKETCAN_CAN_MTU;
+
+        memset(packet, 0, packetLen);
+        quint32 can_id = frame.frameId();
+        if (frame.hasExtendedFrameFormat()) can_id |= 0x80000000U;
+        if (frame.frameType() == QCanBusFrame::RemoteRequestFrame) can_id |= 0x40000000U;
+        else if (frame.frameType() == QCanBusFrame::ErrorFrame) can_id |= 0x20000000U;
+        qToBigEndian<quint32>(can_id, packet);
+        packet[4] = numBytes;
+        if (isFD) packet[5] = SOCKETCAN_CANFD_FDF | (frame.hasBitrateSwitch() ? SOCKETCAN_CANFD_BRS : 0);
+        packet[6] = frame.isReceived ? 0 : 1; // same direction convention the loader understands
+        memcpy(packet + 8, payload.constData(), numBytes);
+
+        qint64 timeStamp = frame.timeStamp().microSeconds();
+        packetHeader.ts.tv_sec = (long)(timeStamp / 1000000);
+        packetHeader.ts.tv_usec = (long)(timeStamp % 1000000);
+        packetHeader.caplen = packetLen;
+        packetHeader.len = packetLen;
+        packetHeader.interface_id = qMax(0, frame.bus);
+        packetHeader.link_type = PCAP_LINKTYPE_SOCKETCAN;
+        if (packetHeader.interface_id >= PCAP_MAX_INTERFACES) {
+            qDebug() << "Bus" << frame.bus << "can't be saved, pcapng files hold at most" << PCAP_MAX_INTERFACES << "buses";
+            result = false;
+            break;
+        }
+        if (!pcap_ng_dump(pcap_data_file, &packetHeader, packet)) {
+            result = false;
+            break;
+        }
+    }
+
+    if (!pcap_dump_close(pcap_data_file)) result = false;
+    return result;
+}
+
@@ -13,6 +13,7 @@
 #include <QStringList>
 #include <QFileDialog>
 #include "can_structs.h"
+#include "frameloadfilter.h"
 #include "utility.h"
 
 class FrameFileIO: public QObject
@@ -28,9 +29,20 @@ public:
     //These routines call the below loading/saving functions so no need to use them directly if you don't want.
     static bool loadFrameFile(QString &, QVector<CANFrame>*);
     static bool saveFrameFile(QString &, const QVector<CANFrame>*);
+    static bool loadMultipleFrameFiles(QString &, QVector<CANFrame>*);
+    //same as loadFrameFile but only frames accepted by the filter are loaded
+    static bool loadFilteredFrameFile(QString &, QVector<CANFrame>*, const FrameLoadFilter &filter);
+
+    //filter applied by all of the loaders below. The common text and binary formats check it as soon as the
+    //ID, bus and timestamp of a record are known and skip the rest of the record. Cleared by default.
+    static void setLoadFilter(const FrameLoadFilter &filter);
+    static void clearLoadFilter();
+    static const FrameLoadFilter &getLoadFilter();
 
     //These do the actual loading and saving and can be used directly if you'd prefer
-    static bool autoDetectLoadFile(QString, QVector<CANFrame>*);
+    static bool autoDetectLoadFile(QString, QVector<CANFrame>*, bool showErrors = true);
+    //loads several logs at once (one per bus usually) and merges them by timestamp. Each file gets its own bus numbers
+    static bool mergeLoadFiles(const QStringList &filenames, QVector<CANFrame>* frames);
     static bool loadCRTDFile(QString, QVector<CANFrame>*);
     static bool loadNativeCSVFile(QString, QVector<CANFrame>*);
     static bool loadGenericCSVFile(QString, QVector<CANFrame>*);
@@ -96,6 +108,8 @@ public:
     static bool saveCabanaFile(QString filename, const QVector<CANFrame>* frames);
     static bool saveCanalyzerASC(QString filename, const QVector<CANFrame>* frames);
     static bool saveCARBUSAnalzyer(QString filename, const QVector<CANFrame>* frames);
+    static bool saveCanalyzerBLF(QString filename, const QVector<CANFrame>* frames);
+    static bool saveWiresharkSocketCANFile(QString filename, const QVector<CANFrame>* frames);
 
     static bool openContinuousNative();
     static bool closeContinuousNative();
@@ -103,7 +117,10 @@ public:
     static bool flushContinuousNative();
 
 private:
+    static void applyLoadFilter(QVector<CANFrame>* frames, int firstNew);
+
     static QFile continuousFile;
+    static FrameLoadFilter loadFilter;
 };
 
 #endif // FRAMEFILEIO_H
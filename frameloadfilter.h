@@ -0,0 +1,85 @@
+#ifndef FRAMELOADFILTER_H
+#define FRAMELOADFILTER_H
+
+#include <QSet>
+#include <QVector>
+#include <stdint.h>
+#include "can_structs.h"
+
+/*
+ * Filter that is pushed down into the frame file loaders. The loaders check a record against it as soon as they
+ * have parsed the ID, bus and timestamp fields and skip the record without ever building the payload if it does
+ * not match. An inactive (default constructed) filter accepts everything.
+ *
+ * IDs are matched either exactly (full 29 bit mask) or as ID/mask pairs. The time window is in microseconds as
+ * stored in the file, a value of zero means unbounded on that end.
+ */
+struct FrameLoadFilter
+{
+    struct IdMask
+    {
+        uint32_t id;
+        uint32_t mask;
+    };
+
+    QSet<uint32_t> exactIds;
+    QVector<IdMask> maskedIds;
+    QSet<int> buses;
+    uint64_t startTime = 0;
+    uint64_t endTime = 0;
+
+    bool hasIdFilter() const { return !exactIds.isEmpty() || !maskedIds.isEmpty(); }
+    bool hasTimeFilter() const { return startTime != 0 || endTime != 0; }
+    bool isActive() const { return hasIdFilter() || !buses.isEmpty() || hasTimeFilter(); }
+
+    void clear()
+    {
+        exactIds.clear();
+        maskedIds.clear();
+        buses.clear();
+        startTime = 0;
+        endTime = 0;
+    }
+
+    void addId(uint32_t id, uint32_t mask = 0x1FFFFFFF)
+    {
+        mask &= 0x1FFFFFFF;
+        if (mask == 0x1FFFFFFF) exactIds.insert(id & mask);
+        else maskedIds.append({id & mask, mask});
+    }
+
+    bool acceptsId(uint32_t id) const
+    {
+        if (!hasIdFilter()) return true;
+        if (exactIds.contains(id)) return true;
+        for (const IdMask &m : maskedIds)
+        {
+            if ((id & m.mask) == m.id) return true;
+        }
+        return false;
+    }
+
+    bool acceptsBus(int bus) const
+    {
+        return buses.isEmpty() || buses.contains(bus);
+    }
+
+    bool acceptsTime(uint64_t timeStamp) const
+    {
+        if (startTime && timeStamp < startTime) return false;
+        if (endTime && timeStamp > endTime) return false;
+        return true;
+    }
+
+    bool accepts(uint32_t id, int bus, uint64_t timeStamp) const
+    {
+        return acceptsId(id) && acceptsBus(bus) && acceptsTime(timeStamp);
+    }
+
+    bool accepts(const CANFrame &frame) const
+    {
+        return accepts(frame.frameId(), frame.bus, static_cast<uint64_t>(frame.timeStamp().microSeconds()));
+    }
+};
+
+#endif // FRAMELOADFILTER_H
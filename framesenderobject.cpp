@@ -114,6 +114,7 @@ void FrameSenderObject::addSendRecord(FrameSendData record)
                                   Q_ARG(FrameSendData, record));
         return;
     }
+    record.resolveSignalHandles(dbcHandler->getSnapshot());
     sendingData.append(record);
 }
 
@@ -297,34 +298,29 @@ void FrameSenderObject::processIncomingFrame(CANFrame *frame)
                 passedChecks = false;
 
             //if the above passed then are we triggering not only on ID but also signal?
-            if (passedChecks && (thisTrigger->triggerMask & (TriggerMask::TRG_SIGNAL | TriggerMask::TRG_ID) ) )
+            if (passedChecks && (thisTrigger->triggerMask & TriggerMask::TRG_SIGNAL) )
             {
                 bool sigCheckPassed = false;
-                DBC_MESSAGE *msg = dbcHandler->findMessage(thisTrigger->ID);
-                if (msg)
+                sendingData[sd].updateSignalHandles();
+                const DBCSnapshot::Signal *sig = thisTrigger->sigHandle;
+                if (sig)
                 {
-                    DBC_SIGNAL *sig = msg->sigHandler->findSignalByName(thisTrigger->sigName);
-                    if (sig)
+                    //first of all, is this signal really in this message we got?
+                    if (sig->isInFrame(*frame)) sigCheckPassed = true;
+                    //if it was and we're also filtering on value then try that next
+                    if (sigCheckPassed && (thisTrigger->triggerMask & TriggerMask::TRG_SIGVAL))
                     {
-                        //first of all, is this signal really in this message we got?
-                        if (sig->isSignalInMessage(*frame)) sigCheckPassed = true;
-                        //if it was and we're also filtering on value then try that next
-                        if (sigCheckPassed && (thisTrigger->triggerMask & TriggerMask::TRG_SIGVAL))
+                        double sigval = 0.0;
+                        if (sig->decodeAsDouble(*frame, sigval))
                         {
-                            double sigval = 0.0;
-                            if (sig->processAsDouble(*frame, sigval))
+                            if (abs(sigval - thisTrigger->sigValueDbl) > 0.001)
                             {
-                                if (abs(sigval - thisTrigger->sigValueDbl) > 0.001)
-                                {
-                                    sigCheckPassed = false;
-                                }
+                                sigCheckPassed = false;
                             }
-                            else sigCheckPassed = false;
                         }
+                        else sigCheckPassed = false;
                     }
-                    else sigCheckPassed = false;
                 }
-                else sigCheckPassed = false;
                 passedChecks &= sigCheckPassed; //passedChecks can only be true if both are
             }
 
@@ -366,6 +362,10 @@ void FrameSenderObject::doModifiers(int idx)
     ModifierOp op;
 
     if (sendData->modifiers.count() == 0) return; //if no modifiers just leave right now
+    sendData->updateSignalHandles();
+
+    //values for signal targets are collected and packed into the frame together once all modifiers ran
+    QList<QPair<const DBCSnapshot::Signal *, double>> signalValues;
 
     //qDebug() << "Executing mods";
 
@@ -408,11 +408,21 @@ void FrameSenderObject::doModifiers(int idx)
                 shadowReg = first % second;
             }
         }
+        if (mod->destByte == -1)
+        {
+            if (mod->sigHandle) signalValues.append(qMakePair(mod->sigHandle, static_cast<double>(shadowReg)));
+            continue;
+        }
+        if (mod->destByte < 0 || mod->destByte >= sendData->payload().length()) continue;
         //Finally, drop the result into the proper data byte
         QByteArray newArr(sendData->payload());
         newArr[mod->destByte] = (char) shadowReg;
         sendData->setPayload(newArr);
     }
+
+    QString errorString;
+    if (!sendData->packSignalValues(signalValues, &errorString))
+        qDebug() << "Could not set signals of frame " << sendData->frameId() << ": " << errorString;
 }
 
 int FrameSenderObject::fetchOperand(int idx, ModifierOperand op)
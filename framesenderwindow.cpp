@@ -224,31 +224,26 @@ void FrameSenderWindow::processIncomingFrame(CANFrame *frame)
             if (passedChecks && (thisTrigger->triggerMask & TriggerMask::TRG_SIGNAL) )
             {
                 bool sigCheckPassed = false;
-                DBC_MESSAGE *msg = dbcHandler->findMessage(thisTrigger->ID);
-                if (msg)
+                sendingData[sd].updateSignalHandles();
+                const DBCSnapshot::Signal *sig = thisTrigger->sigHandle;
+                if (sig)
                 {
-                    DBC_SIGNAL *sig = msg->sigHandler->findSignalByName(thisTrigger->sigName);
-                    if (sig)
+                    //first of all, is this signal really in this message we got?
+                    if (sig->isInFrame(*frame)) sigCheckPassed = true;
+                    //if it was and we're also filtering on value then try that next
+                    if (sigCheckPassed && (thisTrigger->triggerMask & TriggerMask::TRG_SIGVAL))
                     {
-                        //first of all, is this signal really in this message we got?
-                        if (sig->isSignalInMessage(*frame)) sigCheckPassed = true;
-                        //if it was and we're also filtering on value then try that next
-                        if (sigCheckPassed && (thisTrigger->triggerMask & TriggerMask::TRG_SIGVAL))
+                        double sigval = 0.0;
+                        if (sig->decodeAsDouble(*frame, sigval))
                         {
-                            double sigval = 0.0;
-                            if (sig->processAsDouble(*frame, sigval))
+                            if (abs(sigval - thisTrigger->sigValueDbl) > 0.001)
                             {
-                                if (abs(sigval - thisTrigger->sigValueDbl) > 0.001)
-                                {
-                                    sigCheckPassed = false;
-                                }
+                                sigCheckPassed = false;
                             }
-                            else sigCheckPassed = false;
                         }
+                        else sigCheckPassed = false;
                     }
-                    else sigCheckPassed = false;
                 }
-                else sigCheckPassed = false;
                 passedChecks &= sigCheckPassed; //passedChecks can only be true if both are
             }
 
@@ -605,6 +600,10 @@ void FrameSenderWindow::doModifiers(int idx)
     ModifierOp op;
 
     if (sendData->modifiers.count() == 0) return; //if no modifiers just leave right now
+    sendData->updateSignalHandles();
+
+    //values for signal targets are collected and packed into the frame together once all modifiers ran
+    QList<QPair<const DBCSnapshot::Signal *, double>> signalValues;
 
     //qDebug() << "Executing mods";
 
@@ -647,11 +646,21 @@ void FrameSenderWindow::doModifiers(int idx)
                 shadowReg = first % second;
             }
         }
+        if (mod->destByte == -1)
+        {
+            if (mod->sigHandle) signalValues.append(qMakePair(mod->sigHandle, static_cast<double>(shadowReg)));
+            continue;
+        }
+        if (mod->destByte < 0 || mod->destByte >= sendData->payload().length()) continue;
         //Finally, drop the result into the proper data byte
         QByteArray newArr(sendData->payload());
         newArr[mod->destByte] = (char) shadowReg;
         sendData->setPayload(newArr);
     }
+
+    QString errorString;
+    if (!sendData->packSignalValues(signalValues, &errorString))
+        qDebug() << "Could not set signals of frame " << sendData->frameId() << ": " << errorString;
 }
 
 int FrameSenderWindow::fetchOperand(int idx, ModifierOperand op)
@@ -737,13 +746,13 @@ void FrameSenderWindow::processModifierText(int line)
             QRegularExpression regex;
             QRegularExpressionMatch match;
 
-            regex.setPattern("^\\[(\\w+)]=(\\w+)");
+            regex.setPattern("^\\[(\\w+)]=");
             match = regex.match(mods[i]);
             if (match.hasMatch())
             {
                 thisMod.destByte = -1;
                 thisMod.signalName = match.captured(1);
-                mods[i] = match.captured(2);
+                mods[i] = mods[i].mid(match.capturedEnd(0)); //the whole expression after the = is the value
                 thisMod.operations.clear();
             }
             else
@@ -812,6 +821,7 @@ void FrameSenderWindow::processModifierText(int line)
         }
     }
     //there is no else for the modifiers. We'll accept there not being any
+    sendingData[line].resolveSignalHandles(dbcHandler->getSnapshot());
 }
 
 void FrameSenderWindow::processTriggerText(int line)
@@ -915,6 +925,7 @@ void FrameSenderWindow::processTriggerText(int line)
         thisTrigger.triggerMask = TriggerMask::TRG_MS;
         sendingData[line].triggers.append(thisTrigger);
     }
+    sendingData[line].resolveSignalHandles(dbcHandler->getSnapshot());
 }
 
 //Turn a set of tokens into an operand
@@ -1080,6 +1091,7 @@ void FrameSenderWindow::processCellChange(int line, int col)
             if (tempVal < 0) tempVal = 0;
             if (tempVal > 0x7FFFFFFF) tempVal = 0x7FFFFFFF;
             sendingData[line].setFrameId(tempVal);
+            sendingData[line].dbcSnapshot.clear(); //signal modifiers now refer to another message
             if (sendingData[line].frameId() > 0x7FF) {
                 sendingData[line].setExtendedFrameFormat(true);
                 ui->tableSender->blockSignals(true);
@@ -0,0 +1,113 @@
+#include "loadfilterdialog.h"
+#include "ui_loadfilterdialog.h"
+#include <QMessageBox>
+#include <QRegularExpression>
+#include <QSettings>
+
+LoadFilterDialog::LoadFilterDialog(QWidget *parent) :
+    QDialog(parent),
+    ui(new Ui::LoadFilterDialog)
+{
+    ui->setupUi(this);
+
+    QSettings settings;
+    ui->txtIDs->setText(settings.value("LoadFilter/IDs", "").toString());
+    ui->txtBuses->setText(settings.value("LoadFilter/Buses", "").toString());
+    ui->txtStartTime->setText(settings.value("LoadFilter/StartTime", "").toString());
+    ui->txtEndTime->setText(settings.value("LoadFilter/EndTime", "").toString());
+
+    connect(ui->btnOK, &QPushButton::clicked, this, &LoadFilterDialog::handleOK);
+    connect(ui->btnCancel, &QPushButton::clicked, this, &LoadFilterDialog::reject);
+}
+
+LoadFilterDialog::~LoadFilterDialog()
+{
+    delete ui;
+}
+
+void LoadFilterDialog::handleOK()
+{
+    FrameLoadFilter filter;
+    uint64_t dummy;
+
+    if (!parseIds(filter))
+    {
+        QMessageBox::warning(this, "Invalid ID list", "IDs must be hex values separated by commas. A mask can be given as ID/MASK (e.g. 0x100/0x7F0)");
+        return;
+    }
+    if (!parseBuses(filter))
+    {
+        QMessageBox::warning(this, "Invalid bus list", "Buses must be numbers separated by commas");
+        return;
+    }
+    if (!parseTime(ui->txtStartTime->text(), dummy) || !parseTime(ui->txtEndTime->text(), dummy))
+    {
+        QMessageBox::warning(this, "Invalid time", "Start and end time must be given in seconds or left blank");
+        return;
+    }
+
+    QSettings settings;
+    settings.setValue("LoadFilter/IDs", ui->txtIDs->text());
+    settings.setValue("LoadFilter/Buses", ui->txtBuses->text());
+    settings.setValue("LoadFilter/StartTime", ui->txtStartTime->text());
+    settings.setValue("LoadFilter/EndTime", ui->txtEndTime->text());
+
+    accept();
+}
+
+FrameLoadFilter LoadFilterDialog::getFilter() const
+{
+    FrameLoadFilter filter;
+    parseIds(filter);
+    parseBuses(filter);
+    parseTime(ui->txtStartTime->text(), filter.startTime);
+    parseTime(ui->txtEndTime->text(), filter.endTime);
+    return filter;
+}
+
+//comma or space separated list of hex IDs, each one optionally followed by /MASK
+bool LoadFilterDialog::parseIds(FrameLoadFilter &filter) const
+{
+    const QStringList entries = ui->txtIDs->text().split(QRegularExpression("[,\\s]+"), Qt::SkipEmptyParts);
+    for (const QString &entry : entries)
+    {
+        QStringList parts = entry.split('/');
+        if (parts.count() > 2) return false;
+        bool ok;
+        uint32_t id = parts[0].toUInt(&ok, 16);
+        if (!ok) return false;
+        uint32_t mask = 0x1FFFFFFF;
+        if (parts.count() == 2)
+        {
+            mask = parts[1].toUInt(&ok, 16);
+            if (!ok) return false;
+        }
+        filter.addId(id, mask);
+    }
+    return true;
+}
+
+bool LoadFilterDialog::parseBuses(FrameLoadFilter &filter) const
+{
+    const QStringList entries = ui->txtBuses->text().split(QRegularExpression("[,\\s]+"), Qt::SkipEmptyParts);
+    for (const QString &entry : entries)
+    {
+        bool ok;
+        int bus = entry.toInt(&ok);
+        if (!ok || bus < 0) return false;
+        filter.buses.insert(bus);
+    }
+    return true;
+}
+
+//time is entered in seconds and stored in microseconds. Blank means no limit
+bool LoadFilterDialog::parseTime(const QString &text, uint64_t &out) const
+{
+    out = 0;
+    if (text.trimmed().isEmpty()) return true;
+    bool ok;
+    double seconds = text.trimmed().toDouble(&ok);
+    if (!ok || seconds < 0.0) return false;
+    out = static_cast<uint64_t>(seconds * 1000000.0 + 0.5);
+    return true;
+}
@@ -0,0 +1,31 @@
+#ifndef LOADFILTERDIALOG_H
+#define LOADFILTERDIALOG_H
+
+#include <QDialog>
+#include "frameloadfilter.h"
+
+namespace Ui {
+class LoadFilterDialog;
+}
+
+//asks which IDs, buses and time window should be kept when loading a log file
+class LoadFilterDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit LoadFilterDialog(QWidget *parent = nullptr);
+    ~LoadFilterDialog();
+
+    FrameLoadFilter getFilter() const;
+
+private:
+    void handleOK();
+    bool parseIds(FrameLoadFilter &filter) const;
+    bool parseBuses(FrameLoadFilter &filter) const;
+    bool parseTime(const QString &text, uint64_t &out) const;
+
+    Ui::LoadFilterDialog *ui;
+};
+
+#endif // LOADFILTERDIALOG_H
@@ -9,6 +9,8 @@
 #include "helpwindow.h"
 #include "utility.h"
 #include "filterutility.h"
+#include "loadfilterdialog.h"
+#include "dbc/signalvaluestore.h"
 
 #include <QClipboard>
 /*
@@ -108,6 +110,8 @@ MainWindow::MainWindow(QWidget *parent) :
     //handlers for all menu entries
     connect(ui->actionSetup, SIGNAL(triggered(bool)), SLOT(showConnectionSettingsWindow()));
     connect(ui->actionOpen_Log_File, &QAction::triggered, this, &MainWindow::handleLoadFile);
+    connect(ui->actionMerge_Log_Files, &QAction::triggered, this, &MainWindow::handleLoadMergedFiles);
+    connect(ui->actionOpen_Filtered_Log_File, &QAction::triggered, this, &MainWindow::handleLoadFilteredFile);
     connect(ui->actionGraph_Dta, &QAction::triggered, this, &MainWindow::showGraphingWindow);
     connect(ui->actionFrame_Data_Analysis, &QAction::triggered, this, &MainWindow::showFrameDataAnalysis);
     connect(ui->actionSave_Log_File, &QAction::triggered, this, &MainWindow::handleSaveFile);
@@ -532,6 +536,7 @@ void MainWindow::processSenderCellChange(int line, int col)
         if (tempVal < 0) tempVal = 0;
         if (tempVal > 0x7FFFFFFF) tempVal = 0x7FFFFFFF;
         tempData->setFrameId(tempVal);
+        tempData->dbcGeneration = -1; //signal modifiers now refer to another message
         if (tempData->frameId() > 0x7FF) {
             tempData->setExtendedFrameFormat(true);
             ui->tableSimpleSender->blockSignals(true);
@@ -1136,41 +1141,62 @@ void MainWindow::normalizeTiming()
     emit framesUpdated(-2); //claim an all new set of frames because every frame was updated.
 }
 
+/*
+ * Replaces the frame list with freshly loaded frames. If the loader failed part way through the user gets to
+ * decide whether the frames it did get are worth keeping.
+ */
+void MainWindow::useLoadedFrames(const QVector<CANFrame> &loadedFrames, const QString &filename, bool loadResult)
+{
+    if (!loadResult)
+    {
+        if (loadedFrames.count() == 0) return; //only ask if at least one frame was decoded.
+        QMessageBox::StandardButton confirmDialog = QMessageBox::question(this, "Error Loading", "Do you want to salvage what could be loaded?",
+                                  QMessageBox::Yes|QMessageBox::No);
+        if (confirmDialog != QMessageBox::Yes) return;
+    }
+
+    disableAutoRowExpansion();
+    ui->canFramesView->scrollToTop();
+    model->clearFrames();
+    model->insertFrames(loadedFrames);
+    loadedFileName = filename;
+    model->recalcOverwrite();
+    ui->lbNumFrames->setText(QString::number(model->rowCount()));
+    if (ui->cbAutoScroll->isChecked()) ui->canFramesView->scrollToBottom();
+
+    updateFileStatus();
+    emit framesUpdated(-1);
+}
+
 void MainWindow::handleLoadFile()
 {
     QString filename;
     QVector<CANFrame> tempFrames;
 
-    QMessageBox::StandardButton confirmDialog;
-
     bool loadResult = FrameFileIO::loadFrameFile(filename, &tempFrames);
+    useLoadedFrames(tempFrames, filename, loadResult);
+}
 
-    if (!loadResult)
-    {
-        if (tempFrames.count() > 0) //only ask if at least one frame was decoded.
-        {
-            confirmDialog = QMessageBox::question(this, "Error Loading", "Do you want to salvage what could be loaded?",
-                                      QMessageBox::Yes|QMessageBox::No);
-            if (confirmDialog == QMessageBox::Yes) {
-                loadResult = true;
-            }
-        }
-    }
+//pick the IDs / buses / time window first so the loader can throw everything else away while parsing
+void MainWindow::handleLoadFilteredFile()
+{
+    QString filename;
+    QVector<CANFrame> tempFrames;
 
-    if (loadResult)
-    {
-        disableAutoRowExpansion();
-        ui->canFramesView->scrollToTop();
-        model->clearFrames();
-        model->insertFrames(tempFrames);
-        loadedFileName = filename;
-        model->recalcOverwrite();
-        ui->lbNumFrames->setText(QString::number(model->rowCount()));
-        if (ui->cbAutoScroll->isChecked()) ui->canFramesView->scrollToBottom();
+    LoadFilterDialog filterDialog(this);
+    if (filterDialog.exec() != QDialog::Accepted) return;
 
-        updateFileStatus();
-        emit framesUpdated(-1);
-    }
+    bool loadResult = FrameFileIO::loadFilteredFrameFile(filename, &tempFrames, filterDialog.getFilter());
+    useLoadedFrames(tempFrames, filename, loadResult);
+}
+
+void MainWindow::handleLoadMergedFiles()
+{
+    QString filename;
+    QVector<CANFrame> tempFrames;
+
+    bool loadResult = FrameFileIO::loadMultipleFrameFiles(filename, &tempFrames);
+    useLoadedFrames(tempFrames, filename, loadResult);
 }
 
 void MainWindow::handleDroppedFile(const QString &filename)
@@ -1188,33 +1214,7 @@ void MainWindow::handleDroppedFile(const QString &filename)
     
     progress.cancel();
     
-    if (!loadResult)
-    {
-        if (loadedFrames.count() > 0) //only ask if at least one frame was decoded.
-        {
-            QMessageBox::StandardButton confirmDialog = QMessageBox::question(this, "Error Loading", "Do you want to salvage what could be loaded?",
-                                      QMessageBox::Yes|QMessageBox::No);
-            if (confirmDialog == QMessageBox::Yes)
-            {
-                loadResult = true;
-            }
-        }
-    }
-
-    if (loadResult)
-    {
-        disableAutoRowExpansion();
-        ui->canFramesView->scrollToTop();
-        model->clearFrames();
-        model->insertFrames(loadedFrames);
-        loadedFileName = filename;
-        model->recalcOverwrite();
-        ui->lbNumFrames->setText(QString::number(model->rowCount()));
-        if (ui->cbAutoScroll->isChecked()) ui->canFramesView->scrollToBottom();
-
-        updateFileStatus();
-        emit framesUpdated(-1);
-    }
+    useLoadedFrames(loadedFrames, filename, loadResult);
 }
 
 
@@ -1348,10 +1348,28 @@ void MainWindow::handleSaveDecodedMethod(bool csv)
     }
 }
 
+/*
+ * Text of one signal for frames->at(frameIdx), same as processAsText gives it. Taken from the signal value store so
+ * exporting again, or exporting what a graph or the signal viewer already decoded, reuses those series.
+ * The decoded exports have always listed every signal of the message, multiplexed ones the frame doesn't carry too.
+ * Those are in no series and get decoded from the frame.
+ */
+static bool decodedSignalText(const QVector<CANFrame> *frames, int frameIdx, const QSharedPointer<const DBCSnapshot> &snapshot,
+                              const DBCSnapshot::Signal &sig, QString &outString, bool outputName = true, bool outputUnit = true)
+{
+    const CANFrame &frame = frames->at(frameIdx);
+    QSharedPointer<const SignalSeries> series = SignalValueStore::getReference()->getSeries(frames, snapshot, &sig, frame.frameId(), -1);
+    int row = series ? series->rowOfFrame(frameIdx) : -1;
+    if (row >= 0) return series->textAt(row, *frames, &sig, outString, outputName, outputUnit);
+    return sig.decodeAsText(frame, outString, outputName, outputUnit);
+}
+
 void MainWindow::saveDecodedTextFileAsColumns(QString filename)
 {
     QFile *outFile = new QFile(filename);
     const QVector<CANFrame> *frames = model->getFilteredListReference();
+    QSharedPointer<const DBCSnapshot> snapshot;
+    if (dbcHandler != nullptr) snapshot = dbcHandler->getSnapshot();
 
     //const unsigned char *data;
     int dataLen;
@@ -1404,11 +1422,11 @@ Data Bytes: 88 10 00 13 BB 00 06 00
         //add all column names
         if (dbcHandler != nullptr)
         {
-            DBC_MESSAGE *msg = dbcHandler->findMessage(*frame);
+            const DBCSnapshot::Message *msg = snapshot->findMessage(*frame);
             if (msg != nullptr)
             {
                 bool found = false;
-                for (int j = 0; j < msg->sigHandler->getCount(); j++)
+                for (int j = 0; j < msg->sigs.count(); j++)
                 {
                     if(j==0)
                     {
@@ -1424,9 +1442,9 @@ Data Bytes: 88 10 00 13 BB 00 06 00
                     if(found == false)
                     {
                         QString temp;
-                        if (msg->sigHandler->findSignalByIdx(j)->processAsText(*frame, temp))
+                        if (decodedSignalText(frames, c, snapshot, msg->sigs[j], temp))
                         {
-                            builderString.append(msg->sigHandler->findSignalByIdx(j)->name);
+                            builderString.append(msg->sigs[j].name);
                             builderString.append(",");
                             columnsAdded++;
                         }
@@ -1486,10 +1504,10 @@ Data Bytes: 88 10 00 13 BB 00 06 00
 
         if (dbcHandler != nullptr)
         {
-            DBC_MESSAGE *msg = dbcHandler->findMessage(*frame);
+            const DBCSnapshot::Message *msg = snapshot->findMessage(*frame);
             if (msg != nullptr)
             {
-                for (int j = 0; j < msg->sigHandler->getCount(); j++)
+                for (int j = 0; j < msg->sigs.count(); j++)
                 {
                     if(j==0)
                     {
@@ -1508,7 +1526,7 @@ Data Bytes: 88 10 00 13 BB 00 06 00
                     }
 
                     QString temp;
-                    if (msg->sigHandler->findSignalByIdx(j)->processAsText(*frame, temp, false, false))
+                    if (decodedSignalText(frames, c, snapshot, msg->sigs[j], temp, false, false))
                     {
                         builderString.append(temp);
                         builderString.append(",");
@@ -1527,6 +1545,8 @@ void MainWindow::saveDecodedTextFile(QString filename)
 {
     QFile *outFile = new QFile(filename);
     const QVector<CANFrame> *frames = model->getFilteredListReference();
+    QSharedPointer<const DBCSnapshot> snapshot;
+    if (dbcHandler != nullptr) snapshot = dbcHandler->getSnapshot();
 
     const unsigned char *data;
     int dataLen;
@@ -1565,14 +1585,14 @@ Data Bytes: 88 10 00 13 BB 00 06 00
         builderString = "";
         if (dbcHandler != nullptr)
         {
-            DBC_MESSAGE *msg = dbcHandler->findMessage(*frame);
+            const DBCSnapshot::Message *msg = snapshot->findMessage(*frame);
             if (msg != nullptr)
             {
-                for (int j = 0; j < msg->sigHandler->getCount(); j++)
+                for (int j = 0; j < msg->sigs.count(); j++)
                 {
 
                     QString temp;
-                    if (msg->sigHandler->findSignalByIdx(j)->processAsText(*frame, temp))
+                    if (decodedSignalText(frames, c, snapshot, msg->sigs[j], temp))
                     {
                         builderString.append("\t" + temp);
                         builderString.append("\n");
@@ -1893,6 +1913,7 @@ void MainWindow::showFlowViewWindow()
 
 void MainWindow::DBCSettingsUpdated()
     {
+    dbcHandler->publishSnapshot();
     updateFilterList();
     model->sendRefresh();
     }
@@ -71,6 +71,8 @@ public:
 
 private slots:
     void handleLoadFile();
+    void handleLoadMergedFiles();
+    void handleLoadFilteredFile();
     void handleSaveFile();
     void handleSaveFilteredFile();
     void handleSaveFilters();
@@ -220,6 +222,7 @@ private:
     void saveDecodedTextFile(QString);
     void saveDecodedTextFileAsColumns(QString);
     void addFrameToDisplay(CANFrame &, bool);
+    void useLoadedFrames(const QVector<CANFrame> &loadedFrames, const QString &filename, bool loadResult);
     void updateFileStatus();
     void closeEvent(QCloseEvent *event);
     void killEmAll();
@@ -1,197 +1,250 @@
-#include <math.h>
+#include <string.h>
+#include <QFile>
 #include "pcaplite.h"
 
 #define MAGIC_NG 0x0A0D0D0A
-#define MACIG 0xA1B2C3D4  
-
-#define MAX_CAN_PACKET_SIZE 256
+#define MACIG 0xA1B2C3D4
+#define MACIG_NSEC 0xA1B23C4D
+#define MAGIC_BYTE_ORDER 0x1A2B3C4D
 
 // some pcap format constants
 #define PCAP_FILE_HEADER_LENGTH 24
 #define PCAP_FRAME_HEADER_LENGTH 16
+#define PCAP_LINK_TYPE_OFFSET 20
 #define PCAP_CAP_FRAME_LENGTH_OFFSET 8
 #define PCAP_FRAME_LENGTH_OFFSET 12
 
 // some pcapng format constants
+#define SECTION_HEADER_BLOCK MAGIC_NG
 #define INTERFACE_DESCRITION_BLOCK 0x01
+#define SIMPLE_PACKET_BLOCK 0x03
 #define ENCHANCED_PACKET_BLOCK 0x06
+#define OPTION_END 0x00
+#define OPTION_IF_TSRESOL 0x09
+#define BLOCK_OVERHEAD 12 // type, length and the trailing copy of the length
 
-static unsigned char pcap_buffer[MAX_CAN_PACKET_SIZE];
-static pcap_t p;
+#define DEFAULT_TS_PER_SEC 1000000ull
+#define DUMP_BUFFER_SIZE (1024 * 1024)
 
-pcap *pcap_open_offline(const char *filename, char *error_text, int expected_link_type) {
-	FILE *file;
+static inline unsigned int swap32(unsigned int v) {
+    return ((v & 0xFF) << 24) | ((v & 0xFF00) << 8) | ((v >> 8) & 0xFF00) | (v >> 24);
+}
 
-    snprintf(error_text, PCAP_ERRBUF_SIZE, "OK");
+static inline unsigned int rd32(const pcap_t *p, size_t offset) {
+    unsigned int v;
+    memcpy(&v, p->data + offset, sizeof(v));
+    return p->swapped ? swap32(v) : v;
+}
+
+static inline unsigned short rd16(const pcap_t *p, size_t offset) {
+    unsigned short v;
+    memcpy(&v, p->data + offset, sizeof(v));
+    return p->swapped ? (unsigned short)((v << 8) | (v >> 8)) : v;
+}
+
+static void set_timestamp(struct pcap_pkthdr *h, unsigned long long ticks, unsigned long long ts_per_sec) {
+    h->ts.tv_sec = (long)(ticks / ts_per_sec);
+    h->ts.tv_usec = (long)((double)(ticks % ts_per_sec) * 1000000.0 / (double)ts_per_sec);
+}
+
+// reads the interface description block body starting at offset, options included
+static pcap_interface read_interface(const pcap_t *p, size_t offset, size_t body_end) {
+    pcap_interface iface;
+    iface.link_type = rd16(p, offset);
+    iface.ts_per_sec = DEFAULT_TS_PER_SEC;
+
+    size_t opt = offset + 8; // link type, reserved, snap length
+    while (opt + 4 <= body_end) {
+        unsigned short option_type = rd16(p, opt);
+        unsigned short option_length = rd16(p, opt + 2);
+        if (OPTION_END == option_type) break;
+        if (OPTION_IF_TSRESOL == option_type && option_length >= 1 && opt + 5 <= body_end) {
+            unsigned char res = p->data[opt + 4];
+            if ((0x80 & res) == 0) {
+                iface.ts_per_sec = 1;
+                for (int i = 0; i < res; i++) iface.ts_per_sec *= 10;
+            } else {
+                iface.ts_per_sec = 1ull << (res & 0x7f);
+            }
+            if (0 == iface.ts_per_sec) iface.ts_per_sec = DEFAULT_TS_PER_SEC;
+        }
+        // options are padded to a 4 byte boundary
+        opt += 4 + ((option_length + 3u) & ~3u);
+    }
+    return iface;
+}
+
+// handles the byte order magic of a section header. Returns false if it is not a valid one
+static bool read_section_header(pcap_t *p, size_t offset) {
+    unsigned int byte_order;
+    if (offset + 12 > p->size) return false;
+    memcpy(&byte_order, p->data + offset + 8, sizeof(byte_order));
+    if (MAGIC_BYTE_ORDER == byte_order) p->swapped = false;
+    else if (MAGIC_BYTE_ORDER == swap32(byte_order)) p->swapped = true;
+    else return false;
+    p->if_count = 0; // interface ids start over in every section
+    return true;
+}
+
+// link type of the first interface in the file, -1 if there is none
+static int first_ng_link_type(pcap_t *p) {
+    size_t pos = 0;
+    while (pos + BLOCK_OVERHEAD <= p->size) {
+        unsigned int block_type = rd32(p, pos);
+        if (SECTION_HEADER_BLOCK == block_type && !read_section_header(p, pos)) return -1;
+        unsigned int block_size = rd32(p, pos + 4);
+        if (block_size < BLOCK_OVERHEAD || pos + block_size > p->size) return -1;
+        if (INTERFACE_DESCRITION_BLOCK == block_type) return rd16(p, pos + 8);
+        pos += block_size;
+    }
+    return -1;
+}
 
-    file = fopen(filename,"rb");
+pcap *pcap_open_offline(const char *filename, char *error_text, int expected_link_type) {
+    snprintf(error_text, PCAP_ERRBUF_SIZE, "OK");
 
-    if (NULL == file) {
+    QFile *file = new QFile(QString::fromLocal8Bit(filename));
+    if (!file->open(QIODevice::ReadOnly)) {
         snprintf(error_text, PCAP_ERRBUF_SIZE,
                "Cannot open input file");
+        delete file;
         return NULL;
     }
 
-	unsigned int magic;
-	size_t bytes_read;
+    qint64 size = file->size();
+    if (size < PCAP_FILE_HEADER_LENGTH) {
+        snprintf(error_text, PCAP_ERRBUF_SIZE, "Cannot read magic word");
+        delete file;
+        return NULL;
+    }
 
-	bytes_read = fread(&magic, 1, sizeof(magic), file);
-	if (bytes_read != sizeof(magic)) {
-		snprintf(error_text, PCAP_ERRBUF_SIZE, "Cannot read magic word");
-        fclose(file);
-		return (NULL);
-	}
+    const unsigned char *data = file->map(0, size);
+    if (NULL == data) {
+        snprintf(error_text, PCAP_ERRBUF_SIZE, "Cannot map input file");
+        delete file;
+        return NULL;
+    }
 
-    if (magic != MACIG && magic != MAGIC_NG) {
-        snprintf(error_text, PCAP_ERRBUF_SIZE, "Not a supported format %04x", magic);
-        fclose(file);
-		return (NULL);
+    pcap_t *p = new pcap_t;
+    p->file = file;
+    p->data = data;
+    p->size = (size_t)size;
+    p->pos = 0;
+    p->is_ng = false;
+    p->swapped = false;
+    p->link_type = PCAP_LINKTYPE_ANY;
+    p->expected_link_type = expected_link_type;
+    p->ts_per_sec = DEFAULT_TS_PER_SEC;
+    p->if_count = 0;
+
+    unsigned int magic;
+    memcpy(&magic, data, sizeof(magic));
+
+    if (MAGIC_NG == magic) {
+        p->is_ng = true;
+        if (!read_section_header(p, 0)) {
+            snprintf(error_text, PCAP_ERRBUF_SIZE, "Cannot read section header");
+            pcap_close(p);
+            return NULL;
+        }
+        // Check the link type of the first interface. Packets of other interfaces are skipped while reading
+        if (expected_link_type >= 0 && first_ng_link_type(p) != expected_link_type) {
+            snprintf(error_text, PCAP_ERRBUF_SIZE, "This link type is not supported by this decoder");
+            pcap_close(p);
+            return NULL;
+        }
+        // blocks are walked from the start of the file so every section header and interface gets seen
+        p->if_count = 0;
+        return p;
     }
 
-    unsigned int link_type;
-    fseek(file, PCAP_FILE_HEADER_LENGTH - 4, SEEK_SET);
-    bytes_read = fread(&link_type, 1, sizeof(link_type), file);
-    if (bytes_read != sizeof(link_type)) {
-        snprintf(error_text, PCAP_ERRBUF_SIZE, "Cannot read linktype word");
-        fclose(file);
-        return (NULL);
+    if (MACIG == magic || MACIG_NSEC == magic) {
+        p->swapped = false;
+    } else if (MACIG == swap32(magic) || MACIG_NSEC == swap32(magic)) {
+        p->swapped = true;
+        magic = swap32(magic);
+    } else {
+        snprintf(error_text, PCAP_ERRBUF_SIZE, "Not a supported format %04x", magic);
+        pcap_close(p);
+        return NULL;
     }
+
+    if (MACIG_NSEC == magic) p->ts_per_sec = 1000000000ull;
+    // upper bits can carry FCS information
+    p->link_type = (int)(rd32(p, PCAP_LINK_TYPE_OFFSET) & 0x0FFFFFFF);
     if (expected_link_type >= 0) {
         // Check the link type
-        if ((int) link_type != expected_link_type) {
+        if (p->link_type != expected_link_type) {
             snprintf(error_text, PCAP_ERRBUF_SIZE, "This link type is not supported by this decoder");
-            fclose(file);
-            return (NULL);
+            pcap_close(p);
+            return NULL;
         }
     }
 
-    // set the format
-    // and seek past file header
-    if (MAGIC_NG == magic) {
-        p.is_ng = 1;
-        fseek(file, sizeof(magic), SEEK_SET);
-        unsigned int  section_length;
-        bytes_read = fread(&section_length, 1, sizeof(section_length), file);
-        if (bytes_read != sizeof(section_length)) {
-		    snprintf(error_text, PCAP_ERRBUF_SIZE, "Cannot read section length");
-            fclose(file);
-		    return (NULL);
-	    }
-        fseek(file, section_length, SEEK_SET);
-    } else {
-        p.is_ng = 0;
-        fseek(file, PCAP_FILE_HEADER_LENGTH, SEEK_SET);
-    }
-
-    p.file = file;
-	return(&p);
+    // seek past file header
+    p->pos = PCAP_FILE_HEADER_LENGTH;
+    return p;
 }
 
 const unsigned char *pcap_next_ng(pcap_t *p, struct pcap_pkthdr *h) {
-    // this is for ENCHANCED_PACKET_BLOCK
-    struct block_header { 
-        unsigned int block_type;
-        unsigned int block_size;
-        unsigned int interface_id;
-        unsigned int timestamp_hi;
-        unsigned int timestamp_lo;
-        unsigned int cap_len;
-        unsigned int len;
-    } bh;
-
-    struct option_header {
-        unsigned short option_type;
-        unsigned short option_length;
-    } oh;
-
-    size_t bytes_read;
-
-    static double timestamp_multiplier = 0.000001; //microseconds resolution
-
-    long fpos = ftell(p->file);
-    
-    do {
-        bytes_read = fread(&bh, 1, sizeof(bh), p->file);
-        if (bytes_read != sizeof(bh)) {
-            //probably EOF
-            return (NULL);
+    while (p->pos + BLOCK_OVERHEAD <= p->size) {
+        size_t pos = p->pos;
+        unsigned int block_type = rd32(p, pos);
+        if (SECTION_HEADER_BLOCK == block_type && !read_section_header(p, pos)) return NULL;
+        unsigned int block_size = rd32(p, pos + 4);
+        if (block_size < BLOCK_OVERHEAD || pos + block_size > p->size) {
+            //probably truncated at the end
+            return NULL;
         }
+        p->pos += block_size;
 
-        if (bh.block_type != ENCHANCED_PACKET_BLOCK) {
-            if (INTERFACE_DESCRITION_BLOCK == bh.block_type) {
-                // Seek to start of options part in the header
-                fseek(p->file, fpos + 16, SEEK_SET);
-                do {
-                    bytes_read = fread(&oh, 1, sizeof(oh), p->file);
-                    if (bytes_read != sizeof(oh)) {
-                        //probably EOF
-                        return (NULL);
-                    }
-                    
-                    // calculate option length aligned on 4 byte boundary
-                    unsigned int option_file_length = 4*(oh.option_length/4) + ((oh.option_length%4) ? 4:0);
-
-                    
-                    // read in the buffer if it's large enough or skip
-                    if (option_file_length <= sizeof(pcap_buffer)) {
-                        bytes_read = fread(pcap_buffer, 1, option_file_length, p->file);
-                        if (bytes_read != option_file_length) {
-                            //probably EOF
-		                    return (NULL);
-	                    }
-                        //check if time resolution option
-                        if (0x09 == oh.option_type) {
-                            unsigned int res = *(unsigned int*)pcap_buffer;
-                            if ((0x80000000 & res) == 0) {
-                                timestamp_multiplier = 1/pow(10, res); 
-                            } else {
-                               timestamp_multiplier = 1/pow(2, (res & 0x7fffffff));  
-                            }
-                        }
-                    } else if (fseek(p->file, option_file_length, SEEK_CUR)) {
-                        //probably EOF
-		                return (NULL);
-                    }
-
-                } while(ftell(p->file) < fpos + bh.block_size - sizeof(bh.block_size));
-
-                if (fseek(p->file, sizeof(bh.block_size), SEEK_CUR)) {
-                        //probably EOF
-		                return (NULL);
-                }
+        size_t body = pos + 8;
+        size_t body_end = pos + block_size - 4;
+
+        if (INTERFACE_DESCRITION_BLOCK == block_type) {
+            if (p->if_count < PCAP_MAX_INTERFACES && body + 8 <= body_end) {
+                p->interfaces[p->if_count++] = read_interface(p, body, body_end);
             }
+            continue;
+        }
 
+        pcap_interface iface;
+        iface.link_type = PCAP_LINKTYPE_ANY;
+        iface.ts_per_sec = DEFAULT_TS_PER_SEC;
+        const unsigned char *packet;
+
+        if (ENCHANCED_PACKET_BLOCK == block_type) {
+            if (body + 20 > body_end) continue;
+            h->interface_id = rd32(p, body);
+            unsigned long long ticks = ((unsigned long long)rd32(p, body + 4) << 32) | rd32(p, body + 8);
+            h->caplen = rd32(p, body + 12);
+            h->len = rd32(p, body + 16);
+            if (body + 20 + h->caplen > body_end) continue;
+            if (h->interface_id < p->if_count) iface = p->interfaces[h->interface_id];
+            set_timestamp(h, ticks, iface.ts_per_sec);
+            packet = p->data + body + 20;
+        } else if (SIMPLE_PACKET_BLOCK == block_type) {
+            if (body + 4 > body_end) continue;
+            // no timestamp and always the first interface
+            h->interface_id = 0;
+            h->len = rd32(p, body);
+            h->caplen = (unsigned int)(body_end - (body + 4));
+            if (h->caplen > h->len) h->caplen = h->len;
+            if (p->if_count > 0) iface = p->interfaces[0];
+            h->ts.tv_sec = 0;
+            h->ts.tv_usec = 0;
+            packet = p->data + body + 4;
+        } else {
             // skip to the next block
-            if (fseek(p->file, fpos + bh.block_size, SEEK_SET)) {
-                //probably EOF
-		        return (NULL);
-            }
-            fpos = ftell(p->file);
+            continue;
         }
-    } while (bh.block_type != ENCHANCED_PACKET_BLOCK);
-
-    h->caplen = bh.cap_len;
-    
-    double timestamp = ((unsigned long long)bh.timestamp_hi << 32 | bh.timestamp_lo) * timestamp_multiplier;
-    double fractional, integer;
-
-    fractional = modf(timestamp, &integer);
-    h->ts.tv_sec = (long)integer;
-    h->ts.tv_usec = (long)(fractional * 1000000);
-    
-    bytes_read = fread(pcap_buffer, 1, h->caplen, p->file);
-    if (bytes_read != h->caplen) {
-        //probably EOF
-		return (NULL);
-	}
-   
-    //seek to the next block (go back with bytes read of the block and seek fwd with the block size)
-    if (fseek(p->file, fpos + bh.block_size, SEEK_SET)) {
-        //probably EOF
-		return (NULL);
-    }
 
-    return pcap_buffer;
+        h->link_type = iface.link_type;
+        if (p->expected_link_type >= 0 && iface.link_type != p->expected_link_type) continue;
+        return packet;
+    }
+    //EOF
+    return NULL;
 }
 
 
@@ -201,29 +254,116 @@ const unsigned char *pcap_next(pcap_t *p, struct pcap_pkthdr *h)
         return pcap_next_ng(p, h);
     }
 
-	size_t bytes_read;
-
-	bytes_read = fread(pcap_buffer, 1, PCAP_FRAME_HEADER_LENGTH, p->file);
-    if (bytes_read != PCAP_FRAME_HEADER_LENGTH) {
-        //probably EOF
-		return (NULL);
-	}
+    if (p->pos + PCAP_FRAME_HEADER_LENGTH > p->size) {
+        //EOF
+        return NULL;
+    }
 
-    h->ts.tv_sec = *(unsigned int*)(pcap_buffer);
-    h->ts.tv_usec = *(unsigned int*)(pcap_buffer + 4);
+    unsigned long long sec = rd32(p, p->pos);
+    unsigned long long frac = rd32(p, p->pos + 4);
+    set_timestamp(h, sec * p->ts_per_sec + frac, p->ts_per_sec);
 
-    h->caplen = *(unsigned int*)(pcap_buffer + PCAP_CAP_FRAME_LENGTH_OFFSET);
-    h->len = *(unsigned int*)(pcap_buffer + PCAP_FRAME_LENGTH_OFFSET);
+    h->caplen = rd32(p, p->pos + PCAP_CAP_FRAME_LENGTH_OFFSET);
+    h->len = rd32(p, p->pos + PCAP_FRAME_LENGTH_OFFSET);
+    h->interface_id = 0;
+    h->link_type = p->link_type;
 
-    bytes_read = fread(pcap_buffer, 1, h->caplen, p->file);
-    if (bytes_read != h->caplen) {
-        //probably EOF
-		return (NULL);
-	}
+    if (p->pos + PCAP_FRAME_HEADER_LENGTH + h->caplen > p->size) {
+        //probably truncated at the end
+        return NULL;
+    }
 
-    return pcap_buffer;
+    const unsigned char *packet = p->data + p->pos + PCAP_FRAME_HEADER_LENGTH;
+    p->pos += PCAP_FRAME_HEADER_LENGTH + h->caplen;
+    return packet;
 }
 
 void pcap_close(pcap_t *p) {
-    fclose(p->file);
+    p->file->close(); // also unmaps
+    delete p->file;
+    delete p;
+}
+
+static void put32(QByteArray &out, unsigned int v) {
+    out.append(reinterpret_cast<const char *>(&v), sizeof(v));
+}
+
+static void put16(QByteArray &out, unsigned short v) {
+    out.append(reinterpret_cast<const char *>(&v), sizeof(v));
+}
+
+static bool flush_dump(pcap_dumper_t *d) {
+    bool ok = (d->file->write(d->buffer) == d->buffer.size());
+    d->buffer.resize(0);
+    return ok;
+}
+
+pcap_dumper_t *pcap_ng_dump_open(const char *filename, char *error_text, int link_type) {
+    snprintf(error_text, PCAP_ERRBUF_SIZE, "OK");
+
+    QFile *file = new QFile(QString::fromLocal8Bit(filename));
+    if (!file->open(QIODevice::WriteOnly)) {
+        snprintf(error_text, PCAP_ERRBUF_SIZE, "Cannot open output file");
+        delete file;
+        return NULL;
+    }
+
+    pcap_dumper_t *d = new pcap_dumper_t;
+    d->file = file;
+    d->link_type = link_type;
+    d->if_count = 0;
+    d->buffer.reserve(DUMP_BUFFER_SIZE + 1024);
+
+    // section header, version 1.0 with unknown section length
+    put32(d->buffer, SECTION_HEADER_BLOCK);
+    put32(d->buffer, 28);
+    put32(d->buffer, MAGIC_BYTE_ORDER);
+    put16(d->buffer, 1);
+    put16(d->buffer, 0);
+    put32(d->buffer, 0xFFFFFFFF);
+    put32(d->buffer, 0xFFFFFFFF);
+    put32(d->buffer, 28);
+    return d;
+}
+
+bool pcap_ng_dump(pcap_dumper_t *d, const struct pcap_pkthdr *h, const unsigned char *data) {
+    // the reader only keeps PCAP_MAX_INTERFACES descriptions, a packet on a later interface can't be written validly
+    if (h->interface_id >= PCAP_MAX_INTERFACES) return false;
+
+    // describe interfaces as they get used. Default resolution of microseconds so no options needed
+    while (d->if_count <= h->interface_id) {
+        put32(d->buffer, INTERFACE_DESCRITION_BLOCK);
+        put32(d->buffer, 20);
+        put16(d->buffer, (unsigned short)d->link_type);
+        put16(d->buffer, 0);
+        put32(d->buffer, 0); // no snap length limit
+        put32(d->buffer, 20);
+        d->if_count++;
+    }
+
+    unsigned int padded = (h->caplen + 3u) & ~3u;
+    unsigned int block_size = 32 + padded;
+    unsigned long long ticks = (unsigned long long)h->ts.tv_sec * DEFAULT_TS_PER_SEC + h->ts.tv_usec;
+
+    put32(d->buffer, ENCHANCED_PACKET_BLOCK);
+    put32(d->buffer, block_size);
+    put32(d->buffer, h->interface_id);
+    put32(d->buffer, (unsigned int)(ticks >> 32));
+    put32(d->buffer, (unsigned int)(ticks & 0xFFFFFFFF));
+    put32(d->buffer, h->caplen);
+    put32(d->buffer, h->len);
+    d->buffer.append(reinterpret_cast<const char *>(data), h->caplen);
+    if (padded != h->caplen) d->buffer.append(padded - h->caplen, 0);
+    put32(d->buffer, block_size);
+
+    if (d->buffer.size() >= DUMP_BUFFER_SIZE) return flush_dump(d);
+    return true;
+}
+
+bool pcap_dump_close(pcap_dumper_t *d) {
+    bool ok = flush_dump(d);
+    d->file->close();
+    delete d->file;
+    delete d;
+    return ok;
 }
@@ -7,28 +7,66 @@
 #else
 #include <winsock.h>
 #endif
+#include <QByteArray>
+
+class QFile;
 
 #define PCAP_ERRBUF_SIZE        (256)
 #define PCAP_LINKTYPE_SOCKETCAN (227)
 #define PCAP_LINKTYPE_ANY       (-1)
+#define PCAP_MAX_INTERFACES     (64)
 
 struct pcap_pkthdr {
 	struct timeval ts;	/* time stamp */
 	unsigned int caplen;	/* length of portion present */
 	unsigned int len;	/* length of this packet (off wire) */
+    unsigned int interface_id; /* pcapng interface the packet came from, 0 for pcap */
+    int link_type;      /* link type of that interface */
+};
+
+struct pcap_interface {
+    int link_type;
+    unsigned long long ts_per_sec; /* timestamp units per second (if_tsresol) */
 };
 
+/* The whole file is memory mapped. Packets are returned as pointers into the mapping so nothing is copied */
 struct pcap {
-    FILE *file;
+    QFile *file;
+    const unsigned char *data;
+    size_t size;
+    size_t pos;
     bool is_ng;
+    bool swapped;       /* file was written with the other byte order */
+    int link_type;      /* classic pcap only, pcapng keeps it per interface */
+    int expected_link_type;
+    unsigned long long ts_per_sec;
+    unsigned int if_count;
+    pcap_interface interfaces[PCAP_MAX_INTERFACES];
 };
 
 typedef struct pcap pcap_t;
 
+struct pcap_dumper {
+    QFile *file;
+    QByteArray buffer;
+    int link_type;
+    unsigned int if_count;
+};
+
+typedef struct pcap_dumper pcap_dumper_t;
+
 pcap *pcap_open_offline(const char *, char *, int);
 
 const unsigned char *pcap_next(pcap_t *, struct pcap_pkthdr *);
 
 void pcap_close(pcap_t *);
 
+/* pcapng writer. Interfaces are described on first use of each interface_id with the link type given here.
+ * interface_id has to be below PCAP_MAX_INTERFACES, pcap_ng_dump fails on anything higher */
+pcap_dumper_t *pcap_ng_dump_open(const char *, char *, int);
+
+bool pcap_ng_dump(pcap_dumper_t *, const struct pcap_pkthdr *, const unsigned char *);
+
+bool pcap_dump_close(pcap_dumper_t *);
+
 #endif// PCAPLITE_H
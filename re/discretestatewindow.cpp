@@ -2,6 +2,9 @@
 #include "ui_discretestatewindow.h"
 #include "mainwindow.h"
 #include "helpwindow.h"
+#include <QtConcurrent/QtConcurrentMap>
+#include <QtEndian>
+#include <algorithm>
 
 DiscreteStateWindow::DiscreteStateWindow(const QVector<CANFrame> *frames, QWidget *parent) :
     QDialog(parent),
@@ -56,6 +59,12 @@ DiscreteStateWindow::DiscreteStateWindow(const QVector<CANFrame> *frames, QWidge
                 idFilters[id] = isChecked;
             });
 
+    searchWatcher = new QFutureWatcher<DiscreteSearchResult>(this);
+    searchProgress = new PoolProgress(this, searchWatcher, tr("Searching for state signals"));
+    connect(searchWatcher, &QFutureWatcher<DiscreteSearchResult>::resultsReadyAt, this, &DiscreteStateWindow::searchResultsReady);
+    connect(searchWatcher, &QFutureWatcher<DiscreteSearchResult>::finished, this, &DiscreteStateWindow::searchFinished);
+    ui->treeMatches->setHeaderLabel(tr("Match"));
+
     refreshFilterList();
     installEventFilter(this);
 }
@@ -64,6 +73,8 @@ DiscreteStateWindow::~DiscreteStateWindow()
 {
     removeEventFilter(this);
     timer->stop();
+    searchProgress->stop();
+    delete searchProgress;
 
     for (int i = 0; i < stateFrames.count(); i++)
     {
@@ -331,7 +342,6 @@ void DiscreteStateWindow::handleTick()
 
 void DiscreteStateWindow::calculateResults()
 {
-    int minBits, maxBits;
     if (isRealtime)
     {
 
@@ -339,33 +349,177 @@ void DiscreteStateWindow::calculateResults()
     else //use already loaded frames from main cache
     {
         //basic overview: run through all ID filters and see if it is enabled.
-        //If so add it to a giant list of messages by ID where each ID has its own
-        //list of messages
-        //Then, for each ID start a loop that runs from largest bits to smallest bits for scan
-        //For each value run through the algorithm for all messages. At the end list any matches
-        //the simplest approach seems to be to grab that number of bits and then record every
-        //unique value. IF the # of unique values is the same as the number of states then
-        //we've got a match.It should be noted that the # of states must be at least 2 - the idle
-        //state is 1 and then a second state at the minimum. Turn signals might be 3 states then
-
-        minBits = ui->spinMinBits->value();
-        maxBits = ui->spinMaxBits->value();
-        QHash<int, bool>::const_iterator it;
-        QList<CANFrame> frameCache;
-        for (it = idFilters.begin(); it != idFilters.end(); ++it)
+        //If so the frames of that ID get packed into words for a search job. One pass over the frames does every ID.
+        //Each job then runs from largest bits to smallest bits for every start bit and records every unique value
+        //IF the # of unique values is the same as the number of states then we've got a match. It should be noted
+        //that the # of states must be at least 2 - the idle state is 1 and then a second state at the minimum.
+        //Turn signals might be 3 states then
+        searchProgress->stop();
+        ui->treeMatches->clear();
+
+        //the values seen are kept in a 256 bit set, searchID can't take anything over 8 bits whatever the spin boxes say
+        int maxBits = qBound(1, ui->spinMaxBits->value(), 8);
+        int minBits = qBound(1, ui->spinMinBits->value(), 8);
+        int numStates = ui->spinStates->value();
+
+        QHash<uint32_t, int> jobIdx;
+        QVector<DiscreteSearchJob> jobs;
+        for (int i = 0; i < modelFrames->count(); i++)
         {
-            if (it.value())
+            const CANFrame &frame = modelFrames->at(i);
+            if (!idFilters.value(static_cast<int>(frame.frameId()), false)) continue;
+
+            auto it = jobIdx.constFind(frame.frameId());
+            if (it == jobIdx.constEnd())
             {
-                frameCache.clear();
-                for (int i = 0; i < modelFrames->count(); i++)
-                {
-                    if (modelFrames->at(i).frameId() == (unsigned int)it.key()) frameCache.append(modelFrames->at(i));
-                }
-                for (int bits = maxBits; bits >= minBits; bits--)
+                DiscreteSearchJob job;
+                job.ID = frame.frameId();
+                job.extended = frame.hasExtendedFrameFormat();
+                job.maxBits = 0;
+                job.minBits = minBits;
+                job.maxSigBits = maxBits;
+                job.numStates = numStates;
+                it = jobIdx.insert(frame.frameId(), jobs.count());
+                jobs.append(job);
+            }
+            DiscreteSearchJob &job = jobs[it.value()];
+            const QByteArray payload = frame.payload();
+            int len = qMin(payload.length(), 8);
+            unsigned char bytes[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+            memcpy(bytes, payload.constData(), len);
+            job.littleWords.append(qFromLittleEndian<quint64>(bytes));
+            job.bigWords.append(qFromBigEndian<quint64>(bytes));
+            job.lengths.append(static_cast<quint8>(len));
+            if (len * 8 > job.maxBits) job.maxBits = len * 8;
+        }
+
+        if (jobs.isEmpty()) return;
+
+        searchProgress->start(jobs.count());
+
+        //every ID is searched on its own pool thread, matches show up as each ID is done
+        searchWatcher->setFuture(QtConcurrent::mapped(jobs, &DiscreteStateWindow::searchID));
+    }
+}
+
+/*
+ * Tries every signal of minBits to maxSigBits bits that fits in the first 8 bytes of the ID and keeps the ones that
+ * take exactly numStates distinct values. Values are at most 8 bits so the set of values seen is a 256 bit bitset
+ * and a candidate is dropped the moment it goes over the number of states. Signals whose top or bottom bit never
+ * changes are skipped, the narrower signal without that bit is the same match. Big endian layouts are only tried
+ * when they cross a byte, inside one byte they're the same bits as a little endian signal.
+ *
+ * Runs on a pool thread and only reads the job.
+ */
+DiscreteSearchResult DiscreteStateWindow::searchID(const DiscreteSearchJob &job)
+{
+    DiscreteSearchResult result;
+    result.ID = job.ID;
+    result.extended = job.extended;
+
+    int numFrames = job.lengths.count();
+    if (numFrames < 2) return result;
+
+    quint64 changedLittle = 0, changedBig = 0;
+    for (int i = 1; i < numFrames; i++)
+    {
+        changedLittle |= job.littleWords.at(i) ^ job.littleWords.at(0);
+        changedBig |= job.bigWords.at(i) ^ job.bigWords.at(0);
+    }
+
+    const quint8 *lengths = job.lengths.constData();
+    for (int bits = job.maxSigBits; bits >= job.minBits; bits--)
+    {
+        for (int endian = 0; endian < 2; endian++)
+        {
+            bool bigEndian = (endian == 1);
+            const quint64 *words = bigEndian ? job.bigWords.constData() : job.littleWords.constData();
+            quint64 changed = bigEndian ? changedBig : changedLittle;
+
+            for (int startBit = 0; startBit < job.maxBits; startBit++)
+            {
+                int firstByte = startBit / 8;
+                int lead = bigEndian ? (7 - (startBit % 8)) : (startBit % 8);
+                int lastByte = bigEndian ? (firstByte + (lead + bits - 1) / 8) : ((startBit + bits - 1) / 8);
+                if (lastByte * 8 >= job.maxBits) continue;
+                if (bigEndian && (lead + bits) <= 8) continue;
+
+                int shiftUp = bigEndian ? (firstByte * 8 + lead) : (64 - startBit - bits);
+                int shiftDown = 64 - bits;
+                quint64 topBit = 1ULL << (63 - shiftUp);
+                quint64 bottomBit = 1ULL << (64 - shiftUp - bits);
+                if (!(changed & topBit) || !(changed & bottomBit)) continue;
+
+                DiscreteMatch match;
+                match.startBit = startBit;
+                match.bits = bits;
+                match.bigEndian = bigEndian;
+                match.transitions = 0;
+                for (int k = 0; k < 4; k++) match.values[k] = 0;
+
+                int needed = lastByte + 1;
+                int distinct = 0;
+                int prev = -1;
+                bool tooMany = false;
+                for (int i = 0; i < numFrames; i++)
                 {
-                    QList<int> values;
+                    int val = (lengths[i] >= needed) ? static_cast<int>((words[i] << shiftUp) >> shiftDown) : 0;
+                    quint64 &slot = match.values[val >> 6];
+                    quint64 bit = 1ULL << (val & 63);
+                    if (!(slot & bit))
+                    {
+                        slot |= bit;
+                        if (++distinct > job.numStates)
+                        {
+                            tooMany = true;
+                            break;
+                        }
+                    }
+                    if (i > 0 && val != prev) match.transitions++;
+                    prev = val;
                 }
+                if (tooMany || distinct != job.numStates) continue;
+                result.matches.append(match);
+            }
+        }
+    }
+
+    //a state someone toggled by hand changes rarely, noise and counters change all the time. Fewest changes first,
+    //ties keep the widest signal first
+    std::stable_sort(result.matches.begin(), result.matches.end(),
+                     [](const DiscreteMatch &a, const DiscreteMatch &b) { return a.transitions < b.transitions; });
+    return result;
+}
+
+void DiscreteStateWindow::searchResultsReady(int begin, int end)
+{
+    for (int i = begin; i < end; i++)
+    {
+        DiscreteSearchResult result = searchWatcher->resultAt(i);
+        if (result.matches.isEmpty()) continue;
+
+        QTreeWidgetItem *idItem = new QTreeWidgetItem();
+        idItem->setText(0, Utility::formatCANID(result.ID, result.extended) + " (" + QString::number(result.matches.count())
+                        + tr(" candidates)"));
+        for (const DiscreteMatch &match : result.matches)
+        {
+            QStringList values;
+            for (int v = 0; v < 256; v++)
+            {
+                if (match.values[v >> 6] & (1ULL << (v & 63))) values.append(QString::number(v));
             }
+            QTreeWidgetItem *item = new QTreeWidgetItem(idItem);
+            item->setText(0, tr("Start bit: ") + QString::number(match.startBit) + tr("  Bits: ") + QString::number(match.bits)
+                          + (match.bigEndian ? tr("  Big Endian") : tr("  Little Endian"))
+                          + tr("  Values: ") + values.join(", ")
+                          + tr("  Changes: ") + QString::number(match.transitions));
         }
+        ui->treeMatches->addTopLevelItem(idItem);
     }
 }
+
+void DiscreteStateWindow::searchFinished()
+{
+    searchProgress->finish();
+    ui->treeMatches->sortItems(0, Qt::AscendingOrder);
+}
@@ -2,8 +2,40 @@
 #define DISCRETESTATEWINDOW_H
 
 #include <QDialog>
+#include <QFutureWatcher>
 #include <QTimer>
 #include "can_structs.h"
+#include "poolprogress.h"
+
+
+//frames of one ID packed for the state search, same idea as the range state search
+struct DiscreteSearchJob
+{
+    uint32_t ID;
+    bool extended;
+    int maxBits; //bits in the longest payload, capped to the first 8 bytes
+    QVector<quint64> littleWords; //first 8 payload bytes of each frame as a little endian word
+    QVector<quint64> bigWords; //and as a big endian word
+    QVector<quint8> lengths;
+    int minBits, maxSigBits;
+    int numStates;
+};
+
+struct DiscreteMatch
+{
+    int startBit;
+    int bits;
+    bool bigEndian;
+    int transitions; //frames whose value differed from the frame before
+    quint64 values[4]; //bitset of the values seen, signals are at most 8 bits
+};
+
+struct DiscreteSearchResult
+{
+    uint32_t ID;
+    bool extended;
+    QVector<DiscreteMatch> matches; //best first
+};
 
 namespace Ui {
 class DiscreteStateWindow;
@@ -35,6 +67,8 @@ private slots:
     void handleStartButton();
     void handleTick();
     void typeChanged();
+    void searchResultsReady(int begin, int end);
+    void searchFinished();
 
 private:
     Ui::DiscreteStateWindow *ui;
@@ -50,6 +84,8 @@ private:
     int currIteration;
     bool isRealtime;
     QHash<int, bool> idFilters;
+    QFutureWatcher<DiscreteSearchResult> *searchWatcher;
+    PoolProgress *searchProgress;
 
     void refreshFilterList();
     void closeEvent(QCloseEvent *event);
@@ -58,6 +94,7 @@ private:
     void writeSettings();
     void updateStateLabel();
     void calculateResults();
+    static DiscreteSearchResult searchID(const DiscreteSearchJob &job);
 };
 
 #endif // DISCRETESTATEWINDOW_H
@@ -1,9 +1,11 @@
 #include "filecomparatorwindow.h"
 #include "ui_filecomparatorwindow.h"
 #include "helpwindow.h"
-#include <QProgressDialog>
 #include <QSettings>
+#include <QtConcurrent/QtConcurrentMap>
 #include <qevent.h>
+#include <algorithm>
+#include <string.h>
 
 FileComparatorWindow::FileComparatorWindow(QWidget *parent) :
     QDialog(parent),
@@ -22,11 +24,17 @@ FileComparatorWindow::FileComparatorWindow(QWidget *parent) :
 
     dbcHandler = DBCHandler::getReference();
 
+    compareWatcher = new QFutureWatcher<CompareResult>(this);
+    compareProgress = new PoolProgress(this, compareWatcher, tr("Calculating differences"));
+    connect(compareWatcher, &QFutureWatcher<CompareResult>::finished, this, &FileComparatorWindow::comparisonFinished);
+
     installEventFilter(this);
 }
 
 FileComparatorWindow::~FileComparatorWindow()
 {
+    compareProgress->stop();
+    delete compareProgress;
     removeEventFilter(this);
     delete ui;
 }
@@ -83,6 +91,7 @@ void FileComparatorWindow::writeSettings()
 
 void FileComparatorWindow::loadInterestedFile()
 {
+    stopComparison();
     interestedFrames.clear();
     QString resultingFileName;
 
@@ -102,6 +111,8 @@ void FileComparatorWindow::loadReferenceFile()
     //secondFileFrames.clear();
     QString resultingFileName;
 
+    stopComparison();
+
     qApp->processEvents();
 
     if (FrameFileIO::loadFrameFile(resultingFileName, &referenceFrames))
@@ -113,400 +124,330 @@ void FileComparatorWindow::loadReferenceFile()
 
 void FileComparatorWindow::clearReference()
 {
+    stopComparison();
     referenceFrames.clear();
     ui->treeDetails->clear();
     ui->lblRefFrames->setText("Loaded frames: " + QString::number(referenceFrames.length()));
 }
 
-void FileComparatorWindow::calculateDetails()
+FrameData::FrameData()
 {
-    QMap<uint32_t, FrameData> interestedIDs;
-    QMap<uint32_t, FrameData> referenceIDs;
-    QTreeWidgetItem *interestedOnlyBase, *referenceOnlyBase = nullptr, *sharedBase, *bitmapBaseInterested, *bitmapBaseReference = nullptr;
-    QTreeWidgetItem *valuesBase, *detail, *sharedItem, *valuesInterested, *valuesReference = nullptr;
-    uint64_t tmp;
-    const unsigned char *data;
-    int dataLen;
-
-    bool uniqueInterested = ui->ckUniqueToInterested->isChecked();
-
-    QProgressDialog progress(this);
-    progress.setWindowModality(Qt::WindowModal);
-    progress.setLabelText("Calculating differences");
-    progress.setCancelButton(nullptr);
-    progress.setRange(0,0);
-    progress.setMinimumDuration(0);
-    progress.show();
+    dataLen = 0;
+    memset(bitmap, 0, sizeof(bitmap));
+}
 
-    qApp->processEvents();
+void FileComparatorWindow::stopComparison()
+{
+    compareProgress->stop();
+}
 
+/*
+ * Sorts the frame indexes of both captures by ID in one pass each, then every ID gets compared on its own pool
+ * thread. The report is built once all of them are done.
+ */
+void FileComparatorWindow::calculateDetails()
+{
+    stopComparison();
     ui->treeDetails->clear();
 
-    interestedOnlyBase = new QTreeWidgetItem();
-    interestedOnlyBase->setText(0,"IDs found only in " + interestedFilename);
-    if (!uniqueInterested)
-    {
-        referenceOnlyBase = new QTreeWidgetItem();
-        referenceOnlyBase->setText(0, "IDs found only in Side 2 - Reference frames");
-    }
-    sharedBase = new QTreeWidgetItem();
-    sharedBase->setText(0,"IDs found on both sides");
+    compareSnapshot = dbcHandler->getSnapshot();
 
-    //first we have to fill out the data structures to get ready to do the report
-    for (int x = 0; x < interestedFrames.count(); x++)
+    QHash<uint32_t, int> jobIdx;
+    QVector<CompareJob> jobs;
+    for (int side = 0; side < 2; side++)
     {
-        CANFrame frame = interestedFrames.at(x);
-        DBC_MESSAGE *msg = dbcHandler->findMessage(frame.frameId());
-        data = reinterpret_cast<const unsigned char *>(frame.payload().constData());
-        dataLen = frame.payload().count();
-
-        if (interestedIDs.contains(frame.frameId())) //if we saw this ID before then add to the QList in there
+        const QVector<CANFrame> &frames = (side == 0) ? interestedFrames : referenceFrames;
+        for (int x = 0; x < frames.count(); x++)
         {
-            for (int y = 0; y < dataLen; y++)
+            uint32_t id = frames.at(x).frameId();
+            auto it = jobIdx.constFind(id);
+            if (it == jobIdx.constEnd())
             {
-                interestedIDs[frame.frameId()].values[y][data[y]]++;
-                tmp = data[y];
-                tmp = tmp << (8 * y);
-                interestedIDs[frame.frameId()].bitmap |= tmp;
-                //qDebug() << "bitmap: " << QString::number(interestedIDs[frame.frameId()].bitmap, 16);
-            }            
-            if (msg)
-            {
-                int numSignals = msg->sigHandler->getCount();
-                for (int i = 0; i < numSignals; i++)
-                {
-                    DBC_SIGNAL *sig = msg->sigHandler->findSignalByIdx(i);
-                    if (sig)
-                    {
-                        if (sig->isSignalInMessage(frame))
-                        {
-                            QString sigVal;
-                            if (sig->processAsText(frame, sigVal, false))
-                            {
-                                QList<QString> tempList = interestedIDs[frame.frameId()].signalInstances[sig->name];
-                                if (!tempList.contains(sigVal)) tempList.append(sigVal);
-                                interestedIDs[frame.frameId()].signalInstances[sig->name] = tempList;
-                            }
-                        }
-                    }
-                }
-                qApp->processEvents();
+                CompareJob job;
+                job.ID = id;
+                job.interestedFrames = &interestedFrames;
+                job.referenceFrames = &referenceFrames;
+                job.snapshot = compareSnapshot;
+                it = jobIdx.insert(id, jobs.count());
+                jobs.append(job);
             }
+            if (side == 0) jobs[it.value()].interestedIdx.append(x);
+            else jobs[it.value()].referenceIdx.append(x);
         }
-        else //never seen this ID before so add one
-        {
-            FrameData *newData = new FrameData();
-            newData->ID = frame.frameId();
-            newData->dataLen = dataLen;
-            //it would be possible to implement a constructor for FrameData
-            //that sets the bitmap and values to zero. That would be cleaner and better.
-            newData->bitmap = 0;
-            for (int x = 0; x < 8; x++)
-            {
-                for (int y = 0; y < 256; y++)
-                {
-                    newData->values[x][y] = 0;
-                }
-            }
-            //memset(newData->values, 0, 256 * 8);
-            for (int y = 0; y < dataLen; y++)
-            {
-                newData->values[y][data[y]] = 1;
-                tmp = data[y];
-                tmp = tmp << (8 * y);
-                newData->bitmap |= tmp;
-                //qDebug() << "bitmap: " << QString::number(newData->bitmap, 16);
-            }
-            if (msg)
-            {
-                int numSignals = msg->sigHandler->getCount();
-                for (int i = 0; i < numSignals; i++)
-                {
-                    DBC_SIGNAL *sig = msg->sigHandler->findSignalByIdx(i);
-                    if (sig)
-                    {
-                        if (sig->isSignalInMessage(frame))
-                        {
-                            QString sigVal;
-                            if (sig->processAsText(frame, sigVal, false))
-                            {
-                                QList<QString> tempList;
-                                tempList.append(sigVal);
-                                newData->signalInstances[sig->name] = tempList;
-                            }
-                        }
-                    }
-                }
-            }
+    }
 
-            interestedIDs.insert(frame.frameId(), *newData);
-        }
+    compareProgress->start(jobs.count());
+
+    compareWatcher->setFuture(QtConcurrent::mapped(jobs, &FileComparatorWindow::compareID));
+}
+
+//runs on a pool thread. Only reads the frames and the snapshot
+CompareResult FileComparatorWindow::compareID(const CompareJob &job)
+{
+    CompareResult result;
+    result.ID = job.ID;
+    result.inInterested = !job.interestedIdx.isEmpty();
+    result.inReference = !job.referenceIdx.isEmpty();
+    result.msg = job.snapshot->findMessage(job.ID);
+
+    //an ID only one side had is just listed by name, nothing to compare
+    if (result.inInterested && result.inReference)
+    {
+        scanFrames(job.interestedFrames, job.interestedIdx, result.msg, result.interested);
+        scanFrames(job.referenceFrames, job.referenceIdx, result.msg, result.reference);
     }
+    return result;
+}
 
-    qApp->processEvents();
+void FileComparatorWindow::scanFrames(const QVector<CANFrame> *frames, const QVector<int> &idx, const DBCSnapshot::Message *msg, FrameData &out)
+{
+    if (msg) out.signalInstances.resize(msg->sigs.count());
+    for (SignalValueSet &set : out.signalInstances)
+    {
+        set.frames = 0;
+        set.lastRaw = 0;
+    }
 
-    for (int x = 0; x < referenceFrames.count(); x++)
+    for (int x = 0; x < idx.count(); x++)
     {
-        CANFrame frame = referenceFrames.at(x);
-        DBC_MESSAGE *msg = dbcHandler->findMessage(frame.frameId());
-        data = reinterpret_cast<const unsigned char *>(frame.payload().constData());
-        dataLen = frame.payload().count();
+        const CANFrame &frame = frames->at(idx.at(x));
+        const QByteArray payload = frame.payload();
+        const unsigned char *data = reinterpret_cast<const unsigned char *>(payload.constData());
+        int dataLen = qMin(payload.length(), 64);
 
-        if (referenceIDs.contains(frame.frameId())) //if we saw this ID before then add to the QList in there
+        if (dataLen > out.dataLen)
         {
-            for (int y = 0; y < dataLen; y++)
-            {
-                referenceIDs[frame.frameId()].values[y][data[y]]++;
-                tmp = data[y];
-                tmp = tmp << (8 * y);
-                referenceIDs[frame.frameId()].bitmap |= tmp;
-                //qDebug() << "bitmap: " << QString::number(referenceIDs[frame.frameId()].bitmap, 16);
-            }
-            if (msg)
-            {
-                int numSignals = msg->sigHandler->getCount();
-                for (int i = 0; i < numSignals; i++)
-                {
-                    DBC_SIGNAL *sig = msg->sigHandler->findSignalByIdx(i);
-                    if (sig)
-                    {
-                        if (sig->isSignalInMessage(frame))
-                        {
-                            QString sigVal;
-                            if (sig->processAsText(frame, sigVal, false))
-                            {
-                                QList<QString> tempList = referenceIDs[frame.frameId()].signalInstances[sig->name];
-                                if (!tempList.contains(sigVal)) tempList.append(sigVal);
-                                referenceIDs[frame.frameId()].signalInstances[sig->name] = tempList;
-                            }
-                        }
-                    }
-                }
-            }
+            out.dataLen = dataLen;
+            out.values.resize(dataLen * 256);
         }
-        else //never seen this ID before so add one
+        int *values = out.values.data();
+        for (int y = 0; y < dataLen; y++)
         {
-            FrameData *newData = new FrameData();
-            newData->ID = frame.frameId();
-            newData->dataLen = dataLen;
-            newData->bitmap = 0;
-            for (int x = 0; x < 8; x++)
-            {
-                for (int y = 0; y < 256; y++)
-                {
-                    newData->values[x][y] = 0;
-                }
-            }
-            //memset(newData->values, 0, 256 * 8);
-            for (int y = 0; y < dataLen; y++)
-            {
-                newData->values[y][data[y]] = 1;
-                tmp = data[y];
-                tmp = tmp << (8 * y);
-                newData->bitmap |= tmp;
-                //qDebug() << "bitmap: " << QString::number(newData->bitmap, 16);
-            }
-            if (msg)
+            values[y * 256 + data[y]]++;
+            out.bitmap[y] |= data[y];
+        }
+
+        if (!msg) continue;
+        for (int i = 0; i < msg->sigs.count(); i++)
+        {
+            const DBCSnapshot::Signal &sig = msg->sigs[i];
+            if (!sig.isInFrame(frame)) continue;
+            SignalValueSet &set = out.signalInstances[i];
+            if (sig.valType == STRING)
             {
-                int numSignals = msg->sigHandler->getCount();
-                for (int i = 0; i < numSignals; i++)
+                QString sigVal;
+                if (sig.decodeAsText(frame, sigVal, false))
                 {
-                    DBC_SIGNAL *sig = msg->sigHandler->findSignalByIdx(i);
-                    if (sig)
-                    {
-                        if (sig->isSignalInMessage(frame))
-                        {
-                            QString sigVal;
-                            if (sig->processAsText(frame, sigVal, false))
-                            {
-                                QList<QString> tempList;
-                                tempList.append(sigVal);
-                                newData->signalInstances[sig->name] = tempList;
-                            }
-                        }
-                    }
+                    set.text.insert(sigVal);
+                    set.frames++;
                 }
+                continue;
             }
-            referenceIDs.insert(frame.frameId(), *newData);
+            int64_t raw;
+            if (!sig.decodeTextRaw(frame, raw)) continue;
+            //signals mostly hold their value from one frame to the next, only a change needs the set
+            if (set.frames == 0 || raw != set.lastRaw) set.raw.insert(raw);
+            set.lastRaw = raw;
+            set.frames++;
         }
     }
+}
 
-    qApp->processEvents();
+//text of every distinct value, lowest raw value first. Different raw values can read the same once formatted
+QStringList FileComparatorWindow::signalTexts(const DBCSnapshot::Signal &sig, const SignalValueSet &set)
+{
+    QStringList texts;
+    QSet<QString> seen;
+    QVector<qint64> raws;
+    raws.reserve(set.raw.count());
+    for (qint64 raw : set.raw) raws.append(raw);
+    std::sort(raws.begin(), raws.end());
+    for (qint64 raw : raws)
+    {
+        QString str = sig.formatText(raw, false);
+        if (seen.contains(str)) continue;
+        seen.insert(str);
+        texts.append(str);
+    }
+    QStringList strings = set.text.values();
+    strings.sort();
+    texts.append(strings);
+    return texts;
+}
+
+QString FileComparatorWindow::describeID(const CompareResult &result)
+{
+    if (result.msg) return Utility::formatHexNum(result.ID) + " (" + result.msg->name + ")";
+    return Utility::formatHexNum(result.ID);
+}
+
+void FileComparatorWindow::comparisonFinished()
+{
+    compareProgress->finish();
+    if (compareWatcher->isCanceled()) return;
+
+    QTreeWidgetItem *interestedOnlyBase, *referenceOnlyBase = nullptr, *sharedBase, *bitmapBaseInterested, *bitmapBaseReference = nullptr;
+    QTreeWidgetItem *valuesBase, *detail, *sharedItem, *valuesInterested, *valuesReference = nullptr;
+
+    bool uniqueInterested = ui->ckUniqueToInterested->isChecked();
+
+    interestedOnlyBase = new QTreeWidgetItem();
+    interestedOnlyBase->setText(0,"IDs found only in " + interestedFilename);
+    if (!uniqueInterested)
+    {
+        referenceOnlyBase = new QTreeWidgetItem();
+        referenceOnlyBase->setText(0, "IDs found only in Side 2 - Reference frames");
+    }
+    sharedBase = new QTreeWidgetItem();
+    sharedBase->setText(0,"IDs found on both sides");
+
+    QList<CompareResult> results = compareWatcher->future().results();
+    std::sort(results.begin(), results.end(), [](const CompareResult &a, const CompareResult &b) { return a.ID < b.ID; });
 
     //now we iterate through the IDs within both files and see which are unique to one file and which
     //are shared
-    bool interestedHadUnique = false;
-    QMap<uint32_t, FrameData>::iterator i;
-    int framesCounter = 0;
-    for (i = interestedIDs.begin(); i != interestedIDs.end(); ++i)
+    for (const CompareResult &result : results)
     {
-        framesCounter++;
-        if (framesCounter > 50)
+        if (!result.inReference)
         {
-            framesCounter = 0;
-            qApp->processEvents();
+            valuesBase = new QTreeWidgetItem();
+            valuesBase->setText(0, describeID(result));
+            interestedOnlyBase->addChild(valuesBase);
+            continue;
         }
-
-        uint32_t keyone = i.key();
-        if (!referenceIDs.contains(keyone))
+        if (!result.inInterested)
         {
+            if (uniqueInterested) continue;
             valuesBase = new QTreeWidgetItem();
-            DBC_MESSAGE *msg = dbcHandler->findMessage(keyone);
-            if (msg)
-            {
-                valuesBase->setText(0, Utility::formatHexNum(keyone) + " (" + msg->name + ")");
-            }
-            else valuesBase->setText(0, Utility::formatHexNum(keyone));
-            interestedOnlyBase->addChild(valuesBase);
+            valuesBase->setText(0, describeID(result));
+            referenceOnlyBase->addChild(valuesBase);
+            continue;
+        }
+
+        //ID was in both files
+        bool interestedHadUnique = false;
+        sharedItem = new QTreeWidgetItem();
+        sharedItem->setText(0, describeID(result));
+        //if the ID was in both files then we can use the data accumulated in bitmap
+        //and values to figure out what has changed between the two files
+
+        const FrameData &interested = result.interested;
+        const FrameData &reference = result.reference;
+        int numBytes = qMax(interested.dataLen, reference.dataLen);
+
+        bitmapBaseInterested = new QTreeWidgetItem();
+        bitmapBaseInterested->setText(0, "Bits set only in " + interestedFilename);
+        if (!uniqueInterested)
+        {
+            bitmapBaseReference = new QTreeWidgetItem();
+            bitmapBaseReference->setText(0, "Bits set only in Side 2 - Reference frames");
         }
-        else //ID was in both files
+        sharedItem->addChild(bitmapBaseInterested);
+        if (!uniqueInterested) sharedItem->addChild(bitmapBaseReference);
+
+        //first up, which bits were set in one file but not the other
+        for (int b = 0; b < (8 * numBytes); b++)
         {
-            interestedHadUnique = false;
-            sharedItem = new QTreeWidgetItem();
-            DBC_MESSAGE *msg = dbcHandler->findMessage(keyone);
-            if (msg)
+            bool interestedBit = interested.bitmap[b / 8] & (1 << (b % 8));
+            bool referenceBit = reference.bitmap[b / 8] & (1 << (b % 8));
+            if (interestedBit == referenceBit) continue;
+            if (!interestedBit && uniqueInterested) continue;
+            detail = new QTreeWidgetItem();
+            detail->setText(0, QString::number(b) + " (" + QString::number(b / 8) + ":" + QString::number(b % 8) + ")");
+            if (interestedBit)
             {
-                sharedItem->setText(0, Utility::formatHexNum(keyone) + " (" + msg->name + ")");
+                bitmapBaseInterested->addChild(detail);
+                interestedHadUnique = true;
             }
-            else sharedItem->setText(0, Utility::formatHexNum(keyone));
-            //if the ID was in both files then we can use the data accumulated above in bitmap
-            //and values to figure out what has changed between the two files
-
-            FrameData interested = interestedIDs[keyone];
-            FrameData reference = referenceIDs[keyone];
+            else bitmapBaseReference->addChild(detail);
+        }
 
-            bitmapBaseInterested = new QTreeWidgetItem();
-            bitmapBaseInterested->setText(0, "Bits set only in " + interestedFilename);
+        for (int i = 0; i < numBytes; i++)
+        {
+            valuesBase = new QTreeWidgetItem();
+            valuesBase->setText(0, "Byte " + QString::number(i));
+            sharedItem->addChild(valuesBase);
+            valuesInterested = new QTreeWidgetItem();
+            valuesInterested->setText(0, "Values found only in " + interestedFilename);
             if (!uniqueInterested)
             {
-                bitmapBaseReference = new QTreeWidgetItem();
-                bitmapBaseReference->setText(0, "Bits set only in Side 2 - Reference frames");
+                valuesReference = new QTreeWidgetItem();
+                valuesReference->setText(0, "Values found only in Side 2 - Reference frames");
             }
-            sharedItem->addChild(bitmapBaseInterested);
-            if (!uniqueInterested) sharedItem->addChild(bitmapBaseReference);
+            valuesBase->addChild(valuesInterested);
+            if (!uniqueInterested) valuesBase->addChild(valuesReference);
 
-            uint64_t interestedBits = interested.bitmap;
-            uint64_t referenceBits = reference.bitmap;
-
-            //first up, which bits were set in one file but not the other
-            for (int b = 0; b < (8 * interested.dataLen); b++)
+            //a byte past the end of one side's payloads never had any value there
+            const int *interestedValues = (i < interested.dataLen) ? interested.values.constData() + i * 256 : nullptr;
+            const int *referenceValues = (i < reference.dataLen) ? reference.values.constData() + i * 256 : nullptr;
+            for (int j = 0; j < 256; j++)
             {
-                detail = new QTreeWidgetItem();
-                detail->setText(0, QString::number(b) + " (" + QString::number(b / 8) + ":" + QString::number(b % 8) + ")");
-                if ( (interestedBits & 1) && !(referenceBits & 1) )
+                bool inInterested = interestedValues && interestedValues[j] > 0;
+                bool inReference = referenceValues && referenceValues[j] > 0;
+                if (inInterested == inReference) continue;
+                if (inInterested)
                 {
-                    bitmapBaseInterested->addChild(detail);
+                    detail = new QTreeWidgetItem();
+                    detail->setText(0, Utility::formatHexNum(static_cast<unsigned int>(j)));
+                    valuesInterested->addChild(detail);
                     interestedHadUnique = true;
                 }
-                else if ( !(interestedBits & 1) && (referenceBits & 1) )
-                {
-                    if (!uniqueInterested) bitmapBaseReference->addChild(detail);
-                }
-                //qDebug() << b << "  " << QString::number(interestedBits, 16) << "  " << QString::number(referenceBits, 16);
-                interestedBits = interestedBits >> 1;
-                referenceBits = referenceBits >> 1;
-            }
-
-            for (int i = 0; i < qMax(interested.dataLen, reference.dataLen); i++)
-            {
-                valuesBase = new QTreeWidgetItem();
-                valuesBase->setText(0, "Byte " + QString::number(i));
-                sharedItem->addChild(valuesBase);
-                valuesInterested = new QTreeWidgetItem();
-                valuesInterested->setText(0, "Values found only in " + interestedFilename);
-                if (!uniqueInterested)
-                {
-                    valuesReference = new QTreeWidgetItem();
-                    valuesReference->setText(0, "Values found only in Side 2 - Reference frames");
-                }
-                valuesBase->addChild(valuesInterested);
-                if (!uniqueInterested) valuesBase->addChild(valuesReference);
-                for (int j = 0; j < 256; j++)
+                else if (!uniqueInterested)
                 {
                     detail = new QTreeWidgetItem();
                     detail->setText(0, Utility::formatHexNum(static_cast<unsigned int>(j)));
-                    if ((interested.values[i][j] > 0) && (reference.values[i][j] == 0) )
-                    {
-                        valuesInterested->addChild(detail);
-                        interestedHadUnique = true;
-                    }
-                    if ((reference.values[i][j] > 0) && (interested.values[i][j] == 0) )
-                    {
-                        if (!uniqueInterested) valuesReference->addChild(detail);
-                    }
+                    valuesReference->addChild(detail);
                 }
             }
+        }
 
-            //presumably both include the same signals so for this first attempt just
-            //take all signals from the reference and then find that same signal in
-            //the interested frames and then see what unique values there were in either one
+        //both sides decoded with the same message so the signal lists line up. Like before, every signal the
+        //reference frames had is shown with the values that only one side saw
+        for (int s = 0; s < reference.signalInstances.count(); s++)
+        {
+            const SignalValueSet &refSet = reference.signalInstances[s];
+            if (refSet.frames == 0) continue;
+            const DBCSnapshot::Signal &sig = result.msg->sigs[s];
 
-            QHash<QString, QList<QString>>::const_iterator it = reference.signalInstances.constBegin();
-            while (it != reference.signalInstances.constEnd())
+            valuesBase = new QTreeWidgetItem();
+            valuesBase->setText(0, "Signal " + sig.name);
+            sharedItem->addChild(valuesBase);
+            valuesInterested = new QTreeWidgetItem();
+            valuesInterested->setText(0, "Values found only in " + interestedFilename);
+            if (!uniqueInterested)
             {
-                valuesBase = new QTreeWidgetItem();
-                valuesBase->setText(0, "Signal " + it.key());
-                sharedItem->addChild(valuesBase);
-                valuesInterested = new QTreeWidgetItem();
-                valuesInterested->setText(0, "Values found only in " + interestedFilename);
-                if (!uniqueInterested)
-                {
-                    valuesReference = new QTreeWidgetItem();
-                    valuesReference->setText(0, "Values found only in Side 2 - Reference frames");
-                }
-                valuesBase->addChild(valuesInterested);
-                if (!uniqueInterested) valuesBase->addChild(valuesReference);
-
-                QList<QString> refVals = it.value();
-                QList<QString> interestedVals = interested.signalInstances[it.key()];
-                foreach (QString str, refVals)
-                {
-                    if (!interestedVals.contains(str))
-                    {
-                        qDebug() << "Interested frames didn't contain value: " << str << " in signal " << it.key();
-                        detail = new QTreeWidgetItem();
-                        detail->setText(0, str);
-                        valuesReference->addChild(detail);
-                    }
-                }
-                qApp->processEvents();
-                foreach (QString str, interestedVals)
-                {
-                    if (!refVals.contains(str))
-                    {
-                        qDebug() << "Reference frames didn't contain value: " << str << " in signal " << it.key();
-                        detail = new QTreeWidgetItem();
-                        detail->setText(0, str);
-                        valuesInterested->addChild(detail);
-                    }
-                }
-                ++it;
+                valuesReference = new QTreeWidgetItem();
+                valuesReference->setText(0, "Values found only in Side 2 - Reference frames");
             }
-
-            if (interestedHadUnique || !uniqueInterested) sharedBase->addChild(sharedItem);
-        }
-    }
-
-    qApp->processEvents();
-
-    if (!uniqueInterested)
-    {
-        QMap<uint32_t, FrameData>::iterator itwo;
-        for (itwo = referenceIDs.begin(); itwo != referenceIDs.end(); ++itwo)
-        {
-            unsigned int keytwo = itwo.key();
-            if (!interestedIDs.contains(keytwo))
+            valuesBase->addChild(valuesInterested);
+            if (!uniqueInterested) valuesBase->addChild(valuesReference);
+
+            QStringList refVals = signalTexts(sig, refSet);
+            QStringList interestedVals = signalTexts(sig, interested.signalInstances[s]);
+            QSet<QString> refSeen, interestedSeen;
+            for (const QString &str : refVals) refSeen.insert(str);
+            for (const QString &str : interestedVals) interestedSeen.insert(str);
+            if (!uniqueInterested)
             {
-                valuesBase = new QTreeWidgetItem();
-                DBC_MESSAGE *msg = dbcHandler->findMessage(keytwo);
-                if (msg)
+                for (const QString &str : refVals)
                 {
-                    valuesBase->setText(0, Utility::formatHexNum(keytwo) + " (" + msg->name + ")" );
+                    if (interestedSeen.contains(str)) continue;
+                    detail = new QTreeWidgetItem();
+                    detail->setText(0, str);
+                    valuesReference->addChild(detail);
                 }
-                else valuesBase->setText(0, Utility::formatHexNum(keytwo));
-                referenceOnlyBase->addChild(valuesBase);
+            }
+            for (const QString &str : interestedVals)
+            {
+                if (refSeen.contains(str)) continue;
+                detail = new QTreeWidgetItem();
+                detail->setText(0, str);
+                valuesInterested->addChild(detail);
             }
         }
+
+        if (interestedHadUnique || !uniqueInterested) sharedBase->addChild(sharedItem);
+        else delete sharedItem;
     }
 
     ui->treeDetails->addTopLevelItem(interestedOnlyBase);
@@ -521,8 +462,6 @@ void FileComparatorWindow::calculateDetails()
     {
         ui->treeDetails->expandAll();
     }
-
-    progress.cancel();
 }
 
 void FileComparatorWindow::saveDetails()
@@ -3,23 +3,61 @@
 
 #include <QDialog>
 #include <QDebug>
+#include <QFutureWatcher>
+#include <QSet>
+#include <QSharedPointer>
 #include <QTreeWidget>
 #include "framefileio.h"
 #include "can_structs.h"
 #include "utility.h"
 #include "dbc/dbchandler.h"
+#include "dbc/dbcsnapshot.h"
+#include "poolprogress.h"
+
 
 namespace Ui {
 class FileComparatorWindow;
 }
 
+//distinct values one DBC signal took, kept as the raw numbers and only turned into text for the report
+struct SignalValueSet
+{
+    int frames; //frames the signal was in, 0 if it never showed up
+    int64_t lastRaw;
+    QSet<qint64> raw;
+    QSet<QString> text; //STRING signals have no raw number
+};
+
+//what one capture had for an ID
 struct FrameData
+{
+    FrameData();
+
+    int dataLen; //longest payload
+    uint8_t bitmap[64]; //bits set at least once, per byte
+    QVector<int> values; //# of times each byte had each value. Index is byte * 256 + value
+    QVector<SignalValueSet> signalInstances; //one per signal of the message, in DBC order
+};
+
+//where the frames of one ID are in both captures, the unit of work for the comparison
+struct CompareJob
+{
+    uint32_t ID;
+    const QVector<CANFrame> *interestedFrames;
+    const QVector<CANFrame> *referenceFrames;
+    QVector<int> interestedIdx;
+    QVector<int> referenceIdx;
+    QSharedPointer<const DBCSnapshot> snapshot;
+};
+
+struct CompareResult
 {
     uint32_t ID;
-    int dataLen;
-    uint64_t bitmap;
-    int values[8][256]; //first index is the data byte, second is # of times we saw that value
-    QHash<QString, QList<QString>> signalInstances;
+    bool inInterested;
+    bool inReference;
+    const DBCSnapshot::Message *msg;
+    FrameData interested;
+    FrameData reference;
 };
 
 class FileComparatorWindow : public QDialog
@@ -35,6 +73,7 @@ private slots:
     void loadReferenceFile();
     void clearReference();
     void saveDetails();
+    void comparisonFinished();
 
 private:
     Ui::FileComparatorWindow *ui;
@@ -42,8 +81,16 @@ private:
     QVector<CANFrame> referenceFrames;
     QString interestedFilename;
     DBCHandler *dbcHandler;
+    QSharedPointer<const DBCSnapshot> compareSnapshot; //the results point into it
+    QFutureWatcher<CompareResult> *compareWatcher;
+    PoolProgress *compareProgress;
 
     void calculateDetails();
+    void stopComparison();
+    static CompareResult compareID(const CompareJob &job);
+    static void scanFrames(const QVector<CANFrame> *frames, const QVector<int> &idx, const DBCSnapshot::Message *msg, FrameData &out);
+    static QStringList signalTexts(const DBCSnapshot::Signal &sig, const SignalValueSet &set);
+    static QString describeID(const CompareResult &result);
     void showEvent(QShowEvent *);
     void closeEvent(QCloseEvent *event);
     bool eventFilter(QObject *obj, QEvent *event);
@@ -0,0 +1,249 @@
+#include "flowtransitionindex.h"
+
+#include <QThread>
+#include <QtAlgorithms>
+#include <QtConcurrent/QtConcurrentMap>
+#include <QtEndian>
+#include <algorithm>
+#include <string.h>
+
+//a slice of the frame list looked at by one pool thread
+struct FlowIndexSlice
+{
+    const QVector<CANFrame> *frames;
+    uint32_t ID;
+    int first, last;
+    QVector<int> found; //frame list positions of the ID, in order
+    int maxLen;
+
+    //filled in for the packing pass, positions within the index
+    const int *modelIdx;
+    int words;
+    qint64 *stamps;
+    quint8 *lengths;
+    quint64 *data;
+};
+
+static const int minSliceFrames = 65536;
+
+static int packPayload(const CANFrame &frame, int words, quint64 *dest)
+{
+    const QByteArray payload = frame.payload();
+    int len = qMin(payload.length(), 64);
+    unsigned char bytes[64];
+    memset(bytes, 0, sizeof(bytes));
+    memcpy(bytes, payload.constData(), len);
+    for (int w = 0; w < words; w++) dest[w] = qFromLittleEndian<quint64>(bytes + w * 8);
+    return len;
+}
+
+static void findFrames(FlowIndexSlice &slice)
+{
+    slice.maxLen = 0;
+    for (int i = slice.first; i < slice.last; i++)
+    {
+        const CANFrame &frame = slice.frames->at(i);
+        if (frame.frameId() != slice.ID) continue;
+        slice.found.append(i);
+        int len = frame.payload().length();
+        if (len > slice.maxLen) slice.maxLen = len;
+    }
+}
+
+static void packFrames(FlowIndexSlice &slice)
+{
+    for (int pos = slice.first; pos < slice.last; pos++)
+    {
+        const CANFrame &frame = slice.frames->at(slice.modelIdx[pos]);
+        slice.stamps[pos] = frame.timeStamp().microSeconds();
+        slice.lengths[pos] = static_cast<quint8>(packPayload(frame, slice.words, slice.data + static_cast<qint64>(pos) * slice.words));
+    }
+}
+
+static QVector<FlowIndexSlice> makeSlices(const QVector<CANFrame> *frames, uint32_t ID, int count)
+{
+    int numSlices = qBound(1, count / minSliceFrames, qMax(1, QThread::idealThreadCount()));
+    QVector<FlowIndexSlice> slices(numSlices);
+    for (int s = 0; s < numSlices; s++)
+    {
+        slices[s].frames = frames;
+        slices[s].ID = ID;
+        slices[s].first = static_cast<int>(static_cast<qint64>(count) * s / numSlices);
+        slices[s].last = static_cast<int>(static_cast<qint64>(count) * (s + 1) / numSlices);
+        slices[s].maxLen = 0;
+    }
+    return slices;
+}
+
+FlowTransitionIndex::FlowTransitionIndex()
+{
+    clear();
+}
+
+void FlowTransitionIndex::clear()
+{
+    ID = 0;
+    validID = false;
+    monotonic = true;
+    maxLen = 0;
+    words = 1;
+    stamps.clear();
+    lengths.clear();
+    data.clear();
+    changed.clear();
+    changeCounts.clear();
+}
+
+/*
+ * Indexes every frame of ID in the list. Runs on the pool threads but doesn't return until done, the frame list
+ * can't be read from other threads while the GUI thread is free to append to it.
+ */
+void FlowTransitionIndex::build(const QVector<CANFrame> *frames, uint32_t ID)
+{
+    clear();
+    this->ID = ID;
+    validID = true;
+
+    //first find where the ID's frames are
+    QVector<FlowIndexSlice> slices = makeSlices(frames, ID, frames->count());
+    if (slices.count() == 1) findFrames(slices[0]);
+    else QtConcurrent::blockingMap(slices, findFrames);
+
+    QVector<int> modelIdx;
+    for (const FlowIndexSlice &slice : slices)
+    {
+        modelIdx += slice.found;
+        if (slice.maxLen > maxLen) maxLen = slice.maxLen;
+    }
+    if (modelIdx.isEmpty()) return;
+
+    words = qBound(1, (maxLen + 7) / 8, 8);
+    int count = modelIdx.count();
+    stamps.resize(count);
+    lengths.resize(count);
+    data.resize(count * words);
+    changed.resize(count * words);
+    changeCounts.resize(count);
+
+    //then copy their payloads and times in, every frame lands in its own place so slices don't share anything
+    QVector<FlowIndexSlice> packSlices = makeSlices(frames, ID, count);
+    for (FlowIndexSlice &slice : packSlices)
+    {
+        slice.modelIdx = modelIdx.constData();
+        slice.words = words;
+        slice.stamps = stamps.data();
+        slice.lengths = lengths.data();
+        slice.data = data.data();
+    }
+    if (packSlices.count() == 1) packFrames(packSlices[0]);
+    else QtConcurrent::blockingMap(packSlices, packFrames);
+
+    //transitions depend on the frame before so they're a single walk, it only touches the packed words
+    for (int pos = 0; pos < count; pos++)
+    {
+        if (pos > 0 && stamps[pos] < stamps[pos - 1]) monotonic = false;
+        addTransition(pos);
+    }
+}
+
+void FlowTransitionIndex::append(const CANFrame &frame)
+{
+    if (!validID || frame.frameId() != ID) return;
+
+    int len = qMin(frame.payload().length(), 64);
+    if (len > words * 8) setWords((len + 7) / 8);
+    if (len > maxLen) maxLen = len;
+
+    qint64 stamp = frame.timeStamp().microSeconds();
+    if (!stamps.isEmpty() && stamp < stamps.last()) monotonic = false;
+
+    int pos = stamps.count();
+    stamps.append(stamp);
+    lengths.append(static_cast<quint8>(len));
+    data.resize((pos + 1) * words);
+    changed.resize((pos + 1) * words);
+    changeCounts.append(0);
+    packPayload(frame, words, data.data() + pos * words);
+    addTransition(pos);
+}
+
+//widens every frame to newWords words once a longer payload turns up
+void FlowTransitionIndex::setWords(int newWords)
+{
+    int count = stamps.count();
+    QVector<quint64> newData(count * newWords, 0);
+    QVector<quint64> newChanged(count * newWords, 0);
+    for (int pos = 0; pos < count; pos++)
+    {
+        for (int w = 0; w < words; w++)
+        {
+            newData[pos * newWords + w] = data[pos * words + w];
+            newChanged[pos * newWords + w] = changed[pos * words + w];
+        }
+    }
+    data = newData;
+    changed = newChanged;
+    words = newWords;
+}
+
+void FlowTransitionIndex::addTransition(int pos)
+{
+    quint64 *mask = changed.data() + pos * words;
+    if (pos == 0)
+    {
+        for (int w = 0; w < words; w++) mask[w] = 0;
+        changeCounts[pos] = 0;
+        return;
+    }
+
+    const quint64 *curr = data.constData() + pos * words;
+    const quint64 *prev = curr - words;
+    qint64 bits = 0;
+    for (int w = 0; w < words; w++)
+    {
+        mask[w] = curr[w] ^ prev[w];
+        bits += qPopulationCount(mask[w]);
+    }
+    changeCounts[pos] = changeCounts[pos - 1] + bits;
+}
+
+unsigned char FlowTransitionIndex::getByte(int pos, int byte) const
+{
+    if (byte < 0 || byte >= words * 8) return 0;
+    return static_cast<unsigned char>(data[pos * words + byte / 8] >> (8 * (byte % 8)));
+}
+
+void FlowTransitionIndex::getBytes(int pos, unsigned char *out) const
+{
+    memset(out, 0, 64);
+    for (int w = 0; w < words; w++) qToLittleEndian<quint64>(data[pos * words + w], out + w * 8);
+}
+
+//bits of the given word that differ between two frames. Neighbors come straight from the transition masks
+uint64_t FlowTransitionIndex::changedBits(int from, int to, int word) const
+{
+    if (word < 0 || word >= words) return 0;
+    if (to == from + 1) return changed[to * words + word];
+    if (from == to + 1) return changed[from * words + word];
+    return data[from * words + word] ^ data[to * words + word];
+}
+
+//how many bit changes happened stepping from one frame to the other
+qint64 FlowTransitionIndex::changesBetween(int from, int to) const
+{
+    return qAbs(changeCounts[to] - changeCounts[from]);
+}
+
+//the last frame at or before stamp, -1 if every frame is later
+int FlowTransitionIndex::findTime(qint64 stamp) const
+{
+    if (monotonic)
+    {
+        return static_cast<int>(std::upper_bound(stamps.constBegin(), stamps.constEnd(), stamp) - stamps.constBegin()) - 1;
+    }
+    for (int i = 0; i < stamps.count(); i++)
+    {
+        if (stamps[i] > stamp) return i - 1;
+    }
+    return stamps.count() - 1;
+}
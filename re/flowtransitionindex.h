@@ -0,0 +1,59 @@
+#ifndef FLOWTRANSITIONINDEX_H
+#define FLOWTRANSITIONINDEX_H
+
+#include <QVector>
+#include "can_structs.h"
+
+/*
+ * Every frame of one ID packed for FlowViewWindow so stepping, scrubbing and graphing are array lookups instead of
+ * trips through the frame list.
+ *
+ * Payloads are stored as 64 bit words, byte i of a frame in word i / 8 at bit 8 * (i % 8), one word per frame for
+ * classic CAN and up to eight once an FD frame shows up. Next to them is a mask of the bits each frame changed
+ * relative to the frame before it and a running total of changed bits, so how much a stretch of the history moved
+ * is a subtraction. Timestamps are kept as well and searched by bisection when they are in order.
+ *
+ * build() splits the frame list into slices and indexes them on the pool threads, the caller waits for it.
+ * append() adds live frames one at a time.
+ */
+class FlowTransitionIndex
+{
+public:
+    FlowTransitionIndex();
+
+    void build(const QVector<CANFrame> *frames, uint32_t ID);
+    void append(const CANFrame &frame);
+    void clear();
+
+    bool hasID() const { return validID; }
+    uint32_t getID() const { return ID; }
+    int count() const { return stamps.count(); }
+    int getMaxLen() const { return maxLen; }
+    int getWords() const { return words; }
+
+    qint64 getStamp(int pos) const { return stamps[pos]; }
+    int getLength(int pos) const { return lengths[pos]; }
+    unsigned char getByte(int pos, int byte) const;
+    void getBytes(int pos, unsigned char *out) const; //always writes 64 bytes, zero past the frame's length
+    uint64_t changedBits(int from, int to, int word) const;
+    qint64 changesBetween(int from, int to) const;
+    int findTime(qint64 stamp) const;
+
+private:
+    void setWords(int newWords);
+    void addPayload(int pos, const CANFrame &frame);
+    void addTransition(int pos);
+
+    uint32_t ID;
+    bool validID;
+    bool monotonic; //timestamps never go backward
+    int maxLen;
+    int words; //64 bit words per frame
+    QVector<qint64> stamps;
+    QVector<quint8> lengths;
+    QVector<quint64> data; //words per frame
+    QVector<quint64> changed; //bits that differ from the frame before, words per frame. Frame 0 has none
+    QVector<qint64> changeCounts; //changed bits from the first frame through this one
+};
+
+#endif // FLOWTRANSITIONINDEX_H
@@ -296,7 +296,7 @@ void FlowViewWindow::plottableDoubleClick(QCPAbstractPlottable* plottable, QMous
     int id = 0;
     //apply transforms to get the X axis value where we double clicked
     double coord = plottable->keyAxis()->pixelToCoord(event->localPos().x());
-    if (frameCache.count() > 0) id = frameCache[0].frameId();
+    if (flowIndex.hasID()) id = flowIndex.getID();
     if (secondsMode) emit sendCenterTimeID(id, coord);
     else emit sendCenterTimeID(id, coord / 1000000.0);
 }
@@ -321,27 +321,17 @@ void FlowViewWindow::gotCenterTimeID(uint32_t ID, double timestamp)
         }
     }
 
-    int bestIdx = -1;
-    for (int i = 0; i < frameCache.count(); i++)
-    {
-        if (frameCache[i].timeStamp().microSeconds() > t_stamp)
-        {
-            bestIdx = i - 1;
-            break;
-        }
-    }
+    int bestIdx = flowIndex.findTime(t_stamp);
     qDebug() << "Best index " << bestIdx;
     if (bestIdx > -1)
     {
         currentPosition = bestIdx;
         if (ui->cbAutoRef->isChecked())
         {
-            memcpy(refBytes, currBytes, 8);
+            memcpy(refBytes, currBytes, 64);
         }
 
-        memset(currBytes, 0, 8); //first zero out all 8 bytes
-
-        memcpy(currBytes, frameCache.at(currentPosition).payload().data(), frameCache.at(currentPosition).payload().length());
+        loadCurrentBytes();
 
         updateDataView();
     }
@@ -445,8 +435,6 @@ void FlowViewWindow::updatedFrames(int numFrames)
 {
     QVector<double>newX[8];
     QVector<double>newY[8];
-    const unsigned char *data;
-    int dataLen = 0;
 
     const CANFrame *thisFrame;
     if (numFrames == -1) //all frames deleted. Kill the display
@@ -477,15 +465,10 @@ void FlowViewWindow::updatedFrames(int numFrames)
     else //just got some new frames. See if they are relevant.
     {
         if (numFrames > modelFrames->count()) return;
-        unsigned int refID;
-        if (frameCache.count() > 0) refID = frameCache[0].frameId();
-            else refID = 0;
         bool needRefresh = false;
         for (int i = modelFrames->count() - numFrames; i < modelFrames->count(); i++)
         {
             thisFrame = &modelFrames->at(i);
-            data = reinterpret_cast<const unsigned char *>(thisFrame->payload().constData());
-            dataLen = thisFrame->payload().length();
 
             if (!foundID.contains(thisFrame->frameId()))
             {
@@ -493,49 +476,49 @@ void FlowViewWindow::updatedFrames(int numFrames)
                 FilterUtility::createFilterItem(thisFrame->frameId(), ui->listFrameID);
             }
 
-            if (thisFrame->frameId() == refID)
+            if (flowIndex.hasID() && thisFrame->frameId() == flowIndex.getID())
             {
-                frameCache.append(*thisFrame);
+                flowIndex.append(*thisFrame);
+                int pos = flowIndex.count() - 1;
 
-                for (int k = 0; k < dataLen; k++)
+                for (int k = 0; k < qMin(flowIndex.getLength(pos), 8); k++)
                 {
                     if (ui->cbTimeGraph->isChecked())
                     {
                         if (secondsMode){
-                            newX[k].append((double)(thisFrame->timeStamp().microSeconds()) / 1000000.0);
+                            newX[k].append((double)(flowIndex.getStamp(pos)) / 1000000.0);
                         }
                         else
                         {
-                            newX[k].append(thisFrame->timeStamp().microSeconds());
+                            newX[k].append(flowIndex.getStamp(pos));
                         }
                     }
                     else
                     {
-                        newX[k].append(x[k].count());
+                        newX[k].append(pos);
                     }
-                    newY[k].append(data[k]);
+                    newY[k].append(flowIndex.getByte(pos, k));
                     needRefresh = true;
                 }
             }
         }
-        if (ui->cbLiveMode->checkState() == Qt::Checked)
+        if (ui->cbLiveMode->checkState() == Qt::Checked && flowIndex.count() > 0)
         {
-            currentPosition = frameCache.count() - 1;
-            memset(currBytes, 0, 64);
-            memcpy(currBytes, frameCache.at(currentPosition).payload().data(), frameCache.at(currentPosition).payload().length());
+            currentPosition = flowIndex.count() - 1;
+            loadCurrentBytes();
             memcpy(refBytes, currBytes, 64);
 
         }
         if (needRefresh)
         {
-            for (int k = 0; k < dataLen; k++)
+            for (int k = 0; k < 8; k++)
             {
-                if (graphRef[k] && graphRef[k]->data())
+                if (!newX[k].isEmpty() && graphRef[k] && graphRef[k]->data())
                     graphRef[k]->addData(newX[k], newY[k]);
             }
             ui->graphView->replot();
             updateDataView();
-            if (ui->cbSync->checkState() == Qt::Checked) emit sendCenterTimeID(frameCache[currentPosition].frameId(), frameCache[currentPosition].timeStamp().microSeconds() / 1000000.0);
+            sendSyncTime();
         }
     }
     updateFrameLabel();
@@ -549,39 +532,28 @@ void FlowViewWindow::removeAllGraphs()
 
 void FlowViewWindow::createGraph(int byteNum)
 {
-    int tempVal;
-    double minval = 1000000.0, maxval = -100000.0;
-    const unsigned char *data;
-    const CANFrame *frame;
-
     qDebug() << "Create Graph " << byteNum;
 
     bool graphByTime = ui->cbTimeGraph->isChecked();
 
-    int numEntries = frameCache.count();
+    int numEntries = flowIndex.count();
 
     x[byteNum].clear();
     y[byteNum].clear();
     x[byteNum].resize(numEntries);
     y[byteNum].resize(numEntries);
 
+    //bytes past a frame's length are packed as zero so they come out the same as before
     for (int j = 0; j < numEntries; j++)
     {
-        frame = &frameCache[j];
-        data = reinterpret_cast<const unsigned char *>(frame->payload().constData());
-        if (byteNum < frameCache[j].payload().length())
-            tempVal = data[byteNum];
-        else
-            tempVal = 0;
-
         if (graphByTime)
         {
             if (secondsMode){
-                x[byteNum][j] = frame->timeStamp().microSeconds() / 1000000.0;
+                x[byteNum][j] = flowIndex.getStamp(j) / 1000000.0;
             }
             else
             {
-                x[byteNum][j] = frame->timeStamp().microSeconds();
+                x[byteNum][j] = flowIndex.getStamp(j);
             }
         }
         else
@@ -589,9 +561,7 @@ void FlowViewWindow::createGraph(int byteNum)
             x[byteNum][j] = j;
         }
 
-        y[byteNum][j] = tempVal;
-        if (y[byteNum][j] < minval) minval = y[byteNum][j];
-        if (y[byteNum][j] > maxval) maxval = y[byteNum][j];
+        y[byteNum][j] = flowIndex.getByte(j, byteNum);
     }
 
     graphRef[byteNum] = ui->graphView->addGraph();
@@ -624,7 +594,7 @@ void FlowViewWindow::refreshIDList()
 
 void FlowViewWindow::updateFrameLabel()
 {
-    ui->lblNumFrames->setText(QString::number(currentPosition) + tr(" of ") + QString::number(frameCache.count()));
+    ui->lblNumFrames->setText(QString::number(currentPosition) + tr(" of ") + QString::number(flowIndex.count()));
 }
 
 void FlowViewWindow::changeID(QString newID)
@@ -632,27 +602,17 @@ void FlowViewWindow::changeID(QString newID)
     qDebug() << "change id " << newID;
     //parse the ID and then load up the frame cache with just messages with that ID.
     uint32_t id = (uint32_t)Utility::ParseStringToNum(newID);
-    frameCache.clear();
+    flowIndex.clear();
 
     if (modelFrames->count() == 0) return;
 
     playbackTimer->stop();
     playbackActive = false;
-    int maxBytes = 0;
-    for (int x = 0; x < modelFrames->count(); x++)
-    {
-        CANFrame thisFrame = modelFrames->at(x);
-        if (thisFrame.frameId() == id)
-        {
-            thisFrame.payload().clear();
-            frameCache.append(thisFrame);
-            if (thisFrame.payload().length() > maxBytes) maxBytes = thisFrame.payload().length();
-        }
-    }
-    ui->flowView->setBytesToDraw(maxBytes);
+    flowIndex.build(modelFrames, id);
+    ui->flowView->setBytesToDraw(flowIndex.getMaxLen());
     currentPosition = 0;
 
-    if (frameCache.count() == 0) return;
+    if (flowIndex.count() == 0) return;
 
     removeAllGraphs();
     //for (uint32_t c = 0; c < frameCache.at(0).len; c++)
@@ -663,8 +623,7 @@ void FlowViewWindow::changeID(QString newID)
 
     updateGraphLocation();
 
-    memset(currBytes, 0, 64);
-    memcpy(currBytes, frameCache.at(currentPosition).payload().constData(), frameCache.at(currentPosition).payload().length());
+    loadCurrentBytes();
     memcpy(refBytes, currBytes, 64);
 
     updateDataView();
@@ -711,8 +670,7 @@ void FlowViewWindow::btnStopClick()
     playbackActive = false;
     currentPosition = 0;
 
-    memset(currBytes, 0, 64);
-    memcpy(currBytes, frameCache.at(currentPosition).payload().constData(), frameCache.at(currentPosition).payload().length());
+    loadCurrentBytes();
     memcpy(refBytes, currBytes, 64);
 
     updateFrameLabel();
@@ -767,7 +725,7 @@ void FlowViewWindow::timerTriggered()
     if (!ui->cbLoopPlayback->isChecked())
     {
         if (currentPosition == 0) playbackActive = false;
-        if (currentPosition == (frameCache.count() - 1)) playbackActive = false;
+        if (currentPosition == (flowIndex.count() - 1)) playbackActive = false;
     }
 }
 
@@ -795,7 +753,7 @@ void FlowViewWindow::updateDataView()
     ui->flowView->setReference(refBytes, false);
     ui->flowView->updateData(currBytes, true);
 
-    ui->timelineSlider->setMaximum(frameCache.count() - 1);
+    ui->timelineSlider->setMaximum(flowIndex.count() - 1);
     ui->timelineSlider->setValue(currentPosition);
 
     for (int i = 0; i < 8; i++)
@@ -814,25 +772,51 @@ void FlowViewWindow::updateDataView()
 
 }
 
+//the timeline slider moved. Everything shown comes out of the index so dragging it updates the view as it goes
 void FlowViewWindow::gotoFrame(int frame) {
-    if (frameCache.count() >= frame) currentPosition = frame;
-    else currentPosition = 0;
+    if (frame < 0 || frame >= flowIndex.count() || frame == currentPosition) return;
+    currentPosition = frame;
+
+    if (ui->cbAutoRef->isChecked())
+    {
+        memcpy(refBytes, currBytes, 64);
+    }
+    loadCurrentBytes();
+
+    sendSyncTime();
+    updateDataView();
+}
+
+void FlowViewWindow::loadCurrentBytes()
+{
+    if (currentPosition < 0 || currentPosition >= flowIndex.count())
+    {
+        memset(currBytes, 0, 64);
+        return;
+    }
+    flowIndex.getBytes(currentPosition, currBytes);
+}
 
-    if (ui->cbSync->checkState() == Qt::Checked) emit sendCenterTimeID(frameCache[currentPosition].frameId(), frameCache[currentPosition].timeStamp().microSeconds() / 1000000.0);
+void FlowViewWindow::sendSyncTime()
+{
+    if (ui->cbSync->checkState() != Qt::Checked || currentPosition < 0 || currentPosition >= flowIndex.count()) return;
+    emit sendCenterTimeID(flowIndex.getID(), flowIndex.getStamp(currentPosition) / 1000000.0);
 }
 
 void FlowViewWindow::updatePosition(bool forward)
 {
+    if (flowIndex.count() == 0) return;
+    int previousPosition = currentPosition;
 
     if (forward)
     {
-        if (currentPosition < (frameCache.count() - 1)) currentPosition++;
+        if (currentPosition < (flowIndex.count() - 1)) currentPosition++;
         else if (ui->cbLoopPlayback->isChecked()) currentPosition = 0;
     }
     else
     {
         if (currentPosition > 0) currentPosition--;
-        else if (ui->cbLoopPlayback->isChecked()) currentPosition = frameCache.count() - 1;
+        else if (ui->cbLoopPlayback->isChecked()) currentPosition = flowIndex.count() - 1;
     }
 
     if (ui->cbAutoRef->isChecked())
@@ -842,49 +826,40 @@ void FlowViewWindow::updatePosition(bool forward)
 
     //figure out which bits changed since the previous frame and then AND that with the trigger bits. If any bits
     //get through that then they're changed and a trigger so we stop playback at this frame.
-    //This is complicated by the fact that CAN-FD frames might have far more than 64 bits. It is necessary
-    //to thus process them 64 bits at a time and just move chunk to chunk until done.
-    for (int chunk = 0; chunk < frameCache.at(currentPosition).payload().length(); chunk += 8)
+    //CAN-FD frames might have far more than 64 bits so the index keeps them as up to 8 words and each word
+    //is checked against its own trigger bits. Stepping to a neighbor reads the precomputed transition mask.
+    if (previousPosition < flowIndex.count() && flowIndex.changesBetween(previousPosition, currentPosition) > 0)
     {
-        uint64_t changedBits = 0;
-        uint8_t cngByte;
-        int maxVal = qMin(chunk * 8 + 8, frameCache.at(currentPosition).payload().length());
-        for (int i = chunk * 8; i < maxVal; i++)
-        {
-            unsigned char thisByte = static_cast<unsigned char>(frameCache.at(currentPosition).payload()[i]);
-            cngByte = currBytes[i] ^ thisByte;
-            changedBits |= (uint64_t)cngByte << (8ull * (i & 7));
-        }
-
-        qDebug() << "ChangedBits: " << QString::number(changedBits, 16);
-        qDebug() << "TriggerBits: " << QString::number(triggerBits[chunk / 8], 16);
-        changedBits &= triggerBits[chunk / 8];
-        qDebug() << "Final ChangedBits: " << QString::number(changedBits, 16);
-        if (changedBits)
+        for (int chunk = 0; chunk < flowIndex.getWords(); chunk++)
         {
-            playbackActive = false;
-            playbackTimer->stop();
+            uint64_t changedBits = flowIndex.changedBits(previousPosition, currentPosition, chunk) & triggerBits[chunk];
+            if (changedBits)
+            {
+                qDebug() << "Trigger bits changed: " << QString::number(changedBits, 16);
+                playbackActive = false;
+                playbackTimer->stop();
+                break;
+            }
         }
     }
-    memset(currBytes, 0, 64);
-    memcpy(currBytes, frameCache.at(currentPosition).payload().constData(), frameCache.at(currentPosition).payload().length());
+    loadCurrentBytes();
 
-    if (ui->cbSync->checkState() == Qt::Checked) emit sendCenterTimeID(frameCache[currentPosition].frameId(), frameCache[currentPosition].timeStamp().microSeconds() / 1000000.0);
+    sendSyncTime();
     ui->timelineSlider->setValue(currentPosition);
 }
 
 void FlowViewWindow::updateGraphLocation()
 {
-    if (frameCache.count() == 0) return;
+    if (flowIndex.count() == 0) return;
     int start = currentPosition - ui->graphRangeSlider->value();
     if (start < 0) start = 0;
     int end = currentPosition + ui->graphRangeSlider->value();
-    if (end >= frameCache.count()) end = frameCache.count() - 1;
+    if (end >= flowIndex.count()) end = flowIndex.count() - 1;
     if (ui->cbTimeGraph->isChecked())
     {
         if (secondsMode)
         {
-            ui->graphView->xAxis->setRange(frameCache[start].timeStamp().microSeconds() / 1000000.0, frameCache[end].timeStamp().microSeconds() / 1000000.0);
+            ui->graphView->xAxis->setRange(flowIndex.getStamp(start) / 1000000.0, flowIndex.getStamp(end) / 1000000.0);
             /*
             ui->graphView->xAxis->setTickStep((frameCache[end].timeStamp().microSeconds() - frameCache[start].timeStamp().microSeconds())/ 3000000.0);
             ui->graphView->xAxis->setSubTickCount(0);
@@ -894,7 +869,7 @@ void FlowViewWindow::updateGraphLocation()
         }
         else
         {
-            ui->graphView->xAxis->setRange(frameCache[start].timeStamp().microSeconds(), frameCache[end].timeStamp().microSeconds());
+            ui->graphView->xAxis->setRange(flowIndex.getStamp(start), flowIndex.getStamp(end));
             /*
             ui->graphView->xAxis->setTickStep((frameCache[end].timeStamp().microSeconds() - frameCache[start].timeStamp().microSeconds())/ 3.0);
             ui->graphView->xAxis->setSubTickCount(0);
@@ -6,6 +6,7 @@
 #include <QSlider>
 #include "qcustomplot.h"
 #include "can_structs.h"
+#include "flowtransitionindex.h"
 
 namespace Ui {
 class FlowViewWindow;
@@ -49,7 +50,7 @@ signals:
 private:
     Ui::FlowViewWindow *ui;
     QList<quint32> foundID;
-    QList<CANFrame> frameCache;
+    FlowTransitionIndex flowIndex; //every frame of the selected ID
     const QVector<CANFrame> *modelFrames;
     unsigned char refBytes[64];
     unsigned char currBytes[64];
@@ -69,6 +70,8 @@ private:
     void refreshIDList();
     void updateFrameLabel();
     void updatePosition(bool forward);
+    void loadCurrentBytes();
+    void sendSyncTime();
     void gotoFrame(int frame);
     void updateDataView();
     void removeAllGraphs();
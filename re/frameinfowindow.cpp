@@ -4,6 +4,7 @@
 #include "helpwindow.h"
 #include <QtDebug>
 #include <vector>
+#include <algorithm>
 #include "filterutility.h"
 #include "qcpaxistickerhex.h"
 
@@ -15,7 +16,8 @@ const int numIntervalHistBars = 20;
 
 FrameInfoWindow::FrameInfoWindow(const QVector<CANFrame> *frames, QWidget *parent) :
     QDialog(parent),
-    ui(new Ui::FrameInfoWindow)
+    ui(new Ui::FrameInfoWindow),
+    frameStats(frames)
 {
     ui->setupUi(this);
     setWindowFlags(Qt::Window);
@@ -332,36 +334,21 @@ void FrameInfoWindow::updatedFrames(int numFrames)
         //qDebug() << "Got frames in Info Window";
         if (numFrames > modelFrames->count()) return;
 
-        unsigned int currID = 0;
-        if (ui->listFrameID->currentItem())
-            currID = static_cast<unsigned int>(FilterUtility::getIdAsInt(ui->listFrameID->currentItem()));
-        bool thisID = false;
-        for (int x = modelFrames->count() - numFrames; x < modelFrames->count(); x++)
+        //the statistics take the new frames in as they arrive, so clicking an ID later doesn't have to go
+        //through the whole list. Only new IDs need anything done here.
+        QList<uint32_t> newIDs;
+        frameStats.update(&newIDs);
+        for (uint32_t newID : newIDs)
         {
-            CANFrame thisFrame = modelFrames->at(x);
-            int32_t id = static_cast<int32_t>(thisFrame.frameId());
+            int32_t id = static_cast<int32_t>(newID);
             if (!foundID.contains(id))
             {
                 foundID.append(id);
                 FilterUtility::createFilterItem(id, ui->listFrameID);
             }
-
-            if (currID == modelFrames->at(x).frameId())
-            {
-                thisID = true;
-                break;
-            }
         }
-        if (thisID)
-        {
-            //the problem here is that it'll blast us out of the details as soon as this
-            //happens. The only way to do this properly is to actually traverse
-            //the details structure and change the text. We don't do that yet.
-            //so, the line is commented out. If people need to see the updated
-            //data they can click another ID and back and it'll be OK
+        if (newIDs.isEmpty()) return;
 
-            //updateDetailsWindow(ui->listFrameID->currentItem()->text());
-        }
         //default is to sort in ascending order
         ui->listFrameID->sortItems();
         ui->lblUniqueID->setText(")" + QString::number(ui->listFrameID->count()) + tr(" unique ids)"));
@@ -371,26 +358,15 @@ void FrameInfoWindow::updatedFrames(int numFrames)
 void FrameInfoWindow::updateDetailsWindow(QString newID)
 {
     int targettedID;
-    int minLen, maxLen, thisLen;
+    int minLen, maxLen;
     int64_t avgInterval;
     int64_t minInterval;
     int64_t maxInterval;
-    int64_t thisInterval;
-    int minData[8];
-    int maxData[8];
-    int dataHistogram[256][8];
-    int bitfieldHistogram[64];
     QVector<double> histGraphX, histGraphY;
     QVector<double> byteGraphX, byteGraphY[8];
     QVector<double> timeGraphX, timeGraphY;
-    QHash<QString, QHash<QString, int>> signalInstances;
     double maxY = -1000.0;
-    uint8_t changedBits[8];
-    uint8_t referenceBits[8];
     uint8_t heatVals[512];
-
-    //these two used by bitflip heatmap functionality
-    uint8_t refByte[8];
     double bitFlipHeat[64];
 
     QTreeWidgetItem *baseNode, *dataBase, *histBase, *tempItem;
@@ -405,27 +381,17 @@ void FrameInfoWindow::updateDetailsWindow(QString newID)
 
     if (targettedID > -1)
     {
-
-        frameCache.clear();
-        for (int i = 0; i < modelFrames->count(); i++)
-        {
-            CANFrame thisFrame = modelFrames->at(i);
-            if (thisFrame.frameId() == static_cast<uint32_t>(targettedID)) frameCache.append(thisFrame);
-        }
-
-        if (frameCache.count() == 0) return; //nothing to do if there are no frames!
-
-        const unsigned char *data = reinterpret_cast<const unsigned char *>(frameCache.at(0).payload().constData());
-        int dataLen = frameCache.at(0).payload().length();
+        //everything below is read from the running statistics, the frames only get looked at for the byte graphs
+        frameStats.update();
+        const IDStatistics *stats = frameStats.getStats(static_cast<uint32_t>(targettedID));
+        if (!stats || stats->frameCount == 0) return; //nothing to do if there are no frames!
 
         ui->treeDetails->clear();
 
-        if (frameCache.count() == 0) return;
-
         baseNode = new QTreeWidgetItem();
         baseNode->setText(0, QString("ID: ") + newID );
 
-        if (frameCache[0].hasExtendedFrameFormat()) //if these frames seem to be extended then try for J1939 decoding
+        if (stats->extended) //if these frames seem to be extended then try for J1939 decoding
         {
             // ------- J1939 decoding ----------
             J1939ID jid;
@@ -507,133 +473,38 @@ void FrameInfoWindow::updateDetailsWindow(QString newID)
         }
 
         tempItem = new QTreeWidgetItem();
-        tempItem->setText(0, tr("# of frames: ") + QString::number(frameCache.count(),10));
+        tempItem->setText(0, tr("# of frames: ") + QString::number(stats->frameCount,10));
         baseNode->addChild(tempItem);
 
-        //clear out all the counters and accumulators
-        minLen = 8;
-        maxLen = 0;
-        minInterval = 0x7FFFFFFF;
-        maxInterval = 0;
-        for (int i = 0; i < 8; i++)
-        {
-            minData[i] = 256;
-            maxData[i] = -1;
-            for (int k = 0; k < 256; k++) dataHistogram[k][i] = 0;
-        }
-        for (int j = 0; j < 64; j++)
-        {
-            bitfieldHistogram[j] = 0;
-            bitFlipHeat[j] = 0;
-        }
-        signalInstances.clear();
-
-        data = reinterpret_cast<const unsigned char *>(frameCache.at(0).payload().constData());
-        dataLen = frameCache.at(0).payload().length();
-
-        for (int c = 0; c < dataLen; c++)
-        {
-            changedBits[c] = 0;
-            referenceBits[c] = data[c];
-            refByte[c] = data[c];
-            //qDebug() << referenceBits[c];
-        }
-
-        std::vector<int64_t> sortedIntervals;
-        int64_t intervalSum = 0;
-
-        DBC_MESSAGE *msg = dbcHandler->findMessageForFilter(targettedID, nullptr);
+        minLen = stats->minLen;
+        maxLen = stats->maxLen;
+        minInterval = stats->minInterval;
+        maxInterval = stats->maxInterval;
+        int numBytes = qMin(maxLen, 8);
 
-        //then find all data points
-        for (int j = 0; j < frameCache.count(); j++)
+        for (int j = 0; j < stats->frameIdx.count(); j++)
         {
-            data = reinterpret_cast<const unsigned char *>(frameCache.at(j).payload().constData());
-            dataLen = frameCache.at(j).payload().length();
+            const QByteArray payload = modelFrames->at(stats->frameIdx.at(j)).payload();
+            const unsigned char *data = reinterpret_cast<const unsigned char *>(payload.constData());
+            int dataLen = qMin(payload.length(), 8);
 
             byteGraphX.append(j);
             for (int bytcnt = 0; bytcnt < dataLen; bytcnt++)
             {
                 byteGraphY[bytcnt].append(data[bytcnt]);
             }
-
-            if (j != 0)
-            {
-                //TODO - we try the interval whichever way doesn't go negative. But, we should probably sort the frame list before
-                //starting so that the intervals are all correct.
-                if (frameCache[j].timeStamp().microSeconds() > frameCache[j-1].timeStamp().microSeconds())
-                    thisInterval = (frameCache[j].timeStamp().microSeconds() - frameCache[j-1].timeStamp().microSeconds());
-                else
-                    thisInterval = (frameCache[j-1].timeStamp().microSeconds() - frameCache[j].timeStamp().microSeconds());
-
-                sortedIntervals.push_back(thisInterval);
-                intervalSum += thisInterval;
-                if (thisInterval > maxInterval) maxInterval = thisInterval;
-                if (thisInterval < minInterval) minInterval = thisInterval;
-                avgInterval += thisInterval;
-            }
-            thisLen = dataLen;
-            if (thisLen > maxLen) maxLen = thisLen;
-            if (thisLen < minLen) minLen = thisLen;
-            for (int c = 0; c < thisLen; c++)
-            {
-                unsigned char dat = data[c];
-                if (minData[c] > dat) minData[c] = dat;
-                if (maxData[c] < dat) maxData[c] = dat;
-                dataHistogram[dat][c]++; //add one to count for this
-                for (int l = 0; l < 8; l++)
-                {
-                    int bit = dat & (1 << l);
-                    if (bit == (1 << l))
-                    {
-                        bitfieldHistogram[c * 8 + l]++;
-                    }
-                }
-                changedBits[c] |= referenceBits[c] ^ dat;
-
-                if (refByte[c] != dat) //if this byte doesn't match the value it last had
-                {
-                    uint8_t newBits = refByte[c] ^ dat; //get changed bits since last ref
-                    for (int l = 0; l < 8; l++)
-                    {
-                        if (newBits & (1 << l)) bitFlipHeat[(c * 8) + l]++;
-                    }
-                    refByte[c] = dat; //set the reference to this current byte now that processing is done
-                }
-            }
-
-            //Search every signal in the selected message and give output of the range the signal took and
-            //how many messages contained each discrete value.
-            if (msg)
-            {
-                int numSignals = msg->sigHandler->getCount();
-                for (int i = 0; i < numSignals; i++)
-                {
-                    DBC_SIGNAL *sig = msg->sigHandler->findSignalByIdx(i);
-                    if (sig)
-                    {
-                        if (sig->isSignalInMessage(frameCache.at(j)))
-                        {
-                            QString sigVal;
-                            if (sig->processAsText(frameCache.at(j), sigVal, false))
-                            {
-                                signalInstances[sig->name][sigVal] = signalInstances[sig->name][sigVal] + 1;
-                            }
-                        }
-                    }
-                }
-            }
         }
 
         //Divide all the bit flip heat values by the number of frames to get a ratio
-        for (int j = 0; j < 64; j++) bitFlipHeat[j] /= (double)frameCache.count();
+        for (int j = 0; j < 64; j++) bitFlipHeat[j] = stats->bitFlips[j] / (double)stats->frameCount;
 
-        std::sort(sortedIntervals.begin(), sortedIntervals.end());
+        const QVector<qint64> &sortedIntervals = frameStats.getSortedIntervals(stats->ID);
         int64_t intervalStdDiv = 0, intervalPctl5 = 0, intervalPctl95 = 0, intervalMean = 0, intervalVariance = 0;
 
         int maxTimeCounter = -1;
         if (sortedIntervals.size() > 0)
         {
-            intervalMean = intervalSum / sortedIntervals.size();
+            intervalMean = stats->intervalSum / sortedIntervals.size();
 
             for(int l = 0; l < static_cast<int>(sortedIntervals.size()); l++) {
                 intervalVariance += ((sortedIntervals[l] - intervalMean) * (sortedIntervals[l] - intervalMean));
@@ -647,7 +518,7 @@ void FrameInfoWindow::updateDetailsWindow(QString newID)
 
             uint64_t step = static_cast<unsigned int>(ceil((maxInterval - minInterval) / numIntervalHistBars));
             qDebug() << "Step: " << step << " minInt: " << minInterval << " maxInt: " << maxInterval;
-            unsigned int index = 0;
+            int index = 0;
             int counter = 0;
             for(int l = 0; l <= numIntervalHistBars; l++) {
                 int64_t currentMax = maxInterval - ((numIntervalHistBars - l) * step);	// avoid missing the biggest value due to rounding errors
@@ -668,8 +539,8 @@ void FrameInfoWindow::updateDetailsWindow(QString newID)
             }
         }
 
-        if (frameCache.count() > 1)
-            avgInterval = avgInterval / (frameCache.count() - 1);
+        if (stats->frameCount > 1)
+            avgInterval = stats->intervalSum / (stats->frameCount - 1);
         else avgInterval = 0;
 
         //now that data processing is done, create all of our output
@@ -677,7 +548,14 @@ void FrameInfoWindow::updateDetailsWindow(QString newID)
         tempItem = new QTreeWidgetItem();
 
         if (minLen < maxLen)
-            tempItem->setText(0, tr("Data Length: ") + QString::number(minLen) + tr(" to ") + QString::number(maxLen));
+        {
+            QStringList lengths;
+            QList<int> seen = stats->lengths;
+            std::sort(seen.begin(), seen.end());
+            for (int len : seen) lengths.append(QString::number(len));
+            tempItem->setText(0, tr("Data Length: ") + QString::number(minLen) + tr(" to ") + QString::number(maxLen)
+                              + " (" + lengths.join(", ") + ")");
+        }
         else
             tempItem->setText(0, tr("Data Length: ") + QString::number(minLen));
 
@@ -703,7 +581,7 @@ void FrameInfoWindow::updateDetailsWindow(QString newID)
         baseNode->addChild(tempItem);
 
         //display accumulated data for all the bytes in the message
-        for (int c = 0; c < maxLen; c++)
+        for (int c = 0; c < numBytes; c++)
         {
             dataBase = new QTreeWidgetItem();
             histBase = new QTreeWidgetItem();
@@ -713,22 +591,22 @@ void FrameInfoWindow::updateDetailsWindow(QString newID)
 
             tempItem = new QTreeWidgetItem();
             QString builder;
-            builder = tr("Changed bits: 0x") + QString::number(changedBits[c], 16) + "  (" + Utility::formatByteAsBinary(changedBits[c]) + ")";
+            builder = tr("Changed bits: 0x") + QString::number(stats->changedBits[c], 16) + "  (" + Utility::formatByteAsBinary(stats->changedBits[c]) + ")";
             tempItem->setText(0, builder);
             dataBase->addChild(tempItem);
 
             tempItem = new QTreeWidgetItem();
-            tempItem->setText(0, tr("Range: ") + Utility::formatNumber((unsigned int)minData[c]) + tr(" to ") + Utility::formatNumber((unsigned int)maxData[c]));
+            tempItem->setText(0, tr("Range: ") + Utility::formatNumber((unsigned int)stats->minData[c]) + tr(" to ") + Utility::formatNumber((unsigned int)stats->maxData[c]));
             dataBase->addChild(tempItem);
             histBase->setText(0, tr("Histogram"));
             dataBase->addChild(histBase);
 
             for (int d = 0; d < 256; d++)
             {
-                if (dataHistogram[d][c] > 0)
+                if (stats->dataHistogram[d * 8 + c] > 0)
                 {
                     tempItem = new QTreeWidgetItem();
-                    tempItem->setText(0, QString::number(d) + "/0x" + QString::number(d, 16) +" (" + Utility::formatByteAsBinary(static_cast<uint8_t>(d)) +") -> " + QString::number(dataHistogram[d][c]));
+                    tempItem->setText(0, QString::number(d) + "/0x" + QString::number(d, 16) +" (" + Utility::formatByteAsBinary(static_cast<uint8_t>(d)) +") -> " + QString::number(stats->dataHistogram[d * 8 + c]));
                     histBase->addChild(tempItem);
                 }
             }
@@ -736,16 +614,16 @@ void FrameInfoWindow::updateDetailsWindow(QString newID)
 
         dataBase = new QTreeWidgetItem();
         dataBase->setText(0, tr("Bitfield Histogram"));
-        for (int c = 0; c < 8 * maxLen; c++)
+        for (int c = 0; c < 8 * numBytes; c++)
         {
             tempItem = new QTreeWidgetItem();
             tempItem->setText(0, QString::number(c) + " (Byte " + QString::number(c / 8) + " Bit "
-                            + QString::number(c % 8) + ") : " + QString::number(bitfieldHistogram[c]));
+                            + QString::number(c % 8) + ") : " + QString::number(stats->bitfieldHistogram[c]));
 
             dataBase->addChild(tempItem);
             histGraphX.append(c);
-            histGraphY.append(bitfieldHistogram[c]);
-            if (bitfieldHistogram[c] > maxY) maxY = bitfieldHistogram[c];
+            histGraphY.append(stats->bitfieldHistogram[c]);
+            if (stats->bitfieldHistogram[c] > maxY) maxY = stats->bitfieldHistogram[c];
         }
         baseNode->addChild(dataBase);
 
@@ -753,7 +631,7 @@ void FrameInfoWindow::updateDetailsWindow(QString newID)
         dataBase = new QTreeWidgetItem();
         dataBase->setText(0, tr("Bitchange Heatmap"));
         memset(heatVals, 0, 512); //always clear the array before populating it.
-        for (int c = 0; c < 8 * maxLen; c++)
+        for (int c = 0; c < 8 * numBytes; c++)
         {
             tempItem = new QTreeWidgetItem();
             tempItem->setText(0, QString::number(c) + " (Byte " + QString::number(c / 8) + " Bit "
@@ -761,8 +639,8 @@ void FrameInfoWindow::updateDetailsWindow(QString newID)
 
             dataBase->addChild(tempItem);
             histGraphX.append(c);
-            histGraphY.append(bitfieldHistogram[c]);
-            if (bitfieldHistogram[c] > maxY) maxY = bitfieldHistogram[c];
+            histGraphY.append(stats->bitfieldHistogram[c]);
+            if (stats->bitfieldHistogram[c] > maxY) maxY = stats->bitfieldHistogram[c];
             uint8_t heat = bitFlipHeat[c] * 255;
             if ((heat < 1) && (bitFlipHeat[c] > 0.0001)) heat = 1; //make sure any little bit of heat causes at least some output
             //qDebug() << "Heat for bit " << c <<  " is " << heat;
@@ -771,12 +649,15 @@ void FrameInfoWindow::updateDetailsWindow(QString newID)
         baseNode->addChild(dataBase);
         heatmap->setHeat(heatVals);
 
+        //Search every signal in the selected message and give output of the range the signal took and
+        //how many messages contained each discrete value.
+        const QHash<QString, QHash<QString, int>> &signalInstances = frameStats.getSignalInstances(stats->ID, dbcHandler);
         QHash<QString, QHash<QString, int>>::const_iterator it = signalInstances.constBegin();
         while (it != signalInstances.constEnd()) {
             dataBase = new QTreeWidgetItem();
             dataBase->setText(0, it.key());
-            QHash<QString,int>::const_iterator itVal = signalInstances[it.key()].constBegin();
-            while (itVal != signalInstances[it.key()].constEnd())
+            QHash<QString,int>::const_iterator itVal = it.value().constBegin();
+            while (itVal != it.value().constEnd())
             {
                 tempItem = new QTreeWidgetItem();
                 tempItem->setText(0, itVal.key() + ": " + QString::number(itVal.value()));
@@ -842,10 +723,11 @@ void FrameInfoWindow::updateDetailsWindow(QString newID)
 void FrameInfoWindow::refreshIDList()
 {
     int id;
-    for (int i = 0; i < modelFrames->count(); i++)
+    frameStats.update();
+    QList<uint32_t> ids = frameStats.getIDs();
+    for (int i = 0; i < ids.count(); i++)
     {
-        CANFrame thisFrame = modelFrames->at(i);
-        id = (int)thisFrame.frameId();
+        id = (int)ids[i];
         if (!foundID.contains(id))
         {
             foundID.append(id);
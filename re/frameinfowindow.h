@@ -9,6 +9,7 @@
 #include "can_structs.h"
 #include "bus_protocols/j1939_handler.h"
 #include "dbc/dbchandler.h"
+#include "framestatistics.h"
 
 #include "qcustomplot.h"
 
@@ -35,12 +36,12 @@ private slots:
 
 private:
     Ui::FrameInfoWindow *ui;
+    FrameStatistics frameStats;
     QCustomPlot *graphByte[8];
     QCustomPlot *graphHistogram;
     CANDataGrid *heatmap;
 
     QList<int> foundID;
-    QList<CANFrame> frameCache;
     const QVector<CANFrame> *modelFrames;
     bool useOpenGL;
     bool useHexTicker;
@@ -0,0 +1,205 @@
+#include "framestatistics.h"
+#include "dbc/dbchandler.h"
+#include "dbc/signalvaluestore.h"
+
+#include <algorithm>
+
+static const QHash<QString, QHash<QString, int>> noSignalInstances;
+static const QVector<qint64> noIntervals;
+
+IDStatistics::IDStatistics()
+{
+    ID = 0;
+    extended = false;
+    frameCount = 0;
+    minLen = 8;
+    maxLen = 0;
+    lastStamp = 0;
+    minInterval = 0x7FFFFFFF;
+    maxInterval = 0;
+    intervalSum = 0;
+    dataHistogram.fill(0, 256 * 8);
+    for (int i = 0; i < 8; i++)
+    {
+        minData[i] = 256;
+        maxData[i] = -1;
+        referenceBytes[i] = 0;
+        lastBytes[i] = 0;
+        changedBits[i] = 0;
+    }
+    for (int i = 0; i < 64; i++)
+    {
+        bitfieldHistogram[i] = 0;
+        bitFlips[i] = 0;
+    }
+    seenBytes = 0;
+    signalFramesScanned = 0;
+    signalGeneration = 0;
+}
+
+FrameStatistics::FrameStatistics(const QVector<CANFrame> *frames)
+{
+    this->frames = frames;
+    processedFrames = 0;
+    frameEpoch = SignalValueStore::getFrameEpoch();
+}
+
+void FrameStatistics::clear()
+{
+    stats.clear();
+    processedFrames = 0;
+    frameEpoch = SignalValueStore::getFrameEpoch();
+}
+
+/*
+ * Takes in the frames added to the list since the last call. Returns true if the frames that were already there
+ * changed and everything had to be rebuilt. newIDs gets every ID that wasn't known before (all of them after a rebuild).
+ */
+bool FrameStatistics::update(QList<uint32_t> *newIDs)
+{
+    bool rebuilt = false;
+    if (frameEpoch != SignalValueStore::getFrameEpoch() || processedFrames > frames->count())
+    {
+        clear();
+        rebuilt = true;
+    }
+
+    for (int i = processedFrames; i < frames->count(); i++)
+    {
+        const CANFrame &frame = frames->at(i);
+        auto it = stats.find(frame.frameId());
+        if (it == stats.end())
+        {
+            it = stats.insert(frame.frameId(), IDStatistics());
+            it.value().ID = frame.frameId();
+            it.value().extended = frame.hasExtendedFrameFormat();
+            if (newIDs) newIDs->append(frame.frameId());
+        }
+        addFrame(it.value(), frame, i);
+    }
+    processedFrames = frames->count();
+    return rebuilt;
+}
+
+void FrameStatistics::addFrame(IDStatistics &s, const CANFrame &frame, int index)
+{
+    const QByteArray payload = frame.payload();
+    const unsigned char *data = reinterpret_cast<const unsigned char *>(payload.constData());
+    int dataLen = payload.length();
+    qint64 stamp = frame.timeStamp().microSeconds();
+
+    if (s.frameCount > 0)
+    {
+        qint64 interval = (stamp > s.lastStamp) ? (stamp - s.lastStamp) : (s.lastStamp - stamp);
+        s.intervals.append(interval);
+        s.intervalSum += interval;
+        if (interval > s.maxInterval) s.maxInterval = interval;
+        if (interval < s.minInterval) s.minInterval = interval;
+    }
+    s.lastStamp = stamp;
+    s.frameCount++;
+    s.frameIdx.append(index);
+
+    if (dataLen > s.maxLen) s.maxLen = dataLen;
+    if (dataLen < s.minLen) s.minLen = dataLen;
+    if (!s.lengths.contains(dataLen)) s.lengths.append(dataLen);
+
+    int numBytes = qMin(dataLen, 8);
+    for (int c = 0; c < numBytes; c++)
+    {
+        unsigned char dat = data[c];
+        if (s.minData[c] > dat) s.minData[c] = dat;
+        if (s.maxData[c] < dat) s.maxData[c] = dat;
+        s.dataHistogram[dat * 8 + c]++;
+        for (int l = 0; l < 8; l++)
+        {
+            if (dat & (1 << l)) s.bitfieldHistogram[c * 8 + l]++;
+        }
+
+        if (!(s.seenBytes & (1 << c)))
+        {
+            s.seenBytes |= (1 << c);
+            s.referenceBytes[c] = dat;
+            s.lastBytes[c] = dat;
+            continue;
+        }
+        s.changedBits[c] |= s.referenceBytes[c] ^ dat;
+
+        uint8_t newBits = s.lastBytes[c] ^ dat; //bits changed since this byte was last seen
+        if (newBits)
+        {
+            for (int l = 0; l < 8; l++)
+            {
+                if (newBits & (1 << l)) s.bitFlips[(c * 8) + l]++;
+            }
+            s.lastBytes[c] = dat;
+        }
+    }
+}
+
+const IDStatistics *FrameStatistics::getStats(uint32_t ID) const
+{
+    auto it = stats.constFind(ID);
+    if (it == stats.constEnd()) return nullptr;
+    return &it.value();
+}
+
+QList<uint32_t> FrameStatistics::getIDs() const
+{
+    return stats.keys();
+}
+
+//intervals of the ID in ascending order, sorted again only when frames came in since the last call
+const QVector<qint64> &FrameStatistics::getSortedIntervals(uint32_t ID)
+{
+    auto it = stats.find(ID);
+    if (it == stats.end()) return noIntervals;
+    IDStatistics &s = it.value();
+    if (s.sortedIntervals.count() != s.intervals.count())
+    {
+        s.sortedIntervals = s.intervals;
+        std::sort(s.sortedIntervals.begin(), s.sortedIntervals.end());
+    }
+    return s.sortedIntervals;
+}
+
+/*
+ * For every signal the DBC has for this ID, how many frames carried each value (as text). Frames since the last
+ * call are decoded and added, a change to the DBC starts the counts over.
+ */
+const QHash<QString, QHash<QString, int>> &FrameStatistics::getSignalInstances(uint32_t ID, DBCHandler *handler)
+{
+    auto it = stats.find(ID);
+    if (it == stats.end() || !handler) return noSignalInstances;
+    if (frameEpoch != SignalValueStore::getFrameEpoch()) return noSignalInstances; //update() hasn't caught up yet
+    IDStatistics &s = it.value();
+
+    if (s.signalGeneration != DBCHandler::getLookupGeneration())
+    {
+        s.signalInstances.clear();
+        s.signalFramesScanned = 0;
+        s.signalGeneration = DBCHandler::getLookupGeneration();
+    }
+    if (s.signalFramesScanned == s.frameIdx.count()) return s.signalInstances;
+
+    DBC_MESSAGE *msg = handler->findMessageForFilter(ID, nullptr);
+    if (msg)
+    {
+        int numSignals = msg->sigHandler->getCount();
+        for (int j = s.signalFramesScanned; j < s.frameIdx.count(); j++)
+        {
+            const CANFrame &frame = frames->at(s.frameIdx.at(j));
+            for (int i = 0; i < numSignals; i++)
+            {
+                DBC_SIGNAL *sig = msg->sigHandler->findSignalByIdx(i);
+                if (sig && sig->isSignalInMessage(frame))
+                {
+                    QString sigVal;
+                    if (sig->processAsText(frame, sigVal, false)) s.signalInstances[sig->name][sigVal]++;
+                }
+            }
+        }
+    }
+    s.signalFramesScanned = s.frameIdx.count();
+    return s.signalInstances;
+}
@@ -0,0 +1,82 @@
+#ifndef FRAMESTATISTICS_H
+#define FRAMESTATISTICS_H
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QVector>
+#include "can_structs.h"
+
+class DBCHandler;
+
+/*
+ * Everything FrameInfoWindow shows about one message ID, accumulated frame by frame.
+ * Byte statistics cover the first 8 data bytes, same as the window's graphs and histograms.
+ */
+struct IDStatistics
+{
+    IDStatistics();
+
+    uint32_t ID;
+    bool extended; //taken from the first frame seen
+    int frameCount;
+    int minLen, maxLen;
+    QList<int> lengths; //every distinct data length seen, in the order they first showed up
+
+    //inter-frame intervals in microseconds. Gaps are taken whichever way doesn't go negative, so an unsorted list
+    //still gives sensible numbers
+    qint64 lastStamp;
+    qint64 minInterval, maxInterval;
+    qint64 intervalSum;
+    QVector<qint64> intervals; //in frame order
+
+    int minData[8], maxData[8];
+    QVector<int> dataHistogram; //256 counts per byte, index is value * 8 + byte
+    int bitfieldHistogram[64]; //how many frames had each bit set
+    int bitFlips[64]; //how many times each bit changed from one frame to the next
+    uint8_t referenceBytes[8]; //value each byte had the first time it was seen
+    uint8_t lastBytes[8];
+    uint8_t seenBytes; //bit per byte, set once that byte has been in a frame
+    uint8_t changedBits[8]; //bits that ever differed from the reference
+
+    QVector<int> frameIdx; //where this ID's frames are in the frame list
+
+    //cached on demand
+    QVector<qint64> sortedIntervals;
+    QHash<QString, QHash<QString, int>> signalInstances;
+    int signalFramesScanned;
+    quint32 signalGeneration;
+};
+
+/*
+ * Keeps an IDStatistics for every ID in a frame list up to date. update() only looks at frames appended since the
+ * last call so live capture costs a few counters per frame, and a newly loaded file gets a single pass. When the
+ * frames already in the list change (cleared, trimmed, sorted) everything is rebuilt, the frame model announces
+ * that through SignalValueStore::invalidateFrames.
+ *
+ * Sorted intervals and DBC signal value counts are only worked out when asked for since they're only ever wanted
+ * for the ID on screen. Both pick up where they left off on the next request.
+ */
+class FrameStatistics
+{
+public:
+    explicit FrameStatistics(const QVector<CANFrame> *frames);
+
+    bool update(QList<uint32_t> *newIDs = nullptr);
+    void clear();
+
+    const IDStatistics *getStats(uint32_t ID) const;
+    QList<uint32_t> getIDs() const;
+    const QVector<qint64> &getSortedIntervals(uint32_t ID);
+    const QHash<QString, QHash<QString, int>> &getSignalInstances(uint32_t ID, DBCHandler *handler);
+
+private:
+    void addFrame(IDStatistics &stats, const CANFrame &frame, int index);
+
+    const QVector<CANFrame> *frames;
+    QHash<uint32_t, IDStatistics> stats;
+    int processedFrames;
+    quint32 frameEpoch;
+};
+
+#endif // FRAMESTATISTICS_H
@@ -4,7 +4,10 @@
 #include "mainwindow.h"
 #include "helpwindow.h"
 #include "utility.h"
+#include "utils/signalextractor.h"
 #include <QDebug>
+#include <QtConcurrent/QtConcurrentMap>
+#include <QScreen>
 
 #include <algorithm>
 #include <limits>
@@ -77,6 +80,9 @@ GraphingWindow::GraphingWindow(const QVector<CANFrame> *frames, QWidget *parent)
     // make bottom and left axes transfer their ranges to top and right axes:
     connect(ui->graphingView->xAxis, SIGNAL(rangeChanged(QCPRange)), ui->graphingView->xAxis2, SLOT(setRange(QCPRange)));
     connect(ui->graphingView->yAxis, SIGNAL(rangeChanged(QCPRange)), ui->graphingView->yAxis2, SLOT(setRange(QCPRange)));
+    //the plot only holds what's visible, pick new points whenever the view moves or the plot changes size
+    connect(ui->graphingView->xAxis, SIGNAL(rangeChanged(QCPRange)), this, SLOT(xRangeChanged(QCPRange)));
+    connect(ui->graphingView, SIGNAL(afterLayout()), this, SLOT(plotLayoutChanged()));
 
     //connect(ui->graphingView, SIGNAL(titleDoubleClick(QMouseEvent*,QCPTextElement*)), this, SLOT(titleDoubleClick(QMouseEvent*,QCPTextElement*)));
     connect(ui->graphingView, SIGNAL(axisDoubleClick(QCPAxis*,QCPAxis::SelectablePart,QMouseEvent*)), this, SLOT(axisDoubleClick(QCPAxis*,QCPAxis::SelectablePart)));
@@ -112,6 +118,15 @@ GraphingWindow::GraphingWindow(const QVector<CANFrame> *frames, QWidget *parent)
 
     needScaleSetup = true;
     followGraphEnd = false;
+    lodColumns = 0;
+    graphRoutesDirty = true;
+
+    replotTimer = new QTimer(this);
+    replotTimer->setSingleShot(true);
+    QScreen *screen = QGuiApplication::primaryScreen();
+    double refreshRate = (screen && screen->refreshRate() > 0) ? screen->refreshRate() : 60.0;
+    replotTimer->setInterval(qMax(1, qRound(1000.0 / refreshRate)));
+    connect(replotTimer, &QTimer::timeout, this, &GraphingWindow::liveReplot);
 }
 
 GraphingWindow::~GraphingWindow()
@@ -179,21 +194,13 @@ void GraphingWindow::writeSettings()
 
 void GraphingWindow::updatedFrames(int numFrames)
 {
-    CANFrame thisFrame;
-    QVector<double> x, y;
-    bool appendedToGraph = false;
-    bool needReplot = false;
-
     if (numFrames == -1) //all frames deleted. Kill the display
     {
         //removeAllGraphs();
         //now instead of removing the graphs regenerate them which will blank them out but leave them there in case
         //more traffic that matches comes in or someone otherwise loads more data
         ui->graphingView->clearGraphs(); //temporarily remove the graphs from the graph view
-        for (int i = 0; i < graphParams.count(); i++)
-        {
-            createGraph(graphParams[i], false); //regenerate each one
-        }
+        regenerateGraphs();
         ui->graphingView->replot(); //now, redisplay them all
 
     }
@@ -203,60 +210,86 @@ void GraphingWindow::updatedFrames(int numFrames)
         //regenerate them instead
         ui->graphingView->clearGraphs(); //temporarily remove the graphs from the graph view
         //needScaleSetup = true;
-        for (int i = 0; i < graphParams.count(); i++)
-        {
-            createGraph(graphParams[i], false); //regenerate each one
-        }
+        regenerateGraphs();
         ui->graphingView->replot(); //now, redisplay them all
     }
     else //just got some new frames. See if they are relevant.
     {  
         if (numFrames > modelFrames->count()) return;
+        if (graphRoutesDirty) rebuildGraphRoutes();
 
-        for (int j = 0; j < graphParams.count(); j++)
+        QVector<bool> appended(graphParams.count(), false);
+        bool appendedToGraph = false;
+        for (int i = modelFrames->count() - numFrames; i < modelFrames->count(); i++)
         {
-            appendedToGraph = false;
-            x.clear();
-            y.clear();
-            for (int i = modelFrames->count() - numFrames; i < modelFrames->count(); i++)
+            const CANFrame &thisFrame = modelFrames->at(i);
+            auto route = graphRoutes.constFind(thisFrame.frameId());
+            if (route == graphRoutes.constEnd()) continue;
+            for (int j : route.value())
             {
-                thisFrame = modelFrames->at(i);
-                if ( graphParams[j].ID == thisFrame.frameId() && ( (graphParams[j].bus == -1) || (graphParams[j].bus == thisFrame.bus) ) )
-                {
-                    appendToGraph(graphParams[j], thisFrame, x, y);
-                    appendedToGraph = true;
-                }
-            }
-            if (appendedToGraph)
-            {
-                graphParams[j].ref->addData(x, y);
-                needReplot = true;
+                if ( (graphParams[j].bus != -1) && (graphParams[j].bus != thisFrame.bus) ) continue;
+                appendToGraph(graphParams[j], thisFrame);
+                appended[j] = true;
+                appendedToGraph = true;
             }
         }
+        if (!appendedToGraph) return;
 
-        if (needReplot)
+        for (int j = 0; j < graphParams.count(); j++)
         {
-            if (followGraphEnd)
-            {
-                //find the current X span and maintain that span but move the end of it over to match the new end
-                //of the actual graph. This causes the view to move with the data to always show the end
-                QCPRange range = ui->graphingView->xAxis->range();
-                double size = range.size();
-                bool foundRange;
-                QCPRange keyRange = ui->graphingView->graph()->getKeyRange(foundRange);
-                if (foundRange)
-                {
-                    double end, start;
-                    end = keyRange.upper;
-                    start = end - size;
-                    ui->graphingView->xAxis->setRange(start, end);
-                }
-            }
-            ui->graphingView->replot();
+            if (!appended[j]) continue;
+            if (followGraphEnd) trimFollowedGraph(graphParams[j]);
+            graphParams[j].lod.update(graphParams[j].x, graphParams[j].y);
         }
+
+        //frames come in far more often than the screen can show them, so replot at most once per refresh
+        if (!replotTimer->isActive()) replotTimer->start();
     }
 }
 
+/*
+ * Follow mode only ever shows the newest data so a graph doesn't have to keep growing without limit. Once it passes
+ * followMaxPoints the oldest quarter goes in one step, that keeps the cost of shifting the rest down rare.
+ */
+void GraphingWindow::trimFollowedGraph(GraphParams &params)
+{
+    if (params.x.count() <= followMaxPoints) return;
+    int drop = params.x.count() - (followMaxPoints - followMaxPoints / 4);
+    params.x.remove(0, drop);
+    params.y.remove(0, drop);
+    params.lod.clear(); //bucket indexes are all off now, update() right after this indexes the rest again
+}
+
+void GraphingWindow::liveReplot()
+{
+    if (followGraphEnd && !graphParams.isEmpty())
+    {
+        //find the current X span and maintain that span but move the end of it over to match the new end
+        //of the actual graph. This causes the view to move with the data to always show the end
+        //The plot only holds the points in view so ask the full series where it ends instead
+        QCPRange range = ui->graphingView->xAxis->range();
+        double size = range.size();
+        const GraphParams &lastParams = graphParams.last();
+        if (!lastParams.x.isEmpty())
+        {
+            double end, start;
+            end = lastParams.x.last();
+            start = end - size;
+            ui->graphingView->xAxis->setRange(start, end);
+        }
+    }
+    refreshAllGraphData();
+    ui->graphingView->replot();
+}
+
+//which graphs each message ID feeds, so new frames are only looked at once no matter how many graphs there are
+void GraphingWindow::rebuildGraphRoutes()
+{
+    graphRoutes.clear();
+    for (int j = 0; j < graphParams.count(); j++) graphRoutes[graphParams[j].ID].append(j);
+    graphRoutesDirty = false;
+}
+
 void GraphingWindow::plottableClick(QCPAbstractPlottable* plottable, int dataIdx, QMouseEvent* event)
 {
     Q_UNUSED(dataIdx);
@@ -589,6 +622,7 @@ void GraphingWindow::removeSelectedGraph()
         }
 
         graphParams.removeAt(idx);
+        graphRoutesDirty = true;
 
         ui->graphingView->removeGraph(ui->graphingView->selectedGraphs().constFirst());
 
@@ -630,14 +664,45 @@ void GraphingWindow::removeAllGraphs()
         ui->graphingView->clearGraphs();
         ui->graphingView->clearItems();
         graphParams.clear();
+        graphRoutesDirty = true;
         needScaleSetup = true;
         ui->graphingView->replot();
     }
 }
 
+/*
+ * The graphs only hold the points picked for the current view, so QCPAxis::rescale would just fit what is already on
+ * screen. Work out the extents of the full series of every visible graph on this axis instead.
+ */
 void GraphingWindow::rescaleAxis(QCPAxis *axis)
 {
-    axis->rescale(true);
+    bool found = false;
+    double lower = 0.0, upper = 0.0;
+    for (int i = 0; i < graphParams.count(); i++)
+    {
+        const GraphParams &params = graphParams[i];
+        if (!params.ref || !params.ref->visible()) continue;
+        bool isKey = (params.ref->keyAxis() == axis);
+        if (!isKey && params.ref->valueAxis() != axis) continue;
+
+        double xMin, xMax, yMin, yMax;
+        if (!params.lod.extents(params.x, params.y, xMin, xMax, yMin, yMax)) continue;
+        double graphLower = isKey ? xMin : yMin;
+        double graphUpper = isKey ? xMax : yMax;
+        if (!found || graphLower < lower) lower = graphLower;
+        if (!found || graphUpper > upper) upper = graphUpper;
+        found = true;
+    }
+    if (!found) return;
+
+    //a flat line gets the axis' current span centered on it, same as QCustomPlot does
+    if (lower == upper)
+    {
+        double halfSize = axis->range().size() / 2.0;
+        lower -= halfSize;
+        upper += halfSize;
+    }
+    axis->setRange(lower, upper);
 }
 
 void GraphingWindow::rescaleToData()
@@ -972,6 +1037,7 @@ void GraphingWindow::loadDefinitions()
 
         QFile inFile(filename);
         QByteArray line;
+        QList<GraphParams> pending; //graphs are built together once the whole file is read
 
         if (!inFile.open(QIODevice::ReadOnly | QIODevice::Text))
             return;
@@ -1033,7 +1099,7 @@ void GraphingWindow::loadDefinitions()
                        else qDebug() << "Couldn't find the message by name! " << tokens[21] << "  " << tokens[22];
                    }
 
-                   createGraph(gp, true);
+                   pending.append(gp);
                 }
                 else if (tokens[0] == "X") //second newest format based around signals
                 {
@@ -1081,7 +1147,7 @@ void GraphingWindow::loadDefinitions()
                        else qDebug() << "Couldn't find the message by name! " << tokens[20] << "  " << tokens[21];
                    }
 
-                   createGraph(gp, true);
+                   pending.append(gp);
                 }
                 else //one of the two older formats then
                 {
@@ -1109,7 +1175,7 @@ void GraphingWindow::loadDefinitions()
                                 gp.scale = (float)sig->factor;
                                 gp.startBit = sig->startBit;
                                 gp.stride = 1;
-                                createGraph(gp, true);
+                                pending.append(gp);
                             }
                         }
                     }
@@ -1194,12 +1260,18 @@ void GraphingWindow::loadDefinitions()
                             gp.graphName = tokens[11];
                         else
                             gp.graphName = QString();
-                        createGraph(gp, true);
+                        pending.append(gp);
                     }
                 }
             }
         }
         inFile.close();
+
+        QList<GraphParams *> graphs;
+        QVector<GraphSamples> samples;
+        for (int i = 0; i < pending.count(); i++) graphs.append(&pending[i]);
+        collectSamples(graphs, samples);
+        for (int i = 0; i < pending.count(); i++) plotGraph(pending[i], samples[i], true);
     }
 }
 
@@ -1220,6 +1292,7 @@ void GraphingWindow::showParamsDialog(int idx = -1)
         if (idx > -1) //if there was an existing graph then delete it
         {
             graphParams.removeAt(idx);
+            graphRoutesDirty = true;
             ui->graphingView->removeGraph(idx);
         }
         //create a new graph with the returned parameters.
@@ -1235,14 +1308,15 @@ void GraphingWindow::addNewGraph()
     showParamsDialog(-1);
 }
 
-void GraphingWindow::appendToGraph(GraphParams &params, CANFrame &frame, QVector<double> &x, QVector<double> &y)
+void GraphingWindow::appendToGraph(GraphParams &params, const CANFrame &frame)
 {
     params.strideSoFar++;
     if (params.strideSoFar >= params.stride)
     {
         params.strideSoFar = 0;
         int64_t tempVal; //64 bit temp value.
-        tempVal = Utility::processIntegerSignal(frame.payload(), params.startBit, params.numBits, params.intelFormat, params.isSigned); //& params.mask;
+        SignalExtractor extractor(params.startBit, params.numBits, params.intelFormat, params.isSigned);
+        tempVal = extractor.extract(frame.payload()); //& params.mask;
         double xVal, yVal;
         if (Utility::timeStyle == TS_SECONDS)
         {
@@ -1270,8 +1344,6 @@ void GraphingWindow::appendToGraph(GraphParams &params, CANFrame &frame, QVector
 
         params.x.append(xVal);
         params.y.append(yVal);
-        x.append(xVal);
-        y.append(yVal);
 
         //now see if we've got to do anything with the brackets and labels for value table stuff
         QString tempStr;
@@ -1322,79 +1394,216 @@ void GraphingWindow::appendToGraph(GraphParams &params, CANFrame &frame, QVector
     }
 }
 
-void GraphingWindow::createGraph(GraphParams &params, bool createGraphParam)
+/*
+ * A graph that shows a DBC signal exactly as the DBC defines it (same layout, every frame) can take its values from
+ * the shared signal value store. Returns null for anything else, those get decoded by collectSamples.
+ * With scanIfMissing false only series the store already has are returned.
+ */
+QSharedPointer<const SignalSeries> GraphingWindow::findSignalSeries(const GraphParams &params,
+                                                                    const QSharedPointer<const DBCSnapshot> &snapshot,
+                                                                    bool scanIfMissing)
 {
-    int64_t tempVal; //64 bit temp value.
-    double yminval=10000000.0, ymaxval = -1000000.0;
-    double xminval=10000000000.0, xmaxval = -10000000000.0;
-    GraphParams *refParam = &params;
-    QString tempStr;
-    double x{}, y{};
+    const DBC_SIGNAL *sig = params.associatedSignal;
+    if (!sig || params.stride != 1) return QSharedPointer<const SignalSeries>();
+    if (params.startBit != sig->startBit || params.numBits != sig->signalSize || params.intelFormat != sig->intelByteOrder
+        || params.isSigned != (sig->valType == SIGNED_INT)) return QSharedPointer<const SignalSeries>();
+
+    const DBCSnapshot::Signal *snapSig = snapshot->findSignal(params.associatedSignal);
+    if (!snapSig) return QSharedPointer<const SignalSeries>();
+    SignalValueStore *store = SignalValueStore::getReference();
+    if (scanIfMissing) return store->getSeries(modelFrames, snapshot, snapSig, params.ID, params.bus);
+    return store->getCachedSeries(modelFrames, snapshot, snapSig, params.ID, params.bus);
+}
 
-    qDebug() << "New Graph ID: " << params.ID;
-    qDebug() << "Start bit: " << params.startBit;
-    qDebug() << "Data length: " << params.numBits;
-    qDebug() << "Intel Mode: " << params.intelFormat;
-    qDebug() << "Signed: " << params.isSigned;
-    qDebug() << "Mask: " << params.mask;
+/*
+ * Gets the samples of every graph in one go. Graphs the value store already has are taken from there. For the rest
+ * the model's frames are walked once, each frame is routed by ID to the graphs that want it, then every graph's
+ * frames are decoded on the thread pool. Workers only read the frame list and the DBC snapshot, the GUI thread
+ * waits for them so neither changes underneath.
+ */
+void GraphingWindow::collectSamples(const QList<GraphParams *> &graphs, QVector<GraphSamples> &samples)
+{
+    QSharedPointer<const DBCSnapshot> snapshot = dbcHandler->getSnapshot();
+    QVector<DecodeJob> jobs;
+    QHash<uint32_t, QVector<int>> jobsByID;
+
+    samples.clear();
+    samples.resize(graphs.count());
+    jobs.reserve(graphs.count());
+
+    for (int i = 0; i < graphs.count(); i++)
+    {
+        const GraphParams &params = *graphs[i];
+
+        //a lone graph may as well fill the store, that scan is the single pass anyway
+        QSharedPointer<const SignalSeries> series = findSignalSeries(params, snapshot, graphs.count() == 1);
+        if (series && series->count() > 0)
+        {
+            //already decoded and multiplex filtered by the store. These copies just share its columns as long as
+            //they are only read (at(), never operator[])
+            samples[i].stamps = series->timestamps;
+            samples[i].raw = series->raw;
+            samples[i].values = series->values;
+            samples[i].valid = series->valid;
+            continue;
+        }
+
+        DecodeJob job;
+        job.frames = modelFrames;
+        job.ID = params.ID;
+        job.bus = params.bus;
+        job.startBit = params.startBit;
+        job.numBits = params.numBits;
+        job.intelFormat = params.intelFormat;
+        job.isSigned = params.isSigned;
+        job.stride = qMax(params.stride, 1);
+        job.sig = snapshot->findSignal(params.associatedSignal);
+        job.out = &samples[i];
+        jobsByID[params.ID].append(jobs.count());
+        jobs.append(job);
+    }
+
+    if (jobs.isEmpty()) return;
 
-    frameCache.clear();
     for (int i = 0; i < modelFrames->count(); i++)
     {
-        CANFrame thisFrame = modelFrames->at(i);
-        if ( (thisFrame.frameId() == params.ID) && (thisFrame.frameType() == QCanBusFrame::DataFrame)
-       &&  ( ( params.bus == -1) ||  (params.bus == thisFrame.bus) ) ) frameCache.append(thisFrame);
+        const CANFrame &thisFrame = modelFrames->at(i);
+        if (thisFrame.frameType() != QCanBusFrame::DataFrame) continue;
+        auto it = jobsByID.constFind(thisFrame.frameId());
+        if (it == jobsByID.constEnd()) continue;
+        for (int j : it.value())
+        {
+            if (jobs[j].bus == -1 || jobs[j].bus == thisFrame.bus) jobs[j].frameIdx.append(i);
+        }
     }
 
+    if (jobs.count() == 1) decodeJob(jobs[0]);
+    else QtConcurrent::blockingMap(jobs, decodeJob);
+}
+
+//runs on a pool thread, only touches the job, the frame list and the snapshot signal
+void GraphingWindow::decodeJob(DecodeJob &job)
+{
+    QVector<CANFrame> sampled;
+
     //to fix weirdness where a graph that has no data won't be able to be edited, selected, or deleted properly
     //we'll check for the condition that there is nothing to graph and add a single dummy frame to the cache
     //that has all data bytes = 0. This allows the graph to be edited and deleted. No idea why you can't otherwise.
-    if (frameCache.count() == 0)
+    if (job.frameIdx.isEmpty())
     {
         CANFrame dummy;
-        dummy.setFrameId(params.ID);
+        dummy.setFrameId(job.ID);
         dummy.bus = 0;
         dummy.setPayload(QByteArray(8, 0));
         dummy.setFrameType(QCanBusFrame::DataFrame);
-        frameCache.append(dummy);
+        sampled.append(dummy);
+    }
+    else
+    {
+        int numEntries = job.frameIdx.count() / job.stride;
+        if (numEntries < 1) numEntries = 1; //could happen if stride is larger than frame count
+        sampled.reserve(numEntries);
+        for (int j = 0; j < numEntries; j++) sampled.append(job.frames->at(job.frameIdx.at(j * job.stride)));
+    }
+    job.frameIdx = QVector<int>(); //not needed anymore, give the memory back before the decode allocates
+
+    int numEntries = sampled.count();
+    GraphSamples &out = *job.out;
+
+    //decode every sampled frame in bulk up front, plotGraph just picks the values up
+    SignalExtractor extractor(job.startBit, job.numBits, job.intelFormat, job.isSigned);
+    out.raw.resize(numEntries);
+    extractor.extractBatch(sampled.constData(), numEntries, 1, out.raw.data());
+
+    if (job.sig)
+    {
+        out.values.resize(numEntries);
+        out.valid.resize(numEntries);
+        job.sig->decodeBatchAsDouble(sampled.constData(), numEntries, out.values.data(), out.valid.data());
     }
 
-    int numEntries = frameCache.count() / params.stride;
-    if (numEntries < 1) numEntries = 1; //could happen if stride is larger than frame count
+    //keep only the samples this signal is actually in (multiplexing), same as the store does
+    int kept = 0;
+    out.stamps.resize(numEntries);
+    for (int j = 0; j < numEntries; j++)
+    {
+        const CANFrame &thisFrame = sampled.at(j);
+        if (job.sig)
+        {
+            if (!job.sig->isInFrame(thisFrame)) continue;
+            out.values[kept] = out.values[j];
+            out.valid[kept] = out.valid[j];
+        }
+        out.raw[kept] = out.raw[j];
+        out.stamps[kept] = thisFrame.timeStamp().microSeconds();
+        kept++;
+    }
+    out.stamps.resize(kept);
+    out.raw.resize(kept);
+    if (job.sig)
+    {
+        out.values.resize(kept);
+        out.valid.resize(kept);
+    }
+}
+
+void GraphingWindow::createGraph(GraphParams &params, bool createGraphParam)
+{
+    QVector<GraphSamples> samples;
+    collectSamples(QList<GraphParams *>() << &params, samples);
+    plotGraph(params, samples[0], createGraphParam);
+}
+
+//rebuilds every graph from the model's frames, all of them decoded in one pass
+void GraphingWindow::regenerateGraphs()
+{
+    QList<GraphParams *> graphs;
+    QVector<GraphSamples> samples;
+    for (int i = 0; i < graphParams.count(); i++) graphs.append(&graphParams[i]);
+    collectSamples(graphs, samples);
+    for (int i = 0; i < graphParams.count(); i++)
+    {
+        plotGraph(graphParams[i], samples[i], false);
+    }
+}
+
+void GraphingWindow::plotGraph(GraphParams &params, const GraphSamples &samples, bool createGraphParam)
+{
+    int64_t tempVal; //64 bit temp value.
+    double yminval=10000000.0, ymaxval = -1000000.0;
+    double xminval=10000000000.0, xmaxval = -10000000000.0;
+    GraphParams *refParam = &params;
+    QString tempStr;
+    double x{}, y{};
+
+    qDebug() << "New Graph ID: " << params.ID;
+    qDebug() << "Start bit: " << params.startBit;
+    qDebug() << "Data length: " << params.numBits;
+    qDebug() << "Intel Mode: " << params.intelFormat;
+    qDebug() << "Signed: " << params.isSigned;
+    qDebug() << "Mask: " << params.mask;
+
+    const QVector<qint64> &stamps = samples.stamps;
+    const QVector<int64_t> &rawVals = samples.raw;
+    const QVector<double> &sigVals = samples.values;
+    const QVector<bool> &sigValid = samples.valid;
+    int numEntries = stamps.count();
+    bool haveSigVals = (sigValid.count() == numEntries);
 
     params.x.clear();
     params.y.clear();
     params.x.reserve(numEntries);
     params.y.reserve(numEntries);
-    //params.x.fill(0, numEntries);
-    //params.y.fill(0, numEntries);
-
-    int sBit = params.startBit;
-    int bits = params.numBits;
-    bool intelFormat = params.intelFormat;
-    bool isSigned = params.isSigned;
 
     for (int j = 0; j < numEntries; j++)
     {
-        int k = j * params.stride;
-        if (params.associatedSignal)
-        {
-            //skip all the rest of the stuff in this loop and don't add this to the graph if this signal isn't in this frame
-            if (!params.associatedSignal->isSignalInMessage(frameCache[k]))
-            {
-                qDebug() << "Signal was not in this frame";
-                continue;
-            }
-            else qDebug() << "Signal in the frame!";
-        }
-        tempVal = Utility::processIntegerSignal(frameCache[k].payload(), sBit, bits, intelFormat, isSigned); //& params.mask;
-        //qDebug() << tempVal;
+        tempVal = rawVals.at(j); //& params.mask;
 
-        if (params.associatedSignal)
+        if (params.associatedSignal && haveSigVals)
         {
-            //if for some reason the processAsDouble fails we'll fall back on manual approach
-            if (!params.associatedSignal->processAsDouble(frameCache[k], y))
-                y = (tempVal * params.scale) + params.bias;
+            //if for some reason the signal couldn't be decoded we'll fall back on manual approach
+            if (sigValid.at(j)) y = sigVals.at(j);
+            else y = (tempVal * params.scale) + params.bias;
         }
         else y = (tempVal * params.scale) + params.bias;
 
@@ -1402,16 +1611,16 @@ void GraphingWindow::createGraph(GraphParams &params, bool createGraphParam)
 
         if (Utility::timeStyle == TS_SECONDS)
         {
-            x = (frameCache[k].timeStamp().microSeconds()) / 1000000.0;
+            x = stamps.at(j) / 1000000.0;
         }
         else if (Utility::timeStyle == TS_CLOCK)
         {
-            QDateTime dt = QDateTime::fromMSecsSinceEpoch((frameCache[k].timeStamp().microSeconds() / 1000) - params.xbias);
+            QDateTime dt = QDateTime::fromMSecsSinceEpoch((stamps.at(j) / 1000) - params.xbias);
             x = (dt.time().msecsSinceStartOfDay() / 1000.0);
         }
         else
         {
-            x = frameCache[k].timeStamp().microSeconds();
+            x = stamps.at(j);
         }
 
         params.x.append( x );
@@ -1500,6 +1709,7 @@ void GraphingWindow::createGraph(GraphParams &params, bool createGraphParam)
     if (createGraphParam)
     {
         graphParams.append(params);
+        graphRoutesDirty = true;
         refParam = &graphParams.last();
     }
 
@@ -1516,7 +1726,8 @@ void GraphingWindow::createGraph(GraphParams &params, bool createGraphParam)
     ui->graphingView->graph()->setName(params.graphName);
     ui->graphingView->graph()->setProperty("id", params.ID);
 
-    ui->graphingView->graph()->setData(refParam->x,refParam->y);
+    refParam->lod.rebuild(refParam->x, refParam->y);
+    refreshGraphData(*refParam);
 
     ui->graphingView->graph()->setScatterStyle(QCPScatterStyle((QCPScatterStyle::ScatterShape)params.pointType));
 
@@ -1567,6 +1778,48 @@ void GraphingWindow::createGraph(GraphParams &params, bool createGraphParam)
     ui->graphingView->replot();
 }
 
+/*
+ * Hands the plot the points of a graph that are within the current X range, about two per pixel column (the min and
+ * max of each column's worth of samples) once there are more than that. Zooming in far enough shows every sample.
+ * QCustomPlot doesn't have to sort, store or walk millions of points this way and spikes still show up zoomed out.
+ */
+void GraphingWindow::refreshGraphData(GraphParams &params)
+{
+    if (!params.ref) return;
+    QCPRange range = ui->graphingView->xAxis->range();
+    int columns = qMax(ui->graphingView->axisRect()->width(), 1);
+    QVector<double> x, y;
+    params.lod.query(params.x, params.y, range.lower, range.upper, columns, x, y);
+    params.ref->setData(x, y, params.lod.isMonotonic());
+
+    if (params.ref->selected()) //keep the whole graph selected, the selection is in data indexes
+    {
+        QCPDataSelection sel;
+        sel.addDataRange(QCPDataRange(0, params.ref->dataCount()));
+        params.ref->setSelection(sel);
+    }
+}
+
+void GraphingWindow::refreshAllGraphData()
+{
+    lodColumns = ui->graphingView->axisRect()->width();
+    for (int i = 0; i < graphParams.count(); i++) refreshGraphData(graphParams[i]);
+}
+
+void GraphingWindow::xRangeChanged(const QCPRange &range)
+{
+    Q_UNUSED(range);
+    refreshAllGraphData();
+}
+
+void GraphingWindow::plotLayoutChanged()
+{
+    //only worth redoing when the plot got wider than what the data was picked for
+    if (ui->graphingView->axisRect()->width() <= lodColumns) return;
+    refreshAllGraphData();
+    ui->graphingView->replot(QCustomPlot::rpQueuedReplot);
+}
+
 void GraphingWindow::moveLegend()
 {
     qDebug() << "moveLegend";
@@ -4,8 +4,12 @@
 #include "qcustomplot.h"
 #include "can_structs.h"
 #include "dbc/dbchandler.h"
+#include "dbc/signalvaluestore.h"
+#include "utils/minmaxpyramid.h"
 
 #include <QDialog>
+#include <QHash>
+#include <QTimer>
 
 namespace Ui {
 class GraphingWindow;
@@ -37,6 +41,7 @@ public:
 
     //the below stuff is used for internal purposes only - code should be refactored so these can be private
     QVector<double> x, y;
+    MinMaxPyramid lod; //what actually gets handed to the plot is picked from x, y through this
     double xbias;
     int64_t prevValTable;
     QPointF prevValLocation;
@@ -80,13 +85,16 @@ private slots:
     void rescaleToData();
     void toggleFollowMode();
     void addNewGraph();    
-    void appendToGraph(GraphParams &params, CANFrame &frame, QVector<double> &x, QVector<double> &y);
+    void appendToGraph(GraphParams &params, const CANFrame &frame);
     void editSelectedGraph();
     void updatedFrames(int);
     void gotCenterTimeID(uint32_t ID, double timestamp);
     void resetView();
     void zoomIn();
     void zoomOut();
+    void xRangeChanged(const QCPRange &range);
+    void plotLayoutChanged();
+    void liveReplot();
 
 signals:
     void sendCenterTimeID(uint32_t ID, double timestamp);
@@ -94,7 +102,6 @@ signals:
 private:
     Ui::GraphingWindow *ui;
     DBCHandler *dbcHandler;
-    QList<CANFrame> frameCache;
     const QVector<CANFrame> *modelFrames;
     QList<GraphParams> graphParams;
     QPen selectedPen;
@@ -104,8 +111,48 @@ private:
     bool needScaleSetup; //do we need to set x,y graphing extents?
     bool useOpenGL;
     bool followGraphEnd;
+    int lodColumns; //plot width the graph data was last picked for
+    QHash<uint32_t, QVector<int>> graphRoutes; //message ID -> indexes into graphParams
+    bool graphRoutesDirty;
+    QTimer *replotTimer;
+
+    static const int followMaxPoints = 2000000; //per graph, older points are dropped past this in follow mode
+
+    //samples of one graph, what plotGraph turns into points
+    struct GraphSamples
+    {
+        QVector<qint64> stamps; //microseconds
+        QVector<int64_t> raw;
+        QVector<double> values; //only for graphs with a DBC signal, same length as stamps then
+        QVector<bool> valid;
+    };
+
+    //one graph's share of a collectSamples pass. Everything a pool thread needs without going near GraphParams
+    struct DecodeJob
+    {
+        const QVector<CANFrame> *frames;
+        QVector<int> frameIdx; //indexes into frames of the graph's ID and bus, in order
+        uint32_t ID;
+        int bus;
+        int startBit, numBits;
+        bool intelFormat;
+        bool isSigned;
+        int stride;
+        const DBCSnapshot::Signal *sig;
+        GraphSamples *out;
+    };
 
     void showParamsDialog(int idx);
+    void refreshGraphData(GraphParams &params);
+    void refreshAllGraphData();
+    QSharedPointer<const SignalSeries> findSignalSeries(const GraphParams &params,
+                                                        const QSharedPointer<const DBCSnapshot> &snapshot, bool scanIfMissing);
+    void collectSamples(const QList<GraphParams *> &graphs, QVector<GraphSamples> &samples);
+    static void decodeJob(DecodeJob &job);
+    void plotGraph(GraphParams &params, const GraphSamples &samples, bool createGraphParam);
+    void regenerateGraphs();
+    void rebuildGraphRoutes();
+    void trimFollowedGraph(GraphParams &params);
     void closeEvent(QCloseEvent *event);
     void readSettings();
     void writeSettings();
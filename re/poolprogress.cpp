@@ -0,0 +1,44 @@
+#include "poolprogress.h"
+#include <QProgressDialog>
+
+PoolProgress::PoolProgress(QWidget *parent, QFutureWatcherBase *watcher, const QString &label)
+{
+    this->parent = parent;
+    this->watcher = watcher;
+    this->label = label;
+    dialog = nullptr;
+}
+
+//call right before handing the watcher its future
+void PoolProgress::start(int jobCount)
+{
+    if (!dialog)
+    {
+        dialog = new QProgressDialog(parent);
+        dialog->setWindowModality(Qt::WindowModal);
+        dialog->setLabelText(label);
+        dialog->setMinimumDuration(0);
+        dialog->setAutoClose(false);
+        dialog->setAutoReset(false);
+        QObject::connect(dialog, &QProgressDialog::canceled, watcher, &QFutureWatcherBase::cancel);
+        QObject::connect(watcher, &QFutureWatcherBase::progressRangeChanged, dialog, &QProgressDialog::setRange);
+        QObject::connect(watcher, &QFutureWatcherBase::progressValueChanged, dialog, &QProgressDialog::setValue);
+    }
+    dialog->reset();
+    dialog->setRange(0, jobCount);
+    dialog->show();
+}
+
+void PoolProgress::finish()
+{
+    if (dialog) dialog->hide();
+}
+
+void PoolProgress::stop()
+{
+    if (watcher->isRunning())
+    {
+        watcher->cancel();
+        watcher->waitForFinished();
+    }
+}
@@ -0,0 +1,34 @@
+#ifndef POOLPROGRESS_H
+#define POOLPROGRESS_H
+
+#include <QFutureWatcher>
+#include <QString>
+
+class QProgressDialog;
+class QWidget;
+
+/*
+ * Progress dialog for a QtConcurrent job a window runs on the thread pool. The dialog follows the watcher's
+ * progress and its cancel button cancels the job. Made the first time a job starts and reused after that.
+ *
+ * The window owns the watcher and keeps handling its results and finished signal itself, this only drives the
+ * dialog. stop() cancels a running job and waits for it, windows call it before starting a new job and in their
+ * destructor so no worker is left reading their data.
+ */
+class PoolProgress
+{
+public:
+    PoolProgress(QWidget *parent, QFutureWatcherBase *watcher, const QString &label);
+
+    void start(int jobCount);
+    void finish();
+    void stop();
+
+private:
+    QWidget *parent;
+    QFutureWatcherBase *watcher;
+    QString label;
+    QProgressDialog *dialog;
+};
+
+#endif // POOLPROGRESS_H
@@ -2,8 +2,12 @@
 #include "ui_rangestatewindow.h"
 #include "mainwindow.h"
 #include "utility.h"
+#include "utils/signalextractor.h"
 #include "helpwindow.h"
 #include "filterutility.h"
+#include <QtConcurrent/QtConcurrentMap>
+#include <QtEndian>
+#include <algorithm>
 
 RangeStateWindow::RangeStateWindow(const QVector<CANFrame> *frames, QWidget *parent) :
     QDialog(parent),
@@ -77,10 +81,17 @@ RangeStateWindow::RangeStateWindow(const QVector<CANFrame> *frames, QWidget *par
     connect(ui->btnRecalc, &QAbstractButton::clicked, this, &RangeStateWindow::recalcButton);
     connect(MainWindow::getReference(), SIGNAL(framesUpdated(int)), this, SLOT(updatedFrames(int)));
     connect(ui->listCandidates, &QListWidget::currentRowChanged, this, &RangeStateWindow::clickedSignalList);
+
+    searchWatcher = new QFutureWatcher<RangeSearchResult>(this);
+    searchProgress = new PoolProgress(this, searchWatcher, "Calculating");
+    connect(searchWatcher, &QFutureWatcher<RangeSearchResult>::resultsReadyAt, this, &RangeStateWindow::searchResultsReady);
+    connect(searchWatcher, &QFutureWatcher<RangeSearchResult>::finished, this, &RangeStateWindow::searchFinished);
 }
 
 RangeStateWindow::~RangeStateWindow()
 {
+    searchProgress->stop();
+    delete searchProgress;
     delete ui;
 }
 
@@ -190,42 +201,43 @@ void RangeStateWindow::refreshFilterList()
 
 void RangeStateWindow::recalcButton()
 {
-    QMap<int, bool>::iterator iter;
-    uint32_t id;
+    searchProgress->stop();
 
     ui->listCandidates->clear();
     foundSignals.clear();
+    foundOrder.clear();
     ui->graphSignal->clearGraphs();
 
-    QProgressDialog progress(qApp->activeWindow());
-    progress.setWindowModality(Qt::WindowModal);
-    progress.setLabelText("Calculating");
-    progress.setCancelButton(0);
-    progress.setRange(0,0);
-    progress.setMinimumDuration(0);
-    progress.show();
+    QVector<RangeSearchJob> jobs = signalsFactory();
+    if (jobs.isEmpty()) return;
 
+    searchProgress->start(jobs.count());
 
+    //every signal size of every ID is its own job on the thread pool. Found signals show up in the list as jobs finish
+    searchWatcher->setFuture(QtConcurrent::mapped(jobs, &RangeStateWindow::searchCandidates));
+}
 
-    for (iter = idFilters.begin(); iter != idFilters.end(); ++iter)
+void RangeStateWindow::searchResultsReady(int begin, int end)
+{
+    for (int i = begin; i < end; i++)
     {
-        if (iter.value() == true)
+        RangeSearchResult result = searchWatcher->resultAt(i);
+        if (result.found.isEmpty()) continue;
+
+        //jobs finish in any order, keep the list in ranking order anyway
+        int pos = static_cast<int>(std::upper_bound(foundOrder.begin(), foundOrder.end(), result.order) - foundOrder.begin());
+        for (int j = 0; j < result.found.count(); j++)
         {
-            qDebug() << "Processing for ID: " << iter.key();
-            //so, we're supposed to process this frame ID. We'll need to create a frame cache for it
-            frameCache.clear();
-            frameCache.reserve(modelFrames->count()); //block allocate more than enough space
-            id = iter.key();
-            for (int j = 0; j < modelFrames->count(); j++)
-            {
-                if (modelFrames->at(j).frameId() == id) frameCache.append(modelFrames->at(j));
-            }
-            //now we've got a list with all the same ID. Time to send it off for processing
-            signalsFactory();
+            foundSignals.insert(pos + j, result.found.at(j));
+            foundOrder.insert(pos + j, result.order);
+            ui->listCandidates->insertItem(pos + j, describeSignal(result.found.at(j)));
         }
     }
+}
 
-    progress.cancel();
+void RangeStateWindow::searchFinished()
+{
+    searchProgress->finish();
     qDebug() << "Found " << foundSignals.count() << " signals total.";
 }
 
@@ -234,162 +246,197 @@ void RangeStateWindow::recalcButton()
  * The user could specify signal sizes, granularity, endian type and we generate all the permutations from there
  * Should process from max to min and stop when a valid signal is found (at least as an option) to declutter a bit.
  * Mostly what we're interested in is the largest signal that matches
+ *
+ * The frames of every selected ID are gathered in one pass over the model and their payloads turned into words
+ * here, the jobs then only ever read those arrays.
 */
-void RangeStateWindow::signalsFactory()
+QVector<RangeSearchJob> RangeStateWindow::signalsFactory()
 {
     int minSig = ui->spinMinSigSize->value();
     int maxSig = ui->spinMaxSigSize->value();
     int granularity = ui->spinGranularity->value();
     int sigType = ui->cbSignalMode->currentIndex() + 1;
     int signedType = ui->cbSignedMode->currentIndex() + 1;
-    int maxBits = frameCache.at(0).payload().length() * 8;
     int sens = ui->slideSensitivity->value();
+    QVector<RangeSearchJob> jobs;
 
-    for (int sigSize = maxSig; sigSize >= minSig; sigSize -= granularity)
+    if (granularity < 1) return jobs;
+
+    QMap<uint32_t, QSharedPointer<RangeSearchData>> searchData;
+    for (QMap<int, bool>::const_iterator iter = idFilters.constBegin(); iter != idFilters.constEnd(); ++iter)
+    {
+        if (iter.value() == true) searchData.insert(static_cast<uint32_t>(iter.key()), QSharedPointer<RangeSearchData>());
+    }
+
+    for (int j = 0; j < modelFrames->count(); j++)
     {
-        qApp->processEvents();
-        for (int startBit = 0; startBit < maxBits; startBit += granularity)
+        const CANFrame &frame = modelFrames->at(j);
+        auto it = searchData.find(frame.frameId());
+        if (it == searchData.end()) continue;
+        const QByteArray payload = frame.payload();
+        if (!it.value())
         {
-            if (sigType & 1)
-            {
-                if (signedType & 1) processSignal(startBit, sigSize, sens, true, true);
-                if (signedType & 2) processSignal(startBit, sigSize, sens, true, false);
-            }
-            if (sigType & 2)
+            it.value().reset(new RangeSearchData);
+            it.value()->ID = frame.frameId();
+            it.value()->maxBits = payload.length() * 8;
+        }
+        RangeSearchData *data = it.value().data();
+        unsigned char bytes[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+        memcpy(bytes, payload.constData(), qMin(payload.length(), 8));
+        data->littleWords.append(qFromLittleEndian<quint64>(bytes));
+        data->bigWords.append(qFromBigEndian<quint64>(bytes));
+        data->lengths.append(static_cast<quint8>(qMin(payload.length(), 255)));
+        if (data->maxBits > 64) data->frames.append(frame);
+    }
+
+    for (auto it = searchData.constBegin(); it != searchData.constEnd(); ++it)
+    {
+        if (!it.value()) continue; //checked but no frames
+        qDebug() << "Processing for ID: " << it.key();
+        for (int sigSize = maxSig; sigSize >= minSig; sigSize -= granularity)
+        {
+            RangeSearchJob job;
+            job.data = it.value();
+            job.order = jobs.count();
+            job.sigSize = sigSize;
+            job.granularity = granularity;
+            job.sigType = sigType;
+            job.signedType = signedType;
+            job.sensitivity = sens;
+            jobs.append(job);
+        }
+    }
+    return jobs;
+}
+
+//runs on a pool thread. Tries every candidate of one signal size the same way the search always has
+RangeSearchResult RangeStateWindow::searchCandidates(const RangeSearchJob &job)
+{
+    RangeSearchResult result;
+    result.order = job.order;
+    QVector<int64_t> values; //reused by every candidate of this job
+    const RangeSearchData &data = *job.data;
+
+    for (int startBit = 0; startBit < data.maxBits; startBit += job.granularity)
+    {
+        for (int endian = 0; endian < 2; endian++)
+        {
+            bool bigEndian = (endian == 0);
+            if (!(job.sigType & (bigEndian ? 1 : 2))) continue;
+            for (int sign = 0; sign < 2; sign++)
             {
-                if (signedType & 1) processSignal(startBit, sigSize, sens, false, true);
-                if (signedType & 2) processSignal(startBit, sigSize, sens, false, false);
+                bool isSigned = (sign == 0);
+                if (!(job.signedType & (isSigned ? 1 : 2))) continue;
+                //have to try both types even with 8 bit and smaller signals
+                //because they could cross byte boundaries. Could check whether they
+                //do and not try both types if it is impossible.
+                if (!processSignal(data, startBit, job.sigSize, job.sensitivity, bigEndian, isSigned, values)) continue;
+
+                int64_t foundSig;
+                foundSig = data.ID;
+                foundSig += (int64_t)startBit << 32;
+                foundSig += (int64_t)job.sigSize << 40;
+                if (isSigned) foundSig += (int64_t)1 << 48;
+                if (bigEndian) foundSig += (int64_t)1 << 49;
+                result.found.append(foundSig);
             }
-            //have to try both types even with 8 bit and smaller signals
-            //because they could cross byte boundaries. Could check whether they
-            //do and not try both types if it is impossible.
         }
     }
+    return result;
 }
 
 /*
  * Given the signal we generate the relevant data and figure out whether this signal seems to be a smooth range signal
+ *
+ * Signals inside the first 8 bytes are cut straight out of the pre-built words with a shift and a mask, which the
+ * compiler can vectorize. Anything further into a CAN FD payload goes through SignalExtractor. Both give 0 for frames
+ * too short to hold the signal, same as always. The first and second order differences are then counted in a
+ * single pass instead of being stored.
 */
-bool RangeStateWindow::processSignal(int startBit, int bitLength, int sensitivity, bool bigEndian, bool isSigned)
+bool RangeStateWindow::processSignal(const RangeSearchData &data, int startBit, int bitLength, int sensitivity,
+                                     bool bigEndian, bool isSigned, QVector<int64_t> &values)
 {
-    qDebug() << "";
-    qDebug() << "S:" << startBit << " B:" << bitLength << " Sens:" << sensitivity << " Big E:" << bigEndian << " Signed: " << isSigned;
-
-    QVector<int> scaledVals;
-    QVector<int> diff1;
-    QVector<int> diff2;
-    int64_t valu;
-    int64_t highestValue = -1000000000000LL;
-    int64_t lowestValue = 1000000000000LL;
+    int numFrames = data.lengths.count();
     double lerpPoint = ((double)sensitivity - 10.0) / 240.0;
-    int numFrames = frameCache.count();
-
-    scaledVals.reserve(frameCache.count());
-    diff1.reserve(frameCache.count() - 1);
-    diff2.reserve(frameCache.count() - 2);
+    if (bitLength < 1 || bitLength > 64 || numFrames == 0) return false;
 
-    int i;
+    int firstByte = startBit / 8;
+    int lead = bigEndian ? (7 - (startBit % 8)) : (startBit % 8);
+    int lastByte = bigEndian ? (firstByte + (lead + bitLength - 1) / 8) : ((startBit + bitLength - 1) / 8);
 
-    for (i = 0; i < numFrames; i++)
+    values.resize(numFrames);
+    int64_t *vals = values.data();
+    if (lastByte < 8)
     {
-        valu = Utility::processIntegerSignal(frameCache.at(i).payload(), startBit, bitLength, !bigEndian, isSigned);
-        if (valu < lowestValue) lowestValue = valu;
-        if (valu > highestValue) highestValue = valu;
+        const quint64 *words = bigEndian ? data.bigWords.constData() : data.littleWords.constData();
+        const quint8 *lengths = data.lengths.constData();
+        int shiftUp = bigEndian ? (firstByte * 8 + lead) : (64 - startBit - bitLength);
+        int shiftDown = 64 - bitLength;
+        uint64_t signBit = (isSigned && bitLength < 64) ? (1ULL << (bitLength - 1)) : 0;
+        int needed = lastByte + 1;
+        for (int i = 0; i < numFrames; i++)
+        {
+            uint64_t v = (words[i] << shiftUp) >> shiftDown;
+            v = (v ^ signBit) - signBit;
+            v &= 0 - static_cast<uint64_t>(lengths[i] >= needed); //too short a payload reads as 0
+            vals[i] = static_cast<int64_t>(v);
+        }
+    }
+    else
+    {
+        if (data.frames.count() != numFrames) return false; //only CAN FD payloads reach past byte 8
+        SignalExtractor extractor(startBit, bitLength, !bigEndian, isSigned);
+        extractor.extractBatch(data.frames.constData(), numFrames, 1, vals);
     }
 
-    qDebug() << "Min: " << lowestValue << " Max: " << highestValue;
+    int64_t highestValue = vals[0];
+    int64_t lowestValue = vals[0];
+    for (int i = 1; i < numFrames; i++)
+    {
+        if (vals[i] < lowestValue) lowestValue = vals[i];
+        if (vals[i] > highestValue) highestValue = vals[i];
+    }
 
     if (lowestValue == highestValue) return false; //a signal that never changes is worthless and not a range signal
 
     int64_t range = highestValue - lowestValue;
 
-    int64_t maxRange = isSigned?(1<<(bitLength - 1)):(1 << bitLength);
+    int64_t maxRange = isSigned?(1LL << (bitLength - 1)):(1LL << qMin(bitLength, 62));
     //at highest sensitivity require signal to at least range 20% of max range
     //at lowest  sensitivity require signal to at least range 1%  of max range
     int64_t requiredRange = Utility::Lerp(maxRange * 0.01, maxRange * 0.2, lerpPoint);
     if (range < requiredRange)
         return false; //doesn't range enough.
 
-    for (i = 0; i < numFrames; i++)
-        scaledVals.append((int)((Utility::processIntegerSignal(frameCache.at(i).payload(), startBit, bitLength, !bigEndian, isSigned) - lowestValue)));
-
-    for (i = 1; i < numFrames; i++)
-    {
-        valu = scaledVals[i-1] - scaledVals[i];
-        diff1.append(valu);
-    }
-
-    for (i = 1; i < diff1.count(); i++)
-    {
-        valu = diff1[i-1] - diff1[i];
-        diff2.append(valu);
-    }
-
-    //now the differences are all stored so let's go through and see if first order diffs seem to suggest a ramping sort of signal or not.
-    //for a first test lets let through any signal where the first order diff doesn't seem too large
-    bool isGood = true;
-    int comparisonValue = Utility::Lerp((double)range * 0.55, 0, lerpPoint);
-    qDebug() << " 1st Delta comparisonvalue: " << comparisonValue;
-    int overValues = 0;
-    for (i = 0; i < diff1.count(); i++)
+    //now see if first order diffs seem to suggest a ramping sort of signal or not, the diff shouldn't be too large.
+    //Second order differentials are acceleration. There shouldn't be hard acceleration in values for a ranging signal
+    int64_t comparison1 = Utility::Lerp((double)range * 0.55, 0, lerpPoint);
+    int64_t comparison2 = Utility::Lerp((double)range * 0.20, 1, lerpPoint);
+    int maxOvers1 = Utility::Lerp(numFrames / 30.0, 2, lerpPoint);
+    int maxOvers2 = Utility::Lerp(8, 2, lerpPoint); //really clamp down on second order over limits
+    int overValues1 = 0, overValues2 = 0;
+    int64_t prevDiff = 0;
+    for (int i = 1; i < numFrames; i++)
     {
-        if (abs(diff1[i]) > comparisonValue) overValues++;
+        int64_t diff = vals[i - 1] - vals[i];
+        overValues1 += (qAbs(diff) > comparison1);
+        if (i > 1) overValues2 += (qAbs(prevDiff - diff) > comparison2);
+        prevDiff = diff;
     }
-    int maxOvers = Utility::Lerp(numFrames / 30.0, 2, lerpPoint);
-    qDebug() << "1st order overages: " << overValues << "   Max Overs: " << maxOvers;
-    if (overValues > maxOvers) isGood = false;
 
-    if (isGood)
-    {
-        //now look at the second order differentials. This is acceleration. There shouldn't be hard acceleration in values for a ranging signal
-        comparisonValue = Utility::Lerp((double)range * 0.20, 1, lerpPoint);
-        maxOvers = Utility::Lerp(8, 2, lerpPoint); //really clamp down on second order over limits
-        qDebug() << "2nd Delta comparisonvalue: " << comparisonValue;
-        overValues = 0;
-        for (i = 0; i < diff2.count(); i++)
-        {
-            if (abs(diff2[i]) > comparisonValue) overValues++;
-        }
-        if (overValues > maxOvers) isGood = false;
-        qDebug() << "2nd order overages: " << overValues << "   Max Overs: " << maxOvers;
-        if (overValues > maxOvers) isGood = false;
-    }
-
-    qDebug() << "Is this signal good: " << isGood << " Num overs: " << overValues;
-    if (isGood)
-    {
-        //createGraph(scaledVals);
-        QString temp;
-        temp = "ID: " + QString::number(frameCache.at(0).frameId(), 16) + " startBit: " + QString::number(startBit) + "  len: " + QString::number(bitLength);
-        int64_t foundSig;
-        foundSig = frameCache.at(0).frameId();
-        foundSig += (int64_t)startBit << 32;
-        foundSig += (int64_t)bitLength << 40;
-
-        if (isSigned)
-        {
-            temp += " Signed";
-            foundSig += (int64_t)1 << 48;
-        }
-        else
-        {
-            temp += " Unsigned";
-        }
-
-        if (bigEndian)
-        {
-            temp += " BigEndian";
-            foundSig += (int64_t)1 << 49;
-        }
-        else
-        {
-            temp += " LittleEndian";
-        }
+    return (overValues1 <= maxOvers1) && (overValues2 <= maxOvers2);
+}
 
-        ui->listCandidates->addItem(temp);
-        foundSignals.append(foundSig);
-    }
-    return isGood;
+QString RangeStateWindow::describeSignal(int64_t foundSig)
+{
+    QString temp;
+    temp = "ID: " + QString::number(foundSig & 0xFFFFFFFFULL, 16) + " startBit: " + QString::number((foundSig >> 32) & 0xFF)
+         + "  len: " + QString::number((foundSig >> 40) & 0xFF);
+    if (foundSig & (1LL << 48)) temp += " Signed";
+    else temp += " Unsigned";
+    if (foundSig & (1LL << 49)) temp += " BigEndian";
+    else temp += " LittleEndian";
+    return temp;
 }
 
 //graphs the vector such that the X axis is just the index into the vector and Y is perfectly graphed within the window
@@ -475,6 +522,7 @@ void RangeStateWindow::clickedSignalList(int idx)
     int numFrames = frameCache.count();
     QVector<int> values;
     values.reserve(numFrames);
-    for (int i = 0; i < numFrames; i++) values.append((int)((Utility::processIntegerSignal(frameCache.at(i).payload(), startBit, bitLength, !isBigEndian, isSigned))));
+    SignalExtractor extractor(startBit, bitLength, !isBigEndian, isSigned);
+    for (int i = 0; i < numFrames; i++) values.append((int)extractor.extract(frameCache.at(i).payload()));
     createGraph(values);
 }
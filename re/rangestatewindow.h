@@ -2,8 +2,41 @@
 #define RANGESTATEWINDOW_H
 
 #include <QDialog>
+#include <QFutureWatcher>
 #include <QMap>
+#include <QSharedPointer>
 #include "can_structs.h"
+#include "poolprogress.h"
+
+
+//the frames of one ID laid out for the candidate search, built once per search on the GUI thread
+struct RangeSearchData
+{
+    uint32_t ID;
+    int maxBits; //bits in the first frame's payload, candidates start anywhere in there
+    QVector<quint64> littleWords; //first 8 payload bytes of every frame read as a little endian word
+    QVector<quint64> bigWords; //same bytes read big endian, Motorola signals are a plain shift and mask in these
+    QVector<quint8> lengths; //payload length of every frame
+    QVector<CANFrame> frames; //only kept for CAN FD IDs, signals past byte 8 are decoded from the frames
+};
+
+//one signal size for one ID. Every start bit, byte order and signedness the user asked for is tried
+struct RangeSearchJob
+{
+    QSharedPointer<const RangeSearchData> data;
+    int order; //position of this job in the ranking, results are listed in this order
+    int sigSize;
+    int granularity;
+    int sigType; //bit 0 = big endian, bit 1 = little endian
+    int signedType; //bit 0 = signed, bit 1 = unsigned
+    int sensitivity;
+};
+
+struct RangeSearchResult
+{
+    int order;
+    QVector<int64_t> found; //packed the same way as foundSignals
+};
 
 namespace Ui {
 class RangeStateWindow;
@@ -22,20 +55,28 @@ private slots:
     void updatedFrames(int);
     void recalcButton();
     void clickedSignalList(int idx);
+    void searchResultsReady(int begin, int end);
+    void searchFinished();
 
 private:
     Ui::RangeStateWindow *ui;
     const QVector<CANFrame> *modelFrames;
     QVector<CANFrame> frameCache;
     QList<int64_t> foundSignals;
+    QList<int> foundOrder; //ranking order of each entry in foundSignals
+    QFutureWatcher<RangeSearchResult> *searchWatcher;
+    PoolProgress *searchProgress;
     QMap<int, bool> idFilters;
 
     void refreshFilterList();
     void closeEvent(QCloseEvent *event);
     void readSettings();
     void writeSettings();
-    void signalsFactory();
-    bool processSignal(int startBit, int bitLength, int sensitivity, bool bigEndian, bool isSigned);
+    QVector<RangeSearchJob> signalsFactory();
+    static RangeSearchResult searchCandidates(const RangeSearchJob &job);
+    static bool processSignal(const RangeSearchData &data, int startBit, int bitLength, int sensitivity, bool bigEndian,
+                              bool isSigned, QVector<int64_t> &values);
+    static QString describeSignal(int64_t foundSig);
     void createGraph(QVector<int> values);
     bool eventFilter(QObject *obj, QEvent *event);
 };
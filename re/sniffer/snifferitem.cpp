@@ -7,9 +7,13 @@ SnifferItem::SnifferItem(const CANFrame& pFrame, quint32 seq):
     mID(pFrame.frameId())
 {
     const unsigned char *data = reinterpret_cast<const unsigned char *>(pFrame.payload().constData());
-    int dataLen = pFrame.payload().length();
+    int dataLen = qMin(pFrame.payload().length(), 8); //only the first 8 bytes are shown
 
-    for (int i = 0; i < dataLen; i++) {
+    mDirtyBytes = 0;
+    mDirtyTiming = false;
+    mStale = false;
+
+    for (int i = 0; i < 8; i++) {
         mNotch[i] = 0;
         mMarker.data[i] = 0;
         mMarker.dataTimestamp[i] = 0;
@@ -17,8 +21,10 @@ SnifferItem::SnifferItem(const CANFrame& pFrame, quint32 seq):
         else mCurrent.data[i] = 0;
         mCurrent.dataTimestamp[i] = seq;
     }
+    mMarker.len = 0;
     mLastMarker = mMarker;
     mCurrent.len = dataLen;
+    mCurrentTime = 0;
 
     /* that's dirty */
     update(pFrame, seq, false);
@@ -118,7 +124,7 @@ void SnifferItem::update(const CANFrame& pFrame, quint32 timeSeq, bool mute)
     mCurrSeqVal = timeSeq;
 
     const unsigned char *data = reinterpret_cast<const unsigned char *>(pFrame.payload().constData());
-    int dataLen = pFrame.payload().length();
+    int dataLen = qMin(pFrame.payload().length(), 8);
 
     /* copy new value */
     for (int i = 0; i < dataLen; i++)
@@ -142,6 +148,10 @@ void SnifferItem::update(const CANFrame& pFrame, quint32 timeSeq, bool mute)
     for (int i = 0 ; i < 8; i++) mMarker.data[i] |= mLast.data[i] ^ mCurrent.data[i]; //XOR causes only changed bits to be 1's
     mMarker.len  |= mLast.len ^ mCurrent.len;
 
+    //the fade of every byte is measured from this frame's sequence number so all of them need a repaint
+    mDirtyBytes = 0xFF;
+    mDirtyTiming = true;
+
     /* restart timeout */
     mTime.restart();
 }
@@ -150,6 +160,11 @@ void SnifferItem::update(const CANFrame& pFrame, quint32 timeSeq, bool mute)
 //So, this means the marker only accumulates for 200ms then resets
 void SnifferItem::updateMarker()
 {
+    //a byte's highlight can only change if it was lit before or is lit now
+    for (int i = 0; i < 8; i++)
+    {
+        if (mLastMarker.data[i] || mMarker.data[i]) mDirtyBytes |= (1 << i);
+    }
     mLastMarker = mMarker;
     for (int i = 0; i < 8; i++) mMarker.data[i] = 0;
 }
@@ -164,4 +179,29 @@ void SnifferItem::notch(bool pNotch)
 
     else
         for (int i = 0; i < 8; i++) mNotch[i] = 0;
+
+    mDirtyBytes = 0xFF;
+}
+
+quint8 SnifferItem::takeDirtyBytes()
+{
+    quint8 dirty = mDirtyBytes;
+    mDirtyBytes = 0;
+    return dirty;
+}
+
+bool SnifferItem::takeDirtyTiming()
+{
+    bool dirty = mDirtyTiming;
+    mDirtyTiming = false;
+    return dirty;
+}
+
+//true when the item just went quiet for longer than threshold ms or just came back
+bool SnifferItem::staleChanged(int threshold)
+{
+    bool stale = elapsed() > threshold;
+    if (stale == mStale) return false;
+    mStale = stale;
+    return true;
 }
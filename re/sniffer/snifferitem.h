@@ -38,6 +38,9 @@ public:
     void update(const CANFrame& pFrame, quint32 timeSeq, bool mute);
     void updateMarker();
     void notch(bool);
+    quint8 takeDirtyBytes();
+    bool takeDirtyTiming();
+    bool staleChanged(int threshold);
 
 private:
     quint32         mID;
@@ -49,6 +52,10 @@ private:
     quint64         mLastTime;
     quint64         mCurrentTime;
     quint64         mCurrSeqVal;
+    //what changed since the model last asked, so only those cells get repainted
+    quint8          mDirtyBytes; //bit per data byte whose value or colors may have changed
+    bool            mDirtyTiming; //delta and frequency
+    bool            mStale; //whether the ID was last shown as not heard from lately
 
     QElapsedTimer   mTime;
 };
@@ -1,6 +1,7 @@
 #include <QDebug>
 #include <Qt>
 #include <QApplication>
+#include <algorithm>
 #include "sniffermodel.h"
 #include "snifferwindow.h"
 #include "SnifferDelegate.h"
@@ -24,9 +25,9 @@ SnifferModel::SnifferModel(QObject *parent)
 
 SnifferModel::~SnifferModel()
 {
-    qDeleteAll(mMap);
-    mMap.clear();
-    mFilters.clear();
+    mItems.forEach([](quint32, SnifferEntry &entry) { delete entry.item; });
+    mItems.clear();
+    mRows.clear();
 }
 
 void SnifferModel::setExpireInterval(int newVal)
@@ -42,8 +43,7 @@ int SnifferModel::columnCount(const QModelIndex &parent) const
 
 int SnifferModel::rowCount(const QModelIndex &parent) const
 {
-    const QMap<quint32, SnifferItem*>& map = mFilter ? mFilters : mMap;
-    return parent.isValid() ? 0 : map.size();
+    return parent.isValid() ? 0 : mRows.count();
 }
 
 
@@ -53,7 +53,7 @@ QVariant SnifferModel::data(const QModelIndex &index, int role) const
         return QVariant();
 
     SnifferItem *item = static_cast<SnifferItem*>(index.internalPointer());
-    if(!item) QVariant();
+    if(!item) return QVariant();
 
     int col = index.column();
 
@@ -105,7 +105,7 @@ QVariant SnifferModel::data(const QModelIndex &index, int role) const
         {
             if(tc::ID==col)
             {
-                if(item->elapsed() > 4000)
+                if(item->elapsed() > staleInterval)
                 {
                     if (!mDarkMode) return QBrush(Qt::red);
                     return QBrush(QColor(128,0,0));
@@ -171,17 +171,10 @@ QModelIndex SnifferModel::index(int row, int column, const QModelIndex &parent)
     if (parent.isValid())
         return QModelIndex();
 
-    const QMap<quint32, SnifferItem*>& map = mFilter ? mFilters : mMap;
-
-    if(column>tc::LAST || row>=map.size())
+    if(column>tc::LAST || row<0 || row>=mRows.count())
         return QModelIndex();
 
-    /* ugly but I can't find best without creating a list to keep indexes */
-    QMap<quint32, SnifferItem*>::const_iterator iter;
-    int i;
-    for(iter = map.begin(), i=0 ; i<row ; ++i, ++iter);
-
-    return createIndex(row, column, iter.value());
+    return createIndex(row, column, mRows[row]);
 }
 
 
@@ -223,90 +216,194 @@ void SnifferModel::setMuteNotched(bool val)
 void SnifferModel::clear()
 {
     beginResetModel();
-    qDeleteAll(mMap);
-    mMap.clear();
-    mFilters.clear();
+    mItems.forEach([](quint32, SnifferEntry &entry) { delete entry.item; });
+    mItems.clear();
+    mRows.clear();
     mFilter = false;
     endResetModel();
 }
 
 void SnifferModel::updateNotchPoint()
 {
-    QMap<quint32, SnifferItem*>::iterator i;
-
     /* update markers */
-    for (i = mMap.begin(); i != mMap.end(); ++i)
+    mItems.forEach([](quint32, SnifferEntry &entry) { entry.item->updateMarker(); });
+}
+
+//row the ID is shown on, or the row it would be inserted at
+int SnifferModel::rowFor(quint32 id) const
+{
+    auto it = std::lower_bound(mRows.constBegin(), mRows.constEnd(), id,
+                               [](const SnifferItem *item, quint32 id) { return item->getId() < id; });
+    return static_cast<int>(it - mRows.constBegin());
+}
+
+void SnifferModel::insertItemRow(SnifferItem *item)
+{
+    int row = rowFor(item->getId());
+    beginInsertRows(QModelIndex(), row, row);
+    mRows.insert(row, item);
+    endInsertRows();
+}
+
+//takes the rows out in runs of neighbors, last run first so the earlier row numbers stay good
+void SnifferModel::removeItemRows(QVector<int> rows)
+{
+    std::sort(rows.begin(), rows.end());
+    int i = rows.count() - 1;
+    while (i >= 0)
     {
-        i.value()->updateMarker();
+        int last = rows[i];
+        int first = last;
+        while (i > 0 && rows[i - 1] == first - 1)
+        {
+            i--;
+            first--;
+        }
+        i--;
+        beginRemoveRows(QModelIndex(), first, last);
+        mRows.remove(first, last - first + 1);
+        endRemoveRows();
     }
 }
 
+void SnifferModel::rebuildRows()
+{
+    mRows.clear();
+    mItems.forEach([this](quint32, SnifferEntry &entry) { if (entry.shown) mRows.append(entry.item); });
+    std::sort(mRows.begin(), mRows.end(), [](const SnifferItem *a, const SnifferItem *b) { return a->getId() < b->getId(); });
+}
+
 //Called from window with a timer (currently 200ms)
 void SnifferModel::refresh()
 {
-    QMap<quint32, SnifferItem*>::iterator i;
     QVector<quint32> toRemove;
-    SnifferItem* item;
 
     mTimeSequence++;
 
-    for (i = mMap.begin(); i != mMap.end(); ++i)
+    if (!mNeverExpire)
     {
-        //i.value()->updateMarker();
-        if(i.value()->elapsed() > (int)mExpireInterval && !mNeverExpire)
-            toRemove.append(i.key());
+        mItems.forEach([this, &toRemove](quint32 id, SnifferEntry &entry)
+        {
+            if (entry.item->elapsed() > (int)mExpireInterval) toRemove.append(id);
+        });
     }
 
     if(toRemove.size())
     {
-        beginResetModel();
+        QVector<int> rows;
+        foreach(quint32 id, toRemove)
+        {
+            if (mItems.find(id)->shown) rows.append(rowFor(id));
+        }
+        removeItemRows(rows);
+
         foreach(quint32 id, toRemove)
         {
             /* remove element */
-            item = mMap.take(id);
-            mFilters.remove(id);
+            SnifferItem *item = mItems.find(id)->item;
+            mItems.remove(id);
             delete item;
             /* send notification */
             emit idChange(id, false);
         }
-        endResetModel();
     }
-    else
-        /* refresh data */
-        emit dataChanged(createIndex(0, 0),
-                    createIndex(rowCount()-1, columnCount()-1), QVector<int>(Qt::DisplayRole));
+
+    /* refresh data */
+    //only cells of items that changed since the last refresh are sent. Rows next to each other go out as one
+    //range covering all the columns any of them changed
+    int runStart = -1;
+    int runFirstCol = 0, runLastCol = 0;
+    for (int row = 0; row <= mRows.count(); row++)
+    {
+        int firstCol = tc::LAST, lastCol = -1;
+        if (row < mRows.count())
+        {
+            SnifferItem *item = mRows[row];
+            if (item->takeDirtyTiming())
+            {
+                firstCol = tc::DELTA;
+                lastCol = tc::FREQUENCY;
+            }
+            if (item->staleChanged(staleInterval))
+            {
+                firstCol = qMin(firstCol, (int)tc::ID);
+                lastCol = qMax(lastCol, (int)tc::ID);
+            }
+            quint8 bytes = item->takeDirtyBytes();
+            for (int i = 0; i < 8; i++)
+            {
+                if (!(bytes & (1 << i))) continue;
+                firstCol = qMin(firstCol, tc::DATA_0 + i);
+                lastCol = qMax(lastCol, tc::DATA_0 + i);
+            }
+        }
+
+        if (lastCol >= 0)
+        {
+            if (runStart < 0)
+            {
+                runStart = row;
+                runFirstCol = firstCol;
+                runLastCol = lastCol;
+            }
+            else
+            {
+                runFirstCol = qMin(runFirstCol, firstCol);
+                runLastCol = qMax(runLastCol, lastCol);
+            }
+        }
+        else if (runStart >= 0)
+        {
+            emit dataChanged(createIndex(runStart, runFirstCol, mRows[runStart]),
+                             createIndex(row - 1, runLastCol, mRows[row - 1]));
+            runStart = -1;
+        }
+    }
 }
 
 
 void SnifferModel::filter(fltType pType, int pId)
 {
-    beginResetModel();
+    SnifferEntry *found;
     switch(pType)
     {
         case fltType::NONE:
             /* erase everything */
+            beginResetModel();
             mFilter = true;
-            mFilters.clear();
+            mItems.forEach([](quint32, SnifferEntry &entry) { entry.shown = false; });
+            mRows.clear();
+            endResetModel();
             break;
         case fltType::ADD:
             /* add filter to list */
             mFilter = true;
-            mFilters[pId] = mMap[pId];
+            found = mItems.find(pId);
+            if (found && !found->shown)
+            {
+                found->shown = true;
+                insertItemRow(found->item);
+            }
             break;
         case fltType::REMOVE:
             /* remove filter */
-            if(!mFilter)
-                mFilters = mMap;
             mFilter = true;
-            mFilters.remove(pId);
+            found = mItems.find(pId);
+            if (found && found->shown)
+            {
+                found->shown = false;
+                removeItemRows(QVector<int>() << rowFor(pId));
+            }
             break;
         case fltType::ALL:
             /* stop filtering */
+            beginResetModel();
             mFilter = false;
-            mFilters.clear();
+            mItems.forEach([](quint32, SnifferEntry &entry) { entry.shown = true; });
+            rebuildRows();
+            endResetModel();
             break;
     }
-    endResetModel();
 }
 
 
@@ -318,36 +415,34 @@ void SnifferModel::update(CANConnection*, QVector<CANFrame>& pFrames)
 {
     foreach(const CANFrame& frame, pFrames)
     {
-        if(!mMap.contains(frame.frameId()))
+        SnifferEntry *entry = mItems.find(frame.frameId());
+        if (entry)
         {
-            int index = std::distance(mMap.begin(), mMap.lowerBound(frame.frameId()));
-            /* add the frame */
-            beginInsertRows(QModelIndex(), index, index);
-            mMap[frame.frameId()] = new SnifferItem(frame, mTimeSequence);
-            mMap[frame.frameId()]->update(frame, mTimeSequence, mMuteNotched);
-            endInsertRows();
-
-            emit idChange(frame.frameId(), true);
-        }
-        else
             //updateData
-            mMap[frame.frameId()]->update(frame, mTimeSequence, mMuteNotched);
+            entry->item->update(frame, mTimeSequence, mMuteNotched);
+            continue;
+        }
+
+        /* add the frame */
+        SnifferItem *item = new SnifferItem(frame, mTimeSequence);
+        item->update(frame, mTimeSequence, mMuteNotched);
+        //new IDs are always shown, the window ticks them in its list as well
+        mItems.insert(frame.frameId(), SnifferEntry{item, true});
+        insertItemRow(item);
+
+        emit idChange(frame.frameId(), true);
     }
 }
 
 void SnifferModel::notch()
 {
-    QMap<quint32, SnifferItem*>& map = mFilter ? mFilters : mMap;
-
-    foreach(SnifferItem* item, map)
+    foreach(SnifferItem* item, mRows)
         item->notch(true);
 }
 
 void SnifferModel::unNotch()
 {
-    QMap<quint32, SnifferItem*>& map = mFilter ? mFilters : mMap;
-
-    foreach(SnifferItem* item, map)
+    foreach(SnifferItem* item, mRows)
         item->notch(false);
 }
 
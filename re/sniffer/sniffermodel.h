@@ -9,6 +9,7 @@
 #include "can_structs.h"
 #include "connections/canconnection.h"
 #include "snifferitem.h"
+#include "utils/flatidmap.h"
 
 
 enum fltType
@@ -59,8 +60,19 @@ signals:
     void idChange(int, bool);
 
 private:
-    QMap<quint32, SnifferItem*> mMap;
-    QMap<quint32, SnifferItem*> mFilters;
+    struct SnifferEntry
+    {
+        SnifferItem *item;
+        bool shown; //passes the ID filter
+    };
+
+    int rowFor(quint32 id) const;
+    void insertItemRow(SnifferItem *item);
+    void removeItemRows(QVector<int> rows);
+    void rebuildRows();
+
+    FlatIDMap<SnifferEntry>     mItems; //every ID heard from, found once per frame
+    QVector<SnifferItem*>       mRows; //the shown items in ID order, one per row
     bool                        mFilter;
     bool                        mNeverExpire;
     bool                        mFadeInactive;
@@ -68,6 +80,8 @@ private:
     bool                        mDarkMode;
     quint32                     mTimeSequence;
     quint32                     mExpireInterval;
+
+    static const int staleInterval = 4000; //ms of silence before an ID gets highlighted
 };
 
 #endif // SNIFFERMODEL_H
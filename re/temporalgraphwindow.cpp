@@ -2,6 +2,11 @@
 #include "ui_temporalgraphwindow.h"
 #include "helpwindow.h"
 #include "mainwindow.h"
+#include <QScreen>
+#include <QThread>
+#include <QtConcurrent/QtConcurrentMap>
+#include <algorithm>
+#include <math.h>
 
 QString HexTicker::getTickLabel (double tick, const QLocale& locale, QChar formatChar, int precision)
 {
@@ -24,6 +29,18 @@ TemporalGraphWindow::TemporalGraphWindow(const QVector<CANFrame> *frames, QWidge
     readSettings();
 
     modelFrames = frames;
+    graph = nullptr;
+    densityMap = nullptr;
+    followGraphEnd = false;
+    timesMonotonic = true;
+
+    //zooming and dragging change the range many times a frame, the bins are worked out once per screen refresh
+    densityTimer = new QTimer(this);
+    densityTimer->setSingleShot(true);
+    QScreen *screen = QGuiApplication::primaryScreen();
+    double refreshRate = (screen && screen->refreshRate() > 0) ? screen->refreshRate() : 60.0;
+    densityTimer->setInterval(qMax(1, qRound(1000.0 / refreshRate)));
+    connect(densityTimer, &QTimer::timeout, this, &TemporalGraphWindow::refreshDensity);
 
     ui->graphingView->setInteractions(QCP::iRangeDrag | QCP::iRangeZoom | QCP::iSelectAxes);
 
@@ -50,6 +67,9 @@ TemporalGraphWindow::TemporalGraphWindow(const QVector<CANFrame> *frames, QWidge
     // make bottom and left axes transfer their ranges to top and right axes:
     connect(ui->graphingView->xAxis, SIGNAL(rangeChanged(QCPRange)), ui->graphingView->xAxis2, SLOT(setRange(QCPRange)));
     connect(ui->graphingView->yAxis, SIGNAL(rangeChanged(QCPRange)), ui->graphingView->yAxis2, SLOT(setRange(QCPRange)));
+    connect(ui->graphingView->xAxis, SIGNAL(rangeChanged(QCPRange)), this, SLOT(rangeChanged()));
+    connect(ui->graphingView->yAxis, SIGNAL(rangeChanged(QCPRange)), this, SLOT(rangeChanged()));
+    connect(ui->graphingView, SIGNAL(afterLayout()), this, SLOT(plotLayoutChanged()));
 
     if (useOpenGL)
     {
@@ -109,113 +129,105 @@ void TemporalGraphWindow::writeSettings()
 
 void TemporalGraphWindow::updatedFrames(int numFrames)
 {
-    CANFrame thisFrame;
-    QVector<double> x, y;
-    bool appendedToGraph = false;
-    bool needReplot = false;
-
     if (numFrames == -1) //all frames deleted. Kill the display
     {
-        //removeAllGraphs();
-        //now instead of removing the graphs regenerate them which will blank them out but leave them there in case
-        //more traffic that matches comes in or someone otherwise loads more data
-        ui->graphingView->clearGraphs(); //temporarily remove the graphs from the graph view
+        frameTimes.clear();
+        frameIDs.clear();
+        timesMonotonic = true;
+        ui->graphingView->clearGraphs();
         ui->graphingView->clearPlottables();
-        ui->graphingView->replot(); //now, redisplay them all
-
+        graph = nullptr;
+        densityMap = nullptr;
+        ui->graphingView->replot();
     }
     else if (numFrames == -2) //all new set of frames. Reset
     {
-        //there shouldn't be any need to actually remove the graphs.
-        //regenerate them instead
-        ui->graphingView->clearGraphs(); //temporarily remove the graphs from the graph view
-        //needScaleSetup = true;
         generateGraph();
-        //ui->graphingView->replot(); //now, redisplay them all
     }
-    else //just got some new frames. See if they are relevant.
+    else //just got some new frames
     {
         if (numFrames > modelFrames->count()) return;
+        int first = modelFrames->count() - numFrames;
+        //if these don't follow on from the frames we have the list changed some other way, start over
+        if (!densityMap || first != frameTimes.count())
+        {
+            generateGraph();
+            return;
+        }
+        appendFrames(first);
 
-            appendedToGraph = false;
-            x.clear();
-            y.clear();
-            for (int i = modelFrames->count() - numFrames; i < modelFrames->count(); i++)
-            {
-                thisFrame = modelFrames->at(i);
-                /*
-                if (graphParams[j].ID == thisFrame.ID)
-                {
-                    appendToGraph(graphParams[j], thisFrame, x, y);
-                    appendedToGraph = true;
-                }*/
-            }
-            if (appendedToGraph)
-            {
-                //graphParams[j].ref->addData(x, y);
-                needReplot = true;
-            }
-
-        if (needReplot)
+        if (followGraphEnd)
         {
-            if (followGraphEnd)
-            {
-                //find the current X span and maintain that span but move the end of it over to match the new end
-                //of the actual graph. This causes the view to move with the data to always show the end
-                QCPRange range = ui->graphingView->xAxis->range();
-                double size = range.size();
-                bool foundRange;
-                QCPRange keyRange = ui->graphingView->graph()->getKeyRange(foundRange);
-                if (foundRange)
-                {
-                    double end, start;
-                    end = keyRange.upper;
-                    start = end - size;
-                    ui->graphingView->xAxis->setRange(start, end);
-                }
-            }
-            ui->graphingView->replot();
+            //find the current X span and maintain that span but move the end of it over to match the new end
+            //of the actual graph. This causes the view to move with the data to always show the end
+            double size = ui->graphingView->xAxis->range().size();
+            ui->graphingView->xAxis->setRange(xmaxval - size, xmaxval);
         }
+        if (!densityTimer->isActive()) densityTimer->start();
     }
 }
 
-void TemporalGraphWindow::generateGraph()
+//packs the time and ID of frames from first on and keeps the extents up to date
+void TemporalGraphWindow::appendFrames(int first)
 {
-    if (modelFrames->count() == 0) return;
-
-    ui->graphingView->clearGraphs();
-    ui->graphingView->clearPlottables();
-
-    qDebug() << "Regenerating the graph";
-    ui->graphingView->addGraph();
-    graph = ui->graphingView->graph();
-
-    QVector<double> x, y;
     int frameCount = modelFrames->count();
+    frameTimes.reserve(frameCount);
+    frameIDs.reserve(frameCount);
 
-    x.reserve(frameCount);
-    y.reserve(frameCount);
+    for (int i = first; i < frameCount; i++)
+    {
+        const CANFrame &frame = modelFrames->at(i);
+        double x = frame.timeStamp().microSeconds() / 1000000.0;
+        uint32_t y = frame.frameId();
+        if (!frameTimes.isEmpty() && x < frameTimes.last()) timesMonotonic = false;
+        frameTimes.append(x);
+        frameIDs.append(y);
+        if (x > xmaxval) xmaxval = x;
+        if (x < xminval) xminval = x;
+        if (y > ymaxval) ymaxval = y;
+        if (y < yminval) yminval = y;
+    }
+}
 
-    xminval = xmaxval = modelFrames->at(0).timeStamp().microSeconds() / 1000000.0;
-    yminval = ymaxval = modelFrames->at(0).frameId();
+/*
+ * The frames are drawn as a color map of how many fall in each cell of a grid laid over the visible range, a few
+ * pixels per cell. That stays the same amount of drawing whether there are thousands or tens of millions of frames.
+ * The grid is rebuilt for whatever is in view after every zoom or drag so zooming in sharpens it, and once few
+ * enough frames are in view to tell apart they're drawn as points instead.
+ */
+void TemporalGraphWindow::generateGraph()
+{
+    ui->graphingView->clearGraphs();
+    ui->graphingView->clearPlottables();
+    graph = nullptr;
+    densityMap = nullptr;
+    frameTimes.clear();
+    frameIDs.clear();
+    timesMonotonic = true;
 
-    for (int i = 0; i < frameCount; i++)
+    if (modelFrames->count() == 0)
     {
-        x.append(modelFrames->at(i).timeStamp().microSeconds() / 1000000.0);
-        y.append(modelFrames->at(i).frameId());
-        if (x[i] > xmaxval) xmaxval = x[i];
-        if (x[i] < xminval) xminval = x[i];
-        if (y[i] > ymaxval) ymaxval = y[i];
-        if (y[i] < yminval) yminval = y[i];
+        ui->graphingView->replot();
+        return;
     }
 
-    ui->graphingView->graph()->setData(x,y);
-    ui->graphingView->graph()->setLineStyle(QCPGraph::lsNone); //no lines
-    ui->graphingView->graph()->setScatterStyle(QCPScatterStyle::ssCircle);
+    qDebug() << "Regenerating the graph";
+    densityMap = new QCPColorMap(ui->graphingView->xAxis, ui->graphingView->yAxis);
+    densityMap->setGradient(QCPColorGradient::gpJet);
+    densityMap->setInterpolate(false);
+
+    ui->graphingView->addGraph();
+    graph = ui->graphingView->graph();
+    graph->setLineStyle(QCPGraph::lsNone); //no lines
+    graph->setScatterStyle(QCPScatterStyle::ssCircle);
     QPen graphPen;
     graphPen.setColor(Qt::blue);
     graphPen.setWidth(2);
-    ui->graphingView->graph()->setPen(graphPen);
+    graph->setPen(graphPen);
+
+    xminval = xmaxval = modelFrames->at(0).timeStamp().microSeconds() / 1000000.0;
+    yminval = ymaxval = modelFrames->at(0).frameId();
+    appendFrames(0);
 
     qDebug() << "xmin: " << xminval;
     qDebug() << "xmax: " << xmaxval;
@@ -226,41 +238,142 @@ void TemporalGraphWindow::generateGraph()
     ui->graphingView->yAxis->setRange(yminval, ymaxval);
     ui->graphingView->axisRect()->setupFullAxesBox();
 
-    ui->graphingView->replot();
+    refreshDensity();
+}
 
+void TemporalGraphWindow::rangeChanged()
+{
+    if (densityMap && !densityTimer->isActive()) densityTimer->start();
+}
 
-    QCPColorMap *colorMap = new QCPColorMap(ui->graphingView->xAxis, ui->graphingView->yAxis);
+//a resized plot needs a grid to match. Every replot lays out again, so only an actual change in size counts
+void TemporalGraphWindow::plotLayoutChanged()
+{
+    if (ui->graphingView->axisRect()->rect().size() != densityRectSize) rangeChanged();
+}
 
-    int ySize = static_cast<int>(ymaxval - yminval) / 30 + 1;
-    int xSize = static_cast<int>((xmaxval - xminval) * 4.0) + 1;
-    colorMap->data()->setSize(xSize, ySize);
-    colorMap->data()->setRange(QCPRange(xminval, xmaxval), QCPRange(yminval, ymaxval));
-    for (int x = 0; x < xSize; ++x)
+//runs on a pool thread
+void TemporalGraphWindow::binChunk(DensityChunk &chunk)
+{
+    chunk.counts.fill(0, chunk.columns * chunk.rows);
+    int *counts = chunk.counts.data();
+    double xScale = chunk.columns / (chunk.xUpper - chunk.xLower);
+    double yScale = chunk.rows / (chunk.yUpper - chunk.yLower);
+
+    for (int i = chunk.first; i < chunk.last; i++)
+    {
+        double x = chunk.times[i];
+        double y = chunk.ids[i];
+        if (x < chunk.xLower || x > chunk.xUpper || y < chunk.yLower || y > chunk.yUpper) continue;
+        int column = qMin(static_cast<int>((x - chunk.xLower) * xScale), chunk.columns - 1);
+        int row = qMin(static_cast<int>((y - chunk.yLower) * yScale), chunk.rows - 1);
+        counts[row * chunk.columns + column]++;
+    }
+}
+
+void TemporalGraphWindow::refreshDensity()
+{
+    densityTimer->stop();
+    if (!densityMap || !graph || frameTimes.isEmpty()) return;
+
+    QCPRange xRange = ui->graphingView->xAxis->range();
+    QCPRange yRange = ui->graphingView->yAxis->range();
+    if (xRange.size() <= 0.0 || yRange.size() <= 0.0) return;
+
+    QRect rect = ui->graphingView->axisRect()->rect();
+    densityRectSize = rect.size();
+    int columns = qMax(1, rect.width() / densityBinPixels);
+    int rows = qMax(1, rect.height() / densityBinPixels);
+
+    //with times in order only the frames in the visible time span need looking at
+    int lo = 0;
+    int hi = frameTimes.count();
+    if (timesMonotonic)
     {
-      for (int y = 0; y < ySize; ++y)
-      {
-        colorMap->data()->setAlpha(x, y, 180);
-        colorMap->data()->setCell(x, y, 0.0);
-      }
+        lo = static_cast<int>(std::lower_bound(frameTimes.constBegin(), frameTimes.constEnd(), xRange.lower) - frameTimes.constBegin());
+        hi = static_cast<int>(std::upper_bound(frameTimes.constBegin(), frameTimes.constEnd(), xRange.upper) - frameTimes.constBegin());
     }
 
-    for (int i = 0; i < frameCount; i++)
+    //each pool thread bins its own slice into its own grid, the grids get added up afterward
+    const int minChunkFrames = 65536;
+    int numChunks = qBound(1, (hi - lo) / minChunkFrames, qMax(1, QThread::idealThreadCount()));
+    QVector<DensityChunk> chunks(numChunks);
+    for (int c = 0; c < numChunks; c++)
     {
-        int x = static_cast<int>(((modelFrames->at(i).timeStamp().microSeconds() / 1000000.0) - xminval) * 4.0);
-        int y = static_cast<int>(modelFrames->at(i).frameId() - yminval) / 30;
-        double val = colorMap->data()->cell(x, y);
-        double inc;
-        inc = 1 / (val + 1); //logarithmic decay
-        inc = inc * inc; //square the increment to make it even more stark
-        val = val + inc;
-        qDebug() << "X: " << x << " Y: " << y << "Val: " << val;
-        colorMap->data()->setCell(x, y, val);
+        DensityChunk &chunk = chunks[c];
+        chunk.times = frameTimes.constData();
+        chunk.ids = frameIDs.constData();
+        chunk.first = lo + static_cast<int>(static_cast<qint64>(hi - lo) * c / numChunks);
+        chunk.last = lo + static_cast<int>(static_cast<qint64>(hi - lo) * (c + 1) / numChunks);
+        chunk.xLower = xRange.lower;
+        chunk.xUpper = xRange.upper;
+        chunk.yLower = yRange.lower;
+        chunk.yUpper = yRange.upper;
+        chunk.columns = columns;
+        chunk.rows = rows;
     }
+    if (numChunks == 1) binChunk(chunks[0]);
+    else QtConcurrent::blockingMap(chunks, &TemporalGraphWindow::binChunk);
 
-    colorMap->setGradient(QCPColorGradient::gpJet);
-    colorMap->rescaleDataRange(true);
-    ui->graphingView->rescaleAxes();
-    ui->graphingView->replot();
+    QVector<int> &counts = chunks[0].counts;
+    int *total = counts.data();
+    for (int c = 1; c < numChunks; c++)
+    {
+        const int *other = chunks[c].counts.constData();
+        for (int i = 0; i < counts.count(); i++) total[i] += other[i];
+    }
+    qint64 inView = 0;
+    int maxCount = 0;
+    for (int n : counts)
+    {
+        inView += n;
+        if (n > maxCount) maxCount = n;
+    }
+
+    if (inView <= sparsePointLimit)
+    {
+        QVector<double> x, y;
+        x.reserve(static_cast<int>(inView));
+        y.reserve(static_cast<int>(inView));
+        for (int i = lo; i < hi; i++)
+        {
+            double t = frameTimes[i];
+            double id = frameIDs[i];
+            if (t < xRange.lower || t > xRange.upper || id < yRange.lower || id > yRange.upper) continue;
+            x.append(t);
+            y.append(id);
+        }
+        graph->setData(x, y, timesMonotonic);
+        graph->setVisible(true);
+        densityMap->setVisible(false);
+    }
+    else
+    {
+        graph->data()->clear();
+        graph->setVisible(false);
+
+        //counts span several orders of magnitude between idle and busy IDs so the color follows the log of them.
+        //Empty cells are left see through
+        QCPColorMapData *data = densityMap->data();
+        data->setSize(columns, rows);
+        double xStep = xRange.size() / columns;
+        double yStep = yRange.size() / rows;
+        data->setRange(QCPRange(xRange.lower + xStep / 2, xRange.upper - xStep / 2),
+                       QCPRange(yRange.lower + yStep / 2, yRange.upper - yStep / 2));
+        data->fillAlpha(255);
+        for (int row = 0; row < rows; row++)
+        {
+            for (int column = 0; column < columns; column++)
+            {
+                int n = counts[row * columns + column];
+                data->setCell(column, row, n ? log10(n) + 1.0 : 0.0);
+                if (!n) data->setAlpha(column, row, 0);
+            }
+        }
+        densityMap->setDataRange(QCPRange(0.0, log10(qMax(1, maxCount)) + 1.0));
+        densityMap->setVisible(true);
+    }
+    ui->graphingView->replot(QCustomPlot::rpQueuedReplot);
 }
 
 void TemporalGraphWindow::selectionChanged()
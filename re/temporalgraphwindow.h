@@ -2,6 +2,7 @@
 #define TEMPORALGRAPHWINDOW_H
 
 #include <QDialog>
+#include <QTimer>
 #include "qcustomplot.h"
 #include "can_structs.h"
 
@@ -14,6 +15,17 @@ class HexTicker : public QCPAxisTicker
     QString getTickLabel (double tick, const QLocale& locale, QChar formatChar, int precision);
 };
 
+//one slice of the frames in view, binned on a pool thread into its own grid of counts
+struct DensityChunk
+{
+    const double *times;
+    const uint32_t *ids;
+    int first, last;
+    double xLower, xUpper, yLower, yUpper;
+    int columns, rows;
+    QVector<int> counts; //index is row * columns + column
+};
+
 class TemporalGraphWindow : public QDialog
 {
     Q_OBJECT
@@ -31,6 +43,9 @@ private slots:
     void zoomIn();
     void zoomOut();
     void selectionChanged();
+    void rangeChanged();
+    void refreshDensity();
+    void plotLayoutChanged();
 
 private:
     Ui::TemporalGraphWindow *ui;    
@@ -38,7 +53,17 @@ private:
     bool useOpenGL;
     bool followGraphEnd;
     QCPGraph *graph;
+    QCPColorMap *densityMap;
+    QTimer *densityTimer;
+    QVector<double> frameTimes; //every frame's time in seconds and its ID, in model order
+    QVector<uint32_t> frameIDs;
+    bool timesMonotonic;
+    QSize densityRectSize; //plot area the grid was last built for
     double xminval, xmaxval, yminval, ymaxval;
+    static const int densityBinPixels = 3;
+    static const int sparsePointLimit = 20000;
+    static void binChunk(DensityChunk &chunk);
+    void appendFrames(int first);
     void closeEvent(QCloseEvent *event);
     bool eventFilter(QObject *obj, QEvent *event);
     void readSettings();
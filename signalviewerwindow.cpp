@@ -3,6 +3,7 @@
 #include "helpwindow.h"
 #include "mainwindow.h"
 #include "utility.h"
+#include "dbc/signalvaluestore.h"
 #include <QDebug>
 
 #define MSG_COL     1
@@ -63,55 +64,41 @@ SignalViewerWindow::~SignalViewerWindow()
 
 void SignalViewerWindow::updatedFrames(int numFrames)
 {
-    CANFrame thisFrame;
-
     if (numFrames == -1) //all frames deleted. Don't care
     {
     }
-    else if (numFrames == -2) //all new set of frames. Reset
+    else //new frames or an all new set of them. The value store picks up whatever changed
     {
-        for (int i = 0; i < modelFrames->count(); i++)
-        {
-            thisFrame = modelFrames->at(i);
-            processFrame(thisFrame);
-        }
-    }
-    else //just got some new frames. See if they are relevant.
-    {
-        if (numFrames > modelFrames->count()) return;
-
-        for (int i = modelFrames->count() - numFrames; i < modelFrames->count(); i++)
-        {
-            thisFrame = modelFrames->at(i);
-            processFrame(thisFrame);
-        }
+        refreshValues();
     }
 }
 
-void SignalViewerWindow::processFrame(CANFrame &frame)
+//Only the newest value of each signal is shown. The value store keeps every signal's series over the frames and
+//only decodes frames it hasn't seen yet, so this is just looking at the last rows.
+void SignalViewerWindow::refreshValues()
 {
+    QSharedPointer<const DBCSnapshot> snapshot = dbcHandler->getSnapshot();
+    SignalValueStore *store = SignalValueStore::getReference();
     QString sigString;
-    DBC_SIGNAL *sig;
+
     for (int i = 0; i < signalList.count(); i++)
     {
-        sig = signalList.at(i);
-        if (!sig) return;
-        if (sig->parentMessage->ID == frame.frameId())
+        const DBCSnapshot::Signal *snapSig = snapshot->findSignal(signalList.at(i));
+        if (!snapSig) continue;
+        QSharedPointer<const SignalSeries> series = store->getSeries(modelFrames, snapshot, snapSig, snapSig->message->ID, -1);
+        if (!series) continue;
+
+        int row = series->count() - 1;
+        while (row >= 0 && !series->textAt(row, *modelFrames, snapSig, sigString, false)) row--;
+        if (row < 0) continue;
+
+        QTableWidgetItem *item = ui->tableViewer->item(i, VALUE_COL);
+        if (!item)
         {
-            if (sig->isSignalInMessage(frame)) //filter out multiplexed signals that aren't in this message.
-            {
-                if (sig->processAsText(frame, sigString, false)) //if true we could interpret the signal so update it in the list
-                {
-                    QTableWidgetItem *item = ui->tableViewer->item(i, VALUE_COL);
-                    if (!item)
-                    {
-                        item = new QTableWidgetItem(sigString);
-                        ui->tableViewer->setItem(i, VALUE_COL, item);
-                    }
-                    else item->setText(sigString);
-                }
-            }
+            item = new QTableWidgetItem(sigString);
+            ui->tableViewer->setItem(i, VALUE_COL, item);
         }
+        else item->setText(sigString);
     }
 }
 
@@ -41,7 +41,7 @@ private:
     QList<DBC_SIGNAL *> signalList;
     const QVector<CANFrame> *modelFrames;
 
-    void processFrame(CANFrame &frame);
+    void refreshValues();
 };
 
 #endif // SIGNALVIEWERWINDOW_H
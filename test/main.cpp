@@ -2,6 +2,8 @@
 
 #include "tst_lfqueue.h"
 #include "tst_cancon.h"
+#include "tst_signalextractor.h"
+#include "tst_signalencoder.h"
 
 
 int main(int argc, char** argv)
@@ -15,6 +17,8 @@ int main(int argc, char** argv)
    };
 
    ASSERT_TEST(new TestLFQueue());
+   ASSERT_TEST(new TestSignalExtractor());
+   ASSERT_TEST(new TestSignalEncoder());
    ASSERT_TEST(new TestCanCon(CANCon::SOCKETCAN, "vcan0", 1));
 
    return status;
@@ -9,6 +9,9 @@ SOURCES += \
     tst_lfqueue.cpp \
     main.cpp \
     tst_cancon.cpp \
+    tst_signalextractor.cpp \
+    tst_signalencoder.cpp \
+    ../utility.cpp \
     ../connections/canconfactory.cpp \
     ../connections/canconnection.cpp \
     ../connections/gvretserial.cpp \
@@ -25,6 +28,11 @@ INSTALLS += target
 HEADERS += \
     tst_lfqueue.h \
     tst_cancon.h \
+    tst_signalextractor.h \
+    tst_signalencoder.h \
+    ../utils/signalextractor.h \
+    ../utils/signalencoder.h \
+    ../utility.h \
     ../connections/canconconst.h \
     ../connections/canconfactory.h \
     ../connections/canconnection.h \
@@ -0,0 +1,81 @@
+#include <QtTest>
+
+#include "utils/signalencoder.h"
+#include "utils/signalextractor.h"
+#include "tst_signalencoder.h"
+
+
+
+void TestSignalEncoder::roundTrip_data()
+{
+    QTest::addColumn<int>("length");
+
+    QTest::newRow("1")      << 1;
+    QTest::newRow("8")      << 8;
+    QTest::newRow("12")     << 12;
+    QTest::newRow("20")     << 20;
+    QTest::newRow("64")     << 64;
+}
+
+
+//every start bit, every length and both byte orders: what the encoder writes the extractor has to read back and
+//putting the old value back has to give the payload it started with, so no bit outside the signal was touched
+void TestSignalEncoder::roundTrip()
+{
+    QFETCH(int, length);
+
+    QRandomGenerator rng(length + 7);
+    for (int pass = 0; pass < 2; pass++)
+    {
+        QByteArray original(length, 0);
+        for (int i = 0; i < length; i++) original[i] = static_cast<char>(rng.bounded(256));
+
+        for (int startBit = 0; startBit < length * 8; startBit++)
+        {
+            for (int sigSize = 1; sigSize <= 64; sigSize++)
+            {
+                for (int intel = 0; intel < 2; intel++)
+                {
+                    SignalEncoder encoder(startBit, sigSize, intel);
+                    if (!encoder.fits(length)) continue;
+
+                    for (int isSigned = 0; isSigned < 2; isSigned++)
+                    {
+                        //the extractor sign extends 64 bit signals with an out of range shift, skip those
+                        if (isSigned && sigSize == 64) continue;
+                        SignalExtractor extractor(startBit, sigSize, intel, isSigned);
+                        QCOMPARE(encoder.bytesNeeded(), extractor.bytesNeeded());
+
+                        uint64_t mask = (sigSize >= 64) ? ~0ULL : ((1ULL << sigSize) - 1);
+                        uint64_t raw = rng.generate64() & mask;
+                        int64_t expected = static_cast<int64_t>(raw);
+                        if (isSigned && (raw >> (sigSize - 1)) & 1) expected = static_cast<int64_t>(raw | ~mask);
+
+                        //signed values are handed over sign extended, only the low sigSize bits may be used
+                        QByteArray data = original;
+                        QVERIFY(encoder.insert(data, static_cast<uint64_t>(expected)));
+                        if (extractor.extract(data) != expected)
+                        {
+                            QFAIL(qPrintable(QString("start %1 size %2 intel %3 signed %4: got %5 expected %6")
+                                             .arg(startBit).arg(sigSize).arg(intel).arg(isSigned)
+                                             .arg(extractor.extract(data)).arg(expected)));
+                        }
+
+                        QVERIFY(encoder.insert(data, static_cast<uint64_t>(extractor.extract(original))));
+                        if (data != original)
+                        {
+                            QFAIL(qPrintable(QString("start %1 size %2 intel %3 signed %4: bits outside the signal changed")
+                                             .arg(startBit).arg(sigSize).arg(intel).arg(isSigned)));
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    //a payload too short for the signal is left alone
+    QByteArray shortData(length, 0x55);
+    SignalEncoder tooLong(length * 8 - 4, 12, true);
+    QVERIFY(!tooLong.insert(shortData, 0xFFF));
+    QCOMPARE(shortData, QByteArray(length, 0x55));
+}
@@ -0,0 +1,16 @@
+#ifndef TST_SIGNALENCODER_H
+#define TST_SIGNALENCODER_H
+
+#include <QObject>
+
+class TestSignalEncoder: public QObject
+{
+    Q_OBJECT
+private:
+
+private slots:
+    void roundTrip_data();
+    void roundTrip();
+};
+
+#endif // TST_SIGNALENCODER_H
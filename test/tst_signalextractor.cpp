@@ -0,0 +1,104 @@
+#include <QtTest>
+
+#include "utility.h"
+#include "utils/signalextractor.h"
+#include "tst_signalextractor.h"
+
+
+
+void TestSignalExtractor::matchesReference_data()
+{
+    QTest::addColumn<int>("length");
+
+    QTest::newRow("empty")  << 0;
+    QTest::newRow("3")      << 3;
+    QTest::newRow("8")      << 8;
+    QTest::newRow("12")     << 12;
+    QTest::newRow("20")     << 20;
+    QTest::newRow("64")     << 64;
+}
+
+
+//every start bit (including ones past the end of the payload), every length and both byte orders
+void TestSignalExtractor::matchesReference()
+{
+    QFETCH(int, length);
+
+    QRandomGenerator rng(length + 1);
+    for (int pass = 0; pass < 4; pass++)
+    {
+        QByteArray data(length, 0);
+        for (int i = 0; i < length; i++) data[i] = static_cast<char>(rng.bounded(256));
+
+        for (int startBit = 0; startBit < length * 8 + 16; startBit++)
+        {
+            for (int sigSize = 1; sigSize <= 64; sigSize++)
+            {
+                for (int intel = 0; intel < 2; intel++)
+                {
+                    for (int isSigned = 0; isSigned < 2; isSigned++)
+                    {
+                        //the reference sign extends 64 bit signals with an out of range shift, skip those
+                        if (isSigned && sigSize == 64) continue;
+                        SignalExtractor extractor(startBit, sigSize, intel, isSigned);
+                        int64_t expected = Utility::processIntegerSignal(data, startBit, sigSize, intel, isSigned);
+                        if (extractor.extract(data) != expected)
+                        {
+                            QFAIL(qPrintable(QString("start %1 size %2 intel %3 signed %4: got %5 expected %6")
+                                             .arg(startBit).arg(sigSize).arg(intel).arg(isSigned)
+                                             .arg(extractor.extract(data)).arg(expected)));
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+
+void TestSignalExtractor::benchmark_data()
+{
+    QTest::addColumn<bool>("compiled");
+    QTest::addColumn<bool>("intel");
+
+    QTest::newRow("reference intel")     << false << true;
+    QTest::newRow("compiled intel")      << true  << true;
+    QTest::newRow("reference motorola")  << false << false;
+    QTest::newRow("compiled motorola")   << true  << false;
+}
+
+
+//decodes a 12 bit signal out of 100k classic frames
+void TestSignalExtractor::benchmark()
+{
+    QFETCH(bool, compiled);
+    QFETCH(bool, intel);
+
+    const int numFrames = 100000;
+    QVector<QByteArray> payloads(numFrames);
+    QRandomGenerator rng(1234);
+    for (int i = 0; i < numFrames; i++)
+    {
+        payloads[i] = QByteArray(8, 0);
+        for (int b = 0; b < 8; b++) payloads[i][b] = static_cast<char>(rng.bounded(256));
+    }
+
+    const int startBit = intel ? 13 : 21;
+    const int sigSize = 12;
+    int64_t sum = 0;
+
+    if (compiled)
+    {
+        SignalExtractor extractor(startBit, sigSize, intel, true);
+        QBENCHMARK {
+            for (int i = 0; i < numFrames; i++) sum += extractor.extract(payloads[i]);
+        }
+    }
+    else
+    {
+        QBENCHMARK {
+            for (int i = 0; i < numFrames; i++) sum += Utility::processIntegerSignal(payloads[i], startBit, sigSize, intel, true);
+        }
+    }
+    QVERIFY(sum != 0x7FFFFFFFFFFFFFFFLL); //keep the loop from being optimized away
+}
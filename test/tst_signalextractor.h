@@ -0,0 +1,18 @@
+#ifndef TST_SIGNALEXTRACTOR_H
+#define TST_SIGNALEXTRACTOR_H
+
+#include <QObject>
+
+class TestSignalExtractor: public QObject
+{
+    Q_OBJECT
+private:
+
+private slots:
+    void matchesReference_data();
+    void matchesReference();
+    void benchmark_data();
+    void benchmark();
+};
+
+#endif // TST_SIGNALEXTRACTOR_H
@@ -0,0 +1,153 @@
+#ifndef FLATIDMAP_H
+#define FLATIDMAP_H
+
+#include <QVector>
+#include <stdint.h>
+
+/*
+ * Hash table keyed by message ID for the spots that look an ID up for every frame received.
+ *
+ * Open addressing with linear probing in one flat array, so a lookup is a multiply, a shift and usually a single
+ * slot compare instead of walking a tree or following bucket chains. IDs tend to come in runs (0x100, 0x101 ...),
+ * Fibonacci hashing spreads those over the table. The table doubles once it is 70% full and removal shifts the
+ * following entries back instead of leaving tombstones, so lookups never slow down after IDs come and go.
+ *
+ * Pointers handed out by find() and insert() are good until the next insert.
+ */
+template <typename T>
+class FlatIDMap
+{
+public:
+    FlatIDMap()
+    {
+        clear();
+    }
+
+    void clear()
+    {
+        table.clear();
+        table.resize(minCapacity);
+        mask = minCapacity - 1;
+        shift = 32 - minCapacityBits;
+        used = 0;
+    }
+
+    int count() const { return used; }
+    bool isEmpty() const { return used == 0; }
+    bool contains(uint32_t key) const { return find(key) != nullptr; }
+
+    T *find(uint32_t key)
+    {
+        int idx = locate(key);
+        return (idx < 0) ? nullptr : &table[idx].value;
+    }
+
+    const T *find(uint32_t key) const
+    {
+        int idx = locate(key);
+        return (idx < 0) ? nullptr : &table[idx].value;
+    }
+
+    //adds the key or replaces its value
+    T &insert(uint32_t key, const T &value)
+    {
+        if ((used + 1) * 10 > table.count() * 7) grow();
+        int idx = home(key);
+        while (table[idx].used)
+        {
+            if (table[idx].key == key)
+            {
+                table[idx].value = value;
+                return table[idx].value;
+            }
+            idx = (idx + 1) & mask;
+        }
+        table[idx].used = true;
+        table[idx].key = key;
+        table[idx].value = value;
+        used++;
+        return table[idx].value;
+    }
+
+    bool remove(uint32_t key)
+    {
+        int idx = locate(key);
+        if (idx < 0) return false;
+
+        //pull back every entry after the hole that would otherwise no longer be reachable from its home slot
+        int next = idx;
+        for (;;)
+        {
+            next = (next + 1) & mask;
+            if (!table[next].used) break;
+            int nextHome = home(table[next].key);
+            bool reachable = (next > idx) ? (nextHome > idx && nextHome <= next) : (nextHome > idx || nextHome <= next);
+            if (reachable) continue;
+            table[idx] = table[next];
+            idx = next;
+        }
+        table[idx].used = false;
+        table[idx].value = T();
+        used--;
+        return true;
+    }
+
+    //calls func(key, value) for every entry, in no particular order. Don't insert or remove from inside it
+    template <typename Func>
+    void forEach(Func func)
+    {
+        for (Slot &slot : table)
+        {
+            if (slot.used) func(slot.key, slot.value);
+        }
+    }
+
+private:
+    struct Slot
+    {
+        Slot() : key(0), used(false), value() {}
+        uint32_t key;
+        bool used;
+        T value;
+    };
+
+    static const int minCapacityBits = 6;
+    static const int minCapacity = 1 << minCapacityBits;
+
+    int home(uint32_t key) const
+    {
+        return static_cast<int>((key * 2654435769u) >> shift);
+    }
+
+    int locate(uint32_t key) const
+    {
+        int idx = home(key);
+        while (table[idx].used)
+        {
+            if (table[idx].key == key) return idx;
+            idx = (idx + 1) & mask;
+        }
+        return -1;
+    }
+
+    void grow()
+    {
+        QVector<Slot> old = table;
+        table.clear();
+        table.resize(old.count() * 2);
+        mask = table.count() - 1;
+        shift--;
+        used = 0;
+        for (const Slot &slot : old)
+        {
+            if (slot.used) insert(slot.key, slot.value);
+        }
+    }
+
+    QVector<Slot> table;
+    int mask;
+    int shift;
+    int used;
+};
+
+#endif // FLATIDMAP_H
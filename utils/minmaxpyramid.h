@@ -0,0 +1,203 @@
+#ifndef MINMAXPYRAMID_H
+#define MINMAXPYRAMID_H
+
+#include <QVector>
+#include <algorithm>
+
+/*
+ * Level of detail index over a long x / y series so a plot only has to be handed about two points per pixel column.
+ *
+ * Level 0 cuts the series into buckets of baseBucket points, every level above has buckets fanOut times larger.
+ * A bucket remembers where its smallest and largest y are. Drawing a bucket as just those two points (in the order
+ * they occur) keeps every spike and dip visible no matter how far zoomed out. The series itself isn't copied,
+ * buckets hold indexes into the caller's vectors.
+ *
+ * update() indexes whatever was appended since the last call so live capture only pays for the new points.
+ * query() picks the finest level that fits the requested number of columns, or the raw points once zoomed in far
+ * enough that there are fewer of them than that. Lookups by x need x to never go backwards. If it does (clock style
+ * timestamps wrapping at midnight) the index notices and query() simply returns the whole series.
+ */
+class MinMaxPyramid
+{
+public:
+    MinMaxPyramid()
+    {
+        clear();
+    }
+
+    void clear()
+    {
+        levels.clear();
+        levels.append(QVector<Bucket>());
+        indexed = 0;
+        monotonic = true;
+    }
+
+    void rebuild(const QVector<double> &x, const QVector<double> &y)
+    {
+        clear();
+        update(x, y);
+    }
+
+    void update(const QVector<double> &x, const QVector<double> &y)
+    {
+        int count = qMin(x.count(), y.count());
+        for (int i = indexed; i < count; i++)
+        {
+            if (i > 0 && x[i] < x[i - 1]) monotonic = false;
+            int size = baseBucket;
+            for (int l = 0; l < levels.count(); l++)
+            {
+                addPoint(levels[l], i / size, i, y);
+                size *= fanOut;
+            }
+        }
+        indexed = qMax(indexed, count);
+
+        //grow another level whenever the top one gets long enough to be worth summarizing
+        while (levels.last().count() > fanOut * maxTopBuckets) addLevel(y);
+    }
+
+    bool isMonotonic() const { return monotonic; }
+
+    /*
+     * Smallest and largest x and y of the whole indexed series. y comes from the top level so this is a few hundred
+     * compares however long the series is, x is the two ends unless it ever went backwards. False if there are no points.
+     */
+    bool extents(const QVector<double> &x, const QVector<double> &y, double &xMin, double &xMax, double &yMin, double &yMax) const
+    {
+        int count = qMin(indexed, qMin(x.count(), y.count()));
+        if (count == 0) return false;
+
+        if (monotonic)
+        {
+            xMin = x[0];
+            xMax = x[count - 1];
+        }
+        else
+        {
+            xMin = xMax = x[0];
+            for (int i = 1; i < count; i++)
+            {
+                if (x[i] < xMin) xMin = x[i];
+                if (x[i] > xMax) xMax = x[i];
+            }
+        }
+
+        const QVector<Bucket> &top = levels.last();
+        yMin = y[top[0].minIdx];
+        yMax = y[top[0].maxIdx];
+        for (int b = 1; b < top.count(); b++)
+        {
+            if (y[top[b].minIdx] < yMin) yMin = y[top[b].minIdx];
+            if (y[top[b].maxIdx] > yMax) yMax = y[top[b].maxIdx];
+        }
+        return true;
+    }
+
+    /*
+     * The points to draw for lower <= x <= upper across columns pixel columns. One point on either side of the range
+     * is included so lines run off the edge of the plot instead of stopping short.
+     */
+    void query(const QVector<double> &x, const QVector<double> &y, double lower, double upper, int columns,
+               QVector<double> &outX, QVector<double> &outY) const
+    {
+        outX.clear();
+        outY.clear();
+        int count = qMin(indexed, qMin(x.count(), y.count()));
+        if (!monotonic || count == 0 || columns < 1)
+        {
+            outX = x.mid(0, count);
+            outY = y.mid(0, count);
+            return;
+        }
+
+        int lo = static_cast<int>(std::lower_bound(x.constBegin(), x.constBegin() + count, lower) - x.constBegin());
+        int hi = static_cast<int>(std::upper_bound(x.constBegin(), x.constBegin() + count, upper) - x.constBegin());
+        lo = qMax(0, lo - 1);
+        hi = qMin(count, hi + 1);
+        int span = hi - lo;
+
+        if (span <= 2 * columns)
+        {
+            outX = x.mid(lo, span);
+            outY = y.mid(lo, span);
+            return;
+        }
+
+        int level = 0;
+        int size = baseBucket;
+        while (level + 1 < levels.count() && (span / size) > columns)
+        {
+            level++;
+            size *= fanOut;
+        }
+
+        const QVector<Bucket> &buckets = levels[level];
+        int firstBucket = lo / size;
+        int lastBucket = qMin((hi - 1) / size, buckets.count() - 1);
+        outX.reserve((lastBucket - firstBucket + 1) * 2 + 2);
+        outY.reserve((lastBucket - firstBucket + 1) * 2 + 2);
+        for (int b = firstBucket; b <= lastBucket; b++)
+        {
+            int first = qMin(buckets[b].minIdx, buckets[b].maxIdx);
+            int second = qMax(buckets[b].minIdx, buckets[b].maxIdx);
+            outX.append(x[first]);
+            outY.append(y[first]);
+            if (second != first)
+            {
+                outX.append(x[second]);
+                outY.append(y[second]);
+            }
+        }
+    }
+
+private:
+    struct Bucket
+    {
+        int minIdx;
+        int maxIdx;
+    };
+
+    static const int baseBucket = 16;
+    static const int fanOut = 4;
+    static const int maxTopBuckets = 256;
+
+    static void addPoint(QVector<Bucket> &buckets, int bucketIdx, int pointIdx, const QVector<double> &y)
+    {
+        if (bucketIdx >= buckets.count())
+        {
+            buckets.append(Bucket{pointIdx, pointIdx});
+            return;
+        }
+        Bucket &bucket = buckets[bucketIdx];
+        if (y[pointIdx] < y[bucket.minIdx]) bucket.minIdx = pointIdx;
+        if (y[pointIdx] > y[bucket.maxIdx]) bucket.maxIdx = pointIdx;
+    }
+
+    //builds the next level up out of the current top one
+    void addLevel(const QVector<double> &y)
+    {
+        const QVector<Bucket> &below = levels.last();
+        QVector<Bucket> above;
+        above.reserve(below.count() / fanOut + 1);
+        for (int b = 0; b < below.count(); b++)
+        {
+            if (b % fanOut == 0)
+            {
+                above.append(below[b]);
+                continue;
+            }
+            Bucket &bucket = above.last();
+            if (y[below[b].minIdx] < y[bucket.minIdx]) bucket.minIdx = below[b].minIdx;
+            if (y[below[b].maxIdx] > y[bucket.maxIdx]) bucket.maxIdx = below[b].maxIdx;
+        }
+        levels.append(above);
+    }
+
+    QVector<QVector<Bucket>> levels;
+    int indexed;
+    bool monotonic;
+};
+
+#endif // MINMAXPYRAMID_H
@@ -0,0 +1,127 @@
+#ifndef SIGNALENCODER_H
+#define SIGNALENCODER_H
+
+#include <QByteArray>
+#include <QtEndian>
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * The reverse of SignalExtractor: a signal layout compiled to a byte offset, a shift and a mask so a raw value can
+ * be dropped into a payload with one or two word loads and stores instead of setting every bit on its own.
+ * Uses the same bit numbering. Intel signals are a run of bits counting up from startBit, Motorola signals are a
+ * run in the big endian bit stream starting at their MSB. Bits of the payload outside the signal are left alone.
+ */
+class SignalEncoder
+{
+public:
+    SignalEncoder()
+    {
+        compile(0, 0, true);
+    }
+
+    SignalEncoder(int startBit, int sigSize, bool littleEndian)
+    {
+        compile(startBit, sigSize, littleEndian);
+    }
+
+    void compile(int startBit, int sigSize, bool littleEndian)
+    {
+        mStartBit = startBit;
+        mSigSize = sigSize;
+        mLittleEndian = littleEndian;
+
+        mValid = (startBit >= 0 && sigSize > 0 && sigSize <= 64);
+        mFirstByte = startBit / 8;
+        if (littleEndian)
+        {
+            mLead = startBit % 8;
+            mLastByte = (startBit + sigSize - 1) / 8;
+        }
+        else
+        {
+            mLead = 7 - (startBit % 8);
+            mLastByte = mFirstByte + ((mLead + sigSize - 1) / 8);
+        }
+        if (!mValid) mLastByte = 0x7FFFFFFF;
+        mNinthByte = mValid && ((mLead + sigSize) > 64);
+        mMask = (sigSize >= 64) ? ~0ULL : ((1ULL << sigSize) - 1);
+    }
+
+    bool isCompiledFor(int startBit, int sigSize, bool littleEndian) const
+    {
+        return mStartBit == startBit && mSigSize == sigSize && mLittleEndian == littleEndian;
+    }
+
+    bool isValid() const { return mValid; }
+
+    //number of payload bytes a frame needs to hold this signal
+    int bytesNeeded() const { return mLastByte + 1; }
+
+    bool fits(int payloadLen) const { return mLastByte < payloadLen; }
+
+    //puts the low sigSize bits of raw into the payload. False if the payload is too short to hold the signal
+    bool insert(QByteArray &data, uint64_t raw) const
+    {
+        if (!fits(data.size())) return false;
+        insert(reinterpret_cast<unsigned char *>(data.data()), data.size(), raw);
+        return true;
+    }
+
+    void insert(unsigned char *data, int len, uint64_t raw) const
+    {
+        if (!mValid || !fits(len)) return;
+
+        unsigned char *dest = data + mFirstByte;
+        int windowLen = qMin(8, len - mFirstByte);
+        uint64_t word = 0;
+        memcpy(&word, dest, windowLen);
+        raw &= mMask;
+
+        if (mLittleEndian)
+        {
+            uint64_t value = qFromLittleEndian<quint64>(word);
+            value = (value & ~(mMask << mLead)) | (raw << mLead);
+            word = qToLittleEndian<quint64>(value);
+            if (mNinthByte)
+            {
+                int extra = (mLead + mSigSize) - 64; //bits that go to the bottom of the ninth byte
+                uint8_t extraMask = static_cast<uint8_t>((1u << extra) - 1);
+                dest[8] = static_cast<unsigned char>((dest[8] & ~extraMask) | ((raw >> (64 - mLead)) & extraMask));
+            }
+        }
+        else
+        {
+            uint64_t value = qFromBigEndian<quint64>(word);
+            if (mNinthByte)
+            {
+                int extra = (mLead + mSigSize) - 64; //bits that go to the top of the ninth byte
+                uint64_t wordMask = ~0ULL >> mLead;
+                value = (value & ~wordMask) | ((raw >> extra) & wordMask);
+                uint8_t extraMask = static_cast<uint8_t>(((1u << extra) - 1) << (8 - extra));
+                uint8_t extraBits = static_cast<uint8_t>((raw & ((1ULL << extra) - 1)) << (8 - extra));
+                dest[8] = static_cast<unsigned char>((dest[8] & ~extraMask) | extraBits);
+            }
+            else
+            {
+                int shift = 64 - mLead - mSigSize;
+                value = (value & ~(mMask << shift)) | (raw << shift);
+            }
+            word = qToBigEndian<quint64>(value);
+        }
+        memcpy(dest, &word, windowLen);
+    }
+
+private:
+    int mStartBit;
+    int mSigSize;
+    bool mLittleEndian;
+    bool mValid;
+    bool mNinthByte;
+    int mFirstByte;
+    int mLastByte;
+    int mLead;
+    uint64_t mMask;
+};
+
+#endif // SIGNALENCODER_H
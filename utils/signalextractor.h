@@ -0,0 +1,233 @@
+#ifndef SIGNALEXTRACTOR_H
+#define SIGNALEXTRACTOR_H
+
+#include <QByteArray>
+#include <QtEndian>
+#include <stdint.h>
+#include <string.h>
+#include "can_structs.h"
+
+/*
+ * A signal layout (start bit, length, byte order, signedness) compiled down to a byte offset, a shift and a mask.
+ * Pulling the value out of a payload is then one or two word loads, a shift, a mask and an optional sign extend
+ * instead of a loop over every bit. Gives exactly the same results as Utility::processIntegerSignal, including
+ * returning 0 when the signal runs past the end of the payload.
+ *
+ * Intel (little endian) signals are a run of bits counting up from startBit.
+ * Motorola (big endian) signals start at their MSB and walk down through the byte and then on to bit 7 of the
+ * next byte. Numbered as a big endian bit stream that is also just a run of bits, so both orders turn into
+ * "load a word starting at firstByte, shift and mask". A signal that is not byte aligned can spill into a
+ * ninth byte, that byte is loaded separately.
+ *
+ * For bulk work extractBatch() splits decoding in two: the bytes each frame's signal lives in are first gathered
+ * into a plain array of words, then one branch free loop does the byte swap / shift / mask / sign extend for the
+ * whole array. Those loops are written so the compiler can vectorize them, as is applyScale().
+ */
+class SignalExtractor
+{
+public:
+    SignalExtractor()
+    {
+        compile(0, 0, true, false);
+    }
+
+    SignalExtractor(int startBit, int sigSize, bool littleEndian, bool isSigned)
+    {
+        compile(startBit, sigSize, littleEndian, isSigned);
+    }
+
+    void compile(int startBit, int sigSize, bool littleEndian, bool isSigned)
+    {
+        mStartBit = startBit;
+        mSigSize = sigSize;
+        mLittleEndian = littleEndian;
+        mSigned = isSigned && sigSize < 64;
+
+        mValid = (startBit >= 0 && sigSize > 0 && sigSize <= 64);
+        mFirstByte = startBit / 8;
+        if (littleEndian)
+        {
+            mLead = startBit % 8; //bits to drop at the bottom of the first byte
+            mLastByte = (startBit + sigSize - 1) / 8;
+        }
+        else
+        {
+            mLead = 7 - (startBit % 8); //bits to drop at the top of the first byte
+            mLastByte = mFirstByte + ((mLead + sigSize - 1) / 8);
+        }
+        if (!mValid) mLastByte = 0x7FFFFFFF; //never fits so extract() always returns 0
+        mNinthByte = mValid && ((mLead + sigSize) > 64);
+        mMaxBytes = (startBit + sigSize) / 8;
+        mMask = (sigSize >= 64) ? ~0ULL : ((1ULL << sigSize) - 1);
+        mSignBit = (sigSize >= 1 && sigSize <= 64) ? (1ULL << (sigSize - 1)) : 0;
+    }
+
+    bool isCompiledFor(int startBit, int sigSize, bool littleEndian, bool isSigned) const
+    {
+        return mStartBit == startBit && mSigSize == sigSize && mLittleEndian == littleEndian
+            && mSigned == (isSigned && sigSize < 64);
+    }
+
+    bool isValid() const { return mValid; }
+
+    //number of payload bytes a frame needs for this signal to be decodable
+    int bytesNeeded() const { return mLastByte + 1; }
+
+    bool fits(int payloadLen) const { return mLastByte < payloadLen; }
+
+    int64_t extract(const QByteArray &data) const
+    {
+        return extract(reinterpret_cast<const unsigned char *>(data.constData()), data.size());
+    }
+
+    int64_t extract(const unsigned char *data, int len) const
+    {
+        uint64_t word;
+        uint8_t ninth;
+        gatherWindow(data, len, word, ninth);
+        return decodeWord(word, ninth);
+    }
+
+    /*
+     * Raw signal values for frames[0], frames[stride], ... (count of them) into out. Frames with a payload shorter
+     * than minLength get 0 and, if valid is given, valid[i] = false. The same minLength rule lets callers mirror the
+     * length checks DBC_SIGNAL::processAsDouble does.
+     */
+    void extractBatch(const CANFrame *frames, int count, int stride, int64_t *out, bool *valid = nullptr, int minLength = 0) const
+    {
+        const int blockSize = 1024;
+        uint64_t words[blockSize];
+        uint8_t ninths[blockSize];
+
+        for (int base = 0; base < count; base += blockSize)
+        {
+            int n = qMin(blockSize, count - base);
+            for (int i = 0; i < n; i++)
+            {
+                const QByteArray payload = frames[static_cast<qsizetype>(base + i) * stride].payload();
+                bool ok = payload.size() >= minLength;
+                gatherWindow(reinterpret_cast<const unsigned char *>(payload.constData()), ok ? payload.size() : 0, words[i], ninths[i]);
+                if (valid) valid[base + i] = ok;
+            }
+            decodeWindows(words, ninths, n, out + base);
+        }
+    }
+
+    //out[i] = raw[i] * factor + bias
+    static void applyScale(const int64_t *raw, int count, double factor, double bias, double *out)
+    {
+        for (int i = 0; i < count; i++) out[i] = (static_cast<double>(raw[i]) * factor) + bias;
+    }
+
+private:
+    //copies the bytes the signal lives in into word (in payload byte order) and the ninth byte if there is one.
+    //Payloads that are too short give a zero word which decodes to 0.
+    void gatherWindow(const unsigned char *data, int len, uint64_t &word, uint8_t &ninth) const
+    {
+        if (mLastByte >= len)
+        {
+            gatherPastEnd(data, len, word, ninth);
+            return;
+        }
+
+        const unsigned char *src = data + mFirstByte;
+        if (len - mFirstByte >= 8) //classic 8 byte frames with the signal anywhere in the frame end up here
+        {
+            memcpy(&word, src, 8);
+        }
+        else
+        {
+            word = 0;
+            memcpy(&word, src, len - mFirstByte);
+        }
+        ninth = mNinthByte ? src[8] : 0;
+    }
+
+    //processIntegerSignal treats a signal running past the end of the payload as an error except that bits past
+    //the 64 byte CAN-FD maximum silently read as zero. Rare enough that it just gets a zero padded copy.
+    void gatherPastEnd(const unsigned char *data, int len, uint64_t &word, uint8_t &ninth) const
+    {
+        word = 0;
+        ninth = 0;
+        if (!mValid || len < 64 || mMaxBytes > len) return;
+        unsigned char padded[80];
+        memset(padded, 0, sizeof(padded));
+        memcpy(padded, data, 64);
+        gatherWindow(padded, sizeof(padded), word, ninth);
+    }
+
+    uint64_t signExtend(uint64_t value) const
+    {
+        const uint64_t sign = mSigned ? mSignBit : 0;
+        return (value ^ sign) - sign;
+    }
+
+    int64_t decodeWord(uint64_t word, uint8_t ninth) const
+    {
+        if (!mValid) return 0;
+        uint64_t value;
+        if (mLittleEndian)
+        {
+            value = qFromLittleEndian<quint64>(word) >> mLead;
+            if (mNinthByte) value |= static_cast<uint64_t>(ninth) << (64 - mLead);
+            value &= mMask;
+        }
+        else
+        {
+            value = qFromBigEndian<quint64>(word);
+            if (mNinthByte)
+            {
+                int extra = (mLead + mSigSize) - 64; //bits that come from the top of the ninth byte
+                value = ((value & (~0ULL >> mLead)) << extra) | (static_cast<uint64_t>(ninth) >> (8 - extra));
+            }
+            else value = (value << mLead) >> (64 - mSigSize);
+        }
+        return static_cast<int64_t>(signExtend(value));
+    }
+
+    void decodeWindows(const uint64_t *words, const uint8_t *ninths, int count, int64_t *out) const
+    {
+        //signals spilling into a ninth byte are long and unaligned, not worth a special loop
+        if (mNinthByte || !mValid)
+        {
+            for (int i = 0; i < count; i++) out[i] = decodeWord(words[i], ninths[i]);
+            return;
+        }
+
+        const int lead = mLead;
+        const uint64_t mask = mMask;
+        const uint64_t sign = mSigned ? mSignBit : 0;
+        if (mLittleEndian)
+        {
+            for (int i = 0; i < count; i++)
+            {
+                uint64_t value = (qFromLittleEndian<quint64>(words[i]) >> lead) & mask;
+                out[i] = static_cast<int64_t>((value ^ sign) - sign);
+            }
+        }
+        else
+        {
+            const int tail = 64 - mSigSize;
+            for (int i = 0; i < count; i++)
+            {
+                uint64_t value = (qFromBigEndian<quint64>(words[i]) << lead) >> tail;
+                out[i] = static_cast<int64_t>((value ^ sign) - sign);
+            }
+        }
+    }
+
+    int mStartBit;
+    int mSigSize;
+    bool mLittleEndian;
+    bool mSigned;
+    bool mValid;
+    bool mNinthByte;
+    int mFirstByte;
+    int mLastByte;
+    int mLead;
+    int mMaxBytes;
+    uint64_t mMask;
+    uint64_t mSignBit;
+};
+
+#endif // SIGNALEXTRACTOR_H
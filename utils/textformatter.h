@@ -0,0 +1,324 @@
+#ifndef TEXTFORMATTER_H
+#define TEXTFORMATTER_H
+
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QIODevice>
+#include <QThread>
+#include <QVector>
+#include <QtConcurrent/QtConcurrentMap>
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * Fast text formatter used by the frame file savers. Everything is appended into a single
+ * preallocated byte buffer with table driven hex / decimal conversion instead of building
+ * a QString for every field. The finished buffer is then written to the output device in one go.
+ *
+ * writeChunked() splits a frame range into large chunks, formats several of them in parallel on
+ * the global thread pool and writes the finished blocks to the device in their original order.
+ */
+class TextFormatter
+{
+public:
+    explicit TextFormatter(int reserveBytes = 1 << 20)
+    {
+        mBuf.resize(reserveBytes);
+        mPos = 0;
+    }
+
+    int size() const { return mPos; }
+    void clear() { mPos = 0; }
+
+    //returns the formatted text and resets the formatter
+    QByteArray take()
+    {
+        mBuf.resize(mPos);
+        QByteArray out = std::move(mBuf);
+        mBuf = QByteArray();
+        mPos = 0;
+        return out;
+    }
+
+    bool flushTo(QIODevice *dev)
+    {
+        if (mPos == 0) return true;
+        bool ok = (dev->write(mBuf.constData(), mPos) == mPos);
+        mPos = 0;
+        return ok;
+    }
+
+    void appendChar(char c)
+    {
+        ensure(1);
+        mBuf.data()[mPos++] = c;
+    }
+
+    void appendChars(char c, int count)
+    {
+        if (count <= 0) return;
+        ensure(count);
+        char *out = mBuf.data() + mPos;
+        for (int i = 0; i < count; i++) out[i] = c;
+        mPos += count;
+    }
+
+    void append(const char *str, int len)
+    {
+        ensure(len);
+        memcpy(mBuf.data() + mPos, str, len);
+        mPos += len;
+    }
+
+    //string literals. The length is known at compile time so no strlen is needed
+    template <int N>
+    void append(const char (&str)[N])
+    {
+        append(str, N - 1);
+    }
+
+    void append(const QByteArray &str)
+    {
+        append(str.constData(), str.size());
+    }
+
+    //upper case hex with at least minDigits digits, zero filled. Same output as
+    //QString::number(value, 16).toUpper().rightJustified(minDigits, '0')
+    void appendHex(uint64_t value, int minDigits = 1)
+    {
+        int digits = 1;
+        for (uint64_t v = value >> 4; v; v >>= 4) digits++;
+        if (digits < minDigits) digits = minDigits;
+        ensure(digits);
+        char *out = mBuf.data() + mPos + digits;
+        const char *table = hexPairs();
+        int remaining = digits;
+        while (remaining >= 2)
+        {
+            const char *pair = table + ((value & 0xFF) * 2);
+            *--out = pair[1];
+            *--out = pair[0];
+            value >>= 8;
+            remaining -= 2;
+        }
+        if (remaining) *--out = table[((value & 0xF) * 2) + 1];
+        mPos += digits;
+    }
+
+    //a single byte as exactly two upper case hex digits
+    void appendHexByte(uint8_t value)
+    {
+        ensure(2);
+        const char *pair = hexPairs() + (value * 2);
+        char *out = mBuf.data() + mPos;
+        out[0] = pair[0];
+        out[1] = pair[1];
+        mPos += 2;
+    }
+
+    //payload bytes as hex, each byte followed by the separator (if any)
+    void appendHexBytes(const unsigned char *data, int len, const char *separator = nullptr, int sepLen = 0)
+    {
+        ensure(len * (2 + sepLen));
+        const char *table = hexPairs();
+        char *out = mBuf.data() + mPos;
+        for (int i = 0; i < len; i++)
+        {
+            const char *pair = table + (data[i] * 2);
+            *out++ = pair[0];
+            *out++ = pair[1];
+            for (int s = 0; s < sepLen; s++) *out++ = separator[s];
+        }
+        mPos += len * (2 + sepLen);
+    }
+
+    //unsigned decimal, right justified to width using the given fill character
+    void appendDec(uint64_t value, int width = 0, char fill = ' ')
+    {
+        char tmp[20];
+        int len = formatDec(value, tmp);
+        if (width > len) appendChars(fill, width - len);
+        append(tmp + 20 - len, len);
+    }
+
+    void appendSignedDec(int64_t value, int width = 0, char fill = ' ')
+    {
+        if (value >= 0)
+        {
+            appendDec(static_cast<uint64_t>(value), width, fill);
+            return;
+        }
+        char tmp[21];
+        int len = formatDec(0 - static_cast<uint64_t>(value), tmp + 1) + 1;
+        tmp[21 - len] = '-';
+        if (width > len) appendChars(fill, width - len);
+        append(tmp + 21 - len, len);
+    }
+
+    /*
+     * Fixed point output of an integer value that is scaled by 10^scaleDigits. For instance a microsecond
+     * timestamp has scaleDigits = 6 and appendFixed(ts, 6, 6) gives the same text as
+     * QString::number(ts / 1000000.0, 'f', 6) without ever going through a double. If precision is
+     * smaller than scaleDigits the value is rounded half away from zero.
+     */
+    void appendFixed(int64_t value, int scaleDigits, int precision, int width = 0, char fill = ' ')
+    {
+        bool negative = value < 0;
+        uint64_t mag = negative ? (0 - static_cast<uint64_t>(value)) : static_cast<uint64_t>(value);
+        if (precision > scaleDigits) precision = scaleDigits;
+        if (precision < 0) precision = 0;
+        uint64_t drop = pow10(scaleDigits - precision);
+        if (drop > 1) mag = (mag + (drop / 2)) / drop;
+        uint64_t fracScale = pow10(precision);
+        uint64_t whole = mag / fracScale;
+        uint64_t frac = mag % fracScale;
+
+        char tmp[44];
+        char *end = tmp + sizeof(tmp);
+        char *p = end;
+        for (int i = 0; i < precision; i++)
+        {
+            *--p = static_cast<char>('0' + (frac % 10));
+            frac /= 10;
+        }
+        if (precision > 0) *--p = '.';
+        char digits[20];
+        int wholeLen = formatDec(whole, digits);
+        p -= wholeLen;
+        memcpy(p, digits + 20 - wholeLen, wholeLen);
+        if (negative) *--p = '-';
+        int len = static_cast<int>(end - p);
+        if (width > len) appendChars(fill, width - len);
+        append(p, len);
+    }
+
+    /*
+     * Formats frames [0, count) into the device. encodeRange(TextFormatter &out, int first, int last) is called
+     * for consecutive ranges of chunkSize frames and must append the text for frames [first, last). Ranges are
+     * formatted in parallel, so encodeRange must only read shared state. Chunks are written in frame order and the
+     * event loop gets a chance to run between batches just like the old per line processEvents() did.
+     */
+    template <typename Fn>
+    static bool writeChunked(QIODevice *dev, int count, Fn encodeRange, int chunkSize = 16384)
+    {
+        if (count <= 0) return true;
+
+        const int threads = qMax(1, QThread::idealThreadCount());
+        if (threads == 1 || count <= chunkSize)
+        {
+            TextFormatter out;
+            for (int first = 0; first < count; first += chunkSize)
+            {
+                encodeRange(out, first, qMin(count, first + chunkSize));
+                if (!out.flushTo(dev)) return false;
+                QCoreApplication::processEvents();
+            }
+            return true;
+        }
+
+        QVector<QByteArray> blocks(threads);
+        QVector<int> chunks;
+        chunks.reserve(threads);
+        for (int base = 0; base < count; base += chunkSize * threads)
+        {
+            chunks.clear();
+            for (int i = 0; i < threads && (base + i * chunkSize) < count; i++) chunks.append(i);
+
+            QByteArray *blockData = blocks.data();
+            QtConcurrent::blockingMap(chunks, [&](const int &chunk)
+            {
+                int first = base + chunk * chunkSize;
+                TextFormatter out(chunkSize * 48);
+                encodeRange(out, first, qMin(count, first + chunkSize));
+                blockData[chunk] = out.take();
+            });
+
+            for (int i = 0; i < chunks.count(); i++)
+            {
+                if (dev->write(blocks[i]) != blocks[i].size()) return false;
+                blocks[i].clear();
+            }
+            QCoreApplication::processEvents();
+        }
+        return true;
+    }
+
+private:
+    struct HexPairTable
+    {
+        char chars[512];
+        constexpr HexPairTable() : chars()
+        {
+            const char digits[] = "0123456789ABCDEF";
+            for (int i = 0; i < 256; i++)
+            {
+                chars[i * 2] = digits[i >> 4];
+                chars[i * 2 + 1] = digits[i & 0xF];
+            }
+        }
+    };
+
+    struct DecPairTable
+    {
+        char chars[200];
+        constexpr DecPairTable() : chars()
+        {
+            for (int i = 0; i < 100; i++)
+            {
+                chars[i * 2] = static_cast<char>('0' + (i / 10));
+                chars[i * 2 + 1] = static_cast<char>('0' + (i % 10));
+            }
+        }
+    };
+
+    static const char *hexPairs()
+    {
+        static constexpr HexPairTable table;
+        return table.chars;
+    }
+
+    static const char *decPairs()
+    {
+        static constexpr DecPairTable table;
+        return table.chars;
+    }
+
+    static uint64_t pow10(int exp)
+    {
+        uint64_t result = 1;
+        while (exp-- > 0) result *= 10;
+        return result;
+    }
+
+    //writes the digits right aligned at the end of out[20] and returns the number of digits
+    static int formatDec(uint64_t value, char *out)
+    {
+        const char *table = decPairs();
+        char *p = out + 20;
+        while (value >= 100)
+        {
+            const char *pair = table + ((value % 100) * 2);
+            value /= 100;
+            *--p = pair[1];
+            *--p = pair[0];
+        }
+        if (value >= 10)
+        {
+            const char *pair = table + (value * 2);
+            *--p = pair[1];
+            *--p = pair[0];
+        }
+        else *--p = static_cast<char>('0' + value);
+        return static_cast<int>((out + 20) - p);
+    }
+
+    void ensure(int extra)
+    {
+        if (mPos + extra > mBuf.size()) mBuf.resize(qMax(mBuf.size() * 2, mPos + extra + 4096));
+    }
+
+    QByteArray mBuf;
+    int mPos;
+};
+
+#endif // TEXTFORMATTER_H